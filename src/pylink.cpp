@@ -1,23 +1,29 @@
 #define PY_SSIZE_T_CLEAN
 
 #include <Python.h>
+#include <vector>
 #include "texture2d.h"
 
 
 static PyObject *_CompressEtc1(PyObject *self, PyObject *args)
 {
     // define vars
-    uint8_t *data;
-    size_t data_size;
+    Py_buffer data;
     int mipmap, fEffort, jobs, header;
 
-    if (!PyArg_ParseTuple(args, "y#iiii", &data, &data_size, &mipmap, &fEffort, &jobs, &header))
+    if (!PyArg_ParseTuple(args, "y*iiii", &data, &mipmap, &fEffort, &jobs, &header))
         return NULL;
 
     uint8_t *out = nullptr;
     size_t outsize = 0;
 
-    if (CompressEtc1(data, data_size, mipmap, fEffort, jobs, header, &out, &outsize) == 0) {
+    int ok;
+    Py_BEGIN_ALLOW_THREADS
+    ok = CompressEtc1((uint8_t *) data.buf, data.len, mipmap, fEffort, jobs, header, &out, &outsize);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&data);
+    if (ok == 0) {
+        PyErr_SetString(PyExc_RuntimeError, "etc compress failed");
         return NULL;
     }
 
@@ -32,17 +38,22 @@ static PyObject *_CompressEtc2RGB(PyObject *self, PyObject *args)
     //            uint8_t **dst, size_t *filesize
 
     // define vars
-    uint8_t *data;
-    size_t data_size;
+    Py_buffer data;
     int mipmap, fEffort, jobs, header;
 
-    if (!PyArg_ParseTuple(args, "y#iiii", &data, &data_size, &mipmap, &fEffort, &jobs, &header))
+    if (!PyArg_ParseTuple(args, "y*iiii", &data, &mipmap, &fEffort, &jobs, &header))
         return NULL;
 
     uint8_t *out = nullptr;
     size_t outsize = 0;
 
-    if (CompressEtc2RGB(data, data_size, mipmap, fEffort, jobs, header, &out, &outsize) == 0) {
+    int ok;
+    Py_BEGIN_ALLOW_THREADS
+    ok = CompressEtc2RGB((uint8_t *) data.buf, data.len, mipmap, fEffort, jobs, header, &out, &outsize);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&data);
+    if (ok == 0) {
+        PyErr_SetString(PyExc_RuntimeError, "etc compress failed");
         return NULL;
     }
 
@@ -57,17 +68,135 @@ static PyObject *_CompressEtc2RGBA(PyObject *self, PyObject *args)
     //            uint8_t **dst, size_t *filesize
 
     // define vars
-    uint8_t *data;
-    size_t data_size;
+    Py_buffer data;
     int mipmap, fEffort, jobs, header;
 
-    if (!PyArg_ParseTuple(args, "y#iiii", &data, &data_size, &mipmap, &fEffort, &jobs, &header))
+    if (!PyArg_ParseTuple(args, "y*iiii", &data, &mipmap, &fEffort, &jobs, &header))
         return NULL;
 
     uint8_t *out = nullptr;
     size_t outsize = 0;
 
-    if (CompressEtc2RGBA(data, data_size, mipmap, fEffort, jobs, header, &out, &outsize) == 0) {
+    int ok;
+    Py_BEGIN_ALLOW_THREADS
+    ok = CompressEtc2RGBA((uint8_t *) data.buf, data.len, mipmap, fEffort, jobs, header, &out, &outsize);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&data);
+    if (ok == 0) {
+        PyErr_SetString(PyExc_RuntimeError, "etc compress failed");
+        return NULL;
+    }
+
+    PyObject *res = Py_BuildValue("y#", out, outsize);
+    free(out);
+    return res;
+}
+
+// Validates a raw RGBA8 pixel buffer; a stride of 0 means tightly packed rows
+static int checkRawPixels(Py_buffer *pixels, int width, int height, Py_ssize_t *stride)
+{
+    if (*stride == 0) {
+        *stride = (Py_ssize_t) width * 4;
+    }
+    if (width <= 0 || height <= 0 || *stride < (Py_ssize_t) width * 4) {
+        PyErr_SetString(PyExc_ValueError, "width and height must be positive and stride >= width * 4");
+        return 0;
+    }
+    if (pixels->len < *stride * (height - 1) + (Py_ssize_t) width * 4) {
+        PyErr_SetString(PyExc_ValueError, "pixel buffer is smaller than stride * height");
+        return 0;
+    }
+    return 1;
+}
+
+static PyObject *_CompressEtc1Raw(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer pixels;
+    int width, height, mipmap, fEffort, jobs, header;
+    Py_ssize_t stride;
+
+    if (!PyArg_ParseTuple(args, "y*iiniiii", &pixels, &width, &height, &stride, &mipmap, &fEffort, &jobs, &header))
+        return NULL;
+    if (!checkRawPixels(&pixels, width, height, &stride)) {
+        PyBuffer_Release(&pixels);
+        return NULL;
+    }
+
+    uint8_t *out = nullptr;
+    size_t outsize = 0;
+
+    int ok;
+    Py_BEGIN_ALLOW_THREADS
+    ok = CompressEtc1Raw((uint8_t *) pixels.buf, width, height, stride, mipmap, fEffort, jobs, header, &out, &outsize);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&pixels);
+    if (ok == 0) {
+        PyErr_SetString(PyExc_RuntimeError, "etc compress failed");
+        return NULL;
+    }
+
+    PyObject *res = Py_BuildValue("y#", out, outsize);
+    free(out);
+    return res;
+}
+
+static PyObject *_CompressEtc2RGBRaw(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer pixels;
+    int width, height, mipmap, fEffort, jobs, header;
+    Py_ssize_t stride;
+
+    if (!PyArg_ParseTuple(args, "y*iiniiii", &pixels, &width, &height, &stride, &mipmap, &fEffort, &jobs, &header))
+        return NULL;
+    if (!checkRawPixels(&pixels, width, height, &stride)) {
+        PyBuffer_Release(&pixels);
+        return NULL;
+    }
+
+    uint8_t *out = nullptr;
+    size_t outsize = 0;
+
+    int ok;
+    Py_BEGIN_ALLOW_THREADS
+    ok = CompressEtc2RGBRaw((uint8_t *) pixels.buf, width, height, stride, mipmap, fEffort, jobs, header, &out, &outsize);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&pixels);
+    if (ok == 0) {
+        PyErr_SetString(PyExc_RuntimeError, "etc compress failed");
+        return NULL;
+    }
+
+    PyObject *res = Py_BuildValue("y#", out, outsize);
+    free(out);
+    return res;
+}
+
+static PyObject *_CompressEtc2RGBARaw(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer pixels;
+    int width, height, mipmap, fEffort, jobs, header;
+    Py_ssize_t stride;
+
+    if (!PyArg_ParseTuple(args, "y*iiniiii", &pixels, &width, &height, &stride, &mipmap, &fEffort, &jobs, &header))
+        return NULL;
+    if (!checkRawPixels(&pixels, width, height, &stride)) {
+        PyBuffer_Release(&pixels);
+        return NULL;
+    }
+
+    uint8_t *out = nullptr;
+    size_t outsize = 0;
+
+    int ok;
+    Py_BEGIN_ALLOW_THREADS
+    ok = CompressEtc2RGBARaw((uint8_t *) pixels.buf, width, height, stride, mipmap, fEffort, jobs, header, &out, &outsize);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&pixels);
+    if (ok == 0) {
+        PyErr_SetString(PyExc_RuntimeError, "etc compress failed");
         return NULL;
     }
 
@@ -84,242 +213,1875 @@ static PyObject *_CompressEtc1WithFile(PyObject *self, PyObject *args)
     int mipmap, fEffort, jobs;
     if (!PyArg_ParseTuple(args, "ssiii", &input, &output, &mipmap, &fEffort, &jobs))
         return NULL;
-    int result = CompressEtc1WithFile(input, output, mipmap, fEffort, jobs);
-    PyObject *res = Py_BuildValue("i", result);
+    int result;
+    Py_BEGIN_ALLOW_THREADS
+    result = CompressEtc1WithFile(input, output, mipmap, fEffort, jobs);
+    Py_END_ALLOW_THREADS
+    PyObject *res = Py_BuildValue("i", result);
+    return res;
+}
+
+static PyObject *_CompressEtc2RGBWithFile(PyObject *self, PyObject *args)
+{
+    // define vars
+    char *input;
+    char *output;
+    int mipmap, fEffort, jobs;
+    if (!PyArg_ParseTuple(args, "ssiii", &input, &output, &mipmap, &fEffort, &jobs))
+        return NULL;
+    int result;
+    Py_BEGIN_ALLOW_THREADS
+    result = CompressEtc2RGBWithFile(input, output, mipmap, fEffort, jobs);
+    Py_END_ALLOW_THREADS
+    PyObject *res = Py_BuildValue("i", result);
+    return res;
+}
+
+static PyObject *_CompressEtc2RGBAWithFile(PyObject *self, PyObject *args)
+{
+    // define vars
+    char *input;
+    char *output;
+    int mipmap, fEffort, jobs;
+    if (!PyArg_ParseTuple(args, "ssiii", &input, &output, &mipmap, &fEffort, &jobs))
+        return NULL;
+    int result;
+    Py_BEGIN_ALLOW_THREADS
+    result = CompressEtc2RGBAWithFile(input, output, mipmap, fEffort, jobs);
+    Py_END_ALLOW_THREADS
+    PyObject *res = Py_BuildValue("i", result);
+    return res;
+}
+
+
+// ====================astc compress
+
+
+static PyObject *_CompressAstc(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    int fEffort, block_x, block_y, block_z, header;
+
+    if (!PyArg_ParseTuple(args, "y*iiiii", &data, &fEffort, &block_x, &block_y, &block_z, &header))
+        return NULL;
+
+    uint8_t *out = nullptr;
+    size_t outsize = 0;
+
+    int ok;
+    Py_BEGIN_ALLOW_THREADS
+    ok = CompressAstc((uint8_t *) data.buf, data.len, fEffort, block_x, block_y, block_z, header, &out, &outsize);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&data);
+    if (ok == 0) {
+        PyErr_SetString(PyExc_RuntimeError, "astc compress failed");
+        return NULL;
+    }
+
+    PyObject *res = Py_BuildValue("y#", out, outsize);
+    free(out);
+    return res;
+}
+
+static PyObject *_CompressAstcRaw(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer pixels;
+    int width, height, fEffort, block_x, block_y, block_z, header;
+    Py_ssize_t stride;
+
+    if (!PyArg_ParseTuple(args, "y*iiniiiii", &pixels, &width, &height, &stride, &fEffort, &block_x, &block_y,
+                          &block_z, &header))
+        return NULL;
+    if (!checkRawPixels(&pixels, width, height, &stride)) {
+        PyBuffer_Release(&pixels);
+        return NULL;
+    }
+
+    uint8_t *out = nullptr;
+    size_t outsize = 0;
+
+    int ok;
+    Py_BEGIN_ALLOW_THREADS
+    ok = CompressAstcRaw((uint8_t *) pixels.buf, width, height, stride, fEffort, block_x, block_y, block_z, header,
+                         &out, &outsize);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&pixels);
+    if (ok == 0) {
+        PyErr_SetString(PyExc_RuntimeError, "astc compress failed");
+        return NULL;
+    }
+
+    PyObject *res = Py_BuildValue("y#", out, outsize);
+    free(out);
+    return res;
+}
+
+static PyObject *_CompressAstcWithFile(PyObject *self, PyObject *args)
+{
+    // define vars
+    char *input;
+    char *output;
+    int fEffort, block_x, block_y, block_z;
+
+    if (!PyArg_ParseTuple(args, "ssiiii", &input, &output, &fEffort, &block_x, &block_y, &block_z))
+        return NULL;
+
+    int result;
+    Py_BEGIN_ALLOW_THREADS
+    result = CompressAstcWithFile(input, output, fEffort, block_x, block_y, block_z);
+    Py_END_ALLOW_THREADS
+    PyObject *res = Py_BuildValue("i", result);
+    return res;
+}
+
+
+// ================ decode
+
+
+// Decoders read every block of the image without knowing the buffer length, so a short buffer is
+// rejected here before they run off its end on a worker thread. Releases data when it fails.
+static int checkDataBytes(Py_buffer *data, size_t data_bytes)
+{
+    if ((size_t) data->len >= data_bytes)
+        return 1;
+    PyErr_Format(PyExc_ValueError, "data holds %zd bytes, the image needs %zu", data->len, data_bytes);
+    PyBuffer_Release(data);
+    return 0;
+}
+
+// ValueError naming the footprint when block_width x block_height is not an astc block size, releasing
+// data and out (if given) on failure. BlockImageBytes is 0 for those, which checkDataBytes would accept.
+static int checkAstcFootprint(Py_buffer *data, Py_buffer *out, int block_width, int block_height)
+{
+    if (BlockImageBytes(TEXTURE2D_FORMAT_ASTC, 1, 1, block_width, block_height) != 0)
+        return 1;
+    PyErr_Format(PyExc_ValueError, "unsupported astc block footprint %dx%d", block_width, block_height);
+    PyBuffer_Release(data);
+    if (out != NULL)
+        PyBuffer_Release(out);
+    return 0;
+}
+
+// Runs `decoder` without the GIL straight into the storage of a fresh w * h pixel bytes object in the
+// given TEXTURE2D_OUTPUT_* layout, so the decoded image is never staged in a temporary malloc'd buffer.
+// data_bytes is the size of the blocks the decoder reads from data.
+template<typename Decoder>
+static PyObject *decompressToBytes(Py_buffer *data, size_t data_bytes, int w, int h, int pixel_bytes,
+                                   const char *format_name, Decoder decoder)
+{
+    if (w < 0 || h < 0) {
+        PyBuffer_Release(data);
+        PyErr_SetString(PyExc_ValueError, "w and h must not be negative");
+        return NULL;
+    }
+    if (pixel_bytes == 0) {
+        PyBuffer_Release(data);
+        PyErr_Format(PyExc_ValueError, "unknown %s", format_name);
+        return NULL;
+    }
+    if (!checkDataBytes(data, data_bytes))
+        return NULL;
+    PyObject *res = PyBytes_FromStringAndSize(NULL, (Py_ssize_t) w * h * pixel_bytes);
+    if (res == NULL) {
+        PyBuffer_Release(data);
+        return NULL;
+    }
+    uint8_t *out = (uint8_t *) PyBytes_AS_STRING(res);
+    int ok;
+    Py_BEGIN_ALLOW_THREADS
+    ok = decoder((uint8_t *) data->buf, out);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(data);
+    if (ok == 0) {
+        Py_DECREF(res);
+        PyErr_SetString(PyExc_RuntimeError, "decode failed");
+        return NULL;
+    }
+    return res;
+}
+
+template<typename Decoder>
+static PyObject *decompressToBytes(Py_buffer *data, size_t data_bytes, int w, int h, int output_format,
+                                   Decoder decoder)
+{
+    return decompressToBytes(data, data_bytes, w, h, OutputFormatBytes(output_format), "output_format", decoder);
+}
+
+// Same as decompressToBytes, but into a caller-owned writable buffer of at least w * h pixels
+template<typename Decoder>
+static PyObject *decompressIntoBuffer(Py_buffer *data, size_t data_bytes, Py_buffer *out, int w, int h,
+                                      int pixel_bytes, const char *format_name, Decoder decoder)
+{
+    if (pixel_bytes == 0) {
+        PyBuffer_Release(data);
+        PyBuffer_Release(out);
+        PyErr_Format(PyExc_ValueError, "unknown %s", format_name);
+        return NULL;
+    }
+    if (w < 0 || h < 0 || out->len < (Py_ssize_t) w * h * pixel_bytes) {
+        PyBuffer_Release(data);
+        PyBuffer_Release(out);
+        PyErr_Format(PyExc_ValueError, "out_buffer must hold at least w * h pixels of %s", format_name);
+        return NULL;
+    }
+    if (!checkDataBytes(data, data_bytes)) {
+        PyBuffer_Release(out);
+        return NULL;
+    }
+    int ok;
+    Py_BEGIN_ALLOW_THREADS
+    ok = decoder((uint8_t *) data->buf, (uint8_t *) out->buf);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(data);
+    PyBuffer_Release(out);
+    if (ok == 0) {
+        PyErr_SetString(PyExc_RuntimeError, "decode failed");
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+template<typename Decoder>
+static PyObject *decompressIntoBuffer(Py_buffer *data, size_t data_bytes, Py_buffer *out, int w, int h,
+                                      int output_format, Decoder decoder)
+{
+    return decompressIntoBuffer(data, data_bytes, out, w, h, OutputFormatBytes(output_format), "output_format",
+                                decoder);
+}
+
+// Decodes and encodes as image_format (TEXTURE2D_IMAGE_*), returning the file bytes
+template<typename Encoder>
+static PyObject *decompressToImage(Py_buffer *data, size_t data_bytes, int w, int h, int image_format,
+                                   Encoder encoder)
+{
+    if (w <= 0 || h <= 0) {
+        PyBuffer_Release(data);
+        PyErr_SetString(PyExc_ValueError, "w and h must be positive");
+        return NULL;
+    }
+    if (image_format < TEXTURE2D_IMAGE_PNG || image_format > TEXTURE2D_IMAGE_RAW) {
+        PyBuffer_Release(data);
+        PyErr_SetString(PyExc_ValueError, "unknown image_format");
+        return NULL;
+    }
+    if (!checkDataBytes(data, data_bytes))
+        return NULL;
+    uint8_t *out = nullptr;
+    size_t outsize = 0;
+    int ok;
+    Py_BEGIN_ALLOW_THREADS
+    ok = encoder((uint8_t *) data->buf, &out, &outsize);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(data);
+    if (ok == 0) {
+        PyErr_SetString(PyExc_RuntimeError, "decode or encode failed");
+        return NULL;
+    }
+    PyObject *res = Py_BuildValue("y#", out, outsize);
+    free(out);
+    return res;
+}
+
+static PyObject *_DecompressEtc1(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    int w, h, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "y*ii|ii", &data, &w, &h, &jobs, &output_format))
+        return NULL;
+    return decompressToBytes(&data, BlockImageBytes(TEXTURE2D_FORMAT_ETC1, w, h, 4, 4), w, h, output_format,
+                             [&](uint8_t *src, uint8_t *out) {
+        return DecompressEtc1Into(src, w, h, jobs, output_format, out);
+    });
+}
+
+static PyObject *_DecompressEtc2(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    int w, h, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "y*ii|ii", &data, &w, &h, &jobs, &output_format))
+        return NULL;
+    return decompressToBytes(&data, BlockImageBytes(TEXTURE2D_FORMAT_ETC2_RGB, w, h, 4, 4), w, h, output_format,
+                             [&](uint8_t *src, uint8_t *out) {
+        return DecompressEtc2Into(src, w, h, jobs, output_format, out);
+    });
+}
+
+static PyObject *_DecompressEtc2a1(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    int w, h, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "y*ii|ii", &data, &w, &h, &jobs, &output_format))
+        return NULL;
+    return decompressToBytes(&data, BlockImageBytes(TEXTURE2D_FORMAT_ETC2_RGBA1, w, h, 4, 4), w, h, output_format,
+                             [&](uint8_t *src, uint8_t *out) {
+        return DecompressEtc2a1Into(src, w, h, jobs, output_format, out);
+    });
+}
+
+static PyObject *_DecompressEtc2a8(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    int w, h, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "y*ii|ii", &data, &w, &h, &jobs, &output_format))
+        return NULL;
+    return decompressToBytes(&data, BlockImageBytes(TEXTURE2D_FORMAT_ETC2_RGBA, w, h, 4, 4), w, h, output_format,
+                             [&](uint8_t *src, uint8_t *out) {
+        return DecompressEtc2a8Into(src, w, h, jobs, output_format, out);
+    });
+}
+
+static PyObject *_DecompressAstc(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    int w, h, block_width, block_height, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "y*iiii|ii", &data, &w, &h, &block_width, &block_height, &jobs, &output_format))
+        return NULL;
+    if (!checkAstcFootprint(&data, NULL, block_width, block_height))
+        return NULL;
+    return decompressToBytes(&data, BlockImageBytes(TEXTURE2D_FORMAT_ASTC, w, h, block_width, block_height),
+                             w, h, output_format, [&](uint8_t *src, uint8_t *out) {
+        return DecompressAstcInto(src, w, h, block_width, block_height, jobs, output_format, out);
+    });
+}
+
+static PyObject *_DecompressAstcFloat(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    int w, h, block_width, block_height, jobs = 1, float_format = TEXTURE2D_FLOAT_RGBA16F;
+    if (!PyArg_ParseTuple(args, "y*iiii|ii", &data, &w, &h, &block_width, &block_height, &jobs, &float_format))
+        return NULL;
+    if (!checkAstcFootprint(&data, NULL, block_width, block_height))
+        return NULL;
+    return decompressToBytes(&data, BlockImageBytes(TEXTURE2D_FORMAT_ASTC, w, h, block_width, block_height),
+                             w, h, FloatFormatBytes(float_format), "float_format",
+                             [&](uint8_t *src, uint8_t *out) {
+        return DecompressAstcFloatInto(src, w, h, block_width, block_height, jobs, float_format, out);
+    });
+}
+
+static PyObject *_DecompressAstcFloatInto(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data, out;
+    int w, h, block_width, block_height, jobs = 1, float_format = TEXTURE2D_FLOAT_RGBA16F;
+    if (!PyArg_ParseTuple(args, "y*w*iiii|ii", &data, &out, &w, &h, &block_width, &block_height, &jobs, &float_format))
+        return NULL;
+    if (!checkAstcFootprint(&data, &out, block_width, block_height))
+        return NULL;
+    return decompressIntoBuffer(&data, BlockImageBytes(TEXTURE2D_FORMAT_ASTC, w, h, block_width, block_height),
+                                &out, w, h, FloatFormatBytes(float_format), "float_format",
+                                [&](uint8_t *src, uint8_t *dst) {
+        return DecompressAstcFloatInto(src, w, h, block_width, block_height, jobs, float_format, dst);
+    });
+}
+
+static PyObject *_DecompressEtc1Into(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data, out;
+    int w, h, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "y*w*ii|ii", &data, &out, &w, &h, &jobs, &output_format))
+        return NULL;
+    return decompressIntoBuffer(&data, BlockImageBytes(TEXTURE2D_FORMAT_ETC1, w, h, 4, 4), &out, w, h, output_format,
+                                [&](uint8_t *src, uint8_t *dst) {
+        return DecompressEtc1Into(src, w, h, jobs, output_format, dst);
+    });
+}
+
+static PyObject *_DecompressEtc2Into(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data, out;
+    int w, h, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "y*w*ii|ii", &data, &out, &w, &h, &jobs, &output_format))
+        return NULL;
+    return decompressIntoBuffer(&data, BlockImageBytes(TEXTURE2D_FORMAT_ETC2_RGB, w, h, 4, 4),
+                                &out, w, h, output_format, [&](uint8_t *src, uint8_t *dst) {
+        return DecompressEtc2Into(src, w, h, jobs, output_format, dst);
+    });
+}
+
+static PyObject *_DecompressEtc2a1Into(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data, out;
+    int w, h, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "y*w*ii|ii", &data, &out, &w, &h, &jobs, &output_format))
+        return NULL;
+    return decompressIntoBuffer(&data, BlockImageBytes(TEXTURE2D_FORMAT_ETC2_RGBA1, w, h, 4, 4),
+                                &out, w, h, output_format, [&](uint8_t *src, uint8_t *dst) {
+        return DecompressEtc2a1Into(src, w, h, jobs, output_format, dst);
+    });
+}
+
+static PyObject *_DecompressEtc2a8Into(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data, out;
+    int w, h, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "y*w*ii|ii", &data, &out, &w, &h, &jobs, &output_format))
+        return NULL;
+    return decompressIntoBuffer(&data, BlockImageBytes(TEXTURE2D_FORMAT_ETC2_RGBA, w, h, 4, 4),
+                                &out, w, h, output_format, [&](uint8_t *src, uint8_t *dst) {
+        return DecompressEtc2a8Into(src, w, h, jobs, output_format, dst);
+    });
+}
+
+static PyObject *_DecompressAstcInto(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data, out;
+    int w, h, block_width, block_height, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "y*w*iiii|ii", &data, &out, &w, &h, &block_width, &block_height, &jobs, &output_format))
+        return NULL;
+    if (!checkAstcFootprint(&data, &out, block_width, block_height))
+        return NULL;
+    return decompressIntoBuffer(&data, BlockImageBytes(TEXTURE2D_FORMAT_ASTC, w, h, block_width, block_height),
+                                &out, w, h, output_format, [&](uint8_t *src, uint8_t *dst) {
+        return DecompressAstcInto(src, w, h, block_width, block_height, jobs, output_format, dst);
+    });
+}
+
+static PyObject *_DecompressEtc1ToFile(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    char *output;
+    int w, h, jobs = 1, image_format = 0;
+    if (!PyArg_ParseTuple(args, "y*sii|ii", &data, &output, &w, &h, &jobs, &image_format))
+        return NULL;
+    if (!checkDataBytes(&data, BlockImageBytes(TEXTURE2D_FORMAT_ETC1, w, h, 4, 4)))
+        return NULL;
+    int result;
+    Py_BEGIN_ALLOW_THREADS
+    result = DecompressEtc1ToFile((uint8_t *) data.buf, w, h, jobs, image_format, output);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&data);
+    PyObject *res = Py_BuildValue("i", result);
+    return res;
+}
+
+static PyObject *_DecompressEtc2ToFile(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    char *output;
+    int w, h, jobs = 1, image_format = 0;
+    if (!PyArg_ParseTuple(args, "y*sii|ii", &data, &output, &w, &h, &jobs, &image_format))
+        return NULL;
+    if (!checkDataBytes(&data, BlockImageBytes(TEXTURE2D_FORMAT_ETC2_RGB, w, h, 4, 4)))
+        return NULL;
+    int result;
+    Py_BEGIN_ALLOW_THREADS
+    result = DecompressEtc2ToFile((uint8_t *) data.buf, w, h, jobs, image_format, output);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&data);
+    PyObject *res = Py_BuildValue("i", result);
+    return res;
+}
+
+static PyObject *_DecompressEtc2a1ToFile(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    char *output;
+    int w, h, jobs = 1, image_format = 0;
+    if (!PyArg_ParseTuple(args, "y*sii|ii", &data, &output, &w, &h, &jobs, &image_format))
+        return NULL;
+    if (!checkDataBytes(&data, BlockImageBytes(TEXTURE2D_FORMAT_ETC2_RGBA1, w, h, 4, 4)))
+        return NULL;
+    int result;
+    Py_BEGIN_ALLOW_THREADS
+    result = DecompressEtc2a1ToFile((uint8_t *) data.buf, w, h, jobs, image_format, output);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&data);
+    PyObject *res = Py_BuildValue("i", result);
+    return res;
+}
+
+static PyObject *_DecompressEtc2a8ToFile(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    char *output;
+    int w, h, jobs = 1, image_format = 0;
+    if (!PyArg_ParseTuple(args, "y*sii|ii", &data, &output, &w, &h, &jobs, &image_format))
+        return NULL;
+    if (!checkDataBytes(&data, BlockImageBytes(TEXTURE2D_FORMAT_ETC2_RGBA, w, h, 4, 4)))
+        return NULL;
+    int result;
+    Py_BEGIN_ALLOW_THREADS
+    result = DecompressEtc2a8ToFile((uint8_t *) data.buf, w, h, jobs, image_format, output);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&data);
+    PyObject *res = Py_BuildValue("i", result);
+    return res;
+}
+
+static PyObject *_DecompressAstcToFile(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    char *output;
+    int w, h, block_width, block_height, jobs = 1, image_format = 0;
+    if (!PyArg_ParseTuple(args, "y*siiii|ii", &data, &output, &w, &h, &block_width, &block_height, &jobs,
+                          &image_format))
+        return NULL;
+    if (!checkAstcFootprint(&data, NULL, block_width, block_height))
+        return NULL;
+    if (!checkDataBytes(&data, BlockImageBytes(TEXTURE2D_FORMAT_ASTC, w, h, block_width, block_height)))
+        return NULL;
+    int result;
+    Py_BEGIN_ALLOW_THREADS
+    result = DecompressAstcToFile((uint8_t *) data.buf, w, h, block_width, block_height, jobs, image_format, output);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&data);
+    PyObject *res = Py_BuildValue("i", result);
+    return res;
+}
+
+static PyObject *_DecompressBc1(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    int w, h, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "y*ii|ii", &data, &w, &h, &jobs, &output_format))
+        return NULL;
+    return decompressToBytes(&data, BlockImageBytes(TEXTURE2D_FORMAT_BC1, w, h, 4, 4), w, h, output_format,
+                             [&](uint8_t *src, uint8_t *out) {
+        return DecompressBc1Into(src, w, h, jobs, output_format, out);
+    });
+}
+
+static PyObject *_DecompressBc3(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    int w, h, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "y*ii|ii", &data, &w, &h, &jobs, &output_format))
+        return NULL;
+    return decompressToBytes(&data, BlockImageBytes(TEXTURE2D_FORMAT_BC3, w, h, 4, 4), w, h, output_format,
+                             [&](uint8_t *src, uint8_t *out) {
+        return DecompressBc3Into(src, w, h, jobs, output_format, out);
+    });
+}
+
+static PyObject *_DecompressBc4(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    int w, h, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "y*ii|ii", &data, &w, &h, &jobs, &output_format))
+        return NULL;
+    return decompressToBytes(&data, BlockImageBytes(TEXTURE2D_FORMAT_BC4, w, h, 4, 4), w, h, output_format,
+                             [&](uint8_t *src, uint8_t *out) {
+        return DecompressBc4Into(src, w, h, jobs, output_format, out);
+    });
+}
+
+static PyObject *_DecompressBc5(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    int w, h, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "y*ii|ii", &data, &w, &h, &jobs, &output_format))
+        return NULL;
+    return decompressToBytes(&data, BlockImageBytes(TEXTURE2D_FORMAT_BC5, w, h, 4, 4), w, h, output_format,
+                             [&](uint8_t *src, uint8_t *out) {
+        return DecompressBc5Into(src, w, h, jobs, output_format, out);
+    });
+}
+
+static PyObject *_DecompressBc6(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    int w, h, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "y*ii|ii", &data, &w, &h, &jobs, &output_format))
+        return NULL;
+    return decompressToBytes(&data, BlockImageBytes(TEXTURE2D_FORMAT_BC6, w, h, 4, 4), w, h, output_format,
+                             [&](uint8_t *src, uint8_t *out) {
+        return DecompressBc6Into(src, w, h, jobs, output_format, out);
+    });
+}
+
+static PyObject *_DecompressBc7(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    int w, h, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "y*ii|ii", &data, &w, &h, &jobs, &output_format))
+        return NULL;
+    return decompressToBytes(&data, BlockImageBytes(TEXTURE2D_FORMAT_BC7, w, h, 4, 4), w, h, output_format,
+                             [&](uint8_t *src, uint8_t *out) {
+        return DecompressBc7Into(src, w, h, jobs, output_format, out);
+    });
+}
+
+static PyObject *_DecompressBc1Into(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data, out;
+    int w, h, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "y*w*ii|ii", &data, &out, &w, &h, &jobs, &output_format))
+        return NULL;
+    return decompressIntoBuffer(&data, BlockImageBytes(TEXTURE2D_FORMAT_BC1, w, h, 4, 4), &out, w, h, output_format,
+                                [&](uint8_t *src, uint8_t *dst) {
+        return DecompressBc1Into(src, w, h, jobs, output_format, dst);
+    });
+}
+
+static PyObject *_DecompressBc3Into(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data, out;
+    int w, h, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "y*w*ii|ii", &data, &out, &w, &h, &jobs, &output_format))
+        return NULL;
+    return decompressIntoBuffer(&data, BlockImageBytes(TEXTURE2D_FORMAT_BC3, w, h, 4, 4), &out, w, h, output_format,
+                                [&](uint8_t *src, uint8_t *dst) {
+        return DecompressBc3Into(src, w, h, jobs, output_format, dst);
+    });
+}
+
+static PyObject *_DecompressBc4Into(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data, out;
+    int w, h, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "y*w*ii|ii", &data, &out, &w, &h, &jobs, &output_format))
+        return NULL;
+    return decompressIntoBuffer(&data, BlockImageBytes(TEXTURE2D_FORMAT_BC4, w, h, 4, 4), &out, w, h, output_format,
+                                [&](uint8_t *src, uint8_t *dst) {
+        return DecompressBc4Into(src, w, h, jobs, output_format, dst);
+    });
+}
+
+static PyObject *_DecompressBc5Into(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data, out;
+    int w, h, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "y*w*ii|ii", &data, &out, &w, &h, &jobs, &output_format))
+        return NULL;
+    return decompressIntoBuffer(&data, BlockImageBytes(TEXTURE2D_FORMAT_BC5, w, h, 4, 4), &out, w, h, output_format,
+                                [&](uint8_t *src, uint8_t *dst) {
+        return DecompressBc5Into(src, w, h, jobs, output_format, dst);
+    });
+}
+
+static PyObject *_DecompressBc6Into(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data, out;
+    int w, h, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "y*w*ii|ii", &data, &out, &w, &h, &jobs, &output_format))
+        return NULL;
+    return decompressIntoBuffer(&data, BlockImageBytes(TEXTURE2D_FORMAT_BC6, w, h, 4, 4), &out, w, h, output_format,
+                                [&](uint8_t *src, uint8_t *dst) {
+        return DecompressBc6Into(src, w, h, jobs, output_format, dst);
+    });
+}
+
+static PyObject *_DecompressBc7Into(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data, out;
+    int w, h, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "y*w*ii|ii", &data, &out, &w, &h, &jobs, &output_format))
+        return NULL;
+    return decompressIntoBuffer(&data, BlockImageBytes(TEXTURE2D_FORMAT_BC7, w, h, 4, 4), &out, w, h, output_format,
+                                [&](uint8_t *src, uint8_t *dst) {
+        return DecompressBc7Into(src, w, h, jobs, output_format, dst);
+    });
+}
+
+static PyObject *_DecompressEacR11(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    int w, h, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "y*ii|ii", &data, &w, &h, &jobs, &output_format))
+        return NULL;
+    return decompressToBytes(&data, BlockImageBytes(TEXTURE2D_FORMAT_EAC_R11, w, h, 4, 4), w, h, output_format,
+                             [&](uint8_t *src, uint8_t *out) {
+        return DecompressEacR11Into(src, w, h, jobs, output_format, out);
+    });
+}
+
+static PyObject *_DecompressEacR11Signed(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    int w, h, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "y*ii|ii", &data, &w, &h, &jobs, &output_format))
+        return NULL;
+    return decompressToBytes(&data, BlockImageBytes(TEXTURE2D_FORMAT_EAC_R11_SIGNED, w, h, 4, 4), w, h, output_format,
+                             [&](uint8_t *src, uint8_t *out) {
+        return DecompressEacR11SignedInto(src, w, h, jobs, output_format, out);
+    });
+}
+
+static PyObject *_DecompressEacRG11(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    int w, h, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "y*ii|ii", &data, &w, &h, &jobs, &output_format))
+        return NULL;
+    return decompressToBytes(&data, BlockImageBytes(TEXTURE2D_FORMAT_EAC_RG11, w, h, 4, 4), w, h, output_format,
+                             [&](uint8_t *src, uint8_t *out) {
+        return DecompressEacRG11Into(src, w, h, jobs, output_format, out);
+    });
+}
+
+static PyObject *_DecompressEacRG11Signed(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    int w, h, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "y*ii|ii", &data, &w, &h, &jobs, &output_format))
+        return NULL;
+    return decompressToBytes(&data, BlockImageBytes(TEXTURE2D_FORMAT_EAC_RG11_SIGNED, w, h, 4, 4), w, h, output_format,
+                             [&](uint8_t *src, uint8_t *out) {
+        return DecompressEacRG11SignedInto(src, w, h, jobs, output_format, out);
+    });
+}
+
+static PyObject *_DecompressPvrtc(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    int w, h, is2bpp, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "y*iii|ii", &data, &w, &h, &is2bpp, &jobs, &output_format))
+        return NULL;
+    return decompressToBytes(&data, PvrtcImageBytes(w, h, is2bpp), w, h, output_format,
+                             [&](uint8_t *src, uint8_t *out) {
+        return DecompressPvrtcInto(src, w, h, is2bpp, jobs, output_format, out);
+    });
+}
+
+static PyObject *_DecompressEacR11Into(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data, out;
+    int w, h, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "y*w*ii|ii", &data, &out, &w, &h, &jobs, &output_format))
+        return NULL;
+    return decompressIntoBuffer(&data, BlockImageBytes(TEXTURE2D_FORMAT_EAC_R11, w, h, 4, 4), &out, w, h, output_format,
+                                [&](uint8_t *src, uint8_t *dst) {
+        return DecompressEacR11Into(src, w, h, jobs, output_format, dst);
+    });
+}
+
+static PyObject *_DecompressEacR11SignedInto(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data, out;
+    int w, h, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "y*w*ii|ii", &data, &out, &w, &h, &jobs, &output_format))
+        return NULL;
+    return decompressIntoBuffer(&data, BlockImageBytes(TEXTURE2D_FORMAT_EAC_R11_SIGNED, w, h, 4, 4),
+                                &out, w, h, output_format, [&](uint8_t *src, uint8_t *dst) {
+        return DecompressEacR11SignedInto(src, w, h, jobs, output_format, dst);
+    });
+}
+
+static PyObject *_DecompressEacRG11Into(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data, out;
+    int w, h, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "y*w*ii|ii", &data, &out, &w, &h, &jobs, &output_format))
+        return NULL;
+    return decompressIntoBuffer(&data, BlockImageBytes(TEXTURE2D_FORMAT_EAC_RG11, w, h, 4, 4),
+                                &out, w, h, output_format, [&](uint8_t *src, uint8_t *dst) {
+        return DecompressEacRG11Into(src, w, h, jobs, output_format, dst);
+    });
+}
+
+static PyObject *_DecompressEacRG11SignedInto(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data, out;
+    int w, h, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "y*w*ii|ii", &data, &out, &w, &h, &jobs, &output_format))
+        return NULL;
+    return decompressIntoBuffer(&data, BlockImageBytes(TEXTURE2D_FORMAT_EAC_RG11_SIGNED, w, h, 4, 4),
+                                &out, w, h, output_format, [&](uint8_t *src, uint8_t *dst) {
+        return DecompressEacRG11SignedInto(src, w, h, jobs, output_format, dst);
+    });
+}
+
+static PyObject *_DecompressPvrtcInto(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data, out;
+    int w, h, is2bpp, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "y*w*iii|ii", &data, &out, &w, &h, &is2bpp, &jobs, &output_format))
+        return NULL;
+    return decompressIntoBuffer(&data, PvrtcImageBytes(w, h, is2bpp), &out, w, h, output_format,
+                                [&](uint8_t *src, uint8_t *dst) {
+        return DecompressPvrtcInto(src, w, h, is2bpp, jobs, output_format, dst);
+    });
+}
+
+static PyObject *_DecompressBc1ToFile(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    char *output;
+    int w, h, jobs = 1, image_format = 0;
+    if (!PyArg_ParseTuple(args, "y*sii|ii", &data, &output, &w, &h, &jobs, &image_format))
+        return NULL;
+    if (!checkDataBytes(&data, BlockImageBytes(TEXTURE2D_FORMAT_BC1, w, h, 4, 4)))
+        return NULL;
+    int result;
+    Py_BEGIN_ALLOW_THREADS
+    result = DecompressBc1ToFile((uint8_t *) data.buf, w, h, jobs, image_format, output);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&data);
+    PyObject *res = Py_BuildValue("i", result);
+    return res;
+}
+
+static PyObject *_DecompressBc3ToFile(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    char *output;
+    int w, h, jobs = 1, image_format = 0;
+    if (!PyArg_ParseTuple(args, "y*sii|ii", &data, &output, &w, &h, &jobs, &image_format))
+        return NULL;
+    if (!checkDataBytes(&data, BlockImageBytes(TEXTURE2D_FORMAT_BC3, w, h, 4, 4)))
+        return NULL;
+    int result;
+    Py_BEGIN_ALLOW_THREADS
+    result = DecompressBc3ToFile((uint8_t *) data.buf, w, h, jobs, image_format, output);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&data);
+    PyObject *res = Py_BuildValue("i", result);
+    return res;
+}
+
+static PyObject *_DecompressBc4ToFile(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    char *output;
+    int w, h, jobs = 1, image_format = 0;
+    if (!PyArg_ParseTuple(args, "y*sii|ii", &data, &output, &w, &h, &jobs, &image_format))
+        return NULL;
+    if (!checkDataBytes(&data, BlockImageBytes(TEXTURE2D_FORMAT_BC4, w, h, 4, 4)))
+        return NULL;
+    int result;
+    Py_BEGIN_ALLOW_THREADS
+    result = DecompressBc4ToFile((uint8_t *) data.buf, w, h, jobs, image_format, output);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&data);
+    PyObject *res = Py_BuildValue("i", result);
+    return res;
+}
+
+static PyObject *_DecompressBc5ToFile(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    char *output;
+    int w, h, jobs = 1, image_format = 0;
+    if (!PyArg_ParseTuple(args, "y*sii|ii", &data, &output, &w, &h, &jobs, &image_format))
+        return NULL;
+    if (!checkDataBytes(&data, BlockImageBytes(TEXTURE2D_FORMAT_BC5, w, h, 4, 4)))
+        return NULL;
+    int result;
+    Py_BEGIN_ALLOW_THREADS
+    result = DecompressBc5ToFile((uint8_t *) data.buf, w, h, jobs, image_format, output);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&data);
+    PyObject *res = Py_BuildValue("i", result);
+    return res;
+}
+
+static PyObject *_DecompressBc6ToFile(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    char *output;
+    int w, h, jobs = 1, image_format = 0;
+    if (!PyArg_ParseTuple(args, "y*sii|ii", &data, &output, &w, &h, &jobs, &image_format))
+        return NULL;
+    if (!checkDataBytes(&data, BlockImageBytes(TEXTURE2D_FORMAT_BC6, w, h, 4, 4)))
+        return NULL;
+    int result;
+    Py_BEGIN_ALLOW_THREADS
+    result = DecompressBc6ToFile((uint8_t *) data.buf, w, h, jobs, image_format, output);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&data);
+    PyObject *res = Py_BuildValue("i", result);
+    return res;
+}
+
+static PyObject *_DecompressBc7ToFile(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    char *output;
+    int w, h, jobs = 1, image_format = 0;
+    if (!PyArg_ParseTuple(args, "y*sii|ii", &data, &output, &w, &h, &jobs, &image_format))
+        return NULL;
+    if (!checkDataBytes(&data, BlockImageBytes(TEXTURE2D_FORMAT_BC7, w, h, 4, 4)))
+        return NULL;
+    int result;
+    Py_BEGIN_ALLOW_THREADS
+    result = DecompressBc7ToFile((uint8_t *) data.buf, w, h, jobs, image_format, output);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&data);
+    PyObject *res = Py_BuildValue("i", result);
+    return res;
+}
+
+static PyObject *_DecompressEtc1ToImageBytes(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    int w, h, jobs = 1, image_format = 0;
+    if (!PyArg_ParseTuple(args, "y*ii|ii", &data, &w, &h, &jobs, &image_format))
+        return NULL;
+    return decompressToImage(&data, BlockImageBytes(TEXTURE2D_FORMAT_ETC1, w, h, 4, 4), w, h, image_format,
+                             [&](uint8_t *src, uint8_t **out, size_t *outsize) {
+        return DecompressEtc1ToImageBytes(src, w, h, jobs, image_format, out, outsize);
+    });
+}
+
+static PyObject *_DecompressEtc2ToImageBytes(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    int w, h, jobs = 1, image_format = 0;
+    if (!PyArg_ParseTuple(args, "y*ii|ii", &data, &w, &h, &jobs, &image_format))
+        return NULL;
+    return decompressToImage(&data, BlockImageBytes(TEXTURE2D_FORMAT_ETC2_RGB, w, h, 4, 4), w, h, image_format,
+                             [&](uint8_t *src, uint8_t **out, size_t *outsize) {
+        return DecompressEtc2ToImageBytes(src, w, h, jobs, image_format, out, outsize);
+    });
+}
+
+static PyObject *_DecompressEtc2a1ToImageBytes(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    int w, h, jobs = 1, image_format = 0;
+    if (!PyArg_ParseTuple(args, "y*ii|ii", &data, &w, &h, &jobs, &image_format))
+        return NULL;
+    return decompressToImage(&data, BlockImageBytes(TEXTURE2D_FORMAT_ETC2_RGBA1, w, h, 4, 4), w, h, image_format,
+                             [&](uint8_t *src, uint8_t **out, size_t *outsize) {
+        return DecompressEtc2a1ToImageBytes(src, w, h, jobs, image_format, out, outsize);
+    });
+}
+
+static PyObject *_DecompressEtc2a8ToImageBytes(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    int w, h, jobs = 1, image_format = 0;
+    if (!PyArg_ParseTuple(args, "y*ii|ii", &data, &w, &h, &jobs, &image_format))
+        return NULL;
+    return decompressToImage(&data, BlockImageBytes(TEXTURE2D_FORMAT_ETC2_RGBA, w, h, 4, 4), w, h, image_format,
+                             [&](uint8_t *src, uint8_t **out, size_t *outsize) {
+        return DecompressEtc2a8ToImageBytes(src, w, h, jobs, image_format, out, outsize);
+    });
+}
+
+static PyObject *_DecompressAstcToImageBytes(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    int w, h, block_width, block_height, jobs = 1, image_format = 0;
+    if (!PyArg_ParseTuple(args, "y*iiii|ii", &data, &w, &h, &block_width, &block_height, &jobs, &image_format))
+        return NULL;
+    if (!checkAstcFootprint(&data, NULL, block_width, block_height))
+        return NULL;
+    return decompressToImage(&data, BlockImageBytes(TEXTURE2D_FORMAT_ASTC, w, h, block_width, block_height),
+                             w, h, image_format, [&](uint8_t *src, uint8_t **out, size_t *outsize) {
+        return DecompressAstcToImageBytes(src, w, h, block_width, block_height, jobs, image_format, out, outsize);
+    });
+}
+
+static PyObject *_DecompressBc1ToImageBytes(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    int w, h, jobs = 1, image_format = 0;
+    if (!PyArg_ParseTuple(args, "y*ii|ii", &data, &w, &h, &jobs, &image_format))
+        return NULL;
+    return decompressToImage(&data, BlockImageBytes(TEXTURE2D_FORMAT_BC1, w, h, 4, 4), w, h, image_format,
+                             [&](uint8_t *src, uint8_t **out, size_t *outsize) {
+        return DecompressBc1ToImageBytes(src, w, h, jobs, image_format, out, outsize);
+    });
+}
+
+static PyObject *_DecompressBc3ToImageBytes(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    int w, h, jobs = 1, image_format = 0;
+    if (!PyArg_ParseTuple(args, "y*ii|ii", &data, &w, &h, &jobs, &image_format))
+        return NULL;
+    return decompressToImage(&data, BlockImageBytes(TEXTURE2D_FORMAT_BC3, w, h, 4, 4), w, h, image_format,
+                             [&](uint8_t *src, uint8_t **out, size_t *outsize) {
+        return DecompressBc3ToImageBytes(src, w, h, jobs, image_format, out, outsize);
+    });
+}
+
+static PyObject *_DecompressBc4ToImageBytes(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    int w, h, jobs = 1, image_format = 0;
+    if (!PyArg_ParseTuple(args, "y*ii|ii", &data, &w, &h, &jobs, &image_format))
+        return NULL;
+    return decompressToImage(&data, BlockImageBytes(TEXTURE2D_FORMAT_BC4, w, h, 4, 4), w, h, image_format,
+                             [&](uint8_t *src, uint8_t **out, size_t *outsize) {
+        return DecompressBc4ToImageBytes(src, w, h, jobs, image_format, out, outsize);
+    });
+}
+
+static PyObject *_DecompressBc5ToImageBytes(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    int w, h, jobs = 1, image_format = 0;
+    if (!PyArg_ParseTuple(args, "y*ii|ii", &data, &w, &h, &jobs, &image_format))
+        return NULL;
+    return decompressToImage(&data, BlockImageBytes(TEXTURE2D_FORMAT_BC5, w, h, 4, 4), w, h, image_format,
+                             [&](uint8_t *src, uint8_t **out, size_t *outsize) {
+        return DecompressBc5ToImageBytes(src, w, h, jobs, image_format, out, outsize);
+    });
+}
+
+static PyObject *_DecompressBc6ToImageBytes(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    int w, h, jobs = 1, image_format = 0;
+    if (!PyArg_ParseTuple(args, "y*ii|ii", &data, &w, &h, &jobs, &image_format))
+        return NULL;
+    return decompressToImage(&data, BlockImageBytes(TEXTURE2D_FORMAT_BC6, w, h, 4, 4), w, h, image_format,
+                             [&](uint8_t *src, uint8_t **out, size_t *outsize) {
+        return DecompressBc6ToImageBytes(src, w, h, jobs, image_format, out, outsize);
+    });
+}
+
+static PyObject *_DecompressBc7ToImageBytes(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    int w, h, jobs = 1, image_format = 0;
+    if (!PyArg_ParseTuple(args, "y*ii|ii", &data, &w, &h, &jobs, &image_format))
+        return NULL;
+    return decompressToImage(&data, BlockImageBytes(TEXTURE2D_FORMAT_BC7, w, h, 4, 4), w, h, image_format,
+                             [&](uint8_t *src, uint8_t **out, size_t *outsize) {
+        return DecompressBc7ToImageBytes(src, w, h, jobs, image_format, out, outsize);
+    });
+}
+
+static PyObject *_DecodeContainer(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    int level = 0, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "y*|iii", &data, &level, &jobs, &output_format))
+        return NULL;
+    Texture2dContainerLevel info;
+    if (!ParseContainer((const uint8_t *) data.buf, (size_t) data.len, level, &info)) {
+        PyBuffer_Release(&data);
+        PyErr_SetString(PyExc_ValueError, "not a supported KTX, .astc or PKM file, or no such level");
+        return NULL;
+    }
+    size_t size = (size_t) data.len;
+    size_t data_bytes = info.offset + BlockImageBytes(info.format, info.width, info.height, info.block_width,
+                                                      info.block_height);
+    PyObject *pixels = decompressToBytes(&data, data_bytes, (int) info.width, (int) info.height, output_format,
+                                         [&](uint8_t *src, uint8_t *out) {
+        return DecodeContainerInto(src, size, level, jobs, output_format, out);
+    });
+    if (pixels == NULL)
+        return NULL;
+    return Py_BuildValue("Nll", pixels, info.width, info.height);
+}
+
+static PyObject *_DecompressRegion(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    int format, w, h, x, y, rw, rh, block_width = 4, block_height = 4, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "iy*iiiiii|iiii", &format, &data, &w, &h, &x, &y, &rw, &rh, &block_width,
+                          &block_height, &jobs, &output_format))
+        return NULL;
+    if (format < TEXTURE2D_FORMAT_ETC1 || format > TEXTURE2D_FORMAT_EAC_RG11_SIGNED) {
+        PyBuffer_Release(&data);
+        PyErr_SetString(PyExc_ValueError, "unknown format");
+        return NULL;
+    }
+    if (x < 0 || y < 0 || rw <= 0 || rh <= 0 || x > w - rw || y > h - rh) {
+        PyBuffer_Release(&data);
+        PyErr_SetString(PyExc_ValueError, "region must lie inside the w * h image");
+        return NULL;
+    }
+    // data is the whole w * h block image, the region is gathered from it
+    size_t data_bytes = BlockImageBytes(format, w, h, block_width, block_height);
+    if (data_bytes == 0) {
+        PyBuffer_Release(&data);
+        PyErr_Format(PyExc_ValueError, "unsupported astc block footprint %dx%d", block_width, block_height);
+        return NULL;
+    }
+    return decompressToBytes(&data, data_bytes, rw, rh, output_format, [&](uint8_t *src, uint8_t *out) {
+        return DecompressRegionInto(format, src, w, h, x, y, rw, rh, block_width, block_height, jobs, output_format,
+                                    out);
+    });
+}
+
+static PyObject *_TranscodeEtcToBc(PyObject *self, PyObject *args)
+{
+    // define vars
+    Py_buffer data;
+    int w, h, etc_format, bc_format, jobs = 1;
+    if (!PyArg_ParseTuple(args, "y*iiii|i", &data, &w, &h, &etc_format, &bc_format, &jobs))
+        return NULL;
+    if (!checkDataBytes(&data, BlockImageBytes(etc_format, w, h, 4, 4)))
+        return NULL;
+    uint8_t *dst = nullptr;
+    size_t size = 0;
+    int result;
+    Py_BEGIN_ALLOW_THREADS
+    result = TranscodeEtcToBc((uint8_t *) data.buf, w, h, etc_format, bc_format, jobs, &dst, &size);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&data);
+    if (result == 0) {
+        PyErr_SetString(PyExc_ValueError, "unsupported format pair or empty image");
+        return NULL;
+    }
+    PyObject *res = PyBytes_FromStringAndSize((const char *) dst, (Py_ssize_t) size);
+    free(dst);
+    return res;
+}
+
+// ================ batch compress
+
+
+// Reads an optional number from the params dict, keeping the default when the key is missing
+static int paramNumber(PyObject *params, const char *key, double *value)
+{
+    PyObject *item = params == Py_None ? NULL : PyDict_GetItemString(params, key);
+    if (item == NULL)
+        return 1;
+    double v = PyFloat_AsDouble(item);
+    if (v == -1.0 && PyErr_Occurred())
+        return 0;
+    *value = v;
+    return 1;
+}
+
+// Fills compress params from an optional dict of fEffort, mipmap, jobs, block_x/y/z and header
+static int parseParams(PyObject *params, Texture2dCompressParams *out)
+{
+    if (params != Py_None && !PyDict_Check(params)) {
+        PyErr_SetString(PyExc_TypeError, "params must be a dict");
+        return 0;
+    }
+    double fEffort = ASTCENC_DEFAULT_LEVEL, mipmap = 0, jobs = 1, block_x = 4, block_y = 4, block_z = 1, header = 0;
+    if (!paramNumber(params, "fEffort", &fEffort) || !paramNumber(params, "mipmap", &mipmap) ||
+        !paramNumber(params, "jobs", &jobs) || !paramNumber(params, "block_x", &block_x) ||
+        !paramNumber(params, "block_y", &block_y) || !paramNumber(params, "block_z", &block_z) ||
+        !paramNumber(params, "header", &header))
+        return 0;
+    out->fEffort = (float) fEffort;
+    out->mipmap = (int) mipmap;
+    out->jobs = (int) jobs;
+    out->block_x = (unsigned int) block_x;
+    out->block_y = (unsigned int) block_y;
+    out->block_z = (unsigned int) block_z;
+    out->header = (int) header;
+    return 1;
+}
+
+// An image is an encoded png buffer or a (pixels, width, height[, stride]) raw rgba8 tuple.
+// On success the buffer is held and must be released by the caller.
+static int parseImage(PyObject *image, Py_buffer *buffer, Texture2dBatchItem *item)
+{
+    if (PyTuple_Check(image)) {
+        int width, height;
+        Py_ssize_t stride = 0;
+        if (!PyArg_ParseTuple(image, "y*ii|n", buffer, &width, &height, &stride))
+            return 0;
+        if (!checkRawPixels(buffer, width, height, &stride)) {
+            PyBuffer_Release(buffer);
+            return 0;
+        }
+        item->width = width;
+        item->height = height;
+        item->stride = stride;
+    } else {
+        if (PyObject_GetBuffer(image, buffer, PyBUF_SIMPLE) < 0)
+            return 0;
+        item->width = 0;
+        item->height = 0;
+        item->stride = 0;
+    }
+    item->src = (const uint8_t *) buffer->buf;
+    item->size = buffer->len;
+    return 1;
+}
+
+static int checkFormat(int format)
+{
+    if (format < TEXTURE2D_FORMAT_ETC1 || format > TEXTURE2D_FORMAT_ASTC) {
+        PyErr_SetString(PyExc_ValueError, "unknown format");
+        return 0;
+    }
+    return 1;
+}
+
+static PyObject *_CompressBatch(PyObject *self, PyObject *args)
+{
+    // define vars
+    PyObject *images;
+    int format;
+    PyObject *params = Py_None;
+    if (!PyArg_ParseTuple(args, "Oi|O", &images, &format, &params))
+        return NULL;
+
+    Texture2dCompressParams compressParams;
+    if (!checkFormat(format) || !parseParams(params, &compressParams))
+        return NULL;
+
+    PyObject *seq = PySequence_Fast(images, "images must be a sequence");
+    if (seq == NULL)
+        return NULL;
+    Py_ssize_t count = PySequence_Fast_GET_SIZE(seq);
+
+    std::vector<Py_buffer> buffers((size_t) count);
+    std::vector<Texture2dBatchItem> items((size_t) count);
+    Py_ssize_t acquired = 0;
+    while (acquired < count && parseImage(PySequence_Fast_GET_ITEM(seq, acquired), &buffers[acquired],
+                                          &items[acquired]))
+        acquired++;
+    if (acquired < count) {
+        for (Py_ssize_t i = 0; i < acquired; i++)
+            PyBuffer_Release(&buffers[i]);
+        Py_DECREF(seq);
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    CompressBatch(items.data(), items.size(), format, &compressParams);
+    Py_END_ALLOW_THREADS
+    for (Py_ssize_t i = 0; i < count; i++)
+        PyBuffer_Release(&buffers[i]);
+    Py_DECREF(seq);
+
+    // failed images come back as None
+    PyObject *res = PyList_New(count);
+    for (Py_ssize_t i = 0; i < count; i++) {
+        Texture2dBatchItem &item = items[i];
+        if (res != NULL) {
+            PyObject *value;
+            if (item.ok == 1) {
+                value = PyBytes_FromStringAndSize((const char *) item.dst, item.filesize);
+            } else {
+                Py_INCREF(Py_None);
+                value = Py_None;
+            }
+            if (value == NULL)
+                Py_CLEAR(res);
+            else
+                PyList_SET_ITEM(res, i, value);
+        }
+        free(item.dst);
+    }
     return res;
 }
 
-static PyObject *_CompressEtc2RGBWithFile(PyObject *self, PyObject *args)
+
+// ================ async submit
+
+
+// concurrent.futures.Future subclass that asyncio code can await directly
+static PyObject *FutureType = NULL;
+
+static PyObject *Future_await(PyObject *self)
 {
-    // define vars
-    char *input;
-    char *output;
-    int mipmap, fEffort, jobs;
-    if (!PyArg_ParseTuple(args, "ssiii", &input, &output, &mipmap, &fEffort, &jobs))
+    PyObject *asyncio = PyImport_ImportModule("asyncio");
+    if (asyncio == NULL)
         return NULL;
-    int result = CompressEtc2RGBWithFile(input, output, mipmap, fEffort, jobs);
-    PyObject *res = Py_BuildValue("i", result);
+    PyObject *wrapped = PyObject_CallMethod(asyncio, "wrap_future", "O", self);
+    Py_DECREF(asyncio);
+    if (wrapped == NULL)
+        return NULL;
+    PyObject *res = PyObject_CallMethod(wrapped, "__await__", NULL);
+    Py_DECREF(wrapped);
     return res;
 }
 
-static PyObject *_CompressEtc2RGBAWithFile(PyObject *self, PyObject *args)
+static PyType_Slot Future_slots[] = {
+    {Py_am_await, (void *) Future_await},
+    {0, NULL}
+};
+
+static PyType_Spec Future_spec = {
+    "pytexture2dstudio.Future",
+    0,
+    0,
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,
+    Future_slots
+};
+
+static PyObject *_WaitJobs(PyObject *self, PyObject *args)
 {
-    // define vars
-    char *input;
-    char *output;
-    int mipmap, fEffort, jobs;
-    if (!PyArg_ParseTuple(args, "ssiii", &input, &output, &mipmap, &fEffort, &jobs))
-        return NULL;
-    int result = CompressEtc2RGBAWithFile(input, output, mipmap, fEffort, jobs);
-    PyObject *res = Py_BuildValue("i", result);
-    return res;
+    Py_BEGIN_ALLOW_THREADS
+    WaitJobs();
+    Py_END_ALLOW_THREADS
+    Py_RETURN_NONE;
 }
 
+static PyMethodDef WaitJobs_def = {"WaitJobs", (PyCFunction) _WaitJobs, METH_NOARGS, NULL};
 
-// ====================astc compress
+// Built on first Submit; also makes the interpreter drain the queue at exit, since finishing a job
+// takes the GIL and must not happen after finalization.
+static int initSubmit()
+{
+    if (FutureType != NULL)
+        return 1;
+    PyObject *futures = PyImport_ImportModule("concurrent.futures");
+    if (futures == NULL)
+        return 0;
+    PyObject *base = PyObject_GetAttrString(futures, "Future");
+    Py_DECREF(futures);
+    if (base == NULL)
+        return 0;
+    PyObject *bases = PyTuple_Pack(1, base);
+    Py_DECREF(base);
+    if (bases == NULL)
+        return 0;
+    PyObject *type = PyType_FromSpecWithBases(&Future_spec, bases);
+    Py_DECREF(bases);
+    if (type == NULL)
+        return 0;
 
+    PyObject *atexit = PyImport_ImportModule("atexit");
+    PyObject *wait = PyCFunction_New(&WaitJobs_def, NULL);
+    PyObject *registered = atexit && wait ? PyObject_CallMethod(atexit, "register", "O", wait) : NULL;
+    Py_XDECREF(atexit);
+    Py_XDECREF(wait);
+    if (registered == NULL) {
+        Py_DECREF(type);
+        return 0;
+    }
+    Py_DECREF(registered);
+    FutureType = type;
+    return 1;
+}
 
-static PyObject *_CompressAstc(PyObject *self, PyObject *args)
+typedef struct {
+    PyObject *future;
+    Py_buffer buffer;
+    int cancelled;
+} SubmitJob;
+
+// worker thread: marks the future running, or reports it was cancelled while queued
+static int submitStart(void *userdata)
+{
+    auto *job = (SubmitJob *) userdata;
+    PyGILState_STATE gil = PyGILState_Ensure();
+    PyObject *running = PyObject_CallMethod(job->future, "set_running_or_notify_cancel", NULL);
+    job->cancelled = running == NULL || !PyObject_IsTrue(running);
+    if (running == NULL)
+        PyErr_WriteUnraisable(job->future);
+    Py_XDECREF(running);
+    PyGILState_Release(gil);
+    return !job->cancelled;
+}
+
+// worker thread: publishes the result and drops the job's references
+static void submitDone(void *userdata, int ok, uint8_t *dst, size_t filesize)
+{
+    auto *job = (SubmitJob *) userdata;
+    PyGILState_STATE gil = PyGILState_Ensure();
+    PyBuffer_Release(&job->buffer);
+    if (!job->cancelled) {
+        PyObject *res;
+        if (ok == 1) {
+            PyObject *value = PyBytes_FromStringAndSize((const char *) dst, filesize);
+            res = value == NULL ? NULL : PyObject_CallMethod(job->future, "set_result", "O", value);
+            Py_XDECREF(value);
+        } else {
+            PyObject *error = PyObject_CallFunction(PyExc_RuntimeError, "s", "compress failed");
+            res = error == NULL ? NULL : PyObject_CallMethod(job->future, "set_exception", "O", error);
+            Py_XDECREF(error);
+        }
+        if (res == NULL)
+            PyErr_WriteUnraisable(job->future);
+        Py_XDECREF(res);
+    }
+    Py_DECREF(job->future);
+    PyGILState_Release(gil);
+    free(dst);
+    delete job;
+}
+
+static PyObject *_Submit(PyObject *self, PyObject *args)
 {
     // define vars
-    uint8_t *data;
-    size_t data_size;
-    int fEffort, block_x, block_y, block_z, header;
+    int format;
+    PyObject *image;
+    PyObject *params = Py_None;
+    if (!PyArg_ParseTuple(args, "iO|O", &format, &image, &params))
+        return NULL;
 
-    if (!PyArg_ParseTuple(args, "y#iiiii", &data, &data_size, &fEffort, &block_x, &block_y, &block_z, &header))
+    Texture2dCompressParams compressParams;
+    if (!checkFormat(format) || !parseParams(params, &compressParams) || !initSubmit())
         return NULL;
 
-    uint8_t *out = nullptr;
-    size_t outsize = 0;
+    PyObject *future = PyObject_CallObject(FutureType, NULL);
+    if (future == NULL)
+        return NULL;
 
-    if (CompressAstc(data, data_size, fEffort, block_x, block_y, block_z, header, &out, &outsize) == 0) {
+    auto *job = new SubmitJob();
+    Texture2dBatchItem item;
+    if (!parseImage(image, &job->buffer, &item)) {
+        delete job;
+        Py_DECREF(future);
         return NULL;
     }
+    Py_INCREF(future);
+    job->future = future;
 
-    PyObject *res = Py_BuildValue("y#", out, outsize);
-    free(out);
-    return res;
+    Py_BEGIN_ALLOW_THREADS
+    SubmitCompress(&item, format, &compressParams, submitStart, submitDone, job);
+    Py_END_ALLOW_THREADS
+    return future;
 }
 
-static PyObject *_CompressAstcWithFile(PyObject *self, PyObject *args)
+static PyObject *_SetJobLimits(PyObject *self, PyObject *args)
 {
     // define vars
-    char *input;
-    char *output;
-    int fEffort, block_x, block_y, block_z;
-
-    if (!PyArg_ParseTuple(args, "ssiiii", &input, &output, &fEffort, &block_x, &block_y, &block_z))
+    unsigned int concurrency, max_pending = 0;
+    if (!PyArg_ParseTuple(args, "I|I", &concurrency, &max_pending))
         return NULL;
-
-    int result = CompressAstcWithFile(input, output, fEffort, block_x, block_y, block_z);
-    PyObject *res = Py_BuildValue("i", result);
-    return res;
+    SetJobLimits(concurrency, max_pending);
+    Py_RETURN_NONE;
 }
 
 
-// ================ decode
+// ================ persistent encoders
 
 
-static PyObject *_DecompressEtc1(PyObject *self, PyObject *args)
+typedef struct {
+    PyObject_HEAD
+    AstcEncoder *encoder;
+} AstcEncoderObject;
+
+static int AstcEncoder_init(AstcEncoderObject *self, PyObject *args, PyObject *kwds)
 {
     // define vars
-    uint8_t *data;
-    size_t data_size;
-    int w, h;
-    if (!PyArg_ParseTuple(args, "y#ii", &data, &data_size, &w, &h))
-        return NULL;
-    uint32_t *out = nullptr;
-    size_t outsize = 0;
-    if (DecompressEtc1(data, w, h, &out, &outsize) == 0) {
-        return NULL;
+    int fEffort, block_x, block_y, block_z;
+    int profile = 1, flags = 0, threads = 1;
+    if (!PyArg_ParseTuple(args, "iiii|iii", &fEffort, &block_x, &block_y, &block_z, &profile, &flags, &threads))
+        return -1;
+    if (threads < 1) {
+        PyErr_SetString(PyExc_ValueError, "threads must be at least 1");
+        return -1;
     }
-    PyObject *res = Py_BuildValue("y#", out, outsize);
-    free(out);
-    return res;
+    // compress calls use the encoder without the GIL, so it is never replaced once set
+    if (self->encoder != nullptr) {
+        PyErr_SetString(PyExc_TypeError, "AstcEncoder is already initialized");
+        return -1;
+    }
+    AstcEncoder *encoder;
+    Py_BEGIN_ALLOW_THREADS
+    encoder = AstcEncoderCreate(profile, fEffort, block_x, block_y, block_z, flags, threads);
+    Py_END_ALLOW_THREADS
+    if (encoder == nullptr) {
+        PyErr_SetString(PyExc_ValueError, "invalid astc encoder settings");
+        return -1;
+    }
+    // another __init__ may have finished while the GIL was released
+    if (self->encoder != nullptr) {
+        AstcEncoderFree(encoder);
+        PyErr_SetString(PyExc_TypeError, "AstcEncoder is already initialized");
+        return -1;
+    }
+    self->encoder = encoder;
+    return 0;
 }
 
-static PyObject *_DecompressEtc2(PyObject *self, PyObject *args)
+static void AstcEncoder_dealloc(AstcEncoderObject *self)
+{
+    AstcEncoderFree(self->encoder);
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+static PyObject *AstcEncoder_Compress(AstcEncoderObject *self, PyObject *args)
 {
     // define vars
-    uint8_t *data;
-    size_t data_size;
-    int w, h;
-    if (!PyArg_ParseTuple(args, "y#ii", &data, &data_size, &w, &h))
+    Py_buffer data;
+    int header = 0;
+    if (!PyArg_ParseTuple(args, "y*|i", &data, &header))
+        return NULL;
+    if (self->encoder == nullptr) {
+        PyBuffer_Release(&data);
+        PyErr_SetString(PyExc_RuntimeError, "encoder is not initialized");
         return NULL;
-    uint32_t *out = nullptr;
+    }
+
+    uint8_t *out = nullptr;
     size_t outsize = 0;
-    if (DecompressEtc2(data, w, h, &out, &outsize) == 0) {
+
+    int ok;
+    Py_BEGIN_ALLOW_THREADS
+    ok = AstcEncoderCompress(self->encoder, (uint8_t *) data.buf, data.len, header, &out, &outsize);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&data);
+    if (ok == 0) {
+        PyErr_SetString(PyExc_RuntimeError, "astc compress failed");
         return NULL;
     }
+
     PyObject *res = Py_BuildValue("y#", out, outsize);
     free(out);
     return res;
 }
 
-static PyObject *_DecompressEtc2a1(PyObject *self, PyObject *args)
+static PyObject *AstcEncoder_CompressRaw(AstcEncoderObject *self, PyObject *args)
 {
     // define vars
-    uint8_t *data;
-    size_t data_size;
-    int w, h;
-    if (!PyArg_ParseTuple(args, "y#ii", &data, &data_size, &w, &h))
+    Py_buffer pixels;
+    int width, height, header = 0;
+    Py_ssize_t stride = 0;
+    if (!PyArg_ParseTuple(args, "y*ii|ni", &pixels, &width, &height, &stride, &header))
         return NULL;
-    uint32_t *out = nullptr;
+    if (!checkRawPixels(&pixels, width, height, &stride)) {
+        PyBuffer_Release(&pixels);
+        return NULL;
+    }
+    if (self->encoder == nullptr) {
+        PyBuffer_Release(&pixels);
+        PyErr_SetString(PyExc_RuntimeError, "encoder is not initialized");
+        return NULL;
+    }
+
+    uint8_t *out = nullptr;
     size_t outsize = 0;
-    if (DecompressEtc2a1(data, w, h, &out, &outsize) == 0) {
+
+    int ok;
+    Py_BEGIN_ALLOW_THREADS
+    ok = AstcEncoderCompressRaw(self->encoder, (uint8_t *) pixels.buf, width, height, stride, header, &out, &outsize);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&pixels);
+    if (ok == 0) {
+        PyErr_SetString(PyExc_RuntimeError, "astc compress failed");
         return NULL;
     }
+
     PyObject *res = Py_BuildValue("y#", out, outsize);
     free(out);
     return res;
 }
 
-static PyObject *_DecompressEtc2a8(PyObject *self, PyObject *args)
+static PyMethodDef AstcEncoder_methods[] = {
+    {"Compress",
+     (PyCFunction)AstcEncoder_Compress,
+     METH_VARARGS,
+     "buffer data, int header=0"},
+    {"CompressRaw",
+     (PyCFunction)AstcEncoder_CompressRaw,
+     METH_VARARGS,
+     "buffer rgba8 pixels, int width, int height, int stride=0, int header=0"},
+    {NULL,
+     NULL,
+     0,
+     NULL} // Sentinel value ending the table
+};
+
+static PyTypeObject AstcEncoderType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pytexture2dstudio.AstcEncoder",
+    sizeof(AstcEncoderObject),
+};
+
+
+typedef struct {
+    PyObject_HEAD
+    EtcEncoder *encoder;
+} EtcEncoderObject;
+
+static int EtcEncoder_init(EtcEncoderObject *self, PyObject *args, PyObject *kwds)
+{
+    // define vars
+    int format, mipmap, fEffort, jobs;
+    if (!PyArg_ParseTuple(args, "iiii", &format, &mipmap, &fEffort, &jobs))
+        return -1;
+    // compress calls use the encoder without the GIL, so it is never replaced once set
+    if (self->encoder != nullptr) {
+        PyErr_SetString(PyExc_TypeError, "EtcEncoder is already initialized");
+        return -1;
+    }
+    self->encoder = EtcEncoderCreate(format, mipmap, fEffort, jobs);
+    if (self->encoder == nullptr) {
+        PyErr_SetString(PyExc_ValueError, "invalid etc encoder settings");
+        return -1;
+    }
+    return 0;
+}
+
+static void EtcEncoder_dealloc(EtcEncoderObject *self)
+{
+    EtcEncoderFree(self->encoder);
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+static PyObject *EtcEncoder_Compress(EtcEncoderObject *self, PyObject *args)
 {
     // define vars
-    uint8_t *data;
-    size_t data_size;
-    int w, h;
-    if (!PyArg_ParseTuple(args, "y#ii", &data, &data_size, &w, &h))
+    Py_buffer data;
+    int header = 0;
+    if (!PyArg_ParseTuple(args, "y*|i", &data, &header))
         return NULL;
-    uint32_t *out = nullptr;
+    if (self->encoder == nullptr) {
+        PyBuffer_Release(&data);
+        PyErr_SetString(PyExc_RuntimeError, "encoder is not initialized");
+        return NULL;
+    }
+
+    uint8_t *out = nullptr;
     size_t outsize = 0;
-    if (DecompressEtc2a8(data, w, h, &out, &outsize) == 0) {
+
+    int ok;
+    Py_BEGIN_ALLOW_THREADS
+    ok = EtcEncoderCompress(self->encoder, (uint8_t *) data.buf, data.len, header, &out, &outsize);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&data);
+    if (ok == 0) {
+        PyErr_SetString(PyExc_RuntimeError, "etc compress failed");
         return NULL;
     }
+
     PyObject *res = Py_BuildValue("y#", out, outsize);
     free(out);
     return res;
 }
 
-static PyObject *_DecompressAstc(PyObject *self, PyObject *args)
+static PyObject *EtcEncoder_CompressRaw(EtcEncoderObject *self, PyObject *args)
 {
     // define vars
-    uint8_t *data;
-    size_t data_size;
-    int w, h, block_width, block_height;
-    if (!PyArg_ParseTuple(args, "y#iiii", &data, &data_size, &w, &h, &block_width, &block_height))
+    Py_buffer pixels;
+    int width, height, header = 0;
+    Py_ssize_t stride = 0;
+    if (!PyArg_ParseTuple(args, "y*ii|ni", &pixels, &width, &height, &stride, &header))
+        return NULL;
+    if (!checkRawPixels(&pixels, width, height, &stride)) {
+        PyBuffer_Release(&pixels);
+        return NULL;
+    }
+    if (self->encoder == nullptr) {
+        PyBuffer_Release(&pixels);
+        PyErr_SetString(PyExc_RuntimeError, "encoder is not initialized");
         return NULL;
-    uint32_t *out = nullptr;
+    }
+
+    uint8_t *out = nullptr;
     size_t outsize = 0;
-    if (DecompressAstc(data, w, h, block_width, block_height, &out, &outsize) == 0) {
+
+    int ok;
+    Py_BEGIN_ALLOW_THREADS
+    ok = EtcEncoderCompressRaw(self->encoder, (uint8_t *) pixels.buf, width, height, stride, header, &out, &outsize);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&pixels);
+    if (ok == 0) {
+        PyErr_SetString(PyExc_RuntimeError, "etc compress failed");
         return NULL;
     }
+
     PyObject *res = Py_BuildValue("y#", out, outsize);
     free(out);
     return res;
 }
 
-static PyObject *_DecompressEtc1ToFile(PyObject *self, PyObject *args)
+static PyMethodDef EtcEncoder_methods[] = {
+    {"Compress",
+     (PyCFunction)EtcEncoder_Compress,
+     METH_VARARGS,
+     "buffer data, int header=0"},
+    {"CompressRaw",
+     (PyCFunction)EtcEncoder_CompressRaw,
+     METH_VARARGS,
+     "buffer rgba8 pixels, int width, int height, int stride=0, int header=0"},
+    {NULL,
+     NULL,
+     0,
+     NULL} // Sentinel value ending the table
+};
+
+static PyTypeObject EtcEncoderType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pytexture2dstudio.EtcEncoder",
+    sizeof(EtcEncoderObject),
+};
+
+typedef struct {
+    PyObject_HEAD
+    CrunchDecoder *decoder;
+} CrunchDecoderObject;
+
+static int CrunchDecoder_init(CrunchDecoderObject *self, PyObject *args, PyObject *kwds)
 {
     // define vars
-    uint8_t *data;
-    size_t data_size;
-    char *output;
-    int w, h;
-    if (!PyArg_ParseTuple(args, "y#sii", &data, &data_size, &output, &w, &h))
-        return NULL;
-    int result = DecompressEtc1ToFile(data, w, h, output);
-    PyObject *res = Py_BuildValue("i", result);
-    return res;
+    Py_buffer data;
+    if (!PyArg_ParseTuple(args, "y*", &data))
+        return -1;
+    // decode calls use the decoder without the GIL, so it is never replaced once set
+    if (self->decoder != nullptr) {
+        PyBuffer_Release(&data);
+        PyErr_SetString(PyExc_TypeError, "CrunchDecoder is already initialized");
+        return -1;
+    }
+    CrunchDecoder *decoder;
+    Py_BEGIN_ALLOW_THREADS
+    decoder = CrunchDecoderCreate((const uint8_t *) data.buf, (size_t) data.len);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&data);
+    if (decoder == nullptr) {
+        PyErr_SetString(PyExc_ValueError, "not a crunch file, or it unpacks to an unsupported format");
+        return -1;
+    }
+    // another __init__ may have finished while the GIL was released
+    if (self->decoder != nullptr) {
+        CrunchDecoderFree(decoder);
+        PyErr_SetString(PyExc_TypeError, "CrunchDecoder is already initialized");
+        return -1;
+    }
+    self->decoder = decoder;
+    return 0;
 }
 
-static PyObject *_DecompressEtc2ToFile(PyObject *self, PyObject *args)
+static void CrunchDecoder_dealloc(CrunchDecoderObject *self)
 {
-    // define vars
-    uint8_t *data;
-    size_t data_size;
-    char *output;
-    int w, h;
-    if (!PyArg_ParseTuple(args, "y#sii", &data, &data_size, &output, &w, &h))
-        return NULL;
-    int result = DecompressEtc2ToFile(data, w, h, output);
-    PyObject *res = Py_BuildValue("i", result);
-    return res;
+    CrunchDecoderFree(self->decoder);
+    Py_TYPE(self)->tp_free((PyObject *) self);
 }
 
-static PyObject *_DecompressEtc2a1ToFile(PyObject *self, PyObject *args)
+static PyObject *CrunchDecoder_Info(CrunchDecoderObject *self, PyObject *args)
 {
-    // define vars
-    uint8_t *data;
-    size_t data_size;
-    char *output;
-    int w, h;
-    if (!PyArg_ParseTuple(args, "y#sii", &data, &data_size, &output, &w, &h))
+    if (self->decoder == nullptr) {
+        PyErr_SetString(PyExc_RuntimeError, "decoder is not initialized");
         return NULL;
-    int result = DecompressEtc2a1ToFile(data, w, h, output);
-    PyObject *res = Py_BuildValue("i", result);
-    return res;
+    }
+    Texture2dCrunchInfo info;
+    CrunchDecoderGetInfo(self->decoder, &info);
+    return Py_BuildValue("(illii)", info.format, info.width, info.height, info.levels, info.faces);
 }
 
-static PyObject *_DecompressEtc2a8ToFile(PyObject *self, PyObject *args)
+static PyObject *CrunchDecoder_Decode(CrunchDecoderObject *self, PyObject *args)
 {
     // define vars
-    uint8_t *data;
-    size_t data_size;
-    char *output;
-    int w, h;
-    if (!PyArg_ParseTuple(args, "y#sii", &data, &data_size, &output, &w, &h))
+    int level = 0, face = 0, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "|iiii", &level, &face, &jobs, &output_format))
         return NULL;
-    int result = DecompressEtc2a8ToFile(data, w, h, output);
-    PyObject *res = Py_BuildValue("i", result);
-    return res;
+    if (self->decoder == nullptr) {
+        PyErr_SetString(PyExc_RuntimeError, "decoder is not initialized");
+        return NULL;
+    }
+    if (OutputFormatBytes(output_format) == 0) {
+        PyErr_SetString(PyExc_ValueError, "unknown output_format");
+        return NULL;
+    }
+    long w, h;
+    if (!CrunchDecoderLevelSize(self->decoder, level, &w, &h)) {
+        PyErr_SetString(PyExc_ValueError, "no such level");
+        return NULL;
+    }
+    PyObject *res = PyBytes_FromStringAndSize(NULL, (Py_ssize_t) w * h * OutputFormatBytes(output_format));
+    if (res == NULL)
+        return NULL;
+    uint8_t *out = (uint8_t *) PyBytes_AS_STRING(res);
+    int ok;
+    Py_BEGIN_ALLOW_THREADS
+    ok = CrunchDecoderDecodeInto(self->decoder, level, face, jobs, output_format, out);
+    Py_END_ALLOW_THREADS
+    if (ok == 0) {
+        Py_DECREF(res);
+        PyErr_SetString(PyExc_RuntimeError, "crunch decode failed");
+        return NULL;
+    }
+    return Py_BuildValue("(Nll)", res, w, h);
 }
 
-static PyObject *_DecompressAstcToFile(PyObject *self, PyObject *args)
+static PyObject *CrunchDecoder_DecodeInto(CrunchDecoderObject *self, PyObject *args)
 {
     // define vars
-    uint8_t *data;
-    size_t data_size;
-    char *output;
-    int w, h, block_width, block_height;
-    if (!PyArg_ParseTuple(args, "y#siiii", &data, &data_size, &output, &w, &h, &block_width, &block_height))
+    Py_buffer out;
+    int level = 0, face = 0, jobs = 1, output_format = 0;
+    if (!PyArg_ParseTuple(args, "w*|iiii", &out, &level, &face, &jobs, &output_format))
         return NULL;
-    int result = DecompressAstcToFile(data, w, h, block_width, block_height, output);
-    PyObject *res = Py_BuildValue("i", result);
-    return res;
+    if (self->decoder == nullptr) {
+        PyBuffer_Release(&out);
+        PyErr_SetString(PyExc_RuntimeError, "decoder is not initialized");
+        return NULL;
+    }
+    long w, h;
+    if (!CrunchDecoderLevelSize(self->decoder, level, &w, &h) || OutputFormatBytes(output_format) == 0 ||
+        out.len < (Py_ssize_t) w * h * OutputFormatBytes(output_format)) {
+        PyBuffer_Release(&out);
+        PyErr_SetString(PyExc_ValueError, "no such level, unknown output_format or out_buffer too small");
+        return NULL;
+    }
+    int ok;
+    Py_BEGIN_ALLOW_THREADS
+    ok = CrunchDecoderDecodeInto(self->decoder, level, face, jobs, output_format, (uint8_t *) out.buf);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&out);
+    if (ok == 0) {
+        PyErr_SetString(PyExc_RuntimeError, "crunch decode failed");
+        return NULL;
+    }
+    return Py_BuildValue("(ll)", w, h);
 }
 
+static PyMethodDef CrunchDecoder_methods[] = {
+    {"Info",
+     (PyCFunction)CrunchDecoder_Info,
+     METH_NOARGS,
+     "returns (format, width, height, levels, faces), format is the block format decoded: "
+     "0 etc1, 1 etc2 rgb, 2 etc2 rgba, 5 bc1, 6 bc3, 7 bc4, 8 bc5"},
+    {"Decode",
+     (PyCFunction)CrunchDecoder_Decode,
+     METH_VARARGS,
+     "int level=0, int face=0, int jobs=1, int output_format=0; returns (pixels, width, height)"},
+    {"DecodeInto",
+     (PyCFunction)CrunchDecoder_DecodeInto,
+     METH_VARARGS,
+     "writable buffer out_buffer, int level=0, int face=0, int jobs=1, int output_format=0; "
+     "returns (width, height)"},
+    {NULL,
+     NULL,
+     0,
+     NULL} // Sentinel value ending the table
+};
+
+static PyTypeObject CrunchDecoderType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pytexture2dstudio.CrunchDecoder",
+    sizeof(CrunchDecoderObject),
+};
+
 /*
  *************************************************
  *
@@ -333,15 +2095,27 @@ static struct PyMethodDef method_table[] = {
     {"CompressEtc1",
      (PyCFunction)_CompressEtc1,
      METH_VARARGS,
-     "bytes data, size_t data_size, int mipmap, int fEffort, int jobs, int header"},
+     "buffer data, int mipmap, int fEffort, int jobs, int header"},
      {"CompressEtc2RGB",
      (PyCFunction)_CompressEtc2RGB,
      METH_VARARGS,
-     "bytes data, size_t data_size, int mipmap, int fEffort, int jobs, int header"},
+     "buffer data, int mipmap, int fEffort, int jobs, int header"},
      {"CompressEtc2RGBA",
      (PyCFunction)_CompressEtc2RGBA,
      METH_VARARGS,
-     "bytes data, size_t data_size, int mipmap, int fEffort, int jobs, int header"},
+     "buffer data, int mipmap, int fEffort, int jobs, int header"},
+     {"CompressEtc1Raw",
+     (PyCFunction)_CompressEtc1Raw,
+     METH_VARARGS,
+     "buffer rgba8 pixels, int width, int height, int stride, int mipmap, int fEffort, int jobs, int header"},
+     {"CompressEtc2RGBRaw",
+     (PyCFunction)_CompressEtc2RGBRaw,
+     METH_VARARGS,
+     "buffer rgba8 pixels, int width, int height, int stride, int mipmap, int fEffort, int jobs, int header"},
+     {"CompressEtc2RGBARaw",
+     (PyCFunction)_CompressEtc2RGBARaw,
+     METH_VARARGS,
+     "buffer rgba8 pixels, int width, int height, int stride, int mipmap, int fEffort, int jobs, int header"},
      {"CompressEtc1WithFile",
      (PyCFunction)_CompressEtc1WithFile,
      METH_VARARGS,
@@ -357,7 +2131,11 @@ static struct PyMethodDef method_table[] = {
      {"CompressAstc",
      (PyCFunction)_CompressAstc,
      METH_VARARGS,
-     "bytes data, size_t data_size, int fEffort, int block_x, int block_y, int block_z, int header"},
+     "buffer data, int fEffort, int block_x, int block_y, int block_z, int header"},
+     {"CompressAstcRaw",
+     (PyCFunction)_CompressAstcRaw,
+     METH_VARARGS,
+     "buffer rgba8 pixels, int width, int height, int stride, int fEffort, int block_x, int block_y, int block_z, int header"},
      {"CompressAstcWithFile",
      (PyCFunction)_CompressAstcWithFile,
      METH_VARARGS,
@@ -365,43 +2143,318 @@ static struct PyMethodDef method_table[] = {
      {"DecompressEtc1",
      (PyCFunction)_DecompressEtc1,
      METH_VARARGS,
-     "bytes data, size_t data_size, int w, int h"},
+     "buffer data, int w, int h, int jobs=1, "
+     "int output_format=0; output_format: 0 bgra, 1 rgba, 2 rgb, 3 r8, 4 rg8"},
      {"DecompressEtc2",
      (PyCFunction)_DecompressEtc2,
      METH_VARARGS,
-     "bytes data, size_t data_size, int w, int h"},
+     "buffer data, int w, int h, int jobs=1, "
+     "int output_format=0; output_format: 0 bgra, 1 rgba, 2 rgb, 3 r8, 4 rg8"},
       {"DecompressEtc2a1",
      (PyCFunction)_DecompressEtc2a1,
      METH_VARARGS,
-     "bytes data, size_t data_size, int w, int h"},
+     "buffer data, int w, int h, int jobs=1, "
+     "int output_format=0; output_format: 0 bgra, 1 rgba, 2 rgb, 3 r8, 4 rg8"},
      {"DecompressEtc2a8",
      (PyCFunction)_DecompressEtc2a8,
      METH_VARARGS,
-     "bytes data, size_t data_size, int w, int h"},
+     "buffer data, int w, int h, int jobs=1, "
+     "int output_format=0; output_format: 0 bgra, 1 rgba, 2 rgb, 3 r8, 4 rg8"},
      {"DecompressEtc1ToFile",
      (PyCFunction)_DecompressEtc1ToFile,
      METH_VARARGS,
-     "string inputfile, string outputfile, int w, int h"},
+     "string inputfile, string outputfile, int w, int h, int jobs=1, "
+     "int image_format=0; image_format: 0 png, 1 fast png, 2 qoi, 3 tga, 4 raw rgba"},
      {"DecompressEtc2ToFile",
      (PyCFunction)_DecompressEtc2ToFile,
      METH_VARARGS,
-     "string inputfile, string outputfile, int w, int h"},
+     "string inputfile, string outputfile, int w, int h, int jobs=1, "
+     "int image_format=0; image_format: 0 png, 1 fast png, 2 qoi, 3 tga, 4 raw rgba"},
      {"DecompressEtc2a1ToFile",
      (PyCFunction)_DecompressEtc2a1ToFile,
      METH_VARARGS,
-     "string inputfile, string outputfile, int w, int h"},
+     "string inputfile, string outputfile, int w, int h, int jobs=1, "
+     "int image_format=0; image_format: 0 png, 1 fast png, 2 qoi, 3 tga, 4 raw rgba"},
      {"DecompressEtc2a8ToFile",
      (PyCFunction)_DecompressEtc2a8ToFile,
      METH_VARARGS,
-     "string inputfile, string outputfile, int w, int h"},
+     "string inputfile, string outputfile, int w, int h, int jobs=1, "
+     "int image_format=0; image_format: 0 png, 1 fast png, 2 qoi, 3 tga, 4 raw rgba"},
       {"DecompressAstc",
      (PyCFunction)_DecompressAstc,
      METH_VARARGS,
-     "bytes data, size_t data_size, int w, int h, int block_width, int block_height"},
+     "buffer data, int w, int h, int block_width, int block_height, int jobs=1, "
+     "int output_format=0; output_format: 0 bgra, 1 rgba, 2 rgb, 3 r8, 4 rg8"},
+     {"DecompressEtc1Into",
+     (PyCFunction)_DecompressEtc1Into,
+     METH_VARARGS,
+     "buffer data, writable buffer out_buffer, int w, int h, int jobs=1, "
+     "int output_format=0; output_format: 0 bgra, 1 rgba, 2 rgb, 3 r8, 4 rg8"},
+     {"DecompressEtc2Into",
+     (PyCFunction)_DecompressEtc2Into,
+     METH_VARARGS,
+     "buffer data, writable buffer out_buffer, int w, int h, int jobs=1, "
+     "int output_format=0; output_format: 0 bgra, 1 rgba, 2 rgb, 3 r8, 4 rg8"},
+     {"DecompressEtc2a1Into",
+     (PyCFunction)_DecompressEtc2a1Into,
+     METH_VARARGS,
+     "buffer data, writable buffer out_buffer, int w, int h, int jobs=1, "
+     "int output_format=0; output_format: 0 bgra, 1 rgba, 2 rgb, 3 r8, 4 rg8"},
+     {"DecompressEtc2a8Into",
+     (PyCFunction)_DecompressEtc2a8Into,
+     METH_VARARGS,
+     "buffer data, writable buffer out_buffer, int w, int h, int jobs=1, "
+     "int output_format=0; output_format: 0 bgra, 1 rgba, 2 rgb, 3 r8, 4 rg8"},
+     {"DecompressAstcInto",
+     (PyCFunction)_DecompressAstcInto,
+     METH_VARARGS,
+     "buffer data, writable buffer out_buffer, int w, int h, int block_width, int block_height, int jobs=1, "
+     "int output_format=0; output_format: 0 bgra, 1 rgba, 2 rgb, 3 r8, 4 rg8"},
+     {"DecompressAstcFloat",
+     (PyCFunction)_DecompressAstcFloat,
+     METH_VARARGS,
+     "buffer data, int w, int h, int block_width, int block_height, int jobs=1, "
+     "int float_format=0; float_format: 0 rgba half floats, 1 rgba floats"},
+     {"DecompressAstcFloatInto",
+     (PyCFunction)_DecompressAstcFloatInto,
+     METH_VARARGS,
+     "buffer data, writable buffer out_buffer, int w, int h, int block_width, int block_height, int jobs=1, "
+     "int float_format=0; float_format: 0 rgba half floats, 1 rgba floats"},
      {"DecompressAstcToFile",
      (PyCFunction)_DecompressAstcToFile,
      METH_VARARGS,
-     "string inputfile, string outputfile, int w, int h, int block_width, int block_height"},
+     "string inputfile, string outputfile, int w, int h, int block_width, int block_height, int jobs=1, "
+     "int image_format=0; image_format: 0 png, 1 fast png, 2 qoi, 3 tga, 4 raw rgba"},
+     {"DecompressBc1",
+     (PyCFunction)_DecompressBc1,
+     METH_VARARGS,
+     "buffer data, int w, int h, int jobs=1, "
+     "int output_format=0; output_format: 0 bgra, 1 rgba, 2 rgb, 3 r8, 4 rg8"},
+     {"DecompressBc3",
+     (PyCFunction)_DecompressBc3,
+     METH_VARARGS,
+     "buffer data, int w, int h, int jobs=1, "
+     "int output_format=0; output_format: 0 bgra, 1 rgba, 2 rgb, 3 r8, 4 rg8"},
+     {"DecompressBc4",
+     (PyCFunction)_DecompressBc4,
+     METH_VARARGS,
+     "buffer data, int w, int h, int jobs=1, "
+     "int output_format=0; output_format: 0 bgra, 1 rgba, 2 rgb, 3 r8, 4 rg8"},
+     {"DecompressBc5",
+     (PyCFunction)_DecompressBc5,
+     METH_VARARGS,
+     "buffer data, int w, int h, int jobs=1, "
+     "int output_format=0; output_format: 0 bgra, 1 rgba, 2 rgb, 3 r8, 4 rg8"},
+     {"DecompressBc6",
+     (PyCFunction)_DecompressBc6,
+     METH_VARARGS,
+     "buffer data, int w, int h, int jobs=1, "
+     "int output_format=0; output_format: 0 bgra, 1 rgba, 2 rgb, 3 r8, 4 rg8"},
+     {"DecompressBc7",
+     (PyCFunction)_DecompressBc7,
+     METH_VARARGS,
+     "buffer data, int w, int h, int jobs=1, "
+     "int output_format=0; output_format: 0 bgra, 1 rgba, 2 rgb, 3 r8, 4 rg8"},
+     {"DecompressBc1Into",
+     (PyCFunction)_DecompressBc1Into,
+     METH_VARARGS,
+     "buffer data, writable buffer out_buffer, int w, int h, int jobs=1, "
+     "int output_format=0; output_format: 0 bgra, 1 rgba, 2 rgb, 3 r8, 4 rg8"},
+     {"DecompressBc3Into",
+     (PyCFunction)_DecompressBc3Into,
+     METH_VARARGS,
+     "buffer data, writable buffer out_buffer, int w, int h, int jobs=1, "
+     "int output_format=0; output_format: 0 bgra, 1 rgba, 2 rgb, 3 r8, 4 rg8"},
+     {"DecompressBc4Into",
+     (PyCFunction)_DecompressBc4Into,
+     METH_VARARGS,
+     "buffer data, writable buffer out_buffer, int w, int h, int jobs=1, "
+     "int output_format=0; output_format: 0 bgra, 1 rgba, 2 rgb, 3 r8, 4 rg8"},
+     {"DecompressBc5Into",
+     (PyCFunction)_DecompressBc5Into,
+     METH_VARARGS,
+     "buffer data, writable buffer out_buffer, int w, int h, int jobs=1, "
+     "int output_format=0; output_format: 0 bgra, 1 rgba, 2 rgb, 3 r8, 4 rg8"},
+     {"DecompressBc6Into",
+     (PyCFunction)_DecompressBc6Into,
+     METH_VARARGS,
+     "buffer data, writable buffer out_buffer, int w, int h, int jobs=1, "
+     "int output_format=0; output_format: 0 bgra, 1 rgba, 2 rgb, 3 r8, 4 rg8"},
+     {"DecompressBc7Into",
+     (PyCFunction)_DecompressBc7Into,
+     METH_VARARGS,
+     "buffer data, writable buffer out_buffer, int w, int h, int jobs=1, "
+     "int output_format=0; output_format: 0 bgra, 1 rgba, 2 rgb, 3 r8, 4 rg8"},
+     {"DecompressEacR11",
+     (PyCFunction)_DecompressEacR11,
+     METH_VARARGS,
+     "buffer data, int w, int h, int jobs=1, "
+     "int output_format=0; output_format: 0 bgra, 1 rgba, 2 rgb, 3 r8, 4 rg8"},
+     {"DecompressEacR11Signed",
+     (PyCFunction)_DecompressEacR11Signed,
+     METH_VARARGS,
+     "buffer data, int w, int h, int jobs=1, "
+     "int output_format=0; output_format: 0 bgra, 1 rgba, 2 rgb, 3 r8, 4 rg8"},
+     {"DecompressEacRG11",
+     (PyCFunction)_DecompressEacRG11,
+     METH_VARARGS,
+     "buffer data, int w, int h, int jobs=1, "
+     "int output_format=0; output_format: 0 bgra, 1 rgba, 2 rgb, 3 r8, 4 rg8"},
+     {"DecompressEacRG11Signed",
+     (PyCFunction)_DecompressEacRG11Signed,
+     METH_VARARGS,
+     "buffer data, int w, int h, int jobs=1, "
+     "int output_format=0; output_format: 0 bgra, 1 rgba, 2 rgb, 3 r8, 4 rg8"},
+     {"DecompressEacR11Into",
+     (PyCFunction)_DecompressEacR11Into,
+     METH_VARARGS,
+     "buffer data, writable buffer out_buffer, int w, int h, int jobs=1, "
+     "int output_format=0; output_format: 0 bgra, 1 rgba, 2 rgb, 3 r8, 4 rg8"},
+     {"DecompressEacR11SignedInto",
+     (PyCFunction)_DecompressEacR11SignedInto,
+     METH_VARARGS,
+     "buffer data, writable buffer out_buffer, int w, int h, int jobs=1, "
+     "int output_format=0; output_format: 0 bgra, 1 rgba, 2 rgb, 3 r8, 4 rg8"},
+     {"DecompressEacRG11Into",
+     (PyCFunction)_DecompressEacRG11Into,
+     METH_VARARGS,
+     "buffer data, writable buffer out_buffer, int w, int h, int jobs=1, "
+     "int output_format=0; output_format: 0 bgra, 1 rgba, 2 rgb, 3 r8, 4 rg8"},
+     {"DecompressEacRG11SignedInto",
+     (PyCFunction)_DecompressEacRG11SignedInto,
+     METH_VARARGS,
+     "buffer data, writable buffer out_buffer, int w, int h, int jobs=1, "
+     "int output_format=0; output_format: 0 bgra, 1 rgba, 2 rgb, 3 r8, 4 rg8"},
+     {"DecompressPvrtc",
+     (PyCFunction)_DecompressPvrtc,
+     METH_VARARGS,
+     "buffer data, int w, int h, int is2bpp, int jobs=1, "
+     "int output_format=0; output_format: 0 bgra, 1 rgba, 2 rgb, 3 r8, 4 rg8"},
+     {"DecompressPvrtcInto",
+     (PyCFunction)_DecompressPvrtcInto,
+     METH_VARARGS,
+     "buffer data, writable buffer out_buffer, int w, int h, int is2bpp, int jobs=1, "
+     "int output_format=0; output_format: 0 bgra, 1 rgba, 2 rgb, 3 r8, 4 rg8"},
+     {"DecompressBc1ToFile",
+     (PyCFunction)_DecompressBc1ToFile,
+     METH_VARARGS,
+     "string inputfile, string outputfile, int w, int h, int jobs=1, "
+     "int image_format=0; image_format: 0 png, 1 fast png, 2 qoi, 3 tga, 4 raw rgba"},
+     {"DecompressBc3ToFile",
+     (PyCFunction)_DecompressBc3ToFile,
+     METH_VARARGS,
+     "string inputfile, string outputfile, int w, int h, int jobs=1, "
+     "int image_format=0; image_format: 0 png, 1 fast png, 2 qoi, 3 tga, 4 raw rgba"},
+     {"DecompressBc4ToFile",
+     (PyCFunction)_DecompressBc4ToFile,
+     METH_VARARGS,
+     "string inputfile, string outputfile, int w, int h, int jobs=1, "
+     "int image_format=0; image_format: 0 png, 1 fast png, 2 qoi, 3 tga, 4 raw rgba"},
+     {"DecompressBc5ToFile",
+     (PyCFunction)_DecompressBc5ToFile,
+     METH_VARARGS,
+     "string inputfile, string outputfile, int w, int h, int jobs=1, "
+     "int image_format=0; image_format: 0 png, 1 fast png, 2 qoi, 3 tga, 4 raw rgba"},
+     {"DecompressBc6ToFile",
+     (PyCFunction)_DecompressBc6ToFile,
+     METH_VARARGS,
+     "string inputfile, string outputfile, int w, int h, int jobs=1, "
+     "int image_format=0; image_format: 0 png, 1 fast png, 2 qoi, 3 tga, 4 raw rgba"},
+     {"DecompressBc7ToFile",
+     (PyCFunction)_DecompressBc7ToFile,
+     METH_VARARGS,
+     "string inputfile, string outputfile, int w, int h, int jobs=1, "
+     "int image_format=0; image_format: 0 png, 1 fast png, 2 qoi, 3 tga, 4 raw rgba"},
+     {"DecompressEtc1ToImageBytes",
+     (PyCFunction)_DecompressEtc1ToImageBytes,
+     METH_VARARGS,
+     "buffer data, int w, int h, int jobs=1, "
+     "int image_format=0; image_format: 0 png, 1 fast png, 2 qoi, 3 tga, 4 raw rgba"},
+     {"DecompressEtc2ToImageBytes",
+     (PyCFunction)_DecompressEtc2ToImageBytes,
+     METH_VARARGS,
+     "buffer data, int w, int h, int jobs=1, "
+     "int image_format=0; image_format: 0 png, 1 fast png, 2 qoi, 3 tga, 4 raw rgba"},
+     {"DecompressEtc2a1ToImageBytes",
+     (PyCFunction)_DecompressEtc2a1ToImageBytes,
+     METH_VARARGS,
+     "buffer data, int w, int h, int jobs=1, "
+     "int image_format=0; image_format: 0 png, 1 fast png, 2 qoi, 3 tga, 4 raw rgba"},
+     {"DecompressEtc2a8ToImageBytes",
+     (PyCFunction)_DecompressEtc2a8ToImageBytes,
+     METH_VARARGS,
+     "buffer data, int w, int h, int jobs=1, "
+     "int image_format=0; image_format: 0 png, 1 fast png, 2 qoi, 3 tga, 4 raw rgba"},
+     {"DecompressAstcToImageBytes",
+     (PyCFunction)_DecompressAstcToImageBytes,
+     METH_VARARGS,
+     "buffer data, int w, int h, int block_width, int block_height, int jobs=1, "
+     "int image_format=0; image_format: 0 png, 1 fast png, 2 qoi, 3 tga, 4 raw rgba"},
+     {"DecompressBc1ToImageBytes",
+     (PyCFunction)_DecompressBc1ToImageBytes,
+     METH_VARARGS,
+     "buffer data, int w, int h, int jobs=1, "
+     "int image_format=0; image_format: 0 png, 1 fast png, 2 qoi, 3 tga, 4 raw rgba"},
+     {"DecompressBc3ToImageBytes",
+     (PyCFunction)_DecompressBc3ToImageBytes,
+     METH_VARARGS,
+     "buffer data, int w, int h, int jobs=1, "
+     "int image_format=0; image_format: 0 png, 1 fast png, 2 qoi, 3 tga, 4 raw rgba"},
+     {"DecompressBc4ToImageBytes",
+     (PyCFunction)_DecompressBc4ToImageBytes,
+     METH_VARARGS,
+     "buffer data, int w, int h, int jobs=1, "
+     "int image_format=0; image_format: 0 png, 1 fast png, 2 qoi, 3 tga, 4 raw rgba"},
+     {"DecompressBc5ToImageBytes",
+     (PyCFunction)_DecompressBc5ToImageBytes,
+     METH_VARARGS,
+     "buffer data, int w, int h, int jobs=1, "
+     "int image_format=0; image_format: 0 png, 1 fast png, 2 qoi, 3 tga, 4 raw rgba"},
+     {"DecompressBc6ToImageBytes",
+     (PyCFunction)_DecompressBc6ToImageBytes,
+     METH_VARARGS,
+     "buffer data, int w, int h, int jobs=1, "
+     "int image_format=0; image_format: 0 png, 1 fast png, 2 qoi, 3 tga, 4 raw rgba"},
+     {"DecompressBc7ToImageBytes",
+     (PyCFunction)_DecompressBc7ToImageBytes,
+     METH_VARARGS,
+     "buffer data, int w, int h, int jobs=1, "
+     "int image_format=0; image_format: 0 png, 1 fast png, 2 qoi, 3 tga, 4 raw rgba"},
+     {"DecodeContainer",
+     (PyCFunction)_DecodeContainer,
+     METH_VARARGS,
+     "buffer data, int level=0, int jobs=1, int output_format=0; decodes a KTX, .astc or PKM file, "
+     "returns (pixels, width, height)"},
+     {"DecompressRegion",
+     (PyCFunction)_DecompressRegion,
+     METH_VARARGS,
+     "int format, buffer data, int w, int h, int x, int y, int rw, int rh, int block_width=4, "
+     "int block_height=4, int jobs=1, int output_format=0; format: 0 etc1, 1 etc2 rgb, 2 etc2 rgba, 3 astc, "
+     "4 etc2 rgba1, 5 bc1, 6 bc3, 7 bc4, 8 bc5, 9 bc6, 10 bc7, 11 eac r11, 12 eac r11 signed, 13 eac rg11, "
+     "14 eac rg11 signed; output_format: 0 bgra, 1 rgba, 2 rgb, 3 r8, 4 rg8; returns the rw * rh crop"},
+     {"TranscodeEtcToBc",
+     (PyCFunction)_TranscodeEtcToBc,
+     METH_VARARGS,
+     "buffer data, int w, int h, int etc_format, int bc_format, int jobs=1; etc_format: 0 etc1, 1 etc2 rgb, "
+     "2 etc2 rgba, 4 etc2 rgba1; bc_format: 5 bc1, 6 bc3, 10 bc7; returns the bc blocks"},
+     {"CompressBatch",
+     (PyCFunction)_CompressBatch,
+     METH_VARARGS,
+     "list images, int format, dict params; format: 0 etc1, 1 etc2 rgb, 2 etc2 rgba, 3 astc; "
+     "params: fEffort, mipmap, jobs, block_x, block_y, block_z, header"},
+     {"Submit",
+     (PyCFunction)_Submit,
+     METH_VARARGS,
+     "int format, image, dict params; queues one compression like a CompressBatch entry and returns an "
+     "awaitable concurrent.futures.Future"},
+     {"SetJobLimits",
+     (PyCFunction)_SetJobLimits,
+     METH_VARARGS,
+     "int concurrency, int max_pending=0; 0 concurrency uses every pool thread, 0 max_pending is unbounded"},
+     {"WaitJobs",
+     (PyCFunction)_WaitJobs,
+     METH_NOARGS,
+     "blocks until every submitted job has finished"},
     {NULL,
      NULL,
      0,
@@ -425,5 +2478,42 @@ static PyModuleDef pytexture2dstudio_module = {
 // The module init function
 PyMODINIT_FUNC PyInit_pytexture2dstudio(void)
 {
-    return PyModule_Create(&pytexture2dstudio_module);
+    AstcEncoderType.tp_flags = Py_TPFLAGS_DEFAULT;
+    AstcEncoderType.tp_doc = "AstcEncoder(int fEffort, int block_x, int block_y, int block_z, "
+                             "int profile=1, int flags=0, int threads=1)";
+    AstcEncoderType.tp_new = PyType_GenericNew;
+    AstcEncoderType.tp_init = (initproc) AstcEncoder_init;
+    AstcEncoderType.tp_dealloc = (destructor) AstcEncoder_dealloc;
+    AstcEncoderType.tp_methods = AstcEncoder_methods;
+
+    EtcEncoderType.tp_flags = Py_TPFLAGS_DEFAULT;
+    EtcEncoderType.tp_doc = "EtcEncoder(int format, int mipmap, int fEffort, int jobs), "
+                            "format: 0 etc1, 1 etc2 rgb, 2 etc2 rgba";
+    EtcEncoderType.tp_new = PyType_GenericNew;
+    EtcEncoderType.tp_init = (initproc) EtcEncoder_init;
+    EtcEncoderType.tp_dealloc = (destructor) EtcEncoder_dealloc;
+    EtcEncoderType.tp_methods = EtcEncoder_methods;
+
+    CrunchDecoderType.tp_flags = Py_TPFLAGS_DEFAULT;
+    CrunchDecoderType.tp_doc = "CrunchDecoder(buffer data), a .crn file kept open for decoding its levels and faces";
+    CrunchDecoderType.tp_new = PyType_GenericNew;
+    CrunchDecoderType.tp_init = (initproc) CrunchDecoder_init;
+    CrunchDecoderType.tp_dealloc = (destructor) CrunchDecoder_dealloc;
+    CrunchDecoderType.tp_methods = CrunchDecoder_methods;
+
+    if (PyType_Ready(&AstcEncoderType) < 0 || PyType_Ready(&EtcEncoderType) < 0 ||
+        PyType_Ready(&CrunchDecoderType) < 0)
+        return NULL;
+
+    PyObject *module = PyModule_Create(&pytexture2dstudio_module);
+    if (module == NULL)
+        return NULL;
+
+    Py_INCREF(&AstcEncoderType);
+    PyModule_AddObject(module, "AstcEncoder", (PyObject *) &AstcEncoderType);
+    Py_INCREF(&EtcEncoderType);
+    PyModule_AddObject(module, "EtcEncoder", (PyObject *) &EtcEncoderType);
+    Py_INCREF(&CrunchDecoderType);
+    PyModule_AddObject(module, "CrunchDecoder", (PyObject *) &CrunchDecoderType);
+    return module;
 }
\ No newline at end of file
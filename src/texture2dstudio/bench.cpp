@@ -0,0 +1,372 @@
+//
+// Created by smalls on 2021/8/14.
+//
+
+// Decoder throughput for every texture2ddecoder format, as JSON on stdout:
+//
+//   texture2dbench [--size N] [--threads 1,2,4] [--iterations N] [--min-time seconds] [--format name,...]
+//
+// Corpora are generated from one fixed synthetic image, so runs are comparable: ETC/EAC and ASTC blocks
+// come from the encoders, BC1/3/7 from TranscodeEtcToBc (BC7 is mode 6 only), BC4/5 from the BC3 alpha
+// halves. BC6, ATC and PVRTC, where every bit pattern decodes, get seeded random blocks (BC6 with valid
+// modes). ASTC is also timed through astcenc's fp16 decompressor (astc_*_f16). Every result is the
+// fastest of the timed iterations.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <astcenc.h>
+#include <atc.h>
+#include "ThreadPool.h"
+#include "texture2d.h"
+
+struct Corpus {
+    std::string name;
+    long block_width;
+    long block_height;
+    std::vector<uint8_t> blocks;
+    // decodes the whole image as BGRA with `jobs` threads
+    std::function<int(uint8_t *, int, uint8_t *)> decode;
+};
+
+struct Options {
+    long size = 512;
+    std::vector<int> threads;
+    int iterations = 0;
+    double min_time = 0.3;
+    std::vector<std::string> formats;
+};
+
+static const unsigned int ASTC_FOOTPRINTS[14][2] = {{4, 4}, {5, 4}, {5, 5}, {6, 5}, {6, 6}, {8, 5}, {8, 6}, {8, 8},
+                                                    {10, 5}, {10, 6}, {10, 8}, {10, 10}, {12, 10}, {12, 12}};
+
+// Every corpus buildCorpora adds besides astc_WxH and astc_WxH_f16
+static const char *const FORMAT_NAMES[] = {"etc1", "etc2", "etc2a1", "etc2a8", "eac_r11", "eac_r11_signed",
+                                           "eac_rg11", "eac_rg11_signed", "bc1", "bc3", "bc4", "bc5", "bc6",
+                                           "bc7", "atc_rgb4", "atc_rgba8", "pvrtc_4bpp", "pvrtc_2bpp"};
+
+static std::string astcName(const unsigned int *footprint) {
+    return "astc_" + std::to_string(footprint[0]) + "x" + std::to_string(footprint[1]);
+}
+
+static bool knownFormat(const std::string &name) {
+    for (const char *known : FORMAT_NAMES) {
+        if (name == known) {
+            return true;
+        }
+    }
+    for (const unsigned int *footprint : ASTC_FOOTPRINTS) {
+        if (name == astcName(footprint) || name == astcName(footprint) + "_f16") {
+            return true;
+        }
+    }
+    return false;
+}
+
+static std::vector<std::string> split(const char *list) {
+    std::vector<std::string> items;
+    std::string item;
+    for (const char *p = list;; p++) {
+        if (*p == ',' || *p == 0) {
+            if (!item.empty()) {
+                items.push_back(item);
+            }
+            item.clear();
+            if (*p == 0) {
+                break;
+            }
+        } else {
+            item += *p;
+        }
+    }
+    return items;
+}
+
+static bool parseOptions(int argc, char **argv, Options *options) {
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (value == nullptr) {
+            return false;
+        }
+        if (strcmp(arg, "--size") == 0) {
+            options->size = atol(value);
+        } else if (strcmp(arg, "--threads") == 0) {
+            for (const std::string &item : split(value)) {
+                options->threads.push_back(atoi(item.c_str()));
+            }
+        } else if (strcmp(arg, "--iterations") == 0) {
+            options->iterations = atoi(value);
+        } else if (strcmp(arg, "--min-time") == 0) {
+            options->min_time = atof(value);
+        } else if (strcmp(arg, "--format") == 0) {
+            options->formats = split(value);
+            for (const std::string &name : options->formats) {
+                if (!knownFormat(name)) {
+                    fprintf(stderr, "unknown format %s\n", name.c_str());
+                    return false;
+                }
+            }
+        } else {
+            return false;
+        }
+        i++;
+    }
+    if (options->threads.empty()) {
+        options->threads.push_back(1);
+        int hardware = (int) std::thread::hardware_concurrency();
+        if (hardware > 1) {
+            options->threads.push_back(hardware);
+        }
+    }
+    return options->size >= 4;
+}
+
+// Smooth gradients, hard edges and some noise, with an alpha ramp
+static std::vector<uint8_t> sourceImage(long size) {
+    std::vector<uint8_t> pixels((size_t) size * size * 4);
+    std::mt19937 random(1);
+    for (long y = 0; y < size; y++) {
+        for (long x = 0; x < size; x++) {
+            uint8_t *p = &pixels[(y * size + x) * 4];
+            int noise = (int) (random() % 13) - 6;
+            p[0] = (uint8_t) std::min(255.0, std::max(0.0, 128 + 100 * sin(x / 23.0) * cos(y / 31.0) + noise));
+            p[1] = (uint8_t) ((x / 40 + y / 40) % 2 ? x * 255 / size : 255 - y * 255 / size);
+            p[2] = (uint8_t) (128 + 120 * sin((x + y) / 17.0));
+            p[3] = (uint8_t) ((x + y) * 255 / (2 * size));
+        }
+    }
+    return pixels;
+}
+
+static std::vector<uint8_t> takeBuffer(uint8_t *data, size_t size) {
+    std::vector<uint8_t> blocks(data, data + size);
+    free(data);
+    return blocks;
+}
+
+static std::vector<uint8_t> randomBlocks(size_t size, unsigned int seed) {
+    std::vector<uint8_t> blocks(size);
+    std::mt19937 random(seed);
+    for (uint8_t &b : blocks) {
+        b = (uint8_t) random();
+    }
+    return blocks;
+}
+
+// 8 byte halves of 16 byte blocks, `pairs` keeps two consecutive halves per block
+static std::vector<uint8_t> blockHalves(const std::vector<uint8_t> &blocks, size_t offset, bool pairs) {
+    std::vector<uint8_t> halves;
+    for (size_t i = 0; i + 16 <= blocks.size(); i += 16) {
+        halves.insert(halves.end(), blocks.begin() + i + offset, blocks.begin() + i + offset + 8);
+        if (pairs) {
+            // the neighbouring block's alpha as the second channel
+            size_t next = (i + 16) % blocks.size();
+            halves.insert(halves.end(), blocks.begin() + next + offset, blocks.begin() + next + offset + 8);
+        }
+    }
+    return halves;
+}
+
+// Random BC6H blocks whose mode field is one of the 14 valid ones
+static std::vector<uint8_t> bc6Blocks(size_t count) {
+    static const uint8_t MODES[14][2] = {{0x00, 2}, {0x01, 2}, {0x02, 5}, {0x06, 5}, {0x0a, 5}, {0x0e, 5}, {0x12, 5},
+                                         {0x16, 5}, {0x1a, 5}, {0x1e, 5}, {0x03, 5}, {0x07, 5}, {0x0b, 5}, {0x0f, 5}};
+    std::vector<uint8_t> blocks = randomBlocks(count * 16, 6);
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t *mode = MODES[blocks[i * 16 + 1] % 14];
+        uint8_t mask = (uint8_t) ((1 << mode[1]) - 1);
+        blocks[i * 16] = (uint8_t) ((blocks[i * 16] & ~mask) | mode[0]);
+    }
+    return blocks;
+}
+
+// Stripes of block rows through the serial ATC decoders, like the library's other decoders
+static int decodeAtc(int (*func)(const uint8_t *, uint32_t, uint32_t, uint32_t *), long block_bytes,
+                     const uint8_t *src, long size, int jobs, uint8_t *out) {
+    long blocks_y = (size + 3) / 4;
+    long stripes = std::min<long>(blocks_y, (long) jobs * 4);
+    ThreadPool::Shared().ParallelFor((size_t) stripes, (unsigned int) jobs, [&](size_t i) {
+        long by0 = blocks_y * (long) i / stripes;
+        long by1 = blocks_y * ((long) i + 1) / stripes;
+        long rows = std::min(size, by1 * 4) - by0 * 4;
+        func(src + by0 * ((size + 3) / 4) * block_bytes, (uint32_t) size, (uint32_t) rows,
+             (uint32_t *) (out + by0 * 4 * size * 4));
+    });
+    return 1;
+}
+
+static bool wanted(const Options &options, const std::string &name) {
+    return options.formats.empty() ||
+           std::find(options.formats.begin(), options.formats.end(), name) != options.formats.end();
+}
+
+static std::vector<Corpus> buildCorpora(const Options &options) {
+    const long size = options.size;
+    const std::vector<uint8_t> pixels = sourceImage(size);
+    std::vector<Corpus> corpora;
+    uint8_t *data;
+    size_t data_size;
+
+    auto etc = [&](int (*compress)(const uint8_t *, unsigned int, unsigned int, size_t, int, float, int, int,
+                                   uint8_t **, size_t *)) {
+        // header 1 leaves the bare blocks
+        if (compress(pixels.data(), (unsigned int) size, (unsigned int) size, (size_t) size * 4, 0, 0, 1, 1, &data,
+                     &data_size) != 1) {
+            fprintf(stderr, "etc compression failed\n");
+            exit(1);
+        }
+        return takeBuffer(data, data_size);
+    };
+    fprintf(stderr, "encoding etc corpora\n");
+    std::vector<uint8_t> etc1 = etc(CompressEtc1Raw);
+    std::vector<uint8_t> etc2 = etc(CompressEtc2RGBRaw);
+    std::vector<uint8_t> etc2a8 = etc(CompressEtc2RGBARaw);
+    std::vector<uint8_t> eac = blockHalves(etc2a8, 0, false);
+    std::vector<uint8_t> eac2 = blockHalves(etc2a8, 0, true);
+
+    auto add = [&](const char *name, long bw, long bh, std::vector<uint8_t> blocks,
+                   std::function<int(uint8_t *, int, uint8_t *)> decode) {
+        if (wanted(options, name)) {
+            corpora.push_back({name, bw, bh, std::move(blocks), std::move(decode)});
+        }
+    };
+    typedef int (*IntoFunc)(uint8_t *, long, long, int, int, uint8_t *);
+    auto into = [size](IntoFunc func) {
+        return [size, func](uint8_t *src, int jobs, uint8_t *out) {
+            return func(src, size, size, jobs, TEXTURE2D_OUTPUT_BGRA, out);
+        };
+    };
+    add("etc1", 4, 4, etc1, into(DecompressEtc1Into));
+    add("etc2", 4, 4, etc2, into(DecompressEtc2Into));
+    // the rgb blocks reinterpreted, the differential bit becomes the opaque flag
+    add("etc2a1", 4, 4, etc2, into(DecompressEtc2a1Into));
+    add("etc2a8", 4, 4, etc2a8, into(DecompressEtc2a8Into));
+    add("eac_r11", 4, 4, eac, into(DecompressEacR11Into));
+    add("eac_r11_signed", 4, 4, eac, into(DecompressEacR11SignedInto));
+    add("eac_rg11", 4, 4, eac2, into(DecompressEacRG11Into));
+    add("eac_rg11_signed", 4, 4, eac2, into(DecompressEacRG11SignedInto));
+
+    for (const unsigned int *footprint : ASTC_FOOTPRINTS) {
+        long bw = footprint[0], bh = footprint[1];
+        std::string name = astcName(footprint);
+        if (!wanted(options, name) && !wanted(options, name + "_f16")) {
+            continue;
+        }
+        fprintf(stderr, "encoding %s corpus\n", name.c_str());
+        AstcEncoder *encoder = AstcEncoderCreate(ASTCENC_PRF_LDR, ASTCENC_MIN_LEVEL, (unsigned int) bw,
+                                                 (unsigned int) bh, 1, 0, std::thread::hardware_concurrency());
+        if (encoder == nullptr || AstcEncoderCompressRaw(encoder, pixels.data(), (unsigned int) size,
+                                                         (unsigned int) size, size * 4, 0, &data, &data_size) != 1) {
+            fprintf(stderr, "astc compression failed\n");
+            exit(1);
+        }
+        AstcEncoderFree(encoder);
+        std::vector<uint8_t> blocks = takeBuffer(data, data_size);
+        add(name.c_str(), bw, bh, blocks, [size, bw, bh](uint8_t *src, int jobs, uint8_t *out) {
+            return DecompressAstcInto(src, size, size, bw, bh, jobs, TEXTURE2D_OUTPUT_BGRA, out);
+        });
+        // astcenc's own decompressor, for comparison
+        add((name + "_f16").c_str(), bw, bh, blocks, [size, bw, bh](uint8_t *src, int jobs, uint8_t *out) {
+            return DecompressAstcFloatInto(src, size, size, bw, bh, jobs, TEXTURE2D_FLOAT_RGBA16F, out);
+        });
+    }
+
+    auto transcode = [&](const std::vector<uint8_t> &src, int etc_format, int bc_format) {
+        if (TranscodeEtcToBc((uint8_t *) src.data(), size, size, etc_format, bc_format, 0, &data, &data_size) != 1) {
+            fprintf(stderr, "transcode failed\n");
+            exit(1);
+        }
+        return takeBuffer(data, data_size);
+    };
+    size_t blocks = (size_t) ((size + 3) / 4) * ((size + 3) / 4);
+    std::vector<uint8_t> bc3 = transcode(etc2a8, TEXTURE2D_FORMAT_ETC2_RGBA, TEXTURE2D_FORMAT_BC3);
+    add("bc1", 4, 4, transcode(etc2, TEXTURE2D_FORMAT_ETC2_RGB, TEXTURE2D_FORMAT_BC1), into(DecompressBc1Into));
+    add("bc3", 4, 4, bc3, into(DecompressBc3Into));
+    add("bc4", 4, 4, blockHalves(bc3, 0, false), into(DecompressBc4Into));
+    add("bc5", 4, 4, blockHalves(bc3, 0, true), into(DecompressBc5Into));
+    add("bc6", 4, 4, bc6Blocks(blocks), into(DecompressBc6Into));
+    add("bc7", 4, 4, transcode(etc2a8, TEXTURE2D_FORMAT_ETC2_RGBA, TEXTURE2D_FORMAT_BC7), into(DecompressBc7Into));
+
+    add("atc_rgb4", 4, 4, randomBlocks(blocks * 8, 7), [size](uint8_t *src, int jobs, uint8_t *out) {
+        return decodeAtc(decode_atc_rgb4, 8, src, size, jobs, out);
+    });
+    add("atc_rgba8", 4, 4, randomBlocks(blocks * 16, 8), [size](uint8_t *src, int jobs, uint8_t *out) {
+        return decodeAtc(decode_atc_rgba8, 16, src, size, jobs, out);
+    });
+
+    // PVRTC needs a power of 2 number of blocks a side
+    for (int is2bpp = 0; is2bpp < 2; is2bpp++) {
+        long bw = is2bpp ? 8 : 4;
+        long blocks_x = (size + bw - 1) / bw, blocks_y = (size + 3) / 4;
+        if ((blocks_x & (blocks_x - 1)) || (blocks_y & (blocks_y - 1))) {
+            fprintf(stderr, "skipping pvrtc, %ld is not a power of 2 blocks a side\n", size);
+            continue;
+        }
+        add(is2bpp ? "pvrtc_2bpp" : "pvrtc_4bpp", bw, 4, randomBlocks(blocks_x * blocks_y * 8, 9 + is2bpp),
+            [size, is2bpp](uint8_t *src, int jobs, uint8_t *out) {
+                return DecompressPvrtcInto(src, size, size, is2bpp, jobs, TEXTURE2D_OUTPUT_BGRA, out);
+            });
+    }
+    return corpora;
+}
+
+static const char *simdName() {
+    const char *cap = getenv("TEXTURE2D_SIMD");
+    return cap ? cap : "auto";
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    if (!parseOptions(argc, argv, &options)) {
+        fprintf(stderr, "usage: %s [--size N] [--threads 1,2,4] [--iterations N] [--min-time seconds] "
+                        "[--format name,...]\n", argv[0]);
+        return 2;
+    }
+    std::vector<Corpus> corpora = buildCorpora(options);
+    const long size = options.size;
+    // room for the fp16 astc output
+    std::vector<uint8_t> image((size_t) size * size * 8);
+
+    printf("{\n  \"width\": %ld,\n  \"height\": %ld,\n  \"simd\": \"%s\",\n  \"hardware_threads\": %u,\n"
+           "  \"results\": [", size, size, simdName(), std::thread::hardware_concurrency());
+    bool first = true;
+    for (Corpus &corpus : corpora) {
+        long blocks = ((size + corpus.block_width - 1) / corpus.block_width) *
+                      ((size + corpus.block_height - 1) / corpus.block_height);
+        for (int jobs : options.threads) {
+            fprintf(stderr, "%s, %d threads\n", corpus.name.c_str(), jobs);
+            // warm up caches, the pool and lazily built tables
+            if (corpus.decode(corpus.blocks.data(), jobs, image.data()) != 1) {
+                fprintf(stderr, "%s failed to decode\n", corpus.name.c_str());
+                return 1;
+            }
+            double best = INFINITY, total = 0;
+            int iterations = 0;
+            while (options.iterations > 0 ? iterations < options.iterations
+                                          : (total < options.min_time || iterations < 3)) {
+                auto start = std::chrono::steady_clock::now();
+                corpus.decode(corpus.blocks.data(), jobs, image.data());
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                best = std::min(best, seconds);
+                total += seconds;
+                iterations++;
+            }
+            printf("%s\n    {\"format\": \"%s\", \"block\": \"%ldx%ld\", \"threads\": %d, \"iterations\": %d, "
+                   "\"best_ms\": %.4f, \"mean_ms\": %.4f, \"mpix_per_s\": %.2f, \"ns_per_block\": %.2f}",
+                   first ? "" : ",", corpus.name.c_str(), corpus.block_width, corpus.block_height, jobs, iterations,
+                   best * 1e3, total / iterations * 1e3, (double) size * size / best / 1e6, best * 1e9 / blocks);
+            first = false;
+        }
+    }
+    printf("\n  ]\n}\n");
+    return 0;
+}
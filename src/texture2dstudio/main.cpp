@@ -19,7 +19,7 @@ int DecompressEtc2() {
 
     uint8_t *out = nullptr;
     size_t outsize = 0;
-    DecompressEtc2(in, 1024, 1024, &out, &outsize);
+    DecompressEtc2(in, 1024, 1024, 1, TEXTURE2D_OUTPUT_BGRA, &out, &outsize);
 
     FILE *ofd = fopen(output, "wb");
     assert(ofd);
@@ -8,6 +8,7 @@
 #include <chrono>
 #include <cstring>
 #include "Astc.h"
+#include "AstcEncoder.h"
 
 Astc::Astc(const char *in,
            float quality, unsigned int block_x, unsigned int block_y, unsigned int block_z) {
@@ -30,6 +31,19 @@ Astc::Astc(uint8_t *file, size_t filesize,
     writeHeader = header;
 }
 
+Astc::Astc(const uint8_t *pixels, unsigned int width, unsigned int height, size_t stride,
+           float quality, unsigned int block_x, unsigned int block_y, unsigned int block_z, int header) {
+    m_pixels = pixels;
+    m_width = width;
+    m_height = height;
+    m_stride = stride;
+    m_quality = quality;
+    m_block_x = block_x;
+    m_block_y = block_y;
+    m_block_z = block_z;
+    writeHeader = header;
+}
+
 void Astc::Clear() {
     free_image(image_uncomp_in);
     astcenc_context_free(codec_context);
@@ -40,36 +54,48 @@ int Astc::Read() {
     auto start = std::chrono::steady_clock::now();
 
     astcenc_config config{};
-    astcenc_profile profile = ASTCENC_PRF_LDR;
-
-    unsigned int flags = 0;
-
-    flags |= ASTCENC_FLG_SELF_DECOMPRESS_ONLY;
-
-    astcenc_error status = astcenc_config_init(profile, m_block_x, m_block_y, m_block_z,
-                                               m_quality, flags, &config);
-
-    if (status != ASTCENC_SUCCESS) {
-        printf("ERROR: astcenc_config_init failed\n");
-        return 0;
-    }
 
     // Initialize cli_config_options with default values
     cli_config_options cli_config{1, 1, false, false, -10, 10,
                                   {ASTCENC_SWZ_R, ASTCENC_SWZ_G, ASTCENC_SWZ_B, ASTCENC_SWZ_A},
                                   {ASTCENC_SWZ_R, ASTCENC_SWZ_G, ASTCENC_SWZ_B, ASTCENC_SWZ_A}};
 
-    astcenc_error codec_status;
-    codec_status = astcenc_context_alloc(&config, cli_config.thread_count, &codec_context);
+    if (m_encoder != nullptr) {
+        config = m_encoder->GetConfig();
+    } else {
+        astcenc_profile profile = ASTCENC_PRF_LDR;
 
-    if (codec_status != ASTCENC_SUCCESS) {
-        printf("ERROR: Codec context alloc failed: %s\n", astcenc_get_error_string(codec_status));
-        return 0;
+        unsigned int flags = 0;
+
+        flags |= ASTCENC_FLG_SELF_DECOMPRESS_ONLY;
+
+        astcenc_error status = astcenc_config_init(profile, m_block_x, m_block_y, m_block_z,
+                                                   m_quality, flags, &config);
+
+        if (status != ASTCENC_SUCCESS) {
+            printf("ERROR: astcenc_config_init failed\n");
+            return 0;
+        }
+
+        astcenc_error codec_status;
+        codec_status = astcenc_context_alloc(&config, cli_config.thread_count, &codec_context);
+
+        if (codec_status != ASTCENC_SUCCESS) {
+            printf("ERROR: Codec context alloc failed: %s\n", astcenc_get_error_string(codec_status));
+            return 0;
+        }
     }
 
     int dim_x, dim_y;
     uint8_t *data = nullptr;
-    if (m_in == nullptr) {
+    if (m_pixels != nullptr) {
+        // raw RGBA8 input: copy the rows straight into the codec image, no image decode
+        image_uncomp_in = alloc_image(8, m_width, m_height, 1);
+        auto *dst = static_cast<uint8_t *>(image_uncomp_in->data[0]);
+        for (unsigned int y = 0; y < m_height; y++) {
+            memcpy(dst + (size_t) y * m_width * 4, m_pixels + y * m_stride, (size_t) m_width * 4);
+        }
+    } else if (m_in == nullptr) {
         if (m_filesize == 0) {
             return 0;
         }
@@ -79,11 +105,18 @@ int Astc::Read() {
         assert(m_in);
         data = stbi_load(m_in, &dim_x, &dim_y, nullptr, STBI_rgb_alpha);
     }
+    if (image_uncomp_in == nullptr) {
+        if (data == nullptr) {
+            printf("ERROR: Failed to load image: %s\n", stbi_failure_reason());
+            return 0;
+        }
 
-    image_uncomp_in = astc_img_from_unorm8x4_array(data,
-                                                   dim_x,
-                                                   dim_y,
-                                                   false);
+        image_uncomp_in = astc_img_from_unorm8x4_array(data,
+                                                       dim_x,
+                                                       dim_y,
+                                                       false);
+        stbi_image_free(data);
+    }
 
 
     unsigned int blocks_x = (image_uncomp_in->dim_x + config.block_x - 1) / config.block_x;
@@ -92,9 +125,14 @@ int Astc::Read() {
     size_t buffer_size = blocks_x * blocks_y * blocks_z * 16;
     uint8_t *buffer = new uint8_t[buffer_size];
 
-    astcenc_error astcenc_error = astcenc_compress_image(
-            codec_context, image_uncomp_in, &cli_config.swz_encode,
-            buffer, buffer_size, 0);
+    astcenc_error astcenc_error;
+    if (m_encoder != nullptr) {
+        astcenc_error = m_encoder->CompressImage(image_uncomp_in, buffer, buffer_size);
+    } else {
+        astcenc_error = astcenc_compress_image(
+                codec_context, image_uncomp_in, &cli_config.swz_encode,
+                buffer, buffer_size, 0);
+    }
 
     auto end = std::chrono::steady_clock::now();
     std::chrono::milliseconds elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
@@ -103,6 +141,7 @@ int Astc::Read() {
 
     if (astcenc_error != ASTCENC_SUCCESS) {
         printf("ERROR: Codec compress failed: %s\n", astcenc_get_error_string(astcenc_error));
+        delete[] buffer;
         return 0;
     }
 
@@ -118,21 +157,6 @@ int Astc::Read() {
     return 1;
 }
 
-/* ============================================================================
-	ASTC compressed file loading
-============================================================================ */
-struct astc_header {
-    uint8_t magic[4];
-    uint8_t block_x;
-    uint8_t block_y;
-    uint8_t block_z;
-    uint8_t dim_x[3];            // dims = dim[0] + (dim[1] << 8) + (dim[2] << 16)
-    uint8_t dim_y[3];            // Sizes are given in texels;
-    uint8_t dim_z[3];            // block count is inferred
-};
-
-static const uint32_t ASTC_MAGIC_ID = 0x5CA1AB13;
-
 bool Astc::Write(uint8_t **out, size_t *size) const {
     if (writeHeader) {
         astc_header hdr{};
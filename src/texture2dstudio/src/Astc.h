@@ -6,6 +6,23 @@
 #include <cstdint>
 #include "SourceImage.h"
 
+/* ============================================================================
+	ASTC compressed file header, also parsed by TextureContainer
+============================================================================ */
+struct astc_header {
+    uint8_t magic[4];
+    uint8_t block_x;
+    uint8_t block_y;
+    uint8_t block_z;
+    uint8_t dim_x[3];            // dims = dim[0] + (dim[1] << 8) + (dim[2] << 16)
+    uint8_t dim_y[3];            // Sizes are given in texels;
+    uint8_t dim_z[3];            // block count is inferred
+};
+
+static const uint32_t ASTC_MAGIC_ID = 0x5CA1AB13;
+
+class AstcEncoder;
+
 class Astc {
 
 public:
@@ -16,6 +33,14 @@ public:
          unsigned int block_z,
          int header);
 
+    Astc(const uint8_t *pixels, unsigned int width, unsigned int height, size_t stride, float quality,
+         unsigned int block_x, unsigned int block_y, unsigned int block_z, int header);
+
+    // compress with a long lived encoder instead of a per-call context, its block size and quality win
+    void UseEncoder(AstcEncoder *encoder) {
+        m_encoder = encoder;
+    }
+
     int Read();
 
     void Clear();
@@ -34,11 +59,18 @@ private:
     size_t m_filesize = 0;
     const char *m_in = nullptr;
 
+    const uint8_t *m_pixels = nullptr;
+    unsigned int m_width = 0;
+    unsigned int m_height = 0;
+    size_t m_stride = 0;
+
     float m_quality;
     unsigned int m_block_x;
     unsigned int m_block_y;
     unsigned int m_block_z;
 
+    AstcEncoder *m_encoder = nullptr;
+
     astcenc_image *image_uncomp_in = nullptr;
     astcenc_context *codec_context{};
     astc_compressed_image image_comp{};
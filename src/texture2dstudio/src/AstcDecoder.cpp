@@ -0,0 +1,51 @@
+//
+// Created by smalls on 2021/8/14.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include "AstcDecoder.h"
+#include "ThreadPool.h"
+
+AstcDecoder::AstcDecoder(astcenc_profile profile, unsigned int block_x, unsigned int block_y) {
+    // ParallelFor runs on the caller plus at most every pool thread
+    thread_count = ThreadPool::Shared().Size() + 1;
+
+    astcenc_error status = astcenc_config_init(profile, block_x, block_y, 1, ASTCENC_PRE_FASTEST,
+                                               ASTCENC_FLG_DECOMPRESS_ONLY, &config);
+    if (status != ASTCENC_SUCCESS) {
+        printf("ERROR: astcenc_config_init failed: %s\n", astcenc_get_error_string(status));
+        return;
+    }
+
+    status = astcenc_context_alloc(&config, thread_count, &codec_context);
+    if (status != ASTCENC_SUCCESS) {
+        printf("ERROR: Codec context alloc failed: %s\n", astcenc_get_error_string(status));
+        codec_context = nullptr;
+    }
+}
+
+AstcDecoder::~AstcDecoder() {
+    astcenc_context_free(codec_context);
+}
+
+astcenc_error AstcDecoder::DecompressImage(const uint8_t *data, size_t data_len, astcenc_image *image, int jobs) {
+    static const astcenc_swizzle swz_decode{ASTCENC_SWZ_R, ASTCENC_SWZ_G, ASTCENC_SWZ_B, ASTCENC_SWZ_A};
+
+    std::lock_guard<std::mutex> guard(lock);
+
+    unsigned int threads = std::min(thread_count, (unsigned int) std::max(jobs, 1));
+    std::atomic<int> error{ASTCENC_SUCCESS};
+    // each index is a thread_index, the ones the pool never gets to find no blocks left and return
+    ThreadPool::Shared().ParallelFor(threads, threads, [&](size_t i) {
+        astcenc_error status = astcenc_decompress_image(codec_context, data, data_len, image, &swz_decode,
+                                                        (unsigned int) i);
+        if (status != ASTCENC_SUCCESS) {
+            error = status;
+        }
+    });
+
+    astcenc_decompress_reset(codec_context);
+    return (astcenc_error) error.load();
+}
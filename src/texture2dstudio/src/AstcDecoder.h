@@ -0,0 +1,37 @@
+//
+// Created by smalls on 2021/8/14.
+//
+
+#pragma once
+
+#include <astcenc.h>
+#include <mutex>
+
+// A decompress-only astcenc context for one (profile, block size) configuration. Unlike decode_astc,
+// which clamps to 8 bit RGBA, astcenc's decompressor writes U8, FP16 or FP32 texels, so HDR blocks keep
+// their full range. Its threads claim chunks of blocks from the context, so any number of them up to
+// the context's thread count can join one image.
+class AstcDecoder {
+
+public:
+
+    AstcDecoder(astcenc_profile profile, unsigned int block_x, unsigned int block_y);
+
+    ~AstcDecoder();
+
+    bool IsOK() const {
+        return codec_context != nullptr;
+    }
+
+    // Decompresses one image with up to jobs threads of the shared pool and resets the context for the
+    // next one. Calls are serialized, a context only ever works on one image at a time.
+    astcenc_error DecompressImage(const uint8_t *data, size_t data_len, astcenc_image *image, int jobs);
+
+private:
+
+    astcenc_config config{};
+    astcenc_context *codec_context = nullptr;
+    unsigned int thread_count = 1;
+
+    std::mutex lock;
+};
@@ -0,0 +1,52 @@
+//
+// Created by smalls on 2021/8/14.
+//
+
+#include <cstdio>
+#include <vector>
+#include "AstcEncoder.h"
+#include "ThreadPool.h"
+
+AstcEncoder::AstcEncoder(astcenc_profile profile, float quality, unsigned int block_x, unsigned int block_y,
+                         unsigned int block_z, unsigned int flags, unsigned int threads) {
+    thread_count = threads == 0 ? 1 : threads;
+
+    astcenc_error status = astcenc_config_init(profile, block_x, block_y, block_z,
+                                               quality, flags | ASTCENC_FLG_SELF_DECOMPRESS_ONLY, &config);
+    if (status != ASTCENC_SUCCESS) {
+        printf("ERROR: astcenc_config_init failed: %s\n", astcenc_get_error_string(status));
+        return;
+    }
+
+    status = astcenc_context_alloc(&config, thread_count, &codec_context);
+    if (status != ASTCENC_SUCCESS) {
+        printf("ERROR: Codec context alloc failed: %s\n", astcenc_get_error_string(status));
+        codec_context = nullptr;
+    }
+}
+
+AstcEncoder::~AstcEncoder() {
+    astcenc_context_free(codec_context);
+}
+
+astcenc_error AstcEncoder::CompressImage(astcenc_image *image, uint8_t *buffer, size_t buffer_size) {
+    static const astcenc_swizzle swz_encode{ASTCENC_SWZ_R, ASTCENC_SWZ_G, ASTCENC_SWZ_B, ASTCENC_SWZ_A};
+
+    std::lock_guard<std::mutex> guard(lock);
+
+    // every thread_index of a multi-threaded context must join the image. Threads only wait for stages
+    // to complete, not for each other, so the pool may run several indices one after another.
+    std::vector<astcenc_error> errors(thread_count, ASTCENC_SUCCESS);
+    ThreadPool::Shared().ParallelFor(thread_count, thread_count, [&](size_t i) {
+        errors[i] = astcenc_compress_image(codec_context, image, &swz_encode, buffer, buffer_size, (unsigned int) i);
+    });
+
+    astcenc_compress_reset(codec_context);
+
+    for (astcenc_error error : errors) {
+        if (error != ASTCENC_SUCCESS) {
+            return error;
+        }
+    }
+    return ASTCENC_SUCCESS;
+}
@@ -0,0 +1,42 @@
+//
+// Created by smalls on 2021/8/14.
+//
+
+#pragma once
+
+#include <astcenc.h>
+#include <mutex>
+
+// A long lived astcenc context for one (profile, block size, quality, flags, threads) configuration.
+// astcenc_context_alloc builds the block size descriptor, partition tables and working buffers, which
+// for small images costs more than the compression itself, so callers compressing many images keep
+// one of these around instead of going through a fresh context per image.
+class AstcEncoder {
+
+public:
+
+    AstcEncoder(astcenc_profile profile, float quality, unsigned int block_x, unsigned int block_y,
+                unsigned int block_z, unsigned int flags, unsigned int threads);
+
+    ~AstcEncoder();
+
+    bool IsOK() const {
+        return codec_context != nullptr;
+    }
+
+    const astcenc_config &GetConfig() const {
+        return config;
+    }
+
+    // Compresses one image and resets the context for the next one. Calls are serialized, a context
+    // only ever works on one image at a time.
+    astcenc_error CompressImage(astcenc_image *image, uint8_t *buffer, size_t buffer_size);
+
+private:
+
+    astcenc_config config{};
+    astcenc_context *codec_context = nullptr;
+    unsigned int thread_count = 1;
+
+    std::mutex lock;
+};
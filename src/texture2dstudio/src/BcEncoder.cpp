@@ -0,0 +1,506 @@
+//
+// Created by smalls on 2021/8/14.
+//
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include "BcEncoder.h"
+
+static const int BC7_WEIGHTS4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+// Endpoints of 5 and 6 bit channels whose 2/3 interpolation (the decoder's (2 * c0 + c1) / 3) is closest
+// to each 8 bit value, preferring close endpoints that other decoders round alike, and for BC7 the
+// nearest of the 16 weights to each position 0..64 along the endpoint line
+struct BcTables {
+    uint8_t match5[256][2];
+    uint8_t match6[256][2];
+    uint8_t bc7_weight[65];
+
+    BcTables() {
+        prepareMatch(match5, 5);
+        prepareMatch(match6, 6);
+        for (int t = 0; t <= 64; t++) {
+            int best = 0;
+            for (int i = 1; i < 16; i++) {
+                if (std::abs(BC7_WEIGHTS4[i] - t) < std::abs(BC7_WEIGHTS4[best] - t)) {
+                    best = i;
+                }
+            }
+            bc7_weight[t] = (uint8_t) best;
+        }
+    }
+
+    static int expand(int v, int bits) {
+        return bits == 5 ? (v << 3 | v >> 2) : (v << 2 | v >> 4);
+    }
+
+    static void prepareMatch(uint8_t table[256][2], int bits) {
+        int size = 1 << bits;
+        for (int v = 0; v < 256; v++) {
+            int best = INT_MAX;
+            for (int hi = 0; hi < size; hi++) {
+                for (int lo = 0; lo < size; lo++) {
+                    int e0 = expand(hi, bits), e1 = expand(lo, bits);
+                    int error = std::abs((2 * e0 + e1) / 3 - v) * 100 + std::abs(e0 - e1) * 3;
+                    if (error < best) {
+                        best = error;
+                        table[v][0] = (uint8_t) hi;
+                        table[v][1] = (uint8_t) lo;
+                    }
+                }
+            }
+        }
+    }
+};
+
+static const BcTables &tables() {
+    static const BcTables instance;
+    return instance;
+}
+
+// r, g, b, a of each texel
+static void loadTexels(const uint32_t *texels, int px[16][4]) {
+    const uint8_t *p = (const uint8_t *) texels;
+    for (int i = 0; i < 16; i++, p += 4) {
+        px[i][0] = p[2];
+        px[i][1] = p[1];
+        px[i][2] = p[0];
+        px[i][3] = p[3];
+    }
+}
+
+// Principal axis of the first N channels of the texels in mask, by power iteration on the covariance
+template<int N>
+static void principalAxis(const int px[16][4], uint32_t mask, float axis[N]) {
+    int sum[N] = {}, products[N][N] = {}, count = 0;
+    for (int i = 0; i < 16; i++) {
+        int m = -(int) (mask >> i & 1);
+        for (int a = 0; a < N; a++) {
+            int v = px[i][a] & m;
+            sum[a] += v;
+            for (int b = a; b < N; b++) {
+                products[a][b] += v * px[i][b];
+            }
+        }
+        count -= m;
+    }
+    float cov[N][N];
+    const float inverse_count = 1.0f / (float) count;
+    int widest = 0;
+    for (int a = 0; a < N; a++) {
+        for (int b = a; b < N; b++) {
+            cov[a][b] = cov[b][a] = (float) products[a][b] - (float) sum[a] * (float) sum[b] * inverse_count;
+        }
+        if (cov[a][a] > cov[widest][widest]) {
+            widest = a;
+        }
+    }
+    // start from the covariance row of the widest channel, which already leans towards the axis
+    for (int c = 0; c < N; c++) {
+        axis[c] = cov[widest][c];
+    }
+    for (int iteration = 0; iteration < 4; iteration++) {
+        float next[N] = {}, scale = 0;
+        for (int a = 0; a < N; a++) {
+            for (int b = 0; b < N; b++) {
+                next[a] += cov[a][b] * axis[b];
+            }
+            scale = std::max(scale, std::fabs(next[a]));
+        }
+        if (scale < 1e-6f) {
+            break;
+        }
+        scale = 1.0f / scale;
+        for (int c = 0; c < N; c++) {
+            axis[c] = next[c] * scale;
+        }
+    }
+}
+
+// The texels in mask furthest apart along axis
+template<int N>
+static void axisExtremes(const int px[16][4], uint32_t mask, const float *axis, int *low, int *high) {
+    float min = INFINITY, max = -INFINITY;
+    *low = *high = 0;
+    for (int i = 0; i < 16; i++) {
+        if (mask >> i & 1) {
+            float t = 0;
+            for (int c = 0; c < N; c++) {
+                t += axis[c] * (float) px[i][c];
+            }
+            if (t < min) {
+                min = t;
+                *low = i;
+            }
+            if (t > max) {
+                max = t;
+                *high = i;
+            }
+        }
+    }
+}
+
+static inline int mul8bit(int a, int b) {
+    int t = a * b + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+static inline int clamp255(float v) {
+    return v < 0 ? 0 : v > 255 ? 255 : (int) (v + 0.5f);
+}
+
+static inline uint16_t pack565(int r, int g, int b) {
+    return (uint16_t) (mul8bit(r, 31) << 11 | mul8bit(g, 63) << 5 | mul8bit(b, 31));
+}
+
+static inline void unpack565(uint16_t q, int c[3]) {
+    int r = q >> 11, g = q >> 5 & 63, b = q & 31;
+    c[0] = r << 3 | r >> 2;
+    c[1] = g << 2 | g >> 4;
+    c[2] = b << 3 | b >> 2;
+}
+
+struct Bc1Block {
+    uint16_t q0;
+    uint16_t q1;
+    uint32_t indices;
+    int error;
+};
+
+// Orders the endpoints for the 4 colour (q0 > q1) or 3 colour mode and picks the closest palette
+// entry of every texel in opaque, the others get the transparent index 3
+static Bc1Block bc1Indices(uint16_t q0, uint16_t q1, const int px[16][4], uint32_t opaque, bool three) {
+    if (three ? q0 > q1 : q0 < q1) {
+        std::swap(q0, q1);
+    }
+    Bc1Block block{q0, q1, 0, 0};
+    int palette[4][3], count;
+    unpack565(q0, palette[0]);
+    unpack565(q1, palette[1]);
+    if (!three && q0 > q1) {
+        for (int c = 0; c < 3; c++) {
+            palette[2][c] = (palette[0][c] * 2 + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + palette[1][c] * 2) / 3;
+        }
+        count = 4;
+    } else if (!three) {
+        // equal endpoints decode in the 3 colour mode, where only index 0 is safe
+        count = 1;
+    } else {
+        for (int c = 0; c < 3; c++) {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+        }
+        count = 3;
+    }
+    if (count == 4) {
+        // 4 collinear entries: split the projections on c0 - c1 halfway between neighbouring entries
+        int dir[3], stops[4];
+        for (int c = 0; c < 3; c++) {
+            dir[c] = palette[0][c] - palette[1][c];
+        }
+        for (int k = 0; k < 4; k++) {
+            stops[k] = palette[k][0] * dir[0] + palette[k][1] * dir[1] + palette[k][2] * dir[2];
+        }
+        // entries along c0 - c1 in the order 1, 3, 2, 0, counting the midpoints passed gives the index
+        static const int ORDER[4] = {1, 3, 2, 0};
+        int c0_point = stops[1] + stops[3], half_point = stops[3] + stops[2], c3_point = stops[2] + stops[0];
+        for (int i = 0; i < 16; i++) {
+            int dot = 2 * (px[i][0] * dir[0] + px[i][1] * dir[1] + px[i][2] * dir[2]);
+            int index = ORDER[(dot >= c0_point) + (dot >= half_point) + (dot >= c3_point)];
+            int dr = px[i][0] - palette[index][0], dg = px[i][1] - palette[index][1], db = px[i][2] - palette[index][2];
+            block.indices |= (uint32_t) index << 2 * i;
+            block.error += dr * dr + dg * dg + db * db;
+        }
+        return block;
+    }
+    for (int i = 0; i < 16; i++) {
+        if (!(opaque >> i & 1)) {
+            block.indices |= 3u << 2 * i;
+            continue;
+        }
+        int best = INT_MAX, index = 0;
+        for (int k = 0; k < count; k++) {
+            int dr = px[i][0] - palette[k][0], dg = px[i][1] - palette[k][1], db = px[i][2] - palette[k][2];
+            int error = dr * dr + dg * dg + db * db;
+            if (error < best) {
+                best = error;
+                index = k;
+            }
+        }
+        block.indices |= (uint32_t) index << 2 * i;
+        block.error += best;
+    }
+    return block;
+}
+
+// Least squares endpoints for the indices of block
+static bool bc1Refine(const Bc1Block &block, const int px[16][4], uint32_t opaque, bool three, uint16_t *q0,
+                      uint16_t *q1) {
+    // weights of (c0, c1) per index, times scale
+    static const int WEIGHTS4[4][2] = {{3, 0}, {0, 3}, {2, 1}, {1, 2}};
+    static const int WEIGHTS3[4][2] = {{2, 0}, {0, 2}, {1, 1}, {0, 0}};
+    const int (*weights)[2] = three ? WEIGHTS3 : WEIGHTS4;
+    const float scale = three ? 2.0f : 3.0f;
+    if (block.q0 == block.q1) {
+        return false;
+    }
+    int aa = 0, bb = 0, ab = 0, ax[3] = {}, bx[3] = {};
+    for (int i = 0; i < 16; i++) {
+        if (!(opaque >> i & 1)) {
+            continue;
+        }
+        const int *w = weights[block.indices >> 2 * i & 3];
+        aa += w[0] * w[0];
+        bb += w[1] * w[1];
+        ab += w[0] * w[1];
+        for (int c = 0; c < 3; c++) {
+            ax[c] += w[0] * px[i][c];
+            bx[c] += w[1] * px[i][c];
+        }
+    }
+    float det = (float) aa * (float) bb - (float) ab * (float) ab;
+    if (det == 0) {
+        return false;
+    }
+    float f = scale / det;
+    int e0[3], e1[3];
+    for (int c = 0; c < 3; c++) {
+        e0[c] = clamp255(((float) bb * ax[c] - (float) ab * bx[c]) * f);
+        e1[c] = clamp255(((float) aa * bx[c] - (float) ab * ax[c]) * f);
+    }
+    *q0 = pack565(e0[0], e0[1], e0[2]);
+    *q1 = pack565(e1[0], e1[1], e1[2]);
+    return true;
+}
+
+static Bc1Block bc1Fit(const int px[16][4], uint32_t opaque, bool three) {
+    int min[3] = {255, 255, 255}, max[3] = {0, 0, 0};
+    for (int i = 0; i < 16; i++) {
+        if (opaque >> i & 1) {
+            for (int c = 0; c < 3; c++) {
+                min[c] = std::min(min[c], px[i][c]);
+                max[c] = std::max(max[c], px[i][c]);
+            }
+        }
+    }
+    if (min[0] == max[0] && min[1] == max[1] && min[2] == max[2]) {
+        if (three) {
+            uint16_t q = pack565(min[0], min[1], min[2]);
+            return bc1Indices(q, q, px, opaque, three);
+        }
+        const BcTables &t = tables();
+        uint16_t q0 = (uint16_t) (t.match5[min[0]][0] << 11 | t.match6[min[1]][0] << 5 | t.match5[min[2]][0]);
+        uint16_t q1 = (uint16_t) (t.match5[min[0]][1] << 11 | t.match6[min[1]][1] << 5 | t.match5[min[2]][1]);
+        return bc1Indices(q0, q1, px, opaque, three);
+    }
+    float axis[3];
+    int low, high;
+    principalAxis<3>(px, opaque, axis);
+    axisExtremes<3>(px, opaque, axis, &low, &high);
+    Bc1Block block = bc1Indices(pack565(px[high][0], px[high][1], px[high][2]),
+                                pack565(px[low][0], px[low][1], px[low][2]), px, opaque, three);
+    uint16_t q0, q1;
+    if (block.error > 0 && bc1Refine(block, px, opaque, three, &q0, &q1)) {
+        Bc1Block refined = bc1Indices(q0, q1, px, opaque, three);
+        if (refined.error < block.error) {
+            block = refined;
+        }
+    }
+    return block;
+}
+
+static void writeBc1(const Bc1Block &block, uint8_t *out) {
+    out[0] = (uint8_t) block.q0;
+    out[1] = (uint8_t) (block.q0 >> 8);
+    out[2] = (uint8_t) block.q1;
+    out[3] = (uint8_t) (block.q1 >> 8);
+    for (int i = 0; i < 4; i++) {
+        out[4 + i] = (uint8_t) (block.indices >> 8 * i);
+    }
+}
+
+void EncodeBc1Block(const uint32_t *texels, bool punch_through, uint8_t *out) {
+    int px[16][4];
+    loadTexels(texels, px);
+    uint32_t opaque = 0xffff;
+    if (punch_through) {
+        for (int i = 0; i < 16; i++) {
+            if (px[i][3] < 128) {
+                opaque &= ~(1u << i);
+            }
+        }
+    }
+    if (opaque == 0) {
+        writeBc1({0, 0, 0xffffffff, 0}, out);
+        return;
+    }
+    writeBc1(bc1Fit(px, opaque, opaque != 0xffff), out);
+}
+
+void EncodeBc3Block(const uint32_t *texels, uint8_t *out) {
+    int px[16][4];
+    loadTexels(texels, px);
+    int a0 = 0, a1 = 255;
+    for (int i = 0; i < 16; i++) {
+        a0 = std::max(a0, px[i][3]);
+        a1 = std::min(a1, px[i][3]);
+    }
+    // 8 alpha mode (a0 > a1) spanning the block's range
+    uint64_t indices = 0;
+    if (a0 > a1) {
+        int palette[8] = {a0, a1};
+        for (int k = 1; k < 7; k++) {
+            palette[k + 1] = (a0 * (7 - k) + a1 * k) / 7;
+        }
+        for (int i = 0; i < 16; i++) {
+            int best = INT_MAX, index = 0;
+            for (int k = 0; k < 8; k++) {
+                int error = std::abs(px[i][3] - palette[k]);
+                if (error < best) {
+                    best = error;
+                    index = k;
+                }
+            }
+            indices |= (uint64_t) index << 3 * i;
+        }
+    }
+    out[0] = (uint8_t) a0;
+    out[1] = (uint8_t) a1;
+    for (int i = 0; i < 6; i++) {
+        out[2 + i] = (uint8_t) (indices >> 8 * i);
+    }
+    writeBc1(bc1Fit(px, 0xffff, false), out + 8);
+}
+
+struct Bc7Block {
+    int q[2][4];
+    int p[2];
+    uint8_t indices[16];
+    int error;
+};
+
+// 7 bit endpoint plus the p-bit with the smaller error, v holds whole numbers 0..255
+static void bc7Quantize(const float v[4], int q[4], int *p) {
+    int best = INT_MAX;
+    for (int pbit = 0; pbit < 2; pbit++) {
+        int candidate[4], error = 0;
+        for (int c = 0; c < 4; c++) {
+            candidate[c] = std::min(127, std::max(0, (int) ((v[c] - (float) pbit) * 0.5f + 0.5f)));
+            int d = (candidate[c] << 1 | pbit) - (int) v[c];
+            error += d * d;
+        }
+        if (error < best) {
+            best = error;
+            *p = pbit;
+            memcpy(q, candidate, sizeof(candidate));
+        }
+    }
+}
+
+// Weights by projecting every texel on the endpoint line, then the block's squared error
+static void bc7Indices(Bc7Block &block, const int px[16][4]) {
+    int e[2][4], d[4], dd = 0;
+    for (int c = 0; c < 4; c++) {
+        e[0][c] = block.q[0][c] << 1 | block.p[0];
+        e[1][c] = block.q[1][c] << 1 | block.p[1];
+        d[c] = e[1][c] - e[0][c];
+        dd += d[c] * d[c];
+    }
+    const BcTables &t = tables();
+    // 64 / dd in 16.16 fixed point
+    const int64_t scale = dd > 0 ? ((int64_t) 64 << 16) / dd : 0;
+    block.error = 0;
+    for (int i = 0; i < 16; i++) {
+        int dot = 0;
+        for (int c = 0; c < 4; c++) {
+            dot += (px[i][c] - e[0][c]) * d[c];
+        }
+        int index = t.bc7_weight[std::min<int64_t>(64, std::max<int64_t>(0, (dot * scale + 32768) >> 16))];
+        block.indices[i] = (uint8_t) index;
+        int w = BC7_WEIGHTS4[index];
+        for (int c = 0; c < 4; c++) {
+            int diff = (((64 - w) * e[0][c] + w * e[1][c] + 32) >> 6) - px[i][c];
+            block.error += diff * diff;
+        }
+    }
+}
+
+static bool bc7Refine(const Bc7Block &block, const int px[16][4], Bc7Block &refined) {
+    int aa = 0, bb = 0, ab = 0, ax[4] = {}, bx[4] = {};
+    for (int i = 0; i < 16; i++) {
+        int w1 = BC7_WEIGHTS4[block.indices[i]], w0 = 64 - w1;
+        aa += w0 * w0;
+        bb += w1 * w1;
+        ab += w0 * w1;
+        for (int c = 0; c < 4; c++) {
+            ax[c] += w0 * px[i][c];
+            bx[c] += w1 * px[i][c];
+        }
+    }
+    float det = (float) aa * (float) bb - (float) ab * (float) ab;
+    if (det == 0) {
+        return false;
+    }
+    float f = 64.0f / det, e0[4], e1[4];
+    for (int c = 0; c < 4; c++) {
+        e0[c] = (float) clamp255(((float) bb * ax[c] - (float) ab * bx[c]) * f);
+        e1[c] = (float) clamp255(((float) aa * bx[c] - (float) ab * ax[c]) * f);
+    }
+    bc7Quantize(e0, refined.q[0], &refined.p[0]);
+    bc7Quantize(e1, refined.q[1], &refined.p[1]);
+    bc7Indices(refined, px);
+    return true;
+}
+
+static void bitsPut(uint8_t *out, int &pos, uint32_t value, int bits) {
+    for (int i = 0; i < bits; i++, pos++) {
+        if (value >> i & 1) {
+            out[pos >> 3] |= (uint8_t) (1 << (pos & 7));
+        }
+    }
+}
+
+void EncodeBc7Block(const uint32_t *texels, uint8_t *out) {
+    int px[16][4];
+    loadTexels(texels, px);
+    float axis[4];
+    int low, high;
+    principalAxis<4>(px, 0xffff, axis);
+    axisExtremes<4>(px, 0xffff, axis, &low, &high);
+    Bc7Block block;
+    float e0[4], e1[4];
+    for (int c = 0; c < 4; c++) {
+        e0[c] = (float) px[low][c];
+        e1[c] = (float) px[high][c];
+    }
+    bc7Quantize(e0, block.q[0], &block.p[0]);
+    bc7Quantize(e1, block.q[1], &block.p[1]);
+    bc7Indices(block, px);
+    Bc7Block refined;
+    if (block.error > 0 && bc7Refine(block, px, refined) && refined.error < block.error) {
+        block = refined;
+    }
+    // the first texel's index is stored without its top bit
+    if (block.indices[0] & 8) {
+        std::swap(block.q[0], block.q[1]);
+        std::swap(block.p[0], block.p[1]);
+        for (int i = 0; i < 16; i++) {
+            block.indices[i] = (uint8_t) (15 - block.indices[i]);
+        }
+    }
+    memset(out, 0, 16);
+    int pos = 0;
+    bitsPut(out, pos, 1 << 6, 7);
+    for (int c = 0; c < 4; c++) {
+        bitsPut(out, pos, (uint32_t) block.q[0][c], 7);
+        bitsPut(out, pos, (uint32_t) block.q[1][c], 7);
+    }
+    bitsPut(out, pos, (uint32_t) block.p[0], 1);
+    bitsPut(out, pos, (uint32_t) block.p[1], 1);
+    bitsPut(out, pos, block.indices[0], 3);
+    for (int i = 1; i < 16; i++) {
+        bitsPut(out, pos, block.indices[i], 4);
+    }
+}
@@ -0,0 +1,20 @@
+//
+// Created by smalls on 2021/8/14.
+//
+
+#pragma once
+
+#include <cstdint>
+
+// Fast single pass BCn block encoders for already decoded blocks: endpoints are the extremes along the
+// principal axis of the block, refined once by least squares, instead of a search over candidate
+// endpoints. texels are 16 color() texels (BGRA bytes), row by row.
+
+// 8 bytes. punch_through uses the 3 colour mode with texels of alpha < 128 transparent when there are any.
+void EncodeBc1Block(const uint32_t *texels, bool punch_through, uint8_t *out);
+
+// 16 bytes
+void EncodeBc3Block(const uint32_t *texels, uint8_t *out);
+
+// 16 bytes, mode 6: one RGBA endpoint pair with 16 weights
+void EncodeBc7Block(const uint32_t *texels, uint8_t *out);
@@ -0,0 +1,54 @@
+//
+// Created by smalls on 2021/8/14.
+//
+
+#include <algorithm>
+#include "CrunchDecoder.h"
+
+CrunchDecoder::~CrunchDecoder() {
+    if (context != nullptr) {
+        unity_crunch_end(context);
+    }
+}
+
+bool CrunchDecoder::Open(const uint8_t *data, size_t size) {
+    if (context != nullptr || size > UINT32_MAX) {
+        return false;
+    }
+    file.assign(data, data + size);
+    context = unity_crunch_begin(file.data(), (uint32_t) file.size(), &info);
+    return context != nullptr;
+}
+
+uint32_t CrunchDecoder::LevelWidth(uint32_t level) const {
+    return std::max(1U, info.width >> level);
+}
+
+uint32_t CrunchDecoder::LevelHeight(uint32_t level) const {
+    return std::max(1U, info.height >> level);
+}
+
+const uint8_t *CrunchDecoder::Unpack(uint32_t level, uint32_t face) {
+    if (context == nullptr || level >= info.levels || face >= info.faces) {
+        return nullptr;
+    }
+    if (unpacked_level != (int64_t) level) {
+        uint32_t blocks_x = (LevelWidth(level) + 3) / 4;
+        uint32_t blocks_y = (LevelHeight(level) + 3) / 4;
+        face_size = blocks_x * blocks_y * info.bytes_per_block;
+        // sized for the largest level unpacked so far, later (smaller) mips reuse it
+        if (blocks.size() < (size_t) face_size * info.faces) {
+            blocks.resize((size_t) face_size * info.faces);
+        }
+        uint8_t *faces[6];
+        for (uint32_t i = 0; i < info.faces; i++) {
+            faces[i] = blocks.data() + (size_t) face_size * i;
+        }
+        unpacked_level = -1;
+        if (!unity_crunch_unpack(context, level, faces, face_size)) {
+            return nullptr;
+        }
+        unpacked_level = level;
+    }
+    return blocks.data() + (size_t) face_size * face;
+}
@@ -0,0 +1,48 @@
+//
+// Created by smalls on 2021/8/14.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <unitycrunch.h>
+
+// One .crn file opened for unpacking. The crunch context (palettes and huffman tables) is set up
+// once, and the last unpacked level stays in reusable block buffers, so reading several faces of a
+// level or walking the mip chain costs one unpack per level and no per-level allocations.
+class CrunchDecoder {
+
+public:
+
+    CrunchDecoder() = default;
+
+    ~CrunchDecoder();
+
+    CrunchDecoder(const CrunchDecoder &) = delete;
+
+    CrunchDecoder &operator=(const CrunchDecoder &) = delete;
+
+    // copies the file, false if it is not a crunch texture crnd can unpack
+    bool Open(const uint8_t *data, size_t size);
+
+    // block data of a face of `level`, tightly packed 4x4 blocks; null on a bad level or face.
+    // The pointer stays valid until another level is unpacked, callers hold `lock` meanwhile.
+    const uint8_t *Unpack(uint32_t level, uint32_t face);
+
+    uint32_t LevelWidth(uint32_t level) const;
+
+    uint32_t LevelHeight(uint32_t level) const;
+
+    unity_crunch_info info{};
+    std::mutex lock;
+
+private:
+
+    std::vector<uint8_t> file;
+    void *context = nullptr;
+    std::vector<uint8_t> blocks;
+    uint32_t face_size = 0;
+    int64_t unpacked_level = -1;
+};
@@ -0,0 +1,23 @@
+//
+// Created by smalls on 2021/8/14.
+//
+
+#pragma once
+
+#include <Etc.h>
+
+// Encoder settings bound once and reused for every image. etc2comp keeps no per-context tables
+// (Etc::Encode sets up its block state per image), so this only pins the parameters.
+class EtcEncoder {
+
+public:
+
+    EtcEncoder(Etc::Image::Format format, bool mipmap, float fEffort, int jobs)
+            : format(format), mipmap(mipmap), fEffort(fEffort), jobs(jobs) {
+    }
+
+    Etc::Image::Format format;
+    bool mipmap;
+    float fEffort;
+    int jobs;
+};
@@ -0,0 +1,544 @@
+//
+// Created by smalls on 2021/8/14.
+//
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include "EtcFastEncoder.h"
+#include "ThreadPool.h"
+#include "simd.h"
+
+static const int ETC1_MODIFIERS[8][2] = {{2, 8}, {5, 17}, {9, 29}, {13, 42}, {18, 60}, {24, 80}, {33, 106}, {47, 183}};
+
+static const int16_t EAC_MODIFIERS[16][8] = {
+        {-3, -6, -9, -15, 2, 5, 8, 14},
+        {-3, -7, -10, -13, 2, 6, 9, 12},
+        {-2, -5, -8, -13, 1, 4, 7, 12},
+        {-2, -4, -6, -13, 1, 3, 5, 12},
+        {-3, -6, -8, -12, 2, 5, 7, 11},
+        {-3, -7, -9, -11, 2, 6, 8, 10},
+        {-4, -7, -8, -11, 3, 6, 7, 10},
+        {-3, -5, -8, -11, 2, 4, 7, 10},
+        {-2, -6, -8, -10, 1, 5, 7, 9},
+        {-2, -5, -8, -10, 1, 4, 7, 9},
+        {-2, -4, -8, -10, 1, 3, 7, 9},
+        {-2, -5, -7, -10, 1, 4, 6, 9},
+        {-3, -4, -7, -10, 2, 3, 6, 9},
+        {-1, -2, -3, -10, 0, 1, 2, 9},
+        {-4, -6, -8, -9, 3, 5, 7, 8},
+        {-3, -5, -7, -9, 2, 4, 6, 8}};
+
+// Texels of each half block in ETC order (texel x * 4 + y): flip 0 splits columns 0-1 / 2-3,
+// flip 1 rows 0-1 / 2-3
+static const int HALF_TEXELS[2][2][8] = {
+        {{0, 1, 2, 3, 4, 5, 6, 7}, {8, 9, 10, 11, 12, 13, 14, 15}},
+        {{0, 1, 4, 5, 8, 9, 12, 13}, {2, 3, 6, 7, 10, 11, 14, 15}}};
+
+static inline int clamp255(int v) {
+    return v < 0 ? 0 : v > 255 ? 255 : v;
+}
+
+// Base and multiplier stretching EAC table t over the alpha range low..high: index 3 holds the most
+// negative modifier and 7 the most positive
+static inline void eacSpan(int t, int low, int high, int *base, int *multiplier) {
+    const int16_t *modifiers = EAC_MODIFIERS[t];
+    const int span = modifiers[7] - modifiers[3];
+    *multiplier = std::max(1, std::min(15, (high - low + span / 2) / span));
+    *base = clamp255((low + high - (modifiers[3] + modifiers[7]) * *multiplier + 1) / 2);
+}
+
+// Searches are done by a kernel class picked once from simd_level():
+//   table(sums)              - ETC1 table of a half block. sums[i] is the absolute sum of texel i's channel
+//                              differences to the base colour: a modifier m of the right sign then costs
+//                              3m^2 - 2m * sums[i] more than the error every table shares, and a table
+//                              costs the sum over its 8 texels of the cheaper of its two modifiers
+//   alpha(alpha, low, high)  - EAC table whose eacSpan() palette fits the 16 alphas best, each on its
+//                              nearest entry
+namespace {
+
+struct ScalarKernel {
+    static int table(const int32_t *sums) {
+        int best = 0, bestCost = INT_MAX;
+        for (int t = 0; t < 8; t++) {
+            const int a = ETC1_MODIFIERS[t][0], b = ETC1_MODIFIERS[t][1];
+            int cost = 0;
+            for (int i = 0; i < 8; i++) {
+                cost += std::min(3 * a * a - 2 * a * sums[i], 3 * b * b - 2 * b * sums[i]);
+            }
+            if (cost < bestCost) {
+                bestCost = cost;
+                best = t;
+            }
+        }
+        return best;
+    }
+
+    static int alpha(const int16_t *alpha, int low, int high) {
+        int best = 0, bestError = INT_MAX;
+        for (int t = 0; t < 16 && bestError > 0; t++) {
+            int base, multiplier;
+            eacSpan(t, low, high, &base, &multiplier);
+            int palette[8];
+            for (int i = 0; i < 8; i++) {
+                palette[i] = clamp255(base + multiplier * EAC_MODIFIERS[t][i]);
+            }
+            int error = 0;
+            for (int p = 0; p < 16; p++) {
+                int nearest = INT_MAX;
+                for (int i = 0; i < 8; i++) {
+                    nearest = std::min(nearest, std::abs(alpha[p] - palette[i]));
+                }
+                error += nearest * nearest;
+            }
+            if (error < bestError) {
+                bestError = error;
+                best = t;
+            }
+        }
+        return best;
+    }
+};
+
+#if defined(TEXTURE2D_SIMD_X86)
+
+struct Sse41Kernel {
+    SIMD_TARGET_SSE41 static int table(const int32_t *sums) {
+        const __m128i s0 = _mm_loadu_si128((const __m128i *) sums);
+        const __m128i s1 = _mm_loadu_si128((const __m128i *) (sums + 4));
+        int best = 0, bestCost = INT_MAX;
+        for (int t = 0; t < 8; t++) {
+            const int a = ETC1_MODIFIERS[t][0], b = ETC1_MODIFIERS[t][1];
+            const __m128i va = _mm_set1_epi32(2 * a), ca = _mm_set1_epi32(3 * a * a);
+            const __m128i vb = _mm_set1_epi32(2 * b), cb = _mm_set1_epi32(3 * b * b);
+            __m128i cost = _mm_add_epi32(
+                    _mm_min_epi32(_mm_sub_epi32(ca, _mm_mullo_epi32(va, s0)), _mm_sub_epi32(cb, _mm_mullo_epi32(vb, s0))),
+                    _mm_min_epi32(_mm_sub_epi32(ca, _mm_mullo_epi32(va, s1)), _mm_sub_epi32(cb, _mm_mullo_epi32(vb, s1))));
+            cost = _mm_add_epi32(cost, _mm_shuffle_epi32(cost, 0x4e));
+            cost = _mm_add_epi32(cost, _mm_shuffle_epi32(cost, 0xb1));
+            const int total = _mm_cvtsi128_si32(cost);
+            if (total < bestCost) {
+                bestCost = total;
+                best = t;
+            }
+        }
+        return best;
+    }
+
+    // clamp(base + multiplier * modifiers) of table t
+    SIMD_TARGET_SSE41 static inline __m128i palette(int t, int low, int high) {
+        int base, multiplier;
+        eacSpan(t, low, high, &base, &multiplier);
+        const __m128i modifiers = _mm_loadu_si128((const __m128i *) EAC_MODIFIERS[t]);
+        const __m128i entries = _mm_add_epi16(_mm_set1_epi16((short) base),
+                                              _mm_mullo_epi16(_mm_set1_epi16((short) multiplier), modifiers));
+        return _mm_min_epi16(_mm_max_epi16(entries, _mm_setzero_si128()), _mm_set1_epi16(255));
+    }
+
+    SIMD_TARGET_SSE41 static int alpha(const int16_t *alpha, int low, int high) {
+        const __m128i a0 = _mm_loadu_si128((const __m128i *) alpha);
+        const __m128i a1 = _mm_loadu_si128((const __m128i *) (alpha + 8));
+        int best = 0, bestError = INT_MAX;
+        for (int t = 0; t < 16 && bestError > 0; t++) {
+            int16_t entries[8];
+            _mm_storeu_si128((__m128i *) entries, palette(t, low, high));
+            __m128i d0 = _mm_set1_epi16(255), d1 = d0;
+            for (int i = 0; i < 8; i++) {
+                const __m128i entry = _mm_set1_epi16(entries[i]);
+                d0 = _mm_min_epi16(d0, _mm_abs_epi16(_mm_sub_epi16(a0, entry)));
+                d1 = _mm_min_epi16(d1, _mm_abs_epi16(_mm_sub_epi16(a1, entry)));
+            }
+            __m128i error = _mm_add_epi32(_mm_madd_epi16(d0, d0), _mm_madd_epi16(d1, d1));
+            error = _mm_add_epi32(error, _mm_shuffle_epi32(error, 0x4e));
+            error = _mm_add_epi32(error, _mm_shuffle_epi32(error, 0xb1));
+            const int total = _mm_cvtsi128_si32(error);
+            if (total < bestError) {
+                bestError = total;
+                best = t;
+            }
+        }
+        return best;
+    }
+};
+
+struct Avx2Kernel {
+    // all eight tables at once: lane t of the running total is table t's cost
+    SIMD_TARGET_AVX2 static int table(const int32_t *sums) {
+        // 2a, 2b, 3a^2 and 3b^2 of every table
+        const __m256i va = _mm256_setr_epi32(4, 10, 18, 26, 36, 48, 66, 94);
+        const __m256i vb = _mm256_setr_epi32(16, 34, 58, 84, 120, 160, 212, 366);
+        const __m256i ca = _mm256_setr_epi32(12, 75, 243, 507, 972, 1728, 3267, 6627);
+        const __m256i cb = _mm256_setr_epi32(192, 867, 2523, 5292, 10800, 19200, 33708, 100467);
+        __m256i cost = _mm256_setzero_si256();
+        for (int i = 0; i < 8; i++) {
+            const __m256i s = _mm256_set1_epi32(sums[i]);
+            cost = _mm256_add_epi32(cost, _mm256_min_epi32(_mm256_sub_epi32(ca, _mm256_mullo_epi32(va, s)),
+                                                           _mm256_sub_epi32(cb, _mm256_mullo_epi32(vb, s))));
+        }
+        int32_t costs[8];
+        _mm256_storeu_si256((__m256i *) costs, cost);
+        int best = 0;
+        for (int t = 1; t < 8; t++) {
+            if (costs[t] < costs[best]) {
+                best = t;
+            }
+        }
+        return best;
+    }
+
+    SIMD_TARGET_AVX2 static int alpha(const int16_t *alpha, int low, int high) {
+        const __m256i a = _mm256_loadu_si256((const __m256i *) alpha);
+        int best = 0, bestError = INT_MAX;
+        for (int t = 0; t < 16 && bestError > 0; t++) {
+            int16_t entries[8];
+            _mm_storeu_si128((__m128i *) entries, Sse41Kernel::palette(t, low, high));
+            __m256i d = _mm256_set1_epi16(255);
+            for (int i = 0; i < 8; i++) {
+                d = _mm256_min_epi16(d, _mm256_abs_epi16(_mm256_sub_epi16(a, _mm256_set1_epi16(entries[i]))));
+            }
+            const __m256i error8 = _mm256_madd_epi16(d, d);
+            __m128i error = _mm_add_epi32(_mm256_castsi256_si128(error8), _mm256_extracti128_si256(error8, 1));
+            error = _mm_add_epi32(error, _mm_shuffle_epi32(error, 0x4e));
+            error = _mm_add_epi32(error, _mm_shuffle_epi32(error, 0xb1));
+            const int total = _mm_cvtsi128_si32(error);
+            if (total < bestError) {
+                bestError = total;
+                best = t;
+            }
+        }
+        return best;
+    }
+};
+
+#endif
+
+}  // namespace
+
+struct FastKernels {
+    int (*table)(const int32_t *sums);
+    int (*alpha)(const int16_t *alpha, int low, int high);
+};
+
+template<class Kernel>
+static FastKernels fast_kernels() {
+    FastKernels kernels = {Kernel::table, Kernel::alpha};
+    return kernels;
+}
+
+static FastKernels select_fast_kernels() {
+#if defined(TEXTURE2D_SIMD_X86)
+    switch (simd_level()) {
+    case SIMD_AVX2:
+        return fast_kernels<Avx2Kernel>();
+    case SIMD_SSE41:
+        return fast_kernels<Sse41Kernel>();
+    default:
+        break;
+    }
+#endif
+    return fast_kernels<ScalarKernel>();
+}
+
+static const FastKernels &kernels() {
+    static const FastKernels instance = select_fast_kernels();
+    return instance;
+}
+
+// One block in ETC order (texel x * 4 + y), with the channel sum of every texel
+struct FastBlock {
+    int rgb[16][3];
+    int lum[16];
+
+    explicit FastBlock(const uint8_t *texels) {
+        for (int y = 0; y < 4; y++) {
+            for (int x = 0; x < 4; x++) {
+                const uint8_t *texel = texels + (y * 4 + x) * 4;
+                int *p = rgb[x * 4 + y];
+                p[0] = texel[0];
+                p[1] = texel[1];
+                p[2] = texel[2];
+                lum[x * 4 + y] = p[0] + p[1] + p[2];
+            }
+        }
+    }
+};
+
+// Individual or differential mode into out. With measure, returns the squared error of the decoded
+// block, 0 otherwise.
+static int encodeEtc1(const FastBlock &block, bool measure, uint8_t *out) {
+    // 2x2 quadrant sums, quadrant (x >= 2) * 2 + (y >= 2), make up the halves of both flips
+    int quadrant[4][3] = {};
+    for (int p = 0; p < 16; p++) {
+        int *sum = quadrant[(p >> 3) << 1 | (p >> 1 & 1)];
+        sum[0] += block.rgb[p][0];
+        sum[1] += block.rgb[p][1];
+        sum[2] += block.rgb[p][2];
+    }
+    int sum[2][2][3];
+    for (int c = 0; c < 3; c++) {
+        sum[0][0][c] = quadrant[0][c] + quadrant[1][c];
+        sum[0][1][c] = quadrant[2][c] + quadrant[3][c];
+        sum[1][0][c] = quadrant[0][c] + quadrant[2][c];
+        sum[1][1][c] = quadrant[1][c] + quadrant[3][c];
+    }
+    // the flip whose halves vary less: both share the sum of squared texels, which leaves the one whose
+    // half sums have the larger sum of squares
+    int spread[2] = {};
+    for (int flip = 0; flip < 2; flip++) {
+        for (int c = 0; c < 3; c++) {
+            spread[flip] += sum[flip][0][c] * sum[flip][0][c] + sum[flip][1][c] * sum[flip][1][c];
+        }
+    }
+    const int flip = spread[1] > spread[0] ? 1 : 0;
+
+    // half averages as 5 bit base colours when the second is within the delta range of the first,
+    // 4 bit each otherwise
+    int q5[2][3], base[2][3];
+    bool differential = true;
+    for (int c = 0; c < 3; c++) {
+        for (int half = 0; half < 2; half++) {
+            q5[half][c] = (((sum[flip][half][c] + 4) >> 3) * 31 + 127) / 255;
+        }
+        const int delta = q5[1][c] - q5[0][c];
+        differential = differential && delta >= -4 && delta <= 3;
+    }
+    for (int c = 0; c < 3; c++) {
+        if (differential) {
+            base[0][c] = q5[0][c] << 3 | q5[0][c] >> 2;
+            base[1][c] = q5[1][c] << 3 | q5[1][c] >> 2;
+            out[c] = (uint8_t) (q5[0][c] << 3 | ((q5[1][c] - q5[0][c]) & 7));
+        } else {
+            const int q0 = (((sum[flip][0][c] + 4) >> 3) * 15 + 127) / 255;
+            const int q1 = (((sum[flip][1][c] + 4) >> 3) * 15 + 127) / 255;
+            base[0][c] = q0 * 17;
+            base[1][c] = q1 * 17;
+            out[c] = (uint8_t) (q0 << 4 | q1);
+        }
+    }
+
+    int tables[2];
+    unsigned int msb = 0, lsb = 0;
+    int error = 0;
+    for (int half = 0; half < 2; half++) {
+        const int *texels = HALF_TEXELS[flip][half];
+        const int baseLum = base[half][0] + base[half][1] + base[half][2];
+        int32_t sums[8];
+        for (int i = 0; i < 8; i++) {
+            const int s = block.lum[texels[i]] - baseLum;
+            msb |= (unsigned int) (s < 0) << texels[i];
+            sums[i] = s < 0 ? -s : s;
+        }
+        const int t = kernels().table(sums);
+        const int a = ETC1_MODIFIERS[t][0], b = ETC1_MODIFIERS[t][1];
+        tables[half] = t;
+        for (int i = 0; i < 8; i++) {
+            // b is the cheaper modifier once 3b^2 - 2b * s < 3a^2 - 2a * s
+            lsb |= (unsigned int) (2 * sums[i] > 3 * (a + b)) << texels[i];
+        }
+        if (measure) {
+            for (int i = 0; i < 8; i++) {
+                const int texel = texels[i];
+                const int magnitude = lsb >> texel & 1 ? b : a;
+                const int modifier = msb >> texel & 1 ? -magnitude : magnitude;
+                for (int c = 0; c < 3; c++) {
+                    const int d = clamp255(base[half][c] + modifier) - block.rgb[texel][c];
+                    error += d * d;
+                }
+            }
+        }
+    }
+    out[3] = (uint8_t) (tables[0] << 5 | tables[1] << 2 | (differential ? 2 : 0) | flip);
+    out[4] = (uint8_t) (msb >> 8);
+    out[5] = (uint8_t) msb;
+    out[6] = (uint8_t) (lsb >> 8);
+    out[7] = (uint8_t) lsb;
+    return error;
+}
+
+// ETC2 planar mode from a least squares plane through each channel into out, returns the squared
+// error of the decoded block
+static int encodePlanar(const FastBlock &block, uint8_t *out) {
+    // quantised O, H and V per channel
+    int q[3][3];
+    int error = 0;
+    for (int c = 0; c < 3; c++) {
+        // over x, y in 0..3 the slopes are sum((2x - 3) p) / 40 and sum((2y - 3) p) / 40, so in
+        // units of 1 / 80 O = 5 sum(p) - 3 X - 3 Y, H = O + 8 X and V = O + 8 Y
+        int column[4] = {}, row[4] = {};
+        for (int p = 0; p < 16; p++) {
+            column[p >> 2] += block.rgb[p][c];
+            row[p & 3] += block.rgb[p][c];
+        }
+        const int total = column[0] + column[1] + column[2] + column[3];
+        const int sx = 3 * (column[3] - column[0]) + column[2] - column[1];
+        const int sy = 3 * (row[3] - row[0]) + row[2] - row[1];
+        const int o80 = 5 * total - 3 * sx - 3 * sy;
+        const int bits = c == 1 ? 7 : 6;
+        const int max = (1 << bits) - 1;
+        const int fit[3] = {o80, o80 + 8 * sx, o80 + 8 * sy};
+        int e[3];
+        for (int k = 0; k < 3; k++) {
+            q[k][c] = std::max(0, std::min(max, (fit[k] * max + 10200) / 20400));
+            e[k] = q[k][c] << (8 - bits) | q[k][c] >> (2 * bits - 8);
+        }
+        for (int p = 0; p < 16; p++) {
+            const int x = p >> 2, y = p & 3;
+            const int d = clamp255((x * (e[1] - e[0]) + y * (e[2] - e[0]) + 4 * e[0] + 2) >> 2) - block.rgb[p][c];
+            error += d * d;
+        }
+    }
+    const int *o = q[0], *h = q[1], *v = q[2];
+    uint8_t d0 = (uint8_t) (o[0] << 1 | o[1] >> 6);
+    uint8_t d1 = (uint8_t) ((o[1] & 63) << 1 | o[2] >> 5);
+    uint8_t d2 = (uint8_t) ((o[2] & 24) | (o[2] >> 1 & 3));
+    // the free bits keep red and green inside the differential range and push blue outside it,
+    // which is what marks the block planar
+    if (((d0 >> 3) & 15) + ((d0 & 7) ^ 4) - 4 < 0) {
+        d0 |= 0x80;
+    }
+    if (((d1 >> 3) & 15) + ((d1 & 7) ^ 4) - 4 < 0) {
+        d1 |= 0x80;
+    }
+    if (((d2 >> 3) & 3) + (d2 & 3) <= 3) {
+        d2 |= 0x04;
+    } else {
+        d2 |= 0xe0;
+    }
+    out[0] = d0;
+    out[1] = d1;
+    out[2] = d2;
+    out[3] = (uint8_t) ((o[2] & 1) << 7 | (h[0] >> 1) << 2 | 2 | (h[0] & 1));
+    out[4] = (uint8_t) (h[1] << 1 | h[2] >> 5);
+    out[5] = (uint8_t) ((h[2] & 31) << 3 | v[0] >> 3);
+    out[6] = (uint8_t) ((v[0] & 7) << 5 | v[1] >> 2);
+    out[7] = (uint8_t) ((v[1] & 3) << 6 | v[2]);
+    return error;
+}
+
+// EAC alpha: the table whose eacSpan() palette fits the texels best, each texel on its nearest entry
+static void encodeEacAlpha(const uint8_t *texels, uint8_t *out) {
+    int16_t alpha[16];
+    int low = 255, high = 0;
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            const int a = texels[(y * 4 + x) * 4 + 3];
+            alpha[x * 4 + y] = (int16_t) a;
+            low = std::min(low, a);
+            high = std::max(high, a);
+        }
+    }
+    uint64_t indices = 0;
+    if (low == high) {
+        // table 13 has a 0 modifier at index 4
+        out[0] = (uint8_t) low;
+        out[1] = 1 << 4 | 13;
+        for (int p = 0; p < 16; p++) {
+            indices |= (uint64_t) 4 << (45 - 3 * p);
+        }
+    } else {
+        const int t = kernels().alpha(alpha, low, high);
+        int base, multiplier;
+        eacSpan(t, low, high, &base, &multiplier);
+        out[0] = (uint8_t) base;
+        out[1] = (uint8_t) (multiplier << 4 | t);
+        int palette[8];
+        for (int i = 0; i < 8; i++) {
+            palette[i] = clamp255(base + multiplier * EAC_MODIFIERS[t][i]);
+        }
+        for (int p = 0; p < 16; p++) {
+            int nearest = 0;
+            for (int i = 1; i < 8; i++) {
+                if (std::abs(alpha[p] - palette[i]) < std::abs(alpha[p] - palette[nearest])) {
+                    nearest = i;
+                }
+            }
+            indices |= (uint64_t) nearest << (45 - 3 * p);
+        }
+    }
+    for (int i = 0; i < 6; i++) {
+        out[2 + i] = (uint8_t) (indices >> (40 - 8 * i));
+    }
+}
+
+void EncodeEtc1BlockFast(const uint8_t *texels, uint8_t *out) {
+    const FastBlock block(texels);
+    encodeEtc1(block, false, out);
+}
+
+void EncodeEtc2RgbBlockFast(const uint8_t *texels, uint8_t *out) {
+    const FastBlock block(texels);
+    const int error = encodeEtc1(block, true, out);
+    if (error > 0) {
+        uint8_t planar[8];
+        if (encodePlanar(block, planar) < error) {
+            std::copy(planar, planar + 8, out);
+        }
+    }
+}
+
+void EncodeEtc2RgbaBlockFast(const uint8_t *texels, uint8_t *out) {
+    encodeEacAlpha(texels, out);
+    EncodeEtc2RgbBlockFast(texels, out + 8);
+}
+
+size_t EtcFastBlockBytes(Etc::Image::Format format) {
+    switch (format) {
+    case Etc::Image::Format::ETC1:
+    case Etc::Image::Format::RGB8:
+    case Etc::Image::Format::SRGB8:
+        return 8;
+    case Etc::Image::Format::RGBA8:
+    case Etc::Image::Format::SRGBA8:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+int EncodeEtcImageFast(const uint8_t *pixels, unsigned int width, unsigned int height, size_t stride,
+                       Etc::Image::Format format, int jobs, uint8_t *out) {
+    void (*encodeBlock)(const uint8_t *, uint8_t *);
+    switch (format) {
+    case Etc::Image::Format::ETC1:
+        encodeBlock = EncodeEtc1BlockFast;
+        break;
+    case Etc::Image::Format::RGB8:
+    case Etc::Image::Format::SRGB8:
+        encodeBlock = EncodeEtc2RgbBlockFast;
+        break;
+    case Etc::Image::Format::RGBA8:
+    case Etc::Image::Format::SRGBA8:
+        encodeBlock = EncodeEtc2RgbaBlockFast;
+        break;
+    default:
+        return 0;
+    }
+    if (width == 0 || height == 0) {
+        return 0;
+    }
+    const size_t block_bytes = EtcFastBlockBytes(format);
+    long blocks_x = (width + 3) / 4;
+    long blocks_y = (height + 3) / 4;
+    long stripes = std::min<long>(blocks_y, (long) std::max(jobs, 1) * 4);
+    ThreadPool::Shared().ParallelFor((size_t) stripes, (unsigned int) std::max(jobs, 1), [&](size_t i) {
+        long by0 = blocks_y * (long) i / stripes;
+        long by1 = blocks_y * ((long) i + 1) / stripes;
+        uint8_t texels[64];
+        for (long by = by0; by < by1; by++) {
+            const uint8_t *rows[4];
+            for (int y = 0; y < 4; y++) {
+                rows[y] = pixels + std::min<size_t>(by * 4 + y, height - 1) * stride;
+            }
+            for (long bx = 0; bx < blocks_x; bx++) {
+                for (int y = 0; y < 4; y++) {
+                    for (int x = 0; x < 4; x++) {
+                        const uint8_t *texel = rows[y] + std::min<size_t>(bx * 4 + x, width - 1) * 4;
+                        std::copy(texel, texel + 4, texels + (y * 4 + x) * 4);
+                    }
+                }
+                encodeBlock(texels, out + (by * blocks_x + bx) * block_bytes);
+            }
+        }
+    });
+    return 1;
+}
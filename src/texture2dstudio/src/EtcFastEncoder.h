@@ -0,0 +1,35 @@
+//
+// Created by smalls on 2021/8/14.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <Etc.h>
+
+// Real-time ETC encoders for paths that cannot wait for etc2comp (live thumbnails, uploads), selected
+// with fEffort = ETCCOMP_REALTIME_LEVEL. Integer only and a single pass per block: the flip is the split
+// with the lower variance, each half takes its average colour as base colour (differential when the two
+// fit, individual otherwise) and the table with the lowest error over its texels, ignoring clamping.
+// ETC2 RGB also fits a least squares plane and keeps whichever decodes closer; EAC alpha stretches every
+// table over the block's alpha range and keeps the closest. No T/H modes and no search around the base
+// colours, so ETC2 trails etc2comp on hard edges: see ETCCOMP_REALTIME_LEVEL in texture2d.h.
+// texels are 16 RGBA texels (4 bytes each), row by row.
+
+// 8 bytes, individual or differential mode
+void EncodeEtc1BlockFast(const uint8_t *texels, uint8_t *out);
+
+// 8 bytes, individual, differential or planar mode
+void EncodeEtc2RgbBlockFast(const uint8_t *texels, uint8_t *out);
+
+// 16 bytes, EAC alpha then ETC2 RGB
+void EncodeEtc2RgbaBlockFast(const uint8_t *texels, uint8_t *out);
+
+// Bytes per block of format for the fast encoders, 0 when format has none (RGB8A1, R11, RG11)
+size_t EtcFastBlockBytes(Etc::Image::Format format);
+
+// Encodes width x height RGBA8 pixels, rows stride bytes apart, as row-major blocks of format into out
+// (EtcFastBlockBytes(format) per block). Partial blocks repeat the last column and row.
+int EncodeEtcImageFast(const uint8_t *pixels, unsigned int width, unsigned int height, size_t stride,
+                       Etc::Image::Format format, int jobs, uint8_t *out);
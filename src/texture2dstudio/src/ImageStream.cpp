@@ -0,0 +1,362 @@
+//
+// Created by smalls on 2021/8/14.
+//
+
+#include <cstdlib>
+#include <cstring>
+#include "ImageStream.h"
+
+static const uint8_t PNG_SIGNATURE[8] = {0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A};
+// CM 8, 32K window, no dictionary, same header lodepng writes
+static const uint8_t ZLIB_HEADER[2] = {0x78, 0x01};
+
+static const uint8_t QOI_END[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+
+static inline void writeBE32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t) (v >> 24);
+    p[1] = (uint8_t) (v >> 16);
+    p[2] = (uint8_t) (v >> 8);
+    p[3] = (uint8_t) v;
+}
+
+static uint32_t updateAdler32(uint32_t adler, const uint8_t *data, size_t size) {
+    uint32_t s1 = adler & 0xFFFF;
+    uint32_t s2 = adler >> 16;
+    while (size > 0) {
+        // largest run before s2 can overflow 32 bits
+        size_t n = size < 5552 ? size : 5552;
+        size -= n;
+        while (n--) {
+            s1 += *data++;
+            s2 += s1;
+        }
+        s1 %= 65521;
+        s2 %= 65521;
+    }
+    return s2 << 16 | s1;
+}
+
+static inline uint8_t paeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = abs(p - a);
+    int pb = abs(p - b);
+    int pc = abs(p - c);
+    if (pa <= pb && pa <= pc) {
+        return (uint8_t) a;
+    }
+    return (uint8_t) (pb <= pc ? b : c);
+}
+
+// Applies png filter `type` to one scanline, prev is null for the first row of the image
+static void filterRow(int type, const uint8_t *row, const uint8_t *prev, size_t size, uint8_t *out) {
+    const size_t bpp = 4;
+    size_t i;
+    switch (type) {
+        case 1:
+            memcpy(out, row, bpp);
+            for (i = bpp; i < size; i++) {
+                out[i] = (uint8_t) (row[i] - row[i - bpp]);
+            }
+            break;
+        case 2:
+            for (i = 0; i < size; i++) {
+                out[i] = (uint8_t) (row[i] - (prev ? prev[i] : 0));
+            }
+            break;
+        case 3:
+            for (i = 0; i < size; i++) {
+                int a = i >= bpp ? row[i - bpp] : 0;
+                int b = prev ? prev[i] : 0;
+                out[i] = (uint8_t) (row[i] - ((a + b) >> 1));
+            }
+            break;
+        case 4:
+            for (i = 0; i < size; i++) {
+                int a = i >= bpp ? row[i - bpp] : 0;
+                int b = prev ? prev[i] : 0;
+                int c = prev && i >= bpp ? prev[i - bpp] : 0;
+                out[i] = (uint8_t) (row[i] - paeth(a, b, c));
+            }
+            break;
+        default:
+            memcpy(out, row, size);
+            break;
+    }
+}
+
+ImageStream::ImageStream(int format, uint32_t width, uint32_t height, Sink sink, unsigned int max_pending)
+        : format(format), width(width), height(height), sink(std::move(sink)),
+          max_pending(max_pending ? max_pending : 1) {
+    lodepng_compress_settings_init(&settings);
+    if (format == PNG_FAST) {
+        // shorter hash chains (windowsize / 8 links) and no lazy matching
+        settings.windowsize = 512;
+        settings.nicematch = 32;
+        settings.lazymatching = 0;
+    }
+    memset(qoi_index, 0, sizeof(qoi_index));
+    qoi_previous[0] = qoi_previous[1] = qoi_previous[2] = 0;
+    qoi_previous[3] = 255;
+    writer = std::thread(&ImageStream::run, this);
+}
+
+ImageStream::~ImageStream() {
+    if (writer.joinable()) {
+        Finish();
+    }
+}
+
+std::vector<uint8_t> ImageStream::Buffer() {
+    std::lock_guard<std::mutex> guard(lock);
+    if (spare.empty()) {
+        return std::vector<uint8_t>();
+    }
+    std::vector<uint8_t> buffer = std::move(spare.back());
+    spare.pop_back();
+    return buffer;
+}
+
+void ImageStream::Write(std::vector<uint8_t> &&rows) {
+    std::unique_lock<std::mutex> guard(lock);
+    if (rows.size() % ((size_t) width * 4) != 0) {
+        failed = true;
+        return;
+    }
+    changed.wait(guard, [this]() { return pending.size() < max_pending; });
+    pending.push_back(std::move(rows));
+    changed.notify_all();
+}
+
+bool ImageStream::Finish() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        finishing = true;
+    }
+    changed.notify_all();
+    if (writer.joinable()) {
+        writer.join();
+    }
+    return !failed && rows_written == height;
+}
+
+void ImageStream::run() {
+    bool ok = begin();
+    std::unique_lock<std::mutex> guard(lock);
+    failed = failed || !ok;
+    for (;;) {
+        changed.wait(guard, [this]() { return !pending.empty() || finishing; });
+        if (pending.empty()) {
+            return;
+        }
+        std::vector<uint8_t> rows = std::move(pending.front());
+        pending.pop_front();
+        changed.notify_all();
+        bool skip = failed;
+        guard.unlock();
+        ok = skip || encode(rows);
+        guard.lock();
+        failed = failed || !ok;
+        spare.push_back(std::move(rows));
+    }
+}
+
+bool ImageStream::begin() {
+    uint8_t header[18];
+    switch (format) {
+        case PNG:
+        case PNG_FAST:
+            writeBE32(header, width);
+            writeBE32(header + 4, height);
+            header[8] = 8;      // bit depth
+            header[9] = 6;      // RGBA
+            header[10] = 0;     // deflate
+            header[11] = 0;     // adaptive filtering
+            header[12] = 0;     // not interlaced
+            return sink(PNG_SIGNATURE, sizeof(PNG_SIGNATURE)) && chunk("IHDR", header, 13);
+        case QOI:
+            memcpy(header, "qoif", 4);
+            writeBE32(header + 4, width);
+            writeBE32(header + 8, height);
+            header[12] = 4;     // channels
+            header[13] = 0;     // sRGB with linear alpha
+            return sink(header, 14);
+        case TGA:
+            if (width > 0xFFFF || height > 0xFFFF) {
+                return false;
+            }
+            memset(header, 0, sizeof(header));
+            header[2] = 2;      // uncompressed true color
+            header[12] = (uint8_t) width;
+            header[13] = (uint8_t) (width >> 8);
+            header[14] = (uint8_t) height;
+            header[15] = (uint8_t) (height >> 8);
+            header[16] = 32;
+            header[17] = 0x28;  // 8 alpha bits, rows stored top to bottom
+            return sink(header, sizeof(header));
+        case RAW:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool ImageStream::encode(const std::vector<uint8_t> &rows) {
+    size_t count = rows.size() / ((size_t) width * 4);
+    if (count > height - rows_written) {
+        return false;
+    }
+    bool first = rows_written == 0;
+    rows_written += (uint32_t) count;
+    bool last = rows_written == height;
+    switch (format) {
+        case PNG:
+        case PNG_FAST:
+            return encodePng(rows.data(), count, first, last);
+        case QOI:
+            return encodeQoi(rows.data(), count, last);
+        case TGA:
+            return encodeTga(rows.data(), count);
+        default:
+            return sink(rows.data(), rows.size());
+    }
+}
+
+bool ImageStream::encodePng(const uint8_t *rows, size_t count, bool first, bool last) {
+    size_t stride = (size_t) width * 4;
+    filtered.resize(count * (stride + 1));
+    attempt.resize(stride);
+    for (size_t y = 0; y < count; y++) {
+        const uint8_t *row = rows + y * stride;
+        const uint8_t *prev = y > 0 ? row - stride : (previous.empty() ? nullptr : previous.data());
+        uint8_t *out = filtered.data() + y * (stride + 1);
+        if (format == PNG_FAST) {
+            out[0] = 4;
+            filterRow(4, row, prev, stride, out + 1);
+            continue;
+        }
+        // the filter with the smallest sum of absolute signed residuals, the heuristic lodepng uses
+        size_t best_sum = (size_t) -1;
+        for (int type = 0; type < 5; type++) {
+            filterRow(type, row, prev, stride, attempt.data());
+            size_t sum = 0;
+            for (size_t i = 0; i < stride; i++) {
+                sum += (size_t) abs((int) (int8_t) attempt[i]);
+            }
+            if (sum < best_sum) {
+                best_sum = sum;
+                out[0] = (uint8_t) type;
+                memcpy(out + 1, attempt.data(), stride);
+            }
+        }
+    }
+    if (count > 0) {
+        previous.assign(rows + (count - 1) * stride, rows + count * stride);
+    }
+    adler = updateAdler32(adler, filtered.data(), filtered.size());
+
+    uint8_t *deflated = nullptr;
+    size_t deflated_size = 0;
+    if (lodepng_deflate_part(&deflated, &deflated_size, filtered.data(), filtered.size(), &settings, last)) {
+        free(deflated);
+        return false;
+    }
+    encoded.clear();
+    if (first) {
+        encoded.insert(encoded.end(), ZLIB_HEADER, ZLIB_HEADER + sizeof(ZLIB_HEADER));
+    }
+    encoded.insert(encoded.end(), deflated, deflated + deflated_size);
+    free(deflated);
+    if (last) {
+        uint8_t checksum[4];
+        writeBE32(checksum, adler);
+        encoded.insert(encoded.end(), checksum, checksum + sizeof(checksum));
+    }
+    if (!chunk("IDAT", encoded.data(), encoded.size())) {
+        return false;
+    }
+    return !last || chunk("IEND", nullptr, 0);
+}
+
+// https://qoiformat.org/qoi-specification.pdf, the run and the previous pixel carry over batches
+bool ImageStream::encodeQoi(const uint8_t *rows, size_t count, bool last) {
+    size_t pixels = count * width;
+    // worst case is QOI_OP_RGBA for every pixel
+    encoded.resize(pixels * 5 + sizeof(QOI_END));
+    uint8_t *out = encoded.data();
+    for (size_t i = 0; i < pixels; i++) {
+        const uint8_t *px = rows + i * 4;
+        if (memcmp(px, qoi_previous, 4) == 0) {
+            if (++qoi_run == 62) {
+                *out++ = (uint8_t) (0xC0 | (qoi_run - 1));
+                qoi_run = 0;
+            }
+            continue;
+        }
+        if (qoi_run > 0) {
+            *out++ = (uint8_t) (0xC0 | (qoi_run - 1));
+            qoi_run = 0;
+        }
+        int hash = (px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64;
+        if (memcmp(qoi_index[hash], px, 4) == 0) {
+            *out++ = (uint8_t) hash;
+        } else {
+            memcpy(qoi_index[hash], px, 4);
+            if (px[3] == qoi_previous[3]) {
+                int vr = (int8_t) (px[0] - qoi_previous[0]);
+                int vg = (int8_t) (px[1] - qoi_previous[1]);
+                int vb = (int8_t) (px[2] - qoi_previous[2]);
+                int vg_r = vr - vg;
+                int vg_b = vb - vg;
+                if (vr >= -2 && vr <= 1 && vg >= -2 && vg <= 1 && vb >= -2 && vb <= 1) {
+                    *out++ = (uint8_t) (0x40 | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2));
+                } else if (vg >= -32 && vg <= 31 && vg_r >= -8 && vg_r <= 7 && vg_b >= -8 && vg_b <= 7) {
+                    *out++ = (uint8_t) (0x80 | (vg + 32));
+                    *out++ = (uint8_t) ((vg_r + 8) << 4 | (vg_b + 8));
+                } else {
+                    *out++ = 0xFE;
+                    *out++ = px[0];
+                    *out++ = px[1];
+                    *out++ = px[2];
+                }
+            } else {
+                *out++ = 0xFF;
+                memcpy(out, px, 4);
+                out += 4;
+            }
+        }
+        memcpy(qoi_previous, px, 4);
+    }
+    if (last) {
+        if (qoi_run > 0) {
+            *out++ = (uint8_t) (0xC0 | (qoi_run - 1));
+            qoi_run = 0;
+        }
+        memcpy(out, QOI_END, sizeof(QOI_END));
+        out += sizeof(QOI_END);
+    }
+    return sink(encoded.data(), (size_t) (out - encoded.data()));
+}
+
+bool ImageStream::encodeTga(const uint8_t *rows, size_t count) {
+    size_t size = count * width * 4;
+    encoded.resize(size);
+    for (size_t i = 0; i < size; i += 4) {
+        encoded[i] = rows[i + 2];
+        encoded[i + 1] = rows[i + 1];
+        encoded[i + 2] = rows[i];
+        encoded[i + 3] = rows[i + 3];
+    }
+    return sink(encoded.data(), size);
+}
+
+bool ImageStream::chunk(const char *type, const uint8_t *data, size_t size) {
+    unsigned char *out = nullptr;
+    size_t out_size = 0;
+    if (lodepng_chunk_create(&out, &out_size, (unsigned) size, type, data)) {
+        free(out);
+        return false;
+    }
+    bool ok = sink(out, out_size);
+    free(out);
+    return ok;
+}
@@ -0,0 +1,94 @@
+//
+// Created by smalls on 2021/8/14.
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <lodepng.h>
+
+// Incremental RGBA8 image writer. Scanlines are handed over in batches and encoded and written on
+// the stream's own thread while the caller produces the next batch, so only max_pending batches are
+// ever held. A png batch becomes one IDAT chunk holding one part of the zlib stream.
+class ImageStream {
+
+public:
+
+    enum Format {
+        PNG = 0,
+        PNG_FAST = 1,       // one fixed filter and a short match search, ~10% larger files
+        QOI = 2,
+        TGA = 3,            // uncompressed 32 bit, top-left origin, at most 65535 pixels a side
+        RAW = 4,            // headerless RGBA rows
+    };
+
+    // sink receives the file bytes in order and returns false on a failed write
+    typedef std::function<bool(const uint8_t *, size_t)> Sink;
+
+    ImageStream(int format, uint32_t width, uint32_t height, Sink sink, unsigned int max_pending = 2);
+
+    ~ImageStream();
+
+    static bool Supports(int format) {
+        return format >= PNG && format <= RAW;
+    }
+
+    // a batch buffer to fill, recycled from an already written batch when there is one
+    std::vector<uint8_t> Buffer();
+
+    // queues whole RGBA scanlines, blocks while max_pending batches are waiting
+    void Write(std::vector<uint8_t> &&rows);
+
+    // waits for the queued batches. False if a write failed or fewer than height rows were written.
+    bool Finish();
+
+private:
+
+    void run();
+
+    bool begin();
+
+    bool encode(const std::vector<uint8_t> &rows);
+
+    bool encodePng(const uint8_t *rows, size_t count, bool first, bool last);
+
+    bool encodeQoi(const uint8_t *rows, size_t count, bool last);
+
+    bool encodeTga(const uint8_t *rows, size_t count);
+
+    bool chunk(const char *type, const uint8_t *data, size_t size);
+
+    int format;
+    uint32_t width;
+    uint32_t height;
+    Sink sink;
+    unsigned int max_pending;
+
+    // owned by the writer thread
+    uint32_t rows_written = 0;
+    std::vector<uint8_t> encoded;
+    // png
+    LodePNGCompressSettings settings;
+    std::vector<uint8_t> previous;
+    std::vector<uint8_t> filtered;
+    std::vector<uint8_t> attempt;
+    uint32_t adler = 1;
+    // qoi
+    uint8_t qoi_index[64][4];
+    uint8_t qoi_previous[4];
+    unsigned int qoi_run = 0;
+
+    std::deque<std::vector<uint8_t>> pending;
+    std::vector<std::vector<uint8_t>> spare;
+    bool finishing = false;
+    bool failed = false;
+    std::mutex lock;
+    std::condition_variable changed;
+    std::thread writer;
+};
@@ -0,0 +1,55 @@
+//
+// Created by smalls on 2021/8/14.
+//
+
+#include "JobQueue.h"
+
+JobQueue::JobQueue(ThreadPool &pool) : pool(pool), concurrency(pool.Size()) {
+}
+
+void JobQueue::SetLimits(unsigned int concurrency, unsigned int max_pending) {
+    std::lock_guard<std::mutex> guard(lock);
+    this->concurrency = concurrency == 0 ? pool.Size() : concurrency;
+    this->max_pending = max_pending;
+    dispatch();
+    changed.notify_all();
+}
+
+void JobQueue::Submit(std::function<void()> job) {
+    std::unique_lock<std::mutex> guard(lock);
+    changed.wait(guard, [this]() {
+        return max_pending == 0 || pending.size() + running < max_pending;
+    });
+    pending.push_back(std::move(job));
+    dispatch();
+}
+
+void JobQueue::WaitIdle() {
+    std::unique_lock<std::mutex> guard(lock);
+    changed.wait(guard, [this]() { return pending.empty() && running == 0; });
+}
+
+JobQueue &JobQueue::Shared() {
+    static JobQueue queue(ThreadPool::Shared());
+    return queue;
+}
+
+// called with the lock held
+void JobQueue::dispatch() {
+    while (running < concurrency && !pending.empty()) {
+        std::function<void()> job = std::move(pending.front());
+        pending.pop_front();
+        running++;
+        pool.Enqueue([this, job]() {
+            job();
+            finish();
+        });
+    }
+}
+
+void JobQueue::finish() {
+    std::lock_guard<std::mutex> guard(lock);
+    running--;
+    dispatch();
+    changed.notify_all();
+}
@@ -0,0 +1,46 @@
+//
+// Created by smalls on 2021/8/14.
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include "ThreadPool.h"
+
+// Feeds submitted jobs to a thread pool with bounded concurrency and, optionally, a bounded backlog.
+// Submit blocks while max_pending jobs are queued or running, which keeps the memory held by
+// in-flight inputs and outputs bounded.
+class JobQueue {
+
+public:
+
+    explicit JobQueue(ThreadPool &pool);
+
+    // 0 keeps the pool size for concurrency, or means unbounded for max_pending
+    void SetLimits(unsigned int concurrency, unsigned int max_pending);
+
+    void Submit(std::function<void()> job);
+
+    // blocks until every submitted job has finished
+    void WaitIdle();
+
+    static JobQueue &Shared();
+
+private:
+
+    void dispatch();
+
+    void finish();
+
+    ThreadPool &pool;
+    std::deque<std::function<void()>> pending;
+    unsigned int running = 0;
+    unsigned int concurrency;
+    unsigned int max_pending = 0;
+
+    std::mutex lock;
+    std::condition_variable changed;
+};
@@ -1,6 +1,10 @@
+#include <algorithm>
+#include <chrono>
+#include <vector>
 #include <EtcErrorMetric.h>
 #include <Etc.h>
 #include <EtcFilter.h>
+#include "EtcFastEncoder.h"
 #include "Ktx.h"
 #include "KtxFile.h"
 
@@ -31,8 +35,24 @@ Ktx::Ktx(const char *filepath, bool mipmap, Etc::Image::Format format, float fEf
     read(mipmap, format, fEffort, jobs);
 }
 
+Ktx::Ktx(const uint8_t *pixels, unsigned int width, unsigned int height, size_t stride,
+         bool mipmap, Etc::Image::Format format, float fEffort, int jobs, int header) {
+    m_sourceImage = new SourceImage(pixels, width, height, stride);
+    writeHeader = header;
+    read(mipmap, format, fEffort, jobs);
+}
+
 void Ktx::read(bool mipmap, Etc::Image::Format format, float fEffort, int jobs) {
+    if (m_sourceImage->GetPixels() == nullptr) {
+        return;
+    }
     m_mipmap = mipmap;
+    m_format = format;
+    // ETCCOMP_REALTIME_LEVEL, formats without a fast encoder stay on etc2comp
+    if (fEffort < 0.0f && EtcFastBlockBytes(format) != 0) {
+        readFast(format, jobs);
+        return;
+    }
     unsigned int uiSourceWidth = m_sourceImage->GetWidth();
     unsigned int uiSourceHeight = m_sourceImage->GetHeight();
     m_mipmap_count = 1;
@@ -46,7 +66,9 @@ void Ktx::read(bool mipmap, Etc::Image::Format format, float fEffort, int jobs)
         }
         m_mipmap_count = maxMips;
         pMipmapImages = new RawImage[m_mipmap_count];
-        EncodeMipmaps((float *) m_sourceImage->GetPixels(),
+        EncodeMipmaps(m_sourceImage->GetPixels(),
+                      m_sourceImage->GetSourceFormat(),
+                      (unsigned int) m_sourceImage->GetStride(),
                       uiSourceWidth,
                       uiSourceHeight,
                       format,
@@ -59,7 +81,9 @@ void Ktx::read(bool mipmap, Etc::Image::Format format, float fEffort, int jobs)
                       pMipmapImages,
                       &encodingTime);
     } else {
-        Etc::Encode((float *) m_sourceImage->GetPixels(),
+        Etc::Encode(m_sourceImage->GetPixels(),
+                    m_sourceImage->GetSourceFormat(),
+                    (unsigned int) m_sourceImage->GetStride(),
                     uiSourceWidth,
                     uiSourceHeight,
                     format,
@@ -76,13 +100,93 @@ void Ktx::read(bool mipmap, Etc::Image::Format format, float fEffort, int jobs)
     isOK = true;
 }
 
-Ktx::~Ktx() {
-    if (m_sourceImage != nullptr) {
-        delete[] pMipmapImages;
+void Ktx::readFast(Etc::Image::Format format, int jobs) {
+    auto start = std::chrono::steady_clock::now();
+    unsigned int uiSourceWidth = m_sourceImage->GetWidth();
+    unsigned int uiSourceHeight = m_sourceImage->GetHeight();
+    Image::SourceFormat sourceFormat = m_sourceImage->GetSourceFormat();
+    const uint8_t *pixels = m_sourceImage->GetPixels();
+    size_t stride = m_sourceImage->GetStride();
+
+    // the encoders take RGBA8, so 16 bit sources are converted first
+    std::vector<uint8_t> pixels8;
+    if (sourceFormat == Image::SourceFormat::RGBA16) {
+        pixels8.resize((size_t) uiSourceWidth * uiSourceHeight * 4);
+        for (unsigned int y = 0; y < uiSourceHeight; y++) {
+            const uint16_t *row = (const uint16_t *) (pixels + y * stride);
+            for (unsigned int x = 0; x < uiSourceWidth * 4; x++) {
+                pixels8[(size_t) y * uiSourceWidth * 4 + x] = (uint8_t) ((row[x] * 255u + 32767u) / 65535u);
+            }
+        }
+        pixels = pixels8.data();
+        stride = (size_t) uiSourceWidth * 4;
     }
-    if (m_sourceImage != nullptr) {
-        delete[] m_sourceImage->GetPixels();
+
+    // new[] encoding bits of one level, its extended size into level
+    auto encodeLevel = [&](const uint8_t *levelPixels, size_t levelStride, unsigned int width, unsigned int height,
+                           RawImage *level) {
+        level->uiExtendedWidth = (int) ((width + 3) & ~3u);
+        level->uiExtendedHeight = (int) ((height + 3) & ~3u);
+        level->uiEncodingBitsBytes = (unsigned int) (level->uiExtendedWidth / 4 * (level->uiExtendedHeight / 4) *
+                                                     EtcFastBlockBytes(format));
+        unsigned char *bits = new unsigned char[level->uiEncodingBitsBytes];
+        EncodeEtcImageFast(levelPixels, width, height, levelStride, format, jobs, bits);
+        return bits;
+    };
+    auto deleteBits = [](unsigned char *p) { delete[] p; };
+
+    m_mipmap_count = 1;
+    if (m_mipmap) {
+        int dim = (uiSourceWidth < uiSourceHeight) ? uiSourceWidth : uiSourceHeight;
+        int maxMips = 0;
+        while (dim >= 1) {
+            maxMips++;
+            dim >>= 1;
+        }
+        m_mipmap_count = maxMips;
+        pMipmapImages = new RawImage[m_mipmap_count];
+        pMipmapImages[0].paucEncodingBits = std::shared_ptr<unsigned char>(
+                encodeLevel(pixels, stride, uiSourceWidth, uiSourceHeight, &pMipmapImages[0]), deleteBits);
+
+        // smaller levels filtered from the source as etc2comp does, then rounded to RGBA8
+        std::vector<ColorFloatRGBA> sourceRow(uiSourceWidth);
+        auto getSourceRow = [&](int iRow) -> const float * {
+            Image::ConvertSourceRow(pixels + (size_t) iRow * stride, Image::SourceFormat::RGBA8, uiSourceWidth,
+                                    sourceRow.data());
+            return (const float *) sourceRow.data();
+        };
+        unsigned int mipWidth = uiSourceWidth >> 1;
+        unsigned int mipHeight = uiSourceHeight >> 1;
+        for (int mip = 1; mip < m_mipmap_count; mip++, mipWidth >>= 1, mipHeight >>= 1) {
+            std::vector<float> filtered((size_t) mipWidth * mipHeight * 4);
+            if (!FilterTwoPassRows(getSourceRow, uiSourceWidth, uiSourceHeight, filtered.data(), mipWidth, mipHeight,
+                                   FILTER_WRAP_NONE, Etc::FilterLanczos3)) {
+                m_mipmap_count = mip;
+                break;
+            }
+            std::vector<uint8_t> level(filtered.size());
+            for (size_t i = 0; i < filtered.size(); i++) {
+                level[i] = (uint8_t) (std::min(std::max(filtered[i], 0.0f), 1.0f) * 255.0f + 0.5f);
+            }
+            pMipmapImages[mip].paucEncodingBits = std::shared_ptr<unsigned char>(
+                    encodeLevel(level.data(), (size_t) mipWidth * 4, mipWidth, mipHeight, &pMipmapImages[mip]),
+                    deleteBits);
+        }
+    } else {
+        RawImage image;
+        paucEncodingBits = encodeLevel(pixels, stride, uiSourceWidth, uiSourceHeight, &image);
+        uiEncodingBitsBytes = image.uiEncodingBitsBytes;
+        uiExtendedWidth = (uint32_t) image.uiExtendedWidth;
+        uiExtendedHeight = (uint32_t) image.uiExtendedHeight;
     }
+    encodingTime = (int) std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    isOK = true;
+}
+
+Ktx::~Ktx() {
+    delete[] pMipmapImages;
+    delete m_sourceImage;
 }
 
 
@@ -94,7 +198,7 @@ bool Ktx::Write(uint8_t **out, size_t *size) {
     unsigned int uiSourceWidth = m_sourceImage->GetWidth();
     unsigned int uiSourceHeight = m_sourceImage->GetHeight();
     if (m_mipmap) {
-        KtxFile file(Etc::Image::Format::RGBA8,
+        KtxFile file(m_format,
                      m_mipmap_count,
                      pMipmapImages,
                      uiSourceWidth,
@@ -105,7 +209,7 @@ bool Ktx::Write(uint8_t **out, size_t *size) {
         assert(paucEncodingBits);
         assert(uiEncodingBitsBytes);
         KtxFile file(
-                Etc::Image::Format::RGB8,
+                m_format,
                 paucEncodingBits,
                 uiEncodingBitsBytes,
                 uiSourceWidth,
@@ -126,7 +230,7 @@ bool Ktx::WriteToFile(const char *out) {
     unsigned int uiSourceWidth = m_sourceImage->GetWidth();
     unsigned int uiSourceHeight = m_sourceImage->GetHeight();
     if (m_mipmap) {
-        KtxFile file(Etc::Image::Format::RGBA8,
+        KtxFile file(m_format,
                      m_mipmap_count,
                      pMipmapImages,
                      uiSourceWidth,
@@ -137,7 +241,7 @@ bool Ktx::WriteToFile(const char *out) {
         assert(paucEncodingBits);
         assert(uiEncodingBitsBytes);
         KtxFile file(
-                Etc::Image::Format::RGB8,
+                m_format,
                 paucEncodingBits,
                 uiEncodingBitsBytes,
                 uiSourceWidth,
@@ -17,6 +17,9 @@ public:
 
     Ktx(const char *filepath, bool mipmap, Etc::Image::Format format, float fEffort, int jobs);
 
+    Ktx(const uint8_t *pixels, unsigned int width, unsigned int height, size_t stride,
+        bool mipmap, Etc::Image::Format format, float fEffort, int jobs, int header);
+
     ~Ktx();
 
     bool Write(uint8_t **out, size_t *size);
@@ -29,10 +32,16 @@ private:
 
     void read(bool mipmap, Etc::Image::Format format, float fEffort, int jobs);
 
+    // read() through the real-time encoders of EtcFastEncoder.h
+    void readFast(Etc::Image::Format format, int jobs);
+
     Etc::SourceImage *m_sourceImage = nullptr;
 
     bool m_mipmap = false;
 
+    // written to the header's glInternalFormat
+    Etc::Image::Format m_format = Etc::Image::Format::RGB8;
+
     int m_mipmap_count = 0;
 
     Etc::RawImage *pMipmapImages = nullptr;
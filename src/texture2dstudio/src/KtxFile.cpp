@@ -6,6 +6,7 @@
 #include "KtxFile.h"
 
 #include <Etc.h>
+#include <cstring>
 
 using namespace Etc;
 
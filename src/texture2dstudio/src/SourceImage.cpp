@@ -12,6 +12,8 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
 #include <assert.h>
 
 #include "lodepng.h"
@@ -23,7 +25,10 @@ namespace Etc {
         m_uiWidth = 0;
         m_uiHeight = 0;
         m_dim_z = 0;
-        m_pafrgbaPixels = nullptr;
+        m_paucPixels = nullptr;
+        m_paucOwnedPixels = nullptr;
+        m_sourceformat = Image::SourceFormat::RGBA8;
+        m_stride = 0;
         m_file = file;
         m_filesize = filesize;
         Read(a_iPixelX, a_iPixelY);
@@ -33,135 +38,162 @@ namespace Etc {
         m_uiWidth = 0;
         m_uiHeight = 0;
         m_dim_z = 0;
-        m_pafrgbaPixels = nullptr;
+        m_paucPixels = nullptr;
+        m_paucOwnedPixels = nullptr;
+        m_sourceformat = Image::SourceFormat::RGBA8;
+        m_stride = 0;
+        m_file = nullptr;
+        m_filesize = 0;
         m_filepath = filepath;
         Read(a_iPixelX, a_iPixelY);
     }
 
+    SourceImage::SourceImage(const uint8_t *a_paucPixels, unsigned int a_uiWidth, unsigned int a_uiHeight,
+                             size_t a_stride) {
+        m_uiWidth = a_uiWidth;
+        m_uiHeight = a_uiHeight;
+        m_dim_z = 0;
+        m_file = nullptr;
+        m_filesize = 0;
+        // no copy and no conversion to ColorFloatRGBA
+        m_paucPixels = a_paucPixels;
+        m_paucOwnedPixels = nullptr;
+        m_sourceformat = Image::SourceFormat::RGBA8;
+        m_stride = a_stride;
+    }
+
     SourceImage::~SourceImage() {
-        if (m_filepath != nullptr) {
-            delete[] m_filepath;
-        }
+        // m_filepath belongs to the caller
+        free(m_paucOwnedPixels);
     }
 
     void SourceImage::Read(int a_iPixelX, int a_iPixelY) {
 
+        unsigned char *paucFile = m_file;
+        size_t fileSize = m_filesize;
         unsigned char *paucPixels = nullptr;
 
-        int iWidth = 0;
-        int iHeight = 0;
-        bool bool16BitImage = false;
+        unsigned int uiWidth = 0;
+        unsigned int uiHeight = 0;
 
-        //we can load 8 or 16 bit pngs
-        int iBitDepth = 16;
         int error = 0;
-        if (m_filepath == nullptr) {
-            error = lodepng_decode_memory(&paucPixels,
-                                          (unsigned int *) &iWidth,
-                                          (unsigned int *) &iHeight,
-                                          m_file,
-                                          m_filesize,
-                                          LCT_RGBA,
-                                          iBitDepth);
-        } else {
-            error = lodepng_decode_file(&paucPixels,
-                                        (unsigned int *) &iWidth, (unsigned int *) &iHeight,
-                                        m_filepath,
-                                        LCT_RGBA, iBitDepth);
+        if (m_filepath != nullptr) {
+            error = lodepng_load_file(&paucFile, &fileSize, m_filepath);
+        }
+
+        // we can load 8 or 16 bit pngs, keep them at the bit depth they were stored at
+        unsigned int uiBitDepth = 8;
+        if (!error) {
+            LodePNGState state;
+            lodepng_state_init(&state);
+            error = lodepng_inspect(&uiWidth, &uiHeight, &state, paucFile, fileSize);
+            if (!error && state.info_png.color.bitdepth == 16) {
+                uiBitDepth = 16;
+            }
+            lodepng_state_cleanup(&state);
+        }
+        if (!error) {
+            error = lodepng_decode_memory(&paucPixels, &uiWidth, &uiHeight, paucFile, fileSize, LCT_RGBA, uiBitDepth);
+        }
+        if (paucFile != m_file) {
+            free(paucFile);
         }
-        bool16BitImage = (iBitDepth == 16) ? true : false;
         if (error) {
+            // leave the pixels null so the caller can fail this image without taking the process down
             printf("lodePNG error %u: %s\n", error, lodepng_error_text(error));
-            assert(0);
-            exit(1);
+            free(paucPixels);
+            return;
+        }
+
+        m_sourceformat = (uiBitDepth == 16) ? Image::SourceFormat::RGBA16 : Image::SourceFormat::RGBA8;
+        unsigned int uiBytesPerPixel = (uiBitDepth == 16) ? 8 : 4;
+
+        // png stores 16 bit channels big endian
+        if (uiBitDepth == 16) {
+            size_t channels = (size_t) uiWidth * uiHeight * 4;
+            for (size_t channel = 0; channel < channels; ++channel) {
+                unsigned char *pucChannel = &paucPixels[channel * 2];
+                unsigned short ushValue = (unsigned short) ((pucChannel[0] << 8) + pucChannel[1]);
+                memcpy(pucChannel, &ushValue, sizeof(ushValue));
+            }
         }
 
-        //the pixel cords for the top left corner of the block
-        int iBlockX = 0;
-        int iBlockY = 0;
         if (a_iPixelX > -1 && a_iPixelY > -1) {
             // in 1 block mode, we basically will have an img thats 4x4
             m_uiWidth = 4;
             m_uiHeight = 4;
 
-            if (a_iPixelX > iWidth)
-                a_iPixelX = iWidth;
-            if (a_iPixelY > iHeight)
-                a_iPixelY = iHeight;
+            if (a_iPixelX > (int) uiWidth)
+                a_iPixelX = uiWidth;
+            if (a_iPixelY > (int) uiHeight)
+                a_iPixelY = uiHeight;
 
             // remove the bottom 2 bits to get the block coordinates
-            iBlockX = (a_iPixelX & 0xFFFFFFFC);
-            iBlockY = (a_iPixelY & 0xFFFFFFFC);
+            unsigned int uiBlockX = (a_iPixelX & 0xFFFFFFFC);
+            unsigned int uiBlockY = (a_iPixelY & 0xFFFFFFFC);
+
+            m_paucOwnedPixels = (uint8_t *) malloc(m_uiWidth * m_uiHeight * uiBytesPerPixel);
+            for (unsigned int uiV = 0; uiV < m_uiHeight; ++uiV) {
+                memcpy(&m_paucOwnedPixels[uiV * m_uiWidth * uiBytesPerPixel],
+                       &paucPixels[((uiBlockY + uiV) * uiWidth + uiBlockX) * uiBytesPerPixel],
+                       m_uiWidth * uiBytesPerPixel);
+            }
+            free(paucPixels);
         } else {
-            m_uiWidth = iWidth;
-            m_uiHeight = iHeight;
+            m_uiWidth = uiWidth;
+            m_uiHeight = uiHeight;
+            m_paucOwnedPixels = paucPixels;
         }
 
-        m_pafrgbaPixels = new ColorFloatRGBA[m_uiWidth * m_uiHeight];
-        assert(m_pafrgbaPixels);
-
-        int iBytesPerPixel = bool16BitImage ? 8 : 4;
-        unsigned char *pucPixel;    // = &paucPixels[(iBlockY * iWidth + iBlockX) * iBytesPerPixel];
-        ColorFloatRGBA *pfrgbaPixel = m_pafrgbaPixels;
-
-        // convert pixels from RGBA* to ColorFloatRGBA
-        for (unsigned int uiV = iBlockY; uiV < (iBlockY + m_uiHeight); ++uiV) {
-            // reset coordinate for each row
-            pucPixel = &paucPixels[(uiV * iWidth + iBlockX) * iBytesPerPixel];
-
-            // read each row
-            for (unsigned int uiH = iBlockX; uiH < (iBlockX + m_uiWidth); ++uiH) {
-                if (bool16BitImage) {
-                    unsigned short ushR = (pucPixel[0] << 8) + pucPixel[1];
-                    unsigned short ushG = (pucPixel[2] << 8) + pucPixel[3];
-                    unsigned short ushB = (pucPixel[4] << 8) + pucPixel[5];
-                    unsigned short ushA = (pucPixel[6] << 8) + pucPixel[7];
-
-                    *pfrgbaPixel++ = ColorFloatRGBA((float) ushR / 65535.0f,
-                                                    (float) ushG / 65535.0f,
-                                                    (float) ushB / 65535.0f,
-                                                    (float) ushA / 65535.0f);
-                } else {
-                    *pfrgbaPixel++ = ColorFloatRGBA::ConvertFromRGBA8(pucPixel[0], pucPixel[1],
-                                                                      pucPixel[2], pucPixel[3]);
-                }
+        m_paucPixels = m_paucOwnedPixels;
+        m_stride = (size_t) m_uiWidth * uiBytesPerPixel;
 
-                pucPixel += iBytesPerPixel;
-            }
+    }
+
+    void SourceImage::NormalizeXYZ(void) {
+        if (m_paucOwnedPixels == nullptr) {
+            // the caller's pixels are not modified
+            return;
         }
 
-        free(paucPixels);
+        bool bool16BitImage = (m_sourceformat == Image::SourceFormat::RGBA16);
+        float fMax = bool16BitImage ? 65535.0f : 255.0f;
 
-    }
+        for (unsigned int uiV = 0; uiV < m_uiHeight; ++uiV) {
+            uint8_t *paucRow = m_paucOwnedPixels + uiV * m_stride;
+            for (unsigned int uiH = 0; uiH < m_uiWidth; ++uiH) {
+                ColorFloatRGBA frgbaPixel;
+                Image::ConvertSourceRow(paucRow + uiH * (bool16BitImage ? 8 : 4), m_sourceformat, 1, &frgbaPixel);
 
-    void SourceImage::NormalizeXYZ(void) {
-        int iPixels = m_uiWidth * m_uiHeight;
-
-        ColorFloatRGBA *pfrgbaPixel = m_pafrgbaPixels;
-        for (int iPixel = 0; iPixel < iPixels; iPixel++) {
-            float fX = 2.0f * pfrgbaPixel->fR - 1.0f;
-            float fY = 2.0f * pfrgbaPixel->fG - 1.0f;
-            float fZ = 2.0f * pfrgbaPixel->fB - 1.0f;
-
-            float fLength2 = fX * fX + fY * fY + fZ * fZ;
-
-            if (fLength2 == 0.0f) {
-                pfrgbaPixel->fR = 1.0f;
-                pfrgbaPixel->fG = 0.0f;
-                pfrgbaPixel->fB = 0.0f;
-            } else {
-                float fLength = sqrtf(fLength2);
-
-                float fNormalizedX = fX / fLength;
-                float fNormalizedY = fY / fLength;
-                float fNormalizedZ = fZ / fLength;
-
-                pfrgbaPixel->fR = 0.5f * (fNormalizedX + 1.0f);
-                pfrgbaPixel->fG = 0.5f * (fNormalizedY + 1.0f);
-                pfrgbaPixel->fB = 0.5f * (fNormalizedZ + 1.0f);
-            }
+                float fX = 2.0f * frgbaPixel.fR - 1.0f;
+                float fY = 2.0f * frgbaPixel.fG - 1.0f;
+                float fZ = 2.0f * frgbaPixel.fB - 1.0f;
+
+                float fLength2 = fX * fX + fY * fY + fZ * fZ;
+
+                float afXYZ[3];
+                if (fLength2 == 0.0f) {
+                    afXYZ[0] = 1.0f;
+                    afXYZ[1] = 0.0f;
+                    afXYZ[2] = 0.0f;
+                } else {
+                    float fLength = sqrtf(fLength2);
 
-            pfrgbaPixel++;
+                    afXYZ[0] = 0.5f * (fX / fLength + 1.0f);
+                    afXYZ[1] = 0.5f * (fY / fLength + 1.0f);
+                    afXYZ[2] = 0.5f * (fZ / fLength + 1.0f);
+                }
+
+                // back to the source bit depth, rounded
+                for (int iChannel = 0; iChannel < 3; iChannel++) {
+                    float fValue = afXYZ[iChannel] * fMax + 0.5f;
+                    if (bool16BitImage) {
+                        ((unsigned short *) paucRow)[uiH * 4 + iChannel] = (unsigned short) fValue;
+                    } else {
+                        paucRow[uiH * 4 + iChannel] = (uint8_t) fValue;
+                    }
+                }
+            }
         }
 
     }
@@ -1,6 +1,6 @@
 #pragma once
 
-#include <EtcColorFloatRGBA.h>
+#include <EtcImage.h>
 
 namespace Etc {
     class SourceImage {
@@ -16,6 +16,13 @@ namespace Etc {
                     int a_iPixelX = -1,
                     int a_iPixelY = -1);
 
+        // already decoded RGBA8 pixels, rows a_stride bytes apart
+        // they are used in place, so they must outlive the SourceImage
+        SourceImage(const uint8_t *a_paucPixels,
+                    unsigned int a_uiWidth,
+                    unsigned int a_uiHeight,
+                    size_t a_stride);
+
         ~SourceImage();
 
         void NormalizeXYZ();
@@ -40,15 +47,18 @@ namespace Etc {
             return m_uiWidth;
         }
 
-        inline ColorFloatRGBA *GetPixels() {
-            return m_pafrgbaPixels;
+        // RGBA8 or RGBA16 pixels as in GetSourceFormat(), GetStride() bytes between rows
+        // they stay in that format, Etc::Image converts them a block at a time
+        inline const uint8_t *GetPixels() const {
+            return m_paucPixels;
+        }
+
+        inline Image::SourceFormat GetSourceFormat() const {
+            return m_sourceformat;
         }
 
-        inline ColorFloatRGBA *GetPixel(unsigned int a_uiColumn, unsigned int a_uiRow) {
-            if (m_pafrgbaPixels == nullptr) {
-                return nullptr;
-            }
-            return &m_pafrgbaPixels[a_uiRow * m_uiWidth + a_uiColumn];
+        inline size_t GetStride() const {
+            return m_stride;
         }
 
 
@@ -64,7 +74,10 @@ namespace Etc {
         unsigned int m_uiWidth;             // not necessarily block aligned
         unsigned int m_uiHeight;            // not necessarily block aligned
         unsigned int m_dim_z;            // not necessarily block aligned
-        ColorFloatRGBA *m_pafrgbaPixels;
+        const uint8_t *m_paucPixels;
+        uint8_t *m_paucOwnedPixels;      // m_paucPixels when decoded here rather than the caller's
+        Image::SourceFormat m_sourceformat;
+        size_t m_stride;
 
     };
 } // namespace Sm
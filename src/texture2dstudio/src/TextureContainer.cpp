@@ -0,0 +1,189 @@
+//
+// Created by smalls on 2021/8/14.
+//
+
+#include <astcenccli_internal.h>
+#include <cstring>
+#include "Astc.h"
+#include "KtxFileHeader.h"
+#include "TextureContainer.h"
+
+using InternalFormat = Etc::KtxFileHeader::InternalFormat;
+
+static const uint8_t KTX_IDENTIFIER[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+static const uint32_t KTX_ENDIAN_REF = 0x04030201;
+static const uint32_t KTX_ENDIAN_REF_REV = 0x01020304;
+
+// ASTC footprints in glInternalFormat order
+static const uint8_t ASTC_BLOCK_SIZES[14][2] = {{4, 4}, {5, 4}, {5, 5}, {6, 5}, {6, 6}, {8, 5}, {8, 6},
+                                                {8, 8}, {10, 5}, {10, 6}, {10, 8}, {10, 10}, {12, 10}, {12, 12}};
+
+// PKM texture types, indexed by the header's format field
+static const uint32_t PKM_FORMATS[] = {
+        (uint32_t) InternalFormat::ETC1_RGB8,
+        (uint32_t) InternalFormat::ETC2_RGB8,
+        (uint32_t) InternalFormat::ETC2_RGBA8,      // RGBA_NO_MIPMAPS_OLD
+        (uint32_t) InternalFormat::ETC2_RGBA8,
+        (uint32_t) InternalFormat::ETC2_RGB8A1,
+        (uint32_t) InternalFormat::ETC2_R11,
+        (uint32_t) InternalFormat::ETC2_RG11,
+        (uint32_t) InternalFormat::ETC2_SIGNED_R11,
+        (uint32_t) InternalFormat::ETC2_SIGNED_RG11,
+};
+
+static inline uint32_t swap32(uint32_t v) {
+    return (v >> 24) | ((v >> 8) & 0xFF00) | ((v << 8) & 0xFF0000) | (v << 24);
+}
+
+static inline uint32_t readU32(const uint8_t *p, bool swap) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return swap ? swap32(v) : v;
+}
+
+static inline uint32_t readBE16(const uint8_t *p) {
+    return (uint32_t) p[0] << 8 | p[1];
+}
+
+static inline uint32_t mipSize(uint32_t size, uint32_t level) {
+    size >>= level;
+    return size ? size : 1;
+}
+
+bool AstcFormatBlockSize(uint32_t glInternalFormat, uint32_t *block_x, uint32_t *block_y) {
+    uint32_t index;
+    if (glInternalFormat >= GL_COMPRESSED_RGBA_ASTC_4x4 && glInternalFormat < GL_COMPRESSED_RGBA_ASTC_4x4 + 14) {
+        index = glInternalFormat - GL_COMPRESSED_RGBA_ASTC_4x4;
+    } else if (glInternalFormat >= GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4 &&
+               glInternalFormat < GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4 + 14) {
+        index = glInternalFormat - GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4;
+    } else {
+        return false;
+    }
+    *block_x = ASTC_BLOCK_SIZES[index][0];
+    *block_y = ASTC_BLOCK_SIZES[index][1];
+    return true;
+}
+
+static bool parseKtx(const uint8_t *file, size_t filesize, uint32_t level, TextureContainerLevel *out) {
+    typedef Etc::KtxFileHeader::Data Header;
+    if (filesize < sizeof(Header)) {
+        return false;
+    }
+    bool swap;
+    uint32_t endianness = readU32(file + offsetof(Header, m_u32Endianness), false);
+    if (endianness == KTX_ENDIAN_REF) {
+        swap = false;
+    } else if (endianness == KTX_ENDIAN_REF_REV) {
+        swap = true;
+    } else {
+        return false;
+    }
+    uint32_t glInternalFormat = readU32(file + offsetof(Header, m_u32GlInternalFormat), swap);
+    uint32_t width = readU32(file + offsetof(Header, m_u32PixelWidth), swap);
+    uint32_t height = readU32(file + offsetof(Header, m_u32PixelHeight), swap);
+    uint32_t arrayElements = readU32(file + offsetof(Header, m_u32NumberOfArrayElements), swap);
+    uint32_t faces = readU32(file + offsetof(Header, m_u32NumberOfFaces), swap);
+    uint32_t levels = readU32(file + offsetof(Header, m_u32NumberOfMipmapLevels), swap);
+    uint32_t keyValueBytes = readU32(file + offsetof(Header, m_u32BytesOfKeyValueData), swap);
+    if (width == 0) {
+        return false;
+    }
+    // 0 levels asks the loader to generate mipmaps, only the base level is stored
+    levels = levels ? levels : 1;
+    if (level >= levels) {
+        return false;
+    }
+    // a cube map stores imageSize per face, each face padded to 4 bytes; arrays store one imageSize for all
+    uint32_t storedFaces = (faces == 6 && arrayElements == 0) ? 6 : 1;
+
+    size_t offset = sizeof(Header);
+    if (keyValueBytes > filesize - offset) {
+        return false;
+    }
+    offset += keyValueBytes;
+    for (uint32_t mip = 0;; mip++) {
+        if (filesize - offset < sizeof(uint32_t)) {
+            return false;
+        }
+        uint32_t imageSize = readU32(file + offset, swap);
+        offset += sizeof(uint32_t);
+        if (imageSize > filesize - offset) {
+            return false;
+        }
+        if (mip == level) {
+            out->glInternalFormat = glInternalFormat;
+            out->width = mipSize(width, level);
+            out->height = mipSize(height ? height : 1, level);
+            out->levels = levels;
+            out->data = file + offset;
+            out->size = imageSize;
+            return true;
+        }
+        size_t paddedSize = ((size_t) imageSize + 3) & ~(size_t) 3;
+        if (paddedSize > (filesize - offset) / storedFaces) {
+            return false;
+        }
+        offset += paddedSize * storedFaces;
+    }
+}
+
+static bool parseAstc(const uint8_t *file, size_t filesize, uint32_t level, TextureContainerLevel *out) {
+    astc_header header{};
+    if (filesize < sizeof(header) || level != 0) {
+        return false;
+    }
+    memcpy(&header, file, sizeof(header));
+    uint32_t dimX = header.dim_x[0] | header.dim_x[1] << 8 | header.dim_x[2] << 16;
+    uint32_t dimY = header.dim_y[0] | header.dim_y[1] << 8 | header.dim_y[2] << 16;
+    uint32_t dimZ = header.dim_z[0] | header.dim_z[1] << 8 | header.dim_z[2] << 16;
+    if (header.block_z != 1 || dimZ != 1 || dimX == 0 || dimY == 0) {
+        return false;
+    }
+    for (uint32_t i = 0; i < 14; i++) {
+        if (ASTC_BLOCK_SIZES[i][0] == header.block_x && ASTC_BLOCK_SIZES[i][1] == header.block_y) {
+            out->glInternalFormat = GL_COMPRESSED_RGBA_ASTC_4x4 + i;
+            out->width = dimX;
+            out->height = dimY;
+            out->levels = 1;
+            out->data = file + sizeof(header);
+            out->size = filesize - sizeof(header);
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parsePkm(const uint8_t *file, size_t filesize, uint32_t level, TextureContainerLevel *out) {
+    const size_t headerSize = 16;
+    if (filesize < headerSize || level != 0) {
+        return false;
+    }
+    uint32_t format = readBE16(file + 6);
+    uint32_t width = readBE16(file + 12);
+    uint32_t height = readBE16(file + 14);
+    if (format >= sizeof(PKM_FORMATS) / sizeof(PKM_FORMATS[0]) || width == 0 || height == 0) {
+        return false;
+    }
+    out->glInternalFormat = PKM_FORMATS[format];
+    out->width = width;
+    out->height = height;
+    out->levels = 1;
+    out->data = file + headerSize;
+    out->size = filesize - headerSize;
+    return true;
+}
+
+bool ParseTextureContainer(const uint8_t *file, size_t filesize, uint32_t level, TextureContainerLevel *out) {
+    if (filesize >= sizeof(KTX_IDENTIFIER) && memcmp(file, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) == 0) {
+        return parseKtx(file, filesize, level, out);
+    }
+    if (filesize >= 4 && file[0] == (ASTC_MAGIC_ID & 0xFF) && file[1] == ((ASTC_MAGIC_ID >> 8) & 0xFF) &&
+        file[2] == ((ASTC_MAGIC_ID >> 16) & 0xFF) && file[3] == ((ASTC_MAGIC_ID >> 24) & 0xFF)) {
+        return parseAstc(file, filesize, level, out);
+    }
+    if (filesize >= 4 && memcmp(file, "PKM ", 4) == 0) {
+        return parsePkm(file, filesize, level, out);
+    }
+    return false;
+}
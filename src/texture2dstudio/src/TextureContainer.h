@@ -0,0 +1,40 @@
+//
+// Created by smalls on 2021/8/14.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// glInternalFormat values of the non-ETC block formats we decode, the ETC ones are in
+// Etc::KtxFileHeader::InternalFormat. .astc and PKM files are reported with the same values.
+enum GlCompressedFormat : uint32_t {
+    GL_COMPRESSED_RGB_S3TC_DXT1 = 0x83F0,
+    GL_COMPRESSED_RGBA_S3TC_DXT1 = 0x83F1,
+    GL_COMPRESSED_RGBA_S3TC_DXT5 = 0x83F3,
+    GL_COMPRESSED_RED_RGTC1 = 0x8DBB,
+    GL_COMPRESSED_RG_RGTC2 = 0x8DBD,
+    GL_COMPRESSED_RGBA_BPTC_UNORM = 0x8E8C,
+    GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM = 0x8E8D,
+    GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT = 0x8E8F,
+    GL_COMPRESSED_RGBA_ASTC_4x4 = 0x93B0,       // through 12x12 at 0x93BD
+    GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4 = 0x93D0,
+};
+
+// One mip level of a container, pointing into the parsed buffer
+struct TextureContainerLevel {
+    uint32_t glInternalFormat;
+    uint32_t width;
+    uint32_t height;
+    uint32_t levels;
+    const uint8_t *data;
+    size_t size;            // bytes available for the level, at least its block data
+};
+
+// Block footprint of an ASTC glInternalFormat (linear or sRGB), false for any other format
+bool AstcFormatBlockSize(uint32_t glInternalFormat, uint32_t *block_x, uint32_t *block_y);
+
+// Parses a KTX 1, .astc or PKM header and locates mip `level`. Only the first face and array element
+// of a KTX level are addressed. Returns false for an unknown or truncated file.
+bool ParseTextureContainer(const uint8_t *file, size_t filesize, uint32_t level, TextureContainerLevel *out);
@@ -0,0 +1,186 @@
+//
+// Created by smalls on 2021/8/14.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned int threads) {
+    if (threads == 0) {
+        threads = 1;
+    }
+    for (unsigned int i = 0; i < threads; i++) {
+        workers.emplace_back(&ThreadPool::run, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::Enqueue(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        tasks.push_back(std::move(task));
+    }
+    wake.notify_one();
+}
+
+void ThreadPool::ParallelFor(size_t count, unsigned int jobs, const std::function<void(size_t)> &fn) {
+    struct State {
+        std::function<void(size_t)> fn;
+        size_t count;
+        std::atomic<size_t> next{0};
+        size_t completed = 0;
+        std::mutex lock;
+        std::condition_variable finished;
+    };
+    // helpers that only start after everything finished find no index left, the shared state keeps
+    // them from touching the caller's stack
+    auto state = std::make_shared<State>();
+    state->fn = fn;
+    state->count = count;
+    auto drain = [](const std::shared_ptr<State> &state) {
+        size_t i;
+        while ((i = state->next++) < state->count) {
+            state->fn(i);
+            std::lock_guard<std::mutex> guard(state->lock);
+            if (++state->completed == state->count) {
+                state->finished.notify_all();
+            }
+        }
+    };
+
+    size_t helpers = std::min<size_t>(std::min<size_t>(jobs, Size() + 1), count);
+    for (size_t i = 1; i < helpers; i++) {
+        Enqueue([state, drain]() { drain(state); });
+    }
+    drain(state);
+
+    std::unique_lock<std::mutex> guard(state->lock);
+    state->finished.wait(guard, [&state]() { return state->completed == state->count; });
+}
+
+void ThreadPool::ParallelForRanges(size_t count, size_t grain, unsigned int jobs,
+                                   const std::function<void(size_t, size_t)> &fn) {
+    struct Share {
+        std::mutex lock;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+    struct State {
+        std::function<void(size_t, size_t)> fn;
+        size_t count;
+        size_t grain;
+        size_t participants;
+        std::unique_ptr<Share[]> shares;
+        std::atomic<size_t> next_share{0};
+        size_t completed = 0;
+        std::mutex lock;
+        std::condition_variable finished;
+    };
+    if (count == 0) {
+        return;
+    }
+    grain = std::max<size_t>(grain, 1);
+    auto state = std::make_shared<State>();
+    state->fn = fn;
+    state->count = count;
+    state->grain = grain;
+    state->participants = std::min<size_t>(std::min<size_t>(std::max(jobs, 1u), Size() + 1),
+                                           (count + grain - 1) / grain);
+    state->shares.reset(new Share[state->participants]);
+    for (size_t i = 0; i < state->participants; i++) {
+        state->shares[i].begin = count * i / state->participants;
+        state->shares[i].end = count * (i + 1) / state->participants;
+    }
+    auto drain = [](const std::shared_ptr<State> &state) {
+        size_t index = state->next_share++;
+        if (index >= state->participants) {
+            return;
+        }
+        Share &own = state->shares[index];
+        for (;;) {
+            size_t begin, end;
+            {
+                std::lock_guard<std::mutex> guard(own.lock);
+                begin = own.begin;
+                end = std::min(own.end, begin + state->grain);
+                own.begin = end;
+            }
+            if (begin == end) {
+                // steal the back half of the largest share, the victim keeps the indices next to its own
+                Share *victim = nullptr;
+                size_t largest = 0;
+                for (size_t i = 0; i < state->participants; i++) {
+                    std::lock_guard<std::mutex> guard(state->shares[i].lock);
+                    size_t left = state->shares[i].end - state->shares[i].begin;
+                    if (left > largest) {
+                        largest = left;
+                        victim = &state->shares[i];
+                    }
+                }
+                if (victim == nullptr) {
+                    return;
+                }
+                {
+                    std::lock_guard<std::mutex> guard(victim->lock);
+                    if (victim->begin == victim->end) {
+                        continue;
+                    }
+                    end = victim->end;
+                    begin = victim->begin + (victim->end - victim->begin) / 2;
+                    victim->end = begin;
+                }
+                std::lock_guard<std::mutex> guard(own.lock);
+                own.begin = begin;
+                own.end = end;
+                continue;
+            }
+            state->fn(begin, end);
+            std::lock_guard<std::mutex> guard(state->lock);
+            state->completed += end - begin;
+            if (state->completed == state->count) {
+                state->finished.notify_all();
+            }
+        }
+    };
+
+    for (size_t i = 1; i < state->participants; i++) {
+        Enqueue([state, drain]() { drain(state); });
+    }
+    drain(state);
+
+    std::unique_lock<std::mutex> guard(state->lock);
+    state->finished.wait(guard, [&state]() { return state->completed == state->count; });
+}
+
+ThreadPool &ThreadPool::Shared() {
+    static ThreadPool pool(std::thread::hardware_concurrency());
+    return pool;
+}
+
+void ThreadPool::run() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            wake.wait(guard, [this]() { return stopping || !tasks.empty(); });
+            if (tasks.empty()) {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
@@ -0,0 +1,55 @@
+//
+// Created by smalls on 2021/8/14.
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads draining a FIFO of tasks. Shared() is the process-wide pool the batch
+// and async entry points schedule onto, so concurrent callers share one set of threads instead of
+// each spinning up their own.
+class ThreadPool {
+
+public:
+
+    explicit ThreadPool(unsigned int threads);
+
+    ~ThreadPool();
+
+    void Enqueue(std::function<void()> task);
+
+    // Runs fn(0) .. fn(count - 1) on the calling thread plus up to jobs - 1 pool threads and returns
+    // once all of them finished. The caller keeps draining indices itself, so this completes even
+    // when called from a pool thread or while the pool is saturated.
+    void ParallelFor(size_t count, unsigned int jobs, const std::function<void(size_t)> &fn);
+
+    // Runs fn over [0, count) in ranges of at most grain indices. Every participant starts on its own
+    // contiguous share and, once that runs out, steals the back half of the largest share left, so
+    // neighbouring indices mostly stay on one thread and a slow or late thread holds nobody up.
+    void ParallelForRanges(size_t count, size_t grain, unsigned int jobs,
+                           const std::function<void(size_t, size_t)> &fn);
+
+    unsigned int Size() const {
+        return (unsigned int) workers.size();
+    }
+
+    // sized to the hardware concurrency on first use
+    static ThreadPool &Shared();
+
+private:
+
+    void run();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+
+    std::mutex lock;
+    std::condition_variable wake;
+    bool stopping = false;
+};
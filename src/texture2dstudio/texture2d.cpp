@@ -6,19 +6,46 @@
 #include <astcenccli_internal.h>
 #include <etcDecoder.h>
 #include <astcDecoder.h>
+#include <bcn.h>
+#include <pvrtc.h>
+#include <color.h>
 #include <lodepng.h>
 #include "Astc.h"
 #include "Ktx.h"
+#include "KtxFileHeader.h"
+#include "AstcDecoder.h"
+#include "AstcEncoder.h"
+#include "BcEncoder.h"
+#include "CrunchDecoder.h"
+#include "EtcEncoder.h"
+#include "TextureContainer.h"
+#include "ThreadPool.h"
+#include "JobQueue.h"
+#include "ImageStream.h"
+#include <algorithm>
+#include <cstring>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
 #include <stb_image_write.h>
 #include <stb_image.h>
 #include "texture2d.h"
 
+// Timing output is opt-in: the entry points run concurrently on Python worker
+// threads (the bindings release the GIL), where stray stdout writes interleave.
+#ifdef TEXTURE2D_VERBOSE
+#define TEXTURE2D_LOG(...) printf(__VA_ARGS__)
+#else
+#define TEXTURE2D_LOG(...) ((void) 0)
+#endif
+
 int CompressEtc1(uint8_t *src, size_t size, int mipmap, float fEffort, int jobs, int header,
                  uint8_t **dst, size_t *filesize) {
     Ktx ktx{src, size, mipmap == 1, Etc::Image::Format::ETC1, fEffort, jobs, header};
     bool result = ktx.Write(dst, filesize);
     if (result) {
-        printf("CompressEtc1 time = %dms\n", ktx.encodingTime);
+        TEXTURE2D_LOG("CompressEtc1 time = %dms\n", ktx.encodingTime);
         return 1;
     } else {
         return 0;
@@ -30,7 +57,7 @@ int CompressEtc2RGB(uint8_t *src, size_t size, int mipmap, float fEffort, int jo
     Ktx ktx{src, size, mipmap == 1, Etc::Image::Format::RGB8, fEffort, jobs, header};
     bool result = ktx.Write(dst, filesize);
     if (result) {
-        printf("CompressEtc2RGB time = %dms\n", ktx.encodingTime);
+        TEXTURE2D_LOG("CompressEtc2RGB time = %dms\n", ktx.encodingTime);
         return 1;
     } else {
         return 0;
@@ -42,20 +69,53 @@ int CompressEtc2RGBA(uint8_t *src, size_t size, int mipmap, float fEffort, int j
     Ktx ktx{src, size, mipmap == 1, Etc::Image::Format::RGBA8, fEffort, jobs, header};
     bool result = ktx.Write(dst, filesize);
     if (result) {
-        printf("CompressEtc2RGBA time = %dms\n", ktx.encodingTime);
+        TEXTURE2D_LOG("CompressEtc2RGBA time = %dms\n", ktx.encodingTime);
+        return 1;
+    } else {
+        return 0;
+    }
+}
+
+int compressEtcRaw(const uint8_t *pixels, unsigned int width, unsigned int height, size_t stride, int mipmap,
+                   Etc::Image::Format format, float fEffort, int jobs, int header, uint8_t **dst, size_t *filesize) {
+    if (pixels == nullptr || width == 0 || height == 0 || stride < (size_t) width * 4) {
+        return 0;
+    }
+    Ktx ktx{pixels, width, height, stride, mipmap == 1, format, fEffort, jobs, header};
+    bool result = ktx.Write(dst, filesize);
+    if (result) {
+        TEXTURE2D_LOG("CompressEtcRaw time = %dms\n", ktx.encodingTime);
         return 1;
     } else {
         return 0;
     }
 }
 
+int CompressEtc1Raw(const uint8_t *pixels, unsigned int width, unsigned int height, size_t stride, int mipmap,
+                    float fEffort, int jobs, int header, uint8_t **dst, size_t *filesize) {
+    return compressEtcRaw(pixels, width, height, stride, mipmap, Etc::Image::Format::ETC1, fEffort, jobs, header,
+                          dst, filesize);
+}
+
+int CompressEtc2RGBRaw(const uint8_t *pixels, unsigned int width, unsigned int height, size_t stride, int mipmap,
+                       float fEffort, int jobs, int header, uint8_t **dst, size_t *filesize) {
+    return compressEtcRaw(pixels, width, height, stride, mipmap, Etc::Image::Format::RGB8, fEffort, jobs, header,
+                          dst, filesize);
+}
+
+int CompressEtc2RGBARaw(const uint8_t *pixels, unsigned int width, unsigned int height, size_t stride, int mipmap,
+                        float fEffort, int jobs, int header, uint8_t **dst, size_t *filesize) {
+    return compressEtcRaw(pixels, width, height, stride, mipmap, Etc::Image::Format::RGBA8, fEffort, jobs, header,
+                          dst, filesize);
+}
+
 
 int CompressEtc1WithFile(const char *input, const char *output,
                          int mipmap, float fEffort, int jobs) {
     Ktx ktx{input, mipmap == 1, Etc::Image::Format::ETC1, fEffort, jobs};
     bool result = ktx.WriteToFile(output);
     if (result) {
-        printf("CompressEtc1WithFile encode time = %dms\n", ktx.encodingTime);
+        TEXTURE2D_LOG("CompressEtc1WithFile encode time = %dms\n", ktx.encodingTime);
         return 1;
     } else {
         return 0;
@@ -67,7 +127,7 @@ int CompressEtc2RGBWithFile(const char *input, const char *output,
     Ktx ktx{input, mipmap == 1, Etc::Image::Format::RGB8, fEffort, jobs};
     bool result = ktx.WriteToFile(output);
     if (result) {
-        printf("CompressEtc2RGBWithFile encode time = %dms\n", ktx.encodingTime);
+        TEXTURE2D_LOG("CompressEtc2RGBWithFile encode time = %dms\n", ktx.encodingTime);
         return 1;
     } else {
         return 0;
@@ -79,23 +139,20 @@ int CompressEtc2RGBAWithFile(const char *input, const char *output,
     Ktx ktx{input, mipmap == 1, Etc::Image::Format::RGBA8, fEffort, jobs};
     bool result = ktx.WriteToFile(output);
     if (result) {
-        printf("CompressEtc2RGBAWithFile encode time = %dms\n", ktx.encodingTime);
+        TEXTURE2D_LOG("CompressEtc2RGBAWithFile encode time = %dms\n", ktx.encodingTime);
         return 1;
     } else {
         return 0;
     }
 }
 
-int CompressAstc(uint8_t *src, size_t size, float fEffort,
-                 unsigned int block_x, unsigned int block_y, unsigned int block_z, int header,
-                 uint8_t **dst, size_t *filesize) {
-    Astc astc{src, size, fEffort, block_x, block_y, block_z, header};
+int compressAstc(Astc &astc, uint8_t **dst, size_t *filesize) {
     int state = astc.Read();
     if (state) {
         bool result = astc.Write(dst, filesize);
         astc.Clear();
         if (result) {
-            printf("CompressAstc encode time = %dms\n", astc.encodingTime);
+            TEXTURE2D_LOG("CompressAstc encode time = %dms\n", astc.encodingTime);
             return 1;
         } else {
             return 0;
@@ -104,7 +161,23 @@ int CompressAstc(uint8_t *src, size_t size, float fEffort,
         astc.Clear();
         return 0;
     }
-    return 1;
+}
+
+int CompressAstc(uint8_t *src, size_t size, float fEffort,
+                 unsigned int block_x, unsigned int block_y, unsigned int block_z, int header,
+                 uint8_t **dst, size_t *filesize) {
+    Astc astc{src, size, fEffort, block_x, block_y, block_z, header};
+    return compressAstc(astc, dst, filesize);
+}
+
+int CompressAstcRaw(const uint8_t *pixels, unsigned int width, unsigned int height, size_t stride, float fEffort,
+                    unsigned int block_x, unsigned int block_y, unsigned int block_z, int header,
+                    uint8_t **dst, size_t *filesize) {
+    if (pixels == nullptr || width == 0 || height == 0 || stride < (size_t) width * 4) {
+        return 0;
+    }
+    Astc astc{pixels, width, height, stride, fEffort, block_x, block_y, block_z, header};
+    return compressAstc(astc, dst, filesize);
 }
 
 int CompressAstcWithFile(const char *input, const char *output,
@@ -115,7 +188,7 @@ int CompressAstcWithFile(const char *input, const char *output,
         bool result = astc.WriteToFile(output);
         astc.Clear();
         if (result) {
-            printf("CompressAstcWithFile encode time = %dms\n", astc.encodingTime);
+            TEXTURE2D_LOG("CompressAstcWithFile encode time = %dms\n", astc.encodingTime);
             return 1;
         } else {
             return 0;
@@ -126,83 +199,1100 @@ int CompressAstcWithFile(const char *input, const char *output,
     }
 }
 
-int decode(uint8_t *src, long w, long h, uint32_t **dst, size_t *filesize,
-           int (func)(const uint8_t *, const long, const long, uint32_t *)) {
-    uint32_t *image = (uint32_t *) malloc(w * h * 4);
-    int error = func(src, w, h, image);
+AstcEncoder *AstcEncoderCreate(int profile, float fEffort,
+                               unsigned int block_x, unsigned int block_y, unsigned int block_z,
+                               unsigned int flags, unsigned int threads) {
+    if (profile < ASTCENC_PRF_LDR_SRGB || profile > ASTCENC_PRF_HDR) {
+        return nullptr;
+    }
+    auto *encoder = new AstcEncoder((astcenc_profile) profile, fEffort, block_x, block_y, block_z, flags, threads);
+    if (!encoder->IsOK()) {
+        delete encoder;
+        return nullptr;
+    }
+    return encoder;
+}
+
+int AstcEncoderCompress(AstcEncoder *encoder, uint8_t *src, size_t size, int header, uint8_t **dst, size_t *filesize) {
+    // block size and quality come from the encoder's config
+    Astc astc{src, size, 0, 0, 0, 0, header};
+    astc.UseEncoder(encoder);
+    return compressAstc(astc, dst, filesize);
+}
+
+int AstcEncoderCompressRaw(AstcEncoder *encoder, const uint8_t *pixels, unsigned int width, unsigned int height,
+                           size_t stride, int header, uint8_t **dst, size_t *filesize) {
+    if (pixels == nullptr || width == 0 || height == 0 || stride < (size_t) width * 4) {
+        return 0;
+    }
+    Astc astc{pixels, width, height, stride, 0, 0, 0, 0, header};
+    astc.UseEncoder(encoder);
+    return compressAstc(astc, dst, filesize);
+}
+
+void AstcEncoderFree(AstcEncoder *encoder) {
+    delete encoder;
+}
+
+EtcEncoder *EtcEncoderCreate(int format, int mipmap, float fEffort, int jobs) {
+    Etc::Image::Format etcFormat;
+    switch (format) {
+        case TEXTURE2D_FORMAT_ETC1:
+            etcFormat = Etc::Image::Format::ETC1;
+            break;
+        case TEXTURE2D_FORMAT_ETC2_RGB:
+            etcFormat = Etc::Image::Format::RGB8;
+            break;
+        case TEXTURE2D_FORMAT_ETC2_RGBA:
+            etcFormat = Etc::Image::Format::RGBA8;
+            break;
+        default:
+            return nullptr;
+    }
+    return new EtcEncoder(etcFormat, mipmap == 1, fEffort, jobs);
+}
+
+int EtcEncoderCompress(EtcEncoder *encoder, uint8_t *src, size_t size, int header, uint8_t **dst, size_t *filesize) {
+    Ktx ktx{src, size, encoder->mipmap, encoder->format, encoder->fEffort, encoder->jobs, header};
+    bool result = ktx.Write(dst, filesize);
+    if (result) {
+        TEXTURE2D_LOG("EtcEncoderCompress time = %dms\n", ktx.encodingTime);
+        return 1;
+    } else {
+        return 0;
+    }
+}
+
+int EtcEncoderCompressRaw(EtcEncoder *encoder, const uint8_t *pixels, unsigned int width, unsigned int height,
+                          size_t stride, int header, uint8_t **dst, size_t *filesize) {
+    return compressEtcRaw(pixels, width, height, stride, encoder->mipmap ? 1 : 0, encoder->format, encoder->fEffort,
+                          encoder->jobs, header, dst, filesize);
+}
+
+void EtcEncoderFree(EtcEncoder *encoder) {
+    delete encoder;
+}
+
+struct BatchState {
+    Texture2dBatchItem *items;
+    size_t count;
+    int format;
+    Texture2dCompressParams params;
+
+    std::atomic<size_t> next{0};
+    size_t completed = 0;
+    std::mutex lock;
+    std::condition_variable finished;
+};
+
+void compressItem(Texture2dBatchItem &item, int format, const Texture2dCompressParams &params,
+                  AstcEncoder *astcEncoder, EtcEncoder *etcEncoder) {
+    if (format == TEXTURE2D_FORMAT_ASTC) {
+        if (astcEncoder == nullptr) {
+            item.ok = 0;
+        } else if (item.width == 0) {
+            item.ok = AstcEncoderCompress(astcEncoder, (uint8_t *) item.src, item.size, params.header,
+                                          &item.dst, &item.filesize);
+        } else {
+            item.ok = AstcEncoderCompressRaw(astcEncoder, item.src, item.width, item.height, item.stride,
+                                             params.header, &item.dst, &item.filesize);
+        }
+    } else {
+        if (etcEncoder == nullptr) {
+            item.ok = 0;
+        } else if (item.width == 0) {
+            item.ok = EtcEncoderCompress(etcEncoder, (uint8_t *) item.src, item.size, params.header,
+                                         &item.dst, &item.filesize);
+        } else {
+            item.ok = EtcEncoderCompressRaw(etcEncoder, item.src, item.width, item.height, item.stride,
+                                            params.header, &item.dst, &item.filesize);
+        }
+    }
+}
+
+// Pulls items until the batch is drained, so small images pack onto whichever worker is free.
+// Runners that only get scheduled after the batch finished find nothing left and exit.
+void runBatch(const std::shared_ptr<BatchState> &state) {
+    const Texture2dCompressParams &params = state->params;
+    AstcEncoder *astcEncoder = nullptr;
+    EtcEncoder *etcEncoder = nullptr;
+    size_t i;
+    while ((i = state->next++) < state->count) {
+        if (state->format == TEXTURE2D_FORMAT_ASTC && astcEncoder == nullptr) {
+            astcEncoder = AstcEncoderCreate(ASTCENC_PRF_LDR, params.fEffort,
+                                            params.block_x, params.block_y, params.block_z, 0, 1);
+        } else if (state->format != TEXTURE2D_FORMAT_ASTC && etcEncoder == nullptr) {
+            etcEncoder = EtcEncoderCreate(state->format, params.mipmap, params.fEffort, params.jobs);
+        }
+        compressItem(state->items[i], state->format, params, astcEncoder, etcEncoder);
+        std::lock_guard<std::mutex> guard(state->lock);
+        if (++state->completed == state->count) {
+            state->finished.notify_all();
+        }
+    }
+    AstcEncoderFree(astcEncoder);
+    EtcEncoderFree(etcEncoder);
+}
+
+int CompressBatch(Texture2dBatchItem *items, size_t count, int format, const Texture2dCompressParams *params) {
+    if (format < TEXTURE2D_FORMAT_ETC1 || format > TEXTURE2D_FORMAT_ASTC) {
+        return 0;
+    }
+    for (size_t i = 0; i < count; i++) {
+        items[i].dst = nullptr;
+        items[i].filesize = 0;
+        items[i].ok = 0;
+    }
+    if (count == 0) {
+        return 1;
+    }
+
+    auto state = std::make_shared<BatchState>();
+    state->items = items;
+    state->count = count;
+    state->format = format;
+    state->params = *params;
+
+    // the calling thread works the batch too, so it completes even when every pool thread is busy
+    ThreadPool &pool = ThreadPool::Shared();
+    size_t helpers = std::min<size_t>(pool.Size(), count - 1);
+    for (size_t i = 0; i < helpers; i++) {
+        pool.Enqueue([state]() { runBatch(state); });
+    }
+    runBatch(state);
+
+    std::unique_lock<std::mutex> guard(state->lock);
+    state->finished.wait(guard, [&state]() { return state->completed == state->count; });
+
+    for (size_t i = 0; i < count; i++) {
+        if (items[i].ok != 1) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Each pool thread keeps the astc context of its last job, so a stream of submissions with the same
+// settings doesn't pay for a context per image
+AstcEncoder *workerAstcEncoder(const Texture2dCompressParams &params) {
+    struct Cached {
+        AstcEncoder *encoder = nullptr;
+        Texture2dCompressParams params{};
+
+        ~Cached() {
+            AstcEncoderFree(encoder);
+        }
+    };
+    thread_local Cached cached;
+    if (cached.encoder == nullptr || cached.params.fEffort != params.fEffort ||
+        cached.params.block_x != params.block_x || cached.params.block_y != params.block_y ||
+        cached.params.block_z != params.block_z) {
+        AstcEncoderFree(cached.encoder);
+        cached.encoder = AstcEncoderCreate(ASTCENC_PRF_LDR, params.fEffort,
+                                           params.block_x, params.block_y, params.block_z, 0, 1);
+        cached.params = params;
+    }
+    return cached.encoder;
+}
+
+int SubmitCompress(const Texture2dBatchItem *image, int format, const Texture2dCompressParams *params,
+                   int (*start)(void *userdata), void (*done)(void *userdata, int ok, uint8_t *dst, size_t filesize),
+                   void *userdata) {
+    if (format < TEXTURE2D_FORMAT_ETC1 || format > TEXTURE2D_FORMAT_ASTC) {
+        return 0;
+    }
+    Texture2dBatchItem item = *image;
+    Texture2dCompressParams jobParams = *params;
+    JobQueue::Shared().Submit([item, format, jobParams, start, done, userdata]() mutable {
+        item.dst = nullptr;
+        item.filesize = 0;
+        item.ok = 0;
+        if (start == nullptr || start(userdata)) {
+            if (format == TEXTURE2D_FORMAT_ASTC) {
+                compressItem(item, format, jobParams, workerAstcEncoder(jobParams), nullptr);
+            } else {
+                EtcEncoder *encoder = EtcEncoderCreate(format, jobParams.mipmap, jobParams.fEffort, jobParams.jobs);
+                compressItem(item, format, jobParams, nullptr, encoder);
+                EtcEncoderFree(encoder);
+            }
+        }
+        done(userdata, item.ok, item.dst, item.filesize);
+    });
+    return 1;
+}
+
+void SetJobLimits(unsigned int concurrency, unsigned int max_pending) {
+    JobQueue::Shared().SetLimits(concurrency, max_pending);
+}
+
+void WaitJobs(void) {
+    JobQueue::Shared().WaitIdle();
+}
+
+// A block format stored row-major with a fixed size per block, decodable by the serial func into any
+// TEXTURE2D_OUTPUT_* layout
+struct BlockDecoder {
+    long bw;
+    long bh;
+    long block_bytes;
+    std::function<int(const uint8_t *, long, long, int, uint8_t *)> func;
+};
+
+static_assert(TEXTURE2D_OUTPUT_BGRA == LAYOUT_BGRA && TEXTURE2D_OUTPUT_RGBA == LAYOUT_RGBA &&
+              TEXTURE2D_OUTPUT_RGB == LAYOUT_RGB && TEXTURE2D_OUTPUT_R8 == LAYOUT_R8 &&
+              TEXTURE2D_OUTPUT_RG8 == LAYOUT_RG8, "output formats are passed through as decoder layouts");
+
+int OutputFormatBytes(int output_format) {
+    return layout_bytes(output_format);
+}
+
+// Splits the image into stripes of whole block rows decoded on up to `jobs` threads. A stripe is just
+// a shorter image of the same width, starting at its first block and first output row, so every
+// worker writes its own disjoint rows through the unmodified serial decoder.
+int decodeBlocks(const uint8_t *src, long w, long h, int jobs, int output_format, uint8_t *image,
+                 const BlockDecoder &decoder) {
+    long blocks_x = (w + decoder.bw - 1) / decoder.bw;
+    long blocks_y = (h + decoder.bh - 1) / decoder.bh;
+    long row_bytes = w * layout_bytes(output_format);
+    if (row_bytes == 0 && w > 0) {
+        return 0;
+    }
+    if (jobs <= 1 || blocks_y < 2) {
+        return decoder.func(src, w, h, output_format, image);
+    }
+    // a few stripes per thread keeps them balanced when some block rows decode slower
+    long stripes = std::min<long>(blocks_y, (long) jobs * 4);
+    std::atomic<int> result{1};
+    ThreadPool::Shared().ParallelFor((size_t) stripes, (unsigned int) jobs, [&](size_t i) {
+        long by0 = blocks_y * (long) i / stripes;
+        long by1 = blocks_y * ((long) i + 1) / stripes;
+        long y0 = by0 * decoder.bh;
+        long y1 = std::min(h, by1 * decoder.bh);
+        if (decoder.func(src + by0 * blocks_x * decoder.block_bytes, w, y1 - y0, output_format,
+                         image + y0 * row_bytes) != 1) {
+            result = 0;
+        }
+    });
+    return result;
+}
+
+int decode(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t **dst, size_t *filesize,
+           const BlockDecoder &decoder) {
+    size_t size = (size_t) w * h * layout_bytes(output_format);
+    uint8_t *image = (uint8_t *) malloc(size);
+    if (image == nullptr) {
+        return 0;
+    }
+    int error = decodeBlocks(src, w, h, jobs, output_format, image, decoder);
     if (error != 1) {
+        free(image);
         return error;
     }
     *dst = image;
-    *filesize = w * h * 4;
+    *filesize = size;
     return 1;
 }
 
-int DecompressEtc1(uint8_t *src, long w, long h, uint32_t **dst, size_t *filesize) {
-    return decode(src, w, h, dst, filesize, decode_etc1);
+BlockDecoder astcBlockDecoder(long block_width, long block_height) {
+    return {block_width, block_height, 16, [block_width, block_height](const uint8_t *src, long w, long h,
+                                                                       int layout, uint8_t *image) {
+        return decode_astc_as(src, w, h, block_width, block_height, layout, image);
+    }};
 }
 
-int DecompressEtc2(uint8_t *src, long w, long h, uint32_t **dst, size_t *filesize) {
-    return decode(src, w, h, dst, filesize, decode_etc2);
+int DecompressEtc1(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t **dst, size_t *filesize) {
+    return decode(src, w, h, jobs, output_format, dst, filesize, {4, 4, 8, decode_etc1_as});
 }
 
-int DecompressEtc2a1(uint8_t *src, long w, long h, uint32_t **dst, size_t *filesize) {
-    return decode(src, w, h, dst, filesize, decode_etc2a1);
+int DecompressEtc2(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t **dst, size_t *filesize) {
+    return decode(src, w, h, jobs, output_format, dst, filesize, {4, 4, 8, decode_etc2_as});
 }
 
-int DecompressEtc2a8(uint8_t *src, long w, long h, uint32_t **dst, size_t *filesize) {
-    return decode(src, w, h, dst, filesize, decode_etc2a8);
+int DecompressEtc2a1(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t **dst, size_t *filesize) {
+    return decode(src, w, h, jobs, output_format, dst, filesize, {4, 4, 8, decode_etc2a1_as});
 }
 
-int DecompressAstc(uint8_t *src, long w, long h, long block_width, long block_height, uint32_t **dst,
-                   size_t *filesize) {
-    uint32_t *image = (uint32_t *) malloc(w * h * 4);
-    int error = decode_astc(src, w, h, block_width, block_height, image);
-    if (error != 1) {
-        return error;
+int DecompressEtc2a8(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t **dst, size_t *filesize) {
+    return decode(src, w, h, jobs, output_format, dst, filesize, {4, 4, 16, decode_etc2a8_as});
+}
+
+int DecompressAstc(uint8_t *src, long w, long h, long block_width, long block_height, int jobs, int output_format,
+                   uint8_t **dst, size_t *filesize) {
+    return decode(src, w, h, jobs, output_format, dst, filesize, astcBlockDecoder(block_width, block_height));
+}
+
+int DecompressBc1(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t **dst, size_t *filesize) {
+    return decode(src, w, h, jobs, output_format, dst, filesize, {4, 4, 8, decode_bc1_as});
+}
+
+int DecompressBc3(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t **dst, size_t *filesize) {
+    return decode(src, w, h, jobs, output_format, dst, filesize, {4, 4, 16, decode_bc3_as});
+}
+
+int DecompressBc4(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t **dst, size_t *filesize) {
+    return decode(src, w, h, jobs, output_format, dst, filesize, {4, 4, 8, decode_bc4_as});
+}
+
+int DecompressBc5(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t **dst, size_t *filesize) {
+    return decode(src, w, h, jobs, output_format, dst, filesize, {4, 4, 16, decode_bc5_as});
+}
+
+int DecompressBc6(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t **dst, size_t *filesize) {
+    return decode(src, w, h, jobs, output_format, dst, filesize, {4, 4, 16, decode_bc6_as});
+}
+
+int DecompressBc7(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t **dst, size_t *filesize) {
+    return decode(src, w, h, jobs, output_format, dst, filesize, {4, 4, 16, decode_bc7_as});
+}
+
+int DecompressEacR11(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t **dst, size_t *filesize) {
+    return decode(src, w, h, jobs, output_format, dst, filesize, {4, 4, 8, decode_eacr_as});
+}
+
+int DecompressEacR11Signed(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t **dst, size_t *filesize) {
+    return decode(src, w, h, jobs, output_format, dst, filesize, {4, 4, 8, decode_eacr_signed_as});
+}
+
+int DecompressEacRG11(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t **dst, size_t *filesize) {
+    return decode(src, w, h, jobs, output_format, dst, filesize, {4, 4, 16, decode_eacrg_as});
+}
+
+int DecompressEacRG11Signed(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t **dst,
+                            size_t *filesize) {
+    return decode(src, w, h, jobs, output_format, dst, filesize, {4, 4, 16, decode_eacrg_signed_as});
+}
+
+// PVRTC blocks reach into their neighbours, so the image can't be cut into independent stripes of
+// blocks. The colours and weights of all blocks are expanded once, then stripes of pixel rows are
+// decoded from that on up to `jobs` threads.
+int decodePvrtc(const uint8_t *src, long w, long h, int is2bpp, int jobs, int output_format, uint8_t *image) {
+    if (w < 0 || h < 0 || layout_bytes(output_format) == 0) {
+        return 0;
+    }
+    if (w == 0 || h == 0) {
+        return 1;
+    }
+    PVRTCImage expanded;
+    if (pvrtc_expand(src, w, h, is2bpp, &expanded) != 1) {
+        return 0;
+    }
+    long stripes = std::min<long>((h + 3) / 4, (long) std::max(jobs, 1) * 4);
+    std::atomic<int> result{1};
+    ThreadPool::Shared().ParallelFor((size_t) stripes, (unsigned int) std::max(jobs, 1), [&](size_t i) {
+        long y0 = h * (long) i / stripes;
+        long y1 = h * ((long) i + 1) / stripes;
+        if (pvrtc_decode_rows_as(&expanded, y0, y1, output_format, image) != 1) {
+            result = 0;
+        }
+    });
+    pvrtc_free(&expanded);
+    return result;
+}
+
+int DecompressPvrtc(uint8_t *src, long w, long h, int is2bpp, int jobs, int output_format, uint8_t **dst,
+                    size_t *filesize) {
+    size_t size = (size_t) w * h * layout_bytes(output_format);
+    uint8_t *image = (uint8_t *) malloc(size);
+    if (image == nullptr || decodePvrtc(src, w, h, is2bpp, jobs, output_format, image) != 1) {
+        free(image);
+        return 0;
     }
     *dst = image;
-    *filesize = w * h * 4;
+    *filesize = size;
     return 1;
 }
 
-int decodeToFile(uint8_t *src, long w, long h, const char *out,
-                 int (func)(const uint8_t *, const long, const long, uint32_t *)) {
-    uint32_t *image = (uint32_t *) malloc(w * h * 4);
-    int error = func(src, w, h, image);
-    if (error != 1) {
-        return error;
+int DecompressEtc1Into(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t *dst) {
+    return decodeBlocks(src, w, h, jobs, output_format, dst, {4, 4, 8, decode_etc1_as});
+}
+
+int DecompressEtc2Into(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t *dst) {
+    return decodeBlocks(src, w, h, jobs, output_format, dst, {4, 4, 8, decode_etc2_as});
+}
+
+int DecompressEtc2a1Into(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t *dst) {
+    return decodeBlocks(src, w, h, jobs, output_format, dst, {4, 4, 8, decode_etc2a1_as});
+}
+
+int DecompressEtc2a8Into(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t *dst) {
+    return decodeBlocks(src, w, h, jobs, output_format, dst, {4, 4, 16, decode_etc2a8_as});
+}
+
+int DecompressAstcInto(uint8_t *src, long w, long h, long block_width, long block_height, int jobs,
+                       int output_format, uint8_t *dst) {
+    return decodeBlocks(src, w, h, jobs, output_format, dst, astcBlockDecoder(block_width, block_height));
+}
+
+int DecompressBc1Into(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t *dst) {
+    return decodeBlocks(src, w, h, jobs, output_format, dst, {4, 4, 8, decode_bc1_as});
+}
+
+int DecompressBc3Into(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t *dst) {
+    return decodeBlocks(src, w, h, jobs, output_format, dst, {4, 4, 16, decode_bc3_as});
+}
+
+int DecompressBc4Into(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t *dst) {
+    return decodeBlocks(src, w, h, jobs, output_format, dst, {4, 4, 8, decode_bc4_as});
+}
+
+int DecompressBc5Into(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t *dst) {
+    return decodeBlocks(src, w, h, jobs, output_format, dst, {4, 4, 16, decode_bc5_as});
+}
+
+int DecompressBc6Into(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t *dst) {
+    return decodeBlocks(src, w, h, jobs, output_format, dst, {4, 4, 16, decode_bc6_as});
+}
+
+int DecompressBc7Into(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t *dst) {
+    return decodeBlocks(src, w, h, jobs, output_format, dst, {4, 4, 16, decode_bc7_as});
+}
+
+int DecompressEacR11Into(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t *dst) {
+    return decodeBlocks(src, w, h, jobs, output_format, dst, {4, 4, 8, decode_eacr_as});
+}
+
+int DecompressEacR11SignedInto(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t *dst) {
+    return decodeBlocks(src, w, h, jobs, output_format, dst, {4, 4, 8, decode_eacr_signed_as});
+}
+
+int DecompressEacRG11Into(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t *dst) {
+    return decodeBlocks(src, w, h, jobs, output_format, dst, {4, 4, 16, decode_eacrg_as});
+}
+
+int DecompressEacRG11SignedInto(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t *dst) {
+    return decodeBlocks(src, w, h, jobs, output_format, dst, {4, 4, 16, decode_eacrg_signed_as});
+}
+
+int DecompressPvrtcInto(uint8_t *src, long w, long h, int is2bpp, int jobs, int output_format, uint8_t *dst) {
+    return decodePvrtc(src, w, h, is2bpp, jobs, output_format, dst);
+}
+
+// Each calling thread keeps the context of its last footprint, contexts are costly to build and only
+// decode one image at a time
+AstcDecoder *threadAstcDecoder(long block_width, long block_height) {
+    struct Cached {
+        std::unique_ptr<AstcDecoder> decoder;
+        long block_width = 0;
+        long block_height = 0;
+    };
+    thread_local Cached cached;
+    if (cached.decoder == nullptr || cached.block_width != block_width || cached.block_height != block_height) {
+        // the hdr profile also decodes ldr blocks, to unorm16 precision
+        cached.decoder.reset(new AstcDecoder(ASTCENC_PRF_HDR, (unsigned int) block_width,
+                                             (unsigned int) block_height));
+        cached.block_width = block_width;
+        cached.block_height = block_height;
+        if (!cached.decoder->IsOK()) {
+            cached.decoder.reset();
+        }
+    }
+    return cached.decoder.get();
+}
+
+int FloatFormatBytes(int float_format) {
+    switch (float_format) {
+        case TEXTURE2D_FLOAT_RGBA16F:
+            return 8;
+        case TEXTURE2D_FLOAT_RGBA32F:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+int DecompressAstcFloatInto(uint8_t *src, long w, long h, long block_width, long block_height, int jobs,
+                            int float_format, uint8_t *dst) {
+    if (w < 0 || h < 0 || FloatFormatBytes(float_format) == 0) {
+        return 0;
+    }
+    if (w == 0 || h == 0) {
+        return 1;
+    }
+    AstcDecoder *decoder = threadAstcDecoder(block_width, block_height);
+    if (decoder == nullptr) {
+        return 0;
+    }
+    void *slices[] = {dst};
+    astcenc_image image{(unsigned int) w, (unsigned int) h, 1,
+                        float_format == TEXTURE2D_FLOAT_RGBA16F ? ASTCENC_TYPE_F16 : ASTCENC_TYPE_F32, slices};
+    size_t blocks = (size_t) ((w + block_width - 1) / block_width) * ((h + block_height - 1) / block_height);
+    return decoder->DecompressImage(src, blocks * 16, &image, jobs) == ASTCENC_SUCCESS ? 1 : 0;
+}
+
+int DecompressAstcFloat(uint8_t *src, long w, long h, long block_width, long block_height, int jobs,
+                        int float_format, uint8_t **dst, size_t *filesize) {
+    size_t size = (size_t) std::max(w, 0L) * std::max(h, 0L) * (size_t) FloatFormatBytes(float_format);
+    uint8_t *image = (uint8_t *) malloc(std::max<size_t>(size, 1));
+    if (image == nullptr || DecompressAstcFloatInto(src, w, h, block_width, block_height, jobs, float_format,
+                                                    image) != 1) {
+        free(image);
+        return 0;
+    }
+    *dst = image;
+    *filesize = size;
+    return 1;
+}
+
+static_assert(TEXTURE2D_IMAGE_PNG == ImageStream::PNG && TEXTURE2D_IMAGE_PNG_FAST == ImageStream::PNG_FAST &&
+              TEXTURE2D_IMAGE_QOI == ImageStream::QOI && TEXTURE2D_IMAGE_TGA == ImageStream::TGA &&
+              TEXTURE2D_IMAGE_RAW == ImageStream::RAW, "image formats are passed through to ImageStream");
+
+// Decodes a batch of whole block rows at a time into RGBA and hands it to an ImageStream, whose thread
+// encodes and writes the previous batches meanwhile. Only a few batches are held instead of the
+// full image plus the encoder's copy of it.
+int decodeToImage(uint8_t *src, long w, long h, int jobs, int image_format, const ImageStream::Sink &sink,
+                  const BlockDecoder &decoder) {
+    if (w <= 0 || h <= 0 || !ImageStream::Supports(image_format)) {
+        return 0;
+    }
+    long blocks_x = (w + decoder.bw - 1) / decoder.bw;
+    long row_bytes = w * 4;
+    // ~256KB batches, long enough that deflate parts rarely lose a back-reference at their start
+    long batch_rows = std::max(1L, 256 * 1024 / (row_bytes * decoder.bh)) * decoder.bh;
+    int result = 1;
+    ImageStream image(image_format, (uint32_t) w, (uint32_t) h, sink);
+    for (long y = 0; y < h && result == 1; y += batch_rows) {
+        long rows = std::min(batch_rows, h - y);
+        std::vector<uint8_t> buffer = image.Buffer();
+        buffer.resize((size_t) rows * row_bytes);
+        result = decodeBlocks(src + (size_t) (y / decoder.bh) * blocks_x * decoder.block_bytes, w, rows, jobs,
+                              TEXTURE2D_OUTPUT_RGBA, buffer.data(), decoder);
+        if (result == 1) {
+            image.Write(std::move(buffer));
+        }
     }
-    lodepng_encode_file(out, reinterpret_cast<const unsigned char *>(image), w, h, LCT_RGBA, 8);
-    delete[] image;
+    bool written = image.Finish();
+    return result == 1 && written ? 1 : 0;
+}
+
+int decodeToFile(uint8_t *src, long w, long h, int jobs, int image_format, const char *out,
+                 const BlockDecoder &decoder) {
+    if (!ImageStream::Supports(image_format)) {
+        return 0;
+    }
+    FILE *file = fopen(out, "wb");
+    if (file == nullptr) {
+        return 0;
+    }
+    int result = decodeToImage(src, w, h, jobs, image_format, [file](const uint8_t *data, size_t size) {
+        return fwrite(data, 1, size, file) == size;
+    }, decoder);
+    if (fclose(file) != 0 || result != 1) {
+        remove(out);
+        return 0;
+    }
+    return 1;
+}
+
+int decodeToImageBytes(uint8_t *src, long w, long h, int jobs, int image_format, uint8_t **dst, size_t *filesize,
+                       const BlockDecoder &decoder) {
+    uint8_t *data = nullptr;
+    size_t size = 0;
+    // raw and tga sizes are exact, the compressed formats grow from there if they have to
+    size_t capacity = (size_t) std::max(w, 0L) * std::max(h, 0L) * 4 + 64;
+    int result = decodeToImage(src, w, h, jobs, image_format, [&](const uint8_t *bytes, size_t count) {
+        if (data == nullptr || size + count > capacity) {
+            capacity = std::max(data == nullptr ? capacity : capacity * 2, size + count);
+            uint8_t *grown = (uint8_t *) realloc(data, capacity);
+            if (grown == nullptr) {
+                return false;
+            }
+            data = grown;
+        }
+        memcpy(data + size, bytes, count);
+        size += count;
+        return true;
+    }, decoder);
+    if (result != 1) {
+        free(data);
+        return 0;
+    }
+    // give back what the compressed formats did not use of the raw-sized guess
+    uint8_t *shrunk = (uint8_t *) realloc(data, size);
+    *dst = shrunk != nullptr ? shrunk : data;
+    *filesize = size;
     return 1;
 }
 
+int DecompressEtc1ToFile(uint8_t *src, long w, long h, int jobs, int image_format, const char *out) {
+    return decodeToFile(src, w, h, jobs, image_format, out, {4, 4, 8, decode_etc1_as});
+}
 
-int DecompressEtc1ToFile(uint8_t *src, long w, long h, const char *out) {
-    return decodeToFile(src, w, h, out, decode_etc1);
+int DecompressEtc2ToFile(uint8_t *src, long w, long h, int jobs, int image_format, const char *out) {
+    return decodeToFile(src, w, h, jobs, image_format, out, {4, 4, 8, decode_etc2_as});
 }
 
-int DecompressEtc2ToFile(uint8_t *src, long w, long h, const char *out) {
-    return decodeToFile(src, w, h, out, decode_etc2);
+int DecompressEtc2a1ToFile(uint8_t *src, long w, long h, int jobs, int image_format, const char *out) {
+    return decodeToFile(src, w, h, jobs, image_format, out, {4, 4, 8, decode_etc2a1_as});
 }
 
-int DecompressEtc2a1ToFile(uint8_t *src, long w, long h, const char *out) {
-    return decodeToFile(src, w, h, out, decode_etc2a1);
+int DecompressEtc2a8ToFile(uint8_t *src, long w, long h, int jobs, int image_format, const char *out) {
+    return decodeToFile(src, w, h, jobs, image_format, out, {4, 4, 16, decode_etc2a8_as});
 }
 
-int DecompressEtc2a8ToFile(uint8_t *src, long w, long h, const char *out) {
-    return decodeToFile(src, w, h, out, decode_etc2a8);
+int DecompressAstcToFile(uint8_t *src, long w, long h, long block_width, long block_height, int jobs,
+                         int image_format, const char *out) {
+    return decodeToFile(src, w, h, jobs, image_format, out, astcBlockDecoder(block_width, block_height));
 }
 
-int DecompressAstcToFile(uint8_t *src, long w, long h, long block_width, long block_height, const char *out) {
-    uint32_t *image = (uint32_t *) malloc(w * h * 4);
-    int error = decode_astc(src, w, h, block_width, block_height, image);
-    if (error != 1) {
-        return error;
+int DecompressBc1ToFile(uint8_t *src, long w, long h, int jobs, int image_format, const char *out) {
+    return decodeToFile(src, w, h, jobs, image_format, out, {4, 4, 8, decode_bc1_as});
+}
+
+int DecompressBc3ToFile(uint8_t *src, long w, long h, int jobs, int image_format, const char *out) {
+    return decodeToFile(src, w, h, jobs, image_format, out, {4, 4, 16, decode_bc3_as});
+}
+
+int DecompressBc4ToFile(uint8_t *src, long w, long h, int jobs, int image_format, const char *out) {
+    return decodeToFile(src, w, h, jobs, image_format, out, {4, 4, 8, decode_bc4_as});
+}
+
+int DecompressBc5ToFile(uint8_t *src, long w, long h, int jobs, int image_format, const char *out) {
+    return decodeToFile(src, w, h, jobs, image_format, out, {4, 4, 16, decode_bc5_as});
+}
+
+int DecompressBc6ToFile(uint8_t *src, long w, long h, int jobs, int image_format, const char *out) {
+    return decodeToFile(src, w, h, jobs, image_format, out, {4, 4, 16, decode_bc6_as});
+}
+
+int DecompressBc7ToFile(uint8_t *src, long w, long h, int jobs, int image_format, const char *out) {
+    return decodeToFile(src, w, h, jobs, image_format, out, {4, 4, 16, decode_bc7_as});
+}
+
+int DecompressEtc1ToImageBytes(uint8_t *src, long w, long h, int jobs, int image_format, uint8_t **dst,
+                               size_t *filesize) {
+    return decodeToImageBytes(src, w, h, jobs, image_format, dst, filesize, {4, 4, 8, decode_etc1_as});
+}
+
+int DecompressEtc2ToImageBytes(uint8_t *src, long w, long h, int jobs, int image_format, uint8_t **dst,
+                               size_t *filesize) {
+    return decodeToImageBytes(src, w, h, jobs, image_format, dst, filesize, {4, 4, 8, decode_etc2_as});
+}
+
+int DecompressEtc2a1ToImageBytes(uint8_t *src, long w, long h, int jobs, int image_format, uint8_t **dst,
+                                 size_t *filesize) {
+    return decodeToImageBytes(src, w, h, jobs, image_format, dst, filesize, {4, 4, 8, decode_etc2a1_as});
+}
+
+int DecompressEtc2a8ToImageBytes(uint8_t *src, long w, long h, int jobs, int image_format, uint8_t **dst,
+                                 size_t *filesize) {
+    return decodeToImageBytes(src, w, h, jobs, image_format, dst, filesize, {4, 4, 16, decode_etc2a8_as});
+}
+
+int DecompressAstcToImageBytes(uint8_t *src, long w, long h, long block_width, long block_height, int jobs,
+                               int image_format, uint8_t **dst, size_t *filesize) {
+    return decodeToImageBytes(src, w, h, jobs, image_format, dst, filesize,
+                              astcBlockDecoder(block_width, block_height));
+}
+
+int DecompressBc1ToImageBytes(uint8_t *src, long w, long h, int jobs, int image_format, uint8_t **dst,
+                              size_t *filesize) {
+    return decodeToImageBytes(src, w, h, jobs, image_format, dst, filesize, {4, 4, 8, decode_bc1_as});
+}
+
+int DecompressBc3ToImageBytes(uint8_t *src, long w, long h, int jobs, int image_format, uint8_t **dst,
+                              size_t *filesize) {
+    return decodeToImageBytes(src, w, h, jobs, image_format, dst, filesize, {4, 4, 16, decode_bc3_as});
+}
+
+int DecompressBc4ToImageBytes(uint8_t *src, long w, long h, int jobs, int image_format, uint8_t **dst,
+                              size_t *filesize) {
+    return decodeToImageBytes(src, w, h, jobs, image_format, dst, filesize, {4, 4, 8, decode_bc4_as});
+}
+
+int DecompressBc5ToImageBytes(uint8_t *src, long w, long h, int jobs, int image_format, uint8_t **dst,
+                              size_t *filesize) {
+    return decodeToImageBytes(src, w, h, jobs, image_format, dst, filesize, {4, 4, 16, decode_bc5_as});
+}
+
+int DecompressBc6ToImageBytes(uint8_t *src, long w, long h, int jobs, int image_format, uint8_t **dst,
+                              size_t *filesize) {
+    return decodeToImageBytes(src, w, h, jobs, image_format, dst, filesize, {4, 4, 16, decode_bc6_as});
+}
+
+int DecompressBc7ToImageBytes(uint8_t *src, long w, long h, int jobs, int image_format, uint8_t **dst,
+                              size_t *filesize) {
+    return decodeToImageBytes(src, w, h, jobs, image_format, dst, filesize, {4, 4, 16, decode_bc7_as});
+}
+
+// format is one of TEXTURE2D_FORMAT_*, block_width/block_height are only read for astc
+int formatBlockDecoder(int format, long block_width, long block_height, BlockDecoder *decoder) {
+    switch (format) {
+    case TEXTURE2D_FORMAT_ETC1:
+        *decoder = {4, 4, 8, decode_etc1_as};
+        return 1;
+    case TEXTURE2D_FORMAT_ETC2_RGB:
+        *decoder = {4, 4, 8, decode_etc2_as};
+        return 1;
+    case TEXTURE2D_FORMAT_ETC2_RGBA:
+        *decoder = {4, 4, 16, decode_etc2a8_as};
+        return 1;
+    case TEXTURE2D_FORMAT_ETC2_RGBA1:
+        *decoder = {4, 4, 8, decode_etc2a1_as};
+        return 1;
+    case TEXTURE2D_FORMAT_ASTC:
+        if (block_width < 4 || block_width > 12 || block_height < 4 || block_height > 12) {
+            return 0;
+        }
+        *decoder = astcBlockDecoder(block_width, block_height);
+        return 1;
+    case TEXTURE2D_FORMAT_BC1:
+        *decoder = {4, 4, 8, decode_bc1_as};
+        return 1;
+    case TEXTURE2D_FORMAT_BC3:
+        *decoder = {4, 4, 16, decode_bc3_as};
+        return 1;
+    case TEXTURE2D_FORMAT_BC4:
+        *decoder = {4, 4, 8, decode_bc4_as};
+        return 1;
+    case TEXTURE2D_FORMAT_BC5:
+        *decoder = {4, 4, 16, decode_bc5_as};
+        return 1;
+    case TEXTURE2D_FORMAT_BC6:
+        *decoder = {4, 4, 16, decode_bc6_as};
+        return 1;
+    case TEXTURE2D_FORMAT_BC7:
+        *decoder = {4, 4, 16, decode_bc7_as};
+        return 1;
+    case TEXTURE2D_FORMAT_EAC_R11:
+        *decoder = {4, 4, 8, decode_eacr_as};
+        return 1;
+    case TEXTURE2D_FORMAT_EAC_R11_SIGNED:
+        *decoder = {4, 4, 8, decode_eacr_signed_as};
+        return 1;
+    case TEXTURE2D_FORMAT_EAC_RG11:
+        *decoder = {4, 4, 16, decode_eacrg_as};
+        return 1;
+    case TEXTURE2D_FORMAT_EAC_RG11_SIGNED:
+        *decoder = {4, 4, 16, decode_eacrg_signed_as};
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+size_t BlockImageBytes(int format, long w, long h, long block_width, long block_height) {
+    BlockDecoder decoder;
+    if (w < 0 || h < 0 || !formatBlockDecoder(format, block_width, block_height, &decoder)) {
+        return 0;
+    }
+    return (size_t) ((w + decoder.bw - 1) / decoder.bw) * ((h + decoder.bh - 1) / decoder.bh) * decoder.block_bytes;
+}
+
+size_t PvrtcImageBytes(long w, long h, int is2bpp) {
+    if (w < 0 || h < 0) {
+        return 0;
+    }
+    long bw = is2bpp ? 8 : 4;
+    return (size_t) ((w + bw - 1) / bw) * ((h + 3) / 4) * 8;
+}
+
+// Gathers the blocks covering the rectangle into a compact block image, decodes that and crops it.
+// The gather is a memcpy per block row, so the cost follows the region and not the atlas.
+int decodeRegion(const uint8_t *src, long w, long h, long x, long y, long rw, long rh, int jobs, int output_format,
+                 uint8_t *dst, const BlockDecoder &decoder) {
+    long pixel_bytes = layout_bytes(output_format);
+    if (x < 0 || y < 0 || rw <= 0 || rh <= 0 || x + rw > w || y + rh > h || pixel_bytes == 0) {
+        return 0;
+    }
+    long blocks_x = (w + decoder.bw - 1) / decoder.bw;
+    long bx0 = x / decoder.bw;
+    long by0 = y / decoder.bh;
+    long region_blocks_x = (x + rw + decoder.bw - 1) / decoder.bw - bx0;
+    long region_blocks_y = (y + rh + decoder.bh - 1) / decoder.bh - by0;
+    long row_bytes = region_blocks_x * decoder.block_bytes;
+
+    std::vector<uint8_t> blocks(region_blocks_y * row_bytes);
+    for (long by = 0; by < region_blocks_y; by++) {
+        memcpy(blocks.data() + by * row_bytes, src + ((by0 + by) * blocks_x + bx0) * decoder.block_bytes, row_bytes);
+    }
+    long region_w = region_blocks_x * decoder.bw;
+    long region_h = region_blocks_y * decoder.bh;
+    std::vector<uint8_t> image(region_w * region_h * pixel_bytes);
+    if (decodeBlocks(blocks.data(), region_w, region_h, jobs, output_format, image.data(), decoder) != 1) {
+        return 0;
+    }
+    const uint8_t *origin =
+      image.data() + ((y - by0 * decoder.bh) * region_w + (x - bx0 * decoder.bw)) * pixel_bytes;
+    for (long row = 0; row < rh; row++) {
+        memcpy(dst + row * rw * pixel_bytes, origin + row * region_w * pixel_bytes, rw * pixel_bytes);
+    }
+    return 1;
+}
+
+int DecompressRegion(int format, uint8_t *src, long w, long h, long x, long y, long rw, long rh, long block_width,
+                     long block_height, int jobs, int output_format, uint8_t **dst, size_t *filesize) {
+    BlockDecoder decoder;
+    if (!formatBlockDecoder(format, block_width, block_height, &decoder) || rw <= 0 || rh <= 0) {
+        return 0;
+    }
+    size_t size = (size_t) rw * rh * layout_bytes(output_format);
+    uint8_t *image = (uint8_t *) malloc(size);
+    if (image == nullptr || decodeRegion(src, w, h, x, y, rw, rh, jobs, output_format, image, decoder) != 1) {
+        free(image);
+        return 0;
+    }
+    *dst = image;
+    *filesize = size;
+    return 1;
+}
+
+int DecompressRegionInto(int format, uint8_t *src, long w, long h, long x, long y, long rw, long rh,
+                         long block_width, long block_height, int jobs, int output_format, uint8_t *dst) {
+    BlockDecoder decoder;
+    if (!formatBlockDecoder(format, block_width, block_height, &decoder)) {
+        return 0;
+    }
+    return decodeRegion(src, w, h, x, y, rw, rh, jobs, output_format, dst, decoder);
+}
+
+int TranscodeEtcToBc(uint8_t *src, long w, long h, int etc_format, int bc_format, int jobs, uint8_t **dst,
+                     size_t *filesize) {
+    void (*decodeBlock)(const uint8_t *, uint32_t *);
+    long etc_bytes = 8, bc_bytes = 16;
+    switch (etc_format) {
+    case TEXTURE2D_FORMAT_ETC1:
+        decodeBlock = decode_etc1_texels;
+        break;
+    case TEXTURE2D_FORMAT_ETC2_RGB:
+        decodeBlock = decode_etc2_texels;
+        break;
+    case TEXTURE2D_FORMAT_ETC2_RGBA1:
+        decodeBlock = decode_etc2a1_texels;
+        break;
+    case TEXTURE2D_FORMAT_ETC2_RGBA:
+        decodeBlock = decode_etc2a8_texels;
+        etc_bytes = 16;
+        break;
+    default:
+        return 0;
+    }
+    void (*encodeBlock)(const uint32_t *, uint8_t *);
+    switch (bc_format) {
+    case TEXTURE2D_FORMAT_BC1:
+        if (etc_format == TEXTURE2D_FORMAT_ETC2_RGBA1 || etc_format == TEXTURE2D_FORMAT_ETC2_RGBA) {
+            encodeBlock = [](const uint32_t *texels, uint8_t *out) { EncodeBc1Block(texels, true, out); };
+        } else {
+            encodeBlock = [](const uint32_t *texels, uint8_t *out) { EncodeBc1Block(texels, false, out); };
+        }
+        bc_bytes = 8;
+        break;
+    case TEXTURE2D_FORMAT_BC3:
+        encodeBlock = EncodeBc3Block;
+        break;
+    case TEXTURE2D_FORMAT_BC7:
+        encodeBlock = EncodeBc7Block;
+        break;
+    default:
+        return 0;
     }
-    lodepng_encode_file(out, reinterpret_cast<const unsigned char *>(image), w, h, LCT_RGBA, 8);
-    delete[] image;
+    if (w <= 0 || h <= 0) {
+        return 0;
+    }
+    long blocks_x = (w + 3) / 4;
+    long blocks_y = (h + 3) / 4;
+    size_t size = (size_t) blocks_x * blocks_y * bc_bytes;
+    uint8_t *out = (uint8_t *) malloc(size);
+    if (out == nullptr) {
+        return 0;
+    }
+    long stripes = std::min<long>(blocks_y, (long) std::max(jobs, 1) * 4);
+    ThreadPool::Shared().ParallelFor((size_t) stripes, (unsigned int) std::max(jobs, 1), [&](size_t i) {
+        long by0 = blocks_y * (long) i / stripes;
+        long by1 = blocks_y * ((long) i + 1) / stripes;
+        uint32_t texels[16];
+        for (long block = by0 * blocks_x; block < by1 * blocks_x; block++) {
+            decodeBlock(src + block * etc_bytes, texels);
+            encodeBlock(texels, out + block * bc_bytes);
+        }
+    });
+    *dst = out;
+    *filesize = size;
     return 1;
 }
 
+// TEXTURE2D_FORMAT_* decoding a glInternalFormat, -1 when none does
+int glInternalFormatDecoder(uint32_t glInternalFormat) {
+    using InternalFormat = Etc::KtxFileHeader::InternalFormat;
+    switch (glInternalFormat) {
+    case (uint32_t) InternalFormat::ETC1_RGB8:
+        return TEXTURE2D_FORMAT_ETC1;
+    case (uint32_t) InternalFormat::ETC2_RGB8:
+    case (uint32_t) InternalFormat::ETC2_SRGB8:
+        return TEXTURE2D_FORMAT_ETC2_RGB;
+    case (uint32_t) InternalFormat::ETC2_RGB8A1:
+    case (uint32_t) InternalFormat::ETC2_SRGB8_PUNCHTHROUGH_ALPHA1:
+        return TEXTURE2D_FORMAT_ETC2_RGBA1;
+    case (uint32_t) InternalFormat::ETC2_RGBA8:
+    case (uint32_t) InternalFormat::ETC2_RGBA8 + 1:     // SRGB8_ALPHA8_ETC2_EAC
+        return TEXTURE2D_FORMAT_ETC2_RGBA;
+    case (uint32_t) InternalFormat::ETC2_R11:
+        return TEXTURE2D_FORMAT_EAC_R11;
+    case (uint32_t) InternalFormat::ETC2_SIGNED_R11:
+        return TEXTURE2D_FORMAT_EAC_R11_SIGNED;
+    case (uint32_t) InternalFormat::ETC2_RG11:
+        return TEXTURE2D_FORMAT_EAC_RG11;
+    case (uint32_t) InternalFormat::ETC2_SIGNED_RG11:
+        return TEXTURE2D_FORMAT_EAC_RG11_SIGNED;
+    case GL_COMPRESSED_RGB_S3TC_DXT1:
+    case GL_COMPRESSED_RGBA_S3TC_DXT1:
+        return TEXTURE2D_FORMAT_BC1;
+    case GL_COMPRESSED_RGBA_S3TC_DXT5:
+        return TEXTURE2D_FORMAT_BC3;
+    case GL_COMPRESSED_RED_RGTC1:
+        return TEXTURE2D_FORMAT_BC4;
+    case GL_COMPRESSED_RG_RGTC2:
+        return TEXTURE2D_FORMAT_BC5;
+    case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+        return TEXTURE2D_FORMAT_BC6;
+    case GL_COMPRESSED_RGBA_BPTC_UNORM:
+    case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+        return TEXTURE2D_FORMAT_BC7;
+    default: {
+        uint32_t block_x, block_y;
+        return AstcFormatBlockSize(glInternalFormat, &block_x, &block_y) ? TEXTURE2D_FORMAT_ASTC : -1;
+    }
+    }
+}
+
+// Parses the container and checks the level holds every block of its format
+int parseContainer(const uint8_t *src, size_t size, int level, Texture2dContainerLevel *info, BlockDecoder *decoder) {
+    TextureContainerLevel container{};
+    if (level < 0 || !ParseTextureContainer(src, size, (uint32_t) level, &container)) {
+        return 0;
+    }
+    uint32_t block_x = 4, block_y = 4;
+    AstcFormatBlockSize(container.glInternalFormat, &block_x, &block_y);
+    int format = glInternalFormatDecoder(container.glInternalFormat);
+    if (format < 0 || !formatBlockDecoder(format, block_x, block_y, decoder)) {
+        return 0;
+    }
+    size_t blocks_x = (container.width + block_x - 1) / block_x;
+    size_t blocks_y = (container.height + block_y - 1) / block_y;
+    if (blocks_x * blocks_y > container.size / decoder->block_bytes) {
+        return 0;
+    }
+    info->format = format;
+    info->width = container.width;
+    info->height = container.height;
+    info->block_width = block_x;
+    info->block_height = block_y;
+    info->levels = (int) container.levels;
+    info->offset = container.data - src;
+    return 1;
+}
+
+int ParseContainer(const uint8_t *src, size_t size, int level, Texture2dContainerLevel *info) {
+    BlockDecoder decoder;
+    return parseContainer(src, size, level, info, &decoder);
+}
+
+int DecodeContainer(uint8_t *src, size_t size, int level, int jobs, int output_format, uint8_t **dst,
+                    size_t *filesize, long *width, long *height) {
+    Texture2dContainerLevel info;
+    BlockDecoder decoder;
+    if (!parseContainer(src, size, level, &info, &decoder)) {
+        return 0;
+    }
+    if (decode(src + info.offset, info.width, info.height, jobs, output_format, dst, filesize, decoder) != 1) {
+        return 0;
+    }
+    *width = info.width;
+    *height = info.height;
+    return 1;
+}
+
+int DecodeContainerInto(uint8_t *src, size_t size, int level, int jobs, int output_format, uint8_t *dst) {
+    Texture2dContainerLevel info;
+    BlockDecoder decoder;
+    if (!parseContainer(src, size, level, &info, &decoder)) {
+        return 0;
+    }
+    return decodeBlocks(src + info.offset, info.width, info.height, jobs, output_format, dst, decoder);
+}
+
+static int crunchFormat(int block_format) {
+    switch (block_format) {
+    case UNITY_CRUNCH_BC1:
+        return TEXTURE2D_FORMAT_BC1;
+    case UNITY_CRUNCH_BC3:
+        return TEXTURE2D_FORMAT_BC3;
+    case UNITY_CRUNCH_BC4:
+        return TEXTURE2D_FORMAT_BC4;
+    case UNITY_CRUNCH_BC5:
+        return TEXTURE2D_FORMAT_BC5;
+    case UNITY_CRUNCH_ETC1:
+        return TEXTURE2D_FORMAT_ETC1;
+    case UNITY_CRUNCH_ETC2:
+        return TEXTURE2D_FORMAT_ETC2_RGB;
+    case UNITY_CRUNCH_ETC2A:
+        return TEXTURE2D_FORMAT_ETC2_RGBA;
+    default:
+        return -1;
+    }
+}
+
+CrunchDecoder *CrunchDecoderCreate(const uint8_t *src, size_t size) {
+    auto *decoder = new CrunchDecoder();
+    if (!decoder->Open(src, size) || crunchFormat(decoder->info.block_format) < 0) {
+        delete decoder;
+        return nullptr;
+    }
+    return decoder;
+}
+
+void CrunchDecoderGetInfo(CrunchDecoder *decoder, Texture2dCrunchInfo *info) {
+    info->format = crunchFormat(decoder->info.block_format);
+    info->width = decoder->info.width;
+    info->height = decoder->info.height;
+    info->levels = (int) decoder->info.levels;
+    info->faces = (int) decoder->info.faces;
+}
+
+int CrunchDecoderLevelSize(CrunchDecoder *decoder, int level, long *width, long *height) {
+    if (level < 0 || (uint32_t) level >= decoder->info.levels) {
+        return 0;
+    }
+    *width = decoder->LevelWidth((uint32_t) level);
+    *height = decoder->LevelHeight((uint32_t) level);
+    return 1;
+}
+
+int CrunchDecoderDecodeInto(CrunchDecoder *decoder, int level, int face, int jobs, int output_format, uint8_t *dst) {
+    BlockDecoder block_decoder;
+    if (level < 0 || face < 0 || layout_bytes(output_format) == 0 ||
+        !formatBlockDecoder(crunchFormat(decoder->info.block_format), 4, 4, &block_decoder)) {
+        return 0;
+    }
+    // the unpacked blocks are shared by all faces of the level, decode them before another level replaces them
+    std::lock_guard<std::mutex> guard(decoder->lock);
+    const uint8_t *blocks = decoder->Unpack((uint32_t) level, (uint32_t) face);
+    if (blocks == nullptr) {
+        return 0;
+    }
+    return decodeBlocks(blocks, decoder->LevelWidth((uint32_t) level), decoder->LevelHeight((uint32_t) level), jobs,
+                        output_format, dst, block_decoder);
+}
+
+int CrunchDecoderDecode(CrunchDecoder *decoder, int level, int face, int jobs, int output_format, uint8_t **dst,
+                        size_t *filesize, long *width, long *height) {
+    long w, h;
+    if (!CrunchDecoderLevelSize(decoder, level, &w, &h) || layout_bytes(output_format) == 0) {
+        return 0;
+    }
+    size_t size = (size_t) w * h * layout_bytes(output_format);
+    uint8_t *image = (uint8_t *) malloc(size);
+    if (image == nullptr || CrunchDecoderDecodeInto(decoder, level, face, jobs, output_format, image) != 1) {
+        free(image);
+        return 0;
+    }
+    *dst = image;
+    *filesize = size;
+    *width = w;
+    *height = h;
+    return 1;
+}
+
+void CrunchDecoderFree(CrunchDecoder *decoder) {
+    delete decoder;
+}
@@ -8,6 +8,12 @@
 
 #include <cstdint>
 
+class AstcEncoder;
+
+class EtcEncoder;
+
+class CrunchDecoder;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -15,11 +21,51 @@ extern "C" {
 #define ETCCOMP_MIN_LEVEL (0.0f)
 #define ETCCOMP_DEFAULT_LEVEL (40.0f)
 #define ETCCOMP_MAX_LEVEL (100.0f)
+// Any fEffort below ETCCOMP_MIN_LEVEL skips etc2comp for the real-time encoder of EtcFastEncoder.h. On one
+// 2 GHz core it does ETC1 at ~80, ETC2 RGB at ~33 and RGBA at ~15 MPix/s (etc2comp effort 0: ~3.4, ~0.5
+// and ~0.3). PSNR stays within 0.5 dB of effort 40 on smooth images, but on hard edges ETC2 falls up to
+// ~7 dB behind, as it has no T and H modes.
+#define ETCCOMP_REALTIME_LEVEL (-1.0f)
 
 #define ASTCENC_MIN_LEVEL (0.0f)
 #define ASTCENC_DEFAULT_LEVEL (40.0f)
 #define ASTCENC_MAX_LEVEL (100.0f)
 
+#define TEXTURE2D_FORMAT_ETC1 (0)
+#define TEXTURE2D_FORMAT_ETC2_RGB (1)
+#define TEXTURE2D_FORMAT_ETC2_RGBA (2)
+#define TEXTURE2D_FORMAT_ASTC (3)
+// decode only
+#define TEXTURE2D_FORMAT_ETC2_RGBA1 (4)
+#define TEXTURE2D_FORMAT_BC1 (5)
+#define TEXTURE2D_FORMAT_BC3 (6)
+#define TEXTURE2D_FORMAT_BC4 (7)
+#define TEXTURE2D_FORMAT_BC5 (8)
+#define TEXTURE2D_FORMAT_BC6 (9)
+#define TEXTURE2D_FORMAT_BC7 (10)
+#define TEXTURE2D_FORMAT_EAC_R11 (11)
+#define TEXTURE2D_FORMAT_EAC_R11_SIGNED (12)
+#define TEXTURE2D_FORMAT_EAC_RG11 (13)
+#define TEXTURE2D_FORMAT_EAC_RG11_SIGNED (14)
+
+// Decoded pixel layouts, named by their byte order in memory
+#define TEXTURE2D_OUTPUT_BGRA (0)
+#define TEXTURE2D_OUTPUT_RGBA (1)
+#define TEXTURE2D_OUTPUT_RGB (2)
+#define TEXTURE2D_OUTPUT_R8 (3)
+#define TEXTURE2D_OUTPUT_RG8 (4)
+
+// Image encodings written by the ToFile and ToImageBytes decoders, always RGBA
+#define TEXTURE2D_IMAGE_PNG (0)
+#define TEXTURE2D_IMAGE_PNG_FAST (1)
+#define TEXTURE2D_IMAGE_QOI (2)
+#define TEXTURE2D_IMAGE_TGA (3)
+#define TEXTURE2D_IMAGE_RAW (4)
+
+// Texel types of the float decoders, RGBA in that order
+#define TEXTURE2D_FLOAT_RGBA16F (0)
+#define TEXTURE2D_FLOAT_RGBA32F (1)
+
 
 int
 CompressEtc1(uint8_t *src, size_t size, int mipmap, float fEffort, int jobs, int header, uint8_t **dst,
@@ -33,6 +79,19 @@ int
 CompressEtc2RGBA(uint8_t *src, size_t size, int mipmap, float fEffort, int jobs, int header, uint8_t **dst,
                  size_t *filesize);
 
+// Raw RGBA8 input, rows `stride` bytes apart (stride >= width * 4); skips the png decode
+int
+CompressEtc1Raw(const uint8_t *pixels, unsigned int width, unsigned int height, size_t stride, int mipmap,
+                float fEffort, int jobs, int header, uint8_t **dst, size_t *filesize);
+
+int
+CompressEtc2RGBRaw(const uint8_t *pixels, unsigned int width, unsigned int height, size_t stride, int mipmap,
+                   float fEffort, int jobs, int header, uint8_t **dst, size_t *filesize);
+
+int
+CompressEtc2RGBARaw(const uint8_t *pixels, unsigned int width, unsigned int height, size_t stride, int mipmap,
+                    float fEffort, int jobs, int header, uint8_t **dst, size_t *filesize);
+
 
 int CompressEtc1WithFile(const char *input, const char *output,
                          int mipmap, float fEffort, int jobs);
@@ -49,33 +108,302 @@ CompressAstc(uint8_t *src, size_t size, float fEffort, unsigned int block_x, uns
              int header,
              uint8_t **dst, size_t *filesize);
 
+int
+CompressAstcRaw(const uint8_t *pixels, unsigned int width, unsigned int height, size_t stride, float fEffort,
+                unsigned int block_x, unsigned int block_y, unsigned int block_z, int header,
+                uint8_t **dst, size_t *filesize);
+
 int
 CompressAstcWithFile(const char *input, const char *output, float fEffort, unsigned int block_x, unsigned int block_y,
                      unsigned int block_z);
 
 
-int DecompressEtc1(uint8_t *src, long w, long h, uint32_t **dst, size_t *filesize);
+// Long lived encoders for compressing many images with the same settings, create returns null on failure.
+// profile is an astcenc_profile, flags are ASTCENC_FLG_* bits.
+AstcEncoder *
+AstcEncoderCreate(int profile, float fEffort, unsigned int block_x, unsigned int block_y, unsigned int block_z,
+                  unsigned int flags, unsigned int threads);
+
+int AstcEncoderCompress(AstcEncoder *encoder, uint8_t *src, size_t size, int header, uint8_t **dst, size_t *filesize);
+
+int AstcEncoderCompressRaw(AstcEncoder *encoder, const uint8_t *pixels, unsigned int width, unsigned int height,
+                           size_t stride, int header, uint8_t **dst, size_t *filesize);
+
+void AstcEncoderFree(AstcEncoder *encoder);
+
+// format is one of TEXTURE2D_FORMAT_ETC*
+EtcEncoder *EtcEncoderCreate(int format, int mipmap, float fEffort, int jobs);
+
+int EtcEncoderCompress(EtcEncoder *encoder, uint8_t *src, size_t size, int header, uint8_t **dst, size_t *filesize);
+
+int EtcEncoderCompressRaw(EtcEncoder *encoder, const uint8_t *pixels, unsigned int width, unsigned int height,
+                          size_t stride, int header, uint8_t **dst, size_t *filesize);
+
+void EtcEncoderFree(EtcEncoder *encoder);
+
+
+typedef struct {
+    float fEffort;
+    int mipmap;                 // etc only
+    int jobs;                   // etc only, threads per image
+    unsigned int block_x;       // astc only
+    unsigned int block_y;
+    unsigned int block_z;
+    int header;
+} Texture2dCompressParams;
 
-int DecompressEtc2(uint8_t *src, long w, long h, uint32_t **dst, size_t *filesize);
+// One image of a batch. With width == 0, src/size hold an encoded png, otherwise src holds raw
+// RGBA8 pixels with rows stride bytes apart. dst/filesize/ok are filled in by CompressBatch.
+typedef struct {
+    const uint8_t *src;
+    size_t size;
+    unsigned int width;
+    unsigned int height;
+    size_t stride;
 
-int DecompressEtc2a1(uint8_t *src, long w, long h, uint32_t **dst, size_t *filesize);
+    uint8_t *dst;
+    size_t filesize;
+    int ok;
+} Texture2dBatchItem;
 
-int DecompressEtc2a8(uint8_t *src, long w, long h, uint32_t **dst, size_t *filesize);
+// Compresses every item over the shared worker pool, each worker keeping one warm encoder for all the
+// images it picks up. Returns 1 when every item succeeded; per item results are in item->ok.
+int CompressBatch(Texture2dBatchItem *items, size_t count, int format, const Texture2dCompressParams *params);
+
+// Queues one compression on the shared worker pool and returns at once. When a worker picks the job up
+// it calls start (if given), and a 0 return drops the job. done always runs on the worker afterwards;
+// it owns the malloc'd dst. image->src must stay valid until done runs. Blocks while the queue is full.
+int SubmitCompress(const Texture2dBatchItem *image, int format, const Texture2dCompressParams *params,
+                   int (*start)(void *userdata), void (*done)(void *userdata, int ok, uint8_t *dst, size_t filesize),
+                   void *userdata);
+
+// concurrency: jobs running at once, 0 for the pool size; max_pending: queued plus running jobs
+// before SubmitCompress blocks, 0 for unbounded
+void SetJobLimits(unsigned int concurrency, unsigned int max_pending);
+
+// Blocks until every submitted job has finished
+void WaitJobs(void);
+
+
+// jobs > 1 splits the image into stripes of block rows decoded on the shared worker pool.
+// output_format is one of TEXTURE2D_OUTPUT_*, dst holds w * h pixels of that layout.
+int DecompressEtc1(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t **dst, size_t *filesize);
+
+int DecompressEtc2(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t **dst, size_t *filesize);
+
+int DecompressEtc2a1(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t **dst, size_t *filesize);
+
+int DecompressEtc2a8(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t **dst, size_t *filesize);
 
 int
-DecompressAstc(uint8_t *src, long w, long h, long block_width, long block_height, uint32_t **dst, size_t *filesize);
+DecompressAstc(uint8_t *src, long w, long h, long block_width, long block_height, int jobs, int output_format,
+               uint8_t **dst, size_t *filesize);
+
+// BCn (DXT) block formats; BC6H is decoded unsigned and clamped to 8 bits
+int DecompressBc1(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t **dst, size_t *filesize);
+
+int DecompressBc3(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t **dst, size_t *filesize);
+
+int DecompressBc4(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t **dst, size_t *filesize);
+
+int DecompressBc5(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t **dst, size_t *filesize);
 
-int DecompressEtc1ToFile(uint8_t *src, long w, long h, const char *out);
+int DecompressBc6(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t **dst, size_t *filesize);
 
-int DecompressEtc2ToFile(uint8_t *src, long w, long h, const char *out);
+int DecompressBc7(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t **dst, size_t *filesize);
 
-int DecompressEtc2a1ToFile(uint8_t *src, long w, long h, const char *out);
+// EAC R11/RG11 single and two channel formats, decoded to 8 bits with blue 0 and alpha 255
+int DecompressEacR11(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t **dst, size_t *filesize);
 
-int DecompressEtc2a8ToFile(uint8_t *src, long w, long h, const char *out);
+int DecompressEacR11Signed(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t **dst, size_t *filesize);
+
+int DecompressEacRG11(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t **dst, size_t *filesize);
+
+int DecompressEacRG11Signed(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t **dst, size_t *filesize);
+
+// PVRTC1 4bpp or 2bpp (is2bpp) with a power of 2 number of blocks a side. Every pixel blends the
+// colours of neighbouring blocks, so the blocks are expanded once and jobs > 1 then splits the pixel rows.
+int DecompressPvrtc(uint8_t *src, long w, long h, int is2bpp, int jobs, int output_format, uint8_t **dst,
+                    size_t *filesize);
+
+// Decode into a caller-owned buffer of at least w * h * OutputFormatBytes(output_format) bytes
+int DecompressEtc1Into(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t *dst);
+
+int DecompressEtc2Into(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t *dst);
+
+int DecompressEtc2a1Into(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t *dst);
+
+int DecompressEtc2a8Into(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t *dst);
 
 int
-DecompressAstcToFile(uint8_t *src, long w, long h, long block_width, long block_height, const char *out);
+DecompressAstcInto(uint8_t *src, long w, long h, long block_width, long block_height, int jobs, int output_format,
+                   uint8_t *dst);
+
+int DecompressBc1Into(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t *dst);
+
+int DecompressBc3Into(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t *dst);
+
+int DecompressBc4Into(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t *dst);
+
+int DecompressBc5Into(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t *dst);
+
+int DecompressBc6Into(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t *dst);
+
+int DecompressBc7Into(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t *dst);
+
+int DecompressEacR11Into(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t *dst);
+
+int DecompressEacR11SignedInto(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t *dst);
+
+int DecompressEacRG11Into(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t *dst);
+
+int DecompressEacRG11SignedInto(uint8_t *src, long w, long h, int jobs, int output_format, uint8_t *dst);
+
+int DecompressPvrtcInto(uint8_t *src, long w, long h, int is2bpp, int jobs, int output_format, uint8_t *dst);
+
+// ASTC through astcenc's own decompressor at full precision: HDR blocks keep their range, LDR blocks
+// come out as 0..1. float_format is one of TEXTURE2D_FLOAT_*, dst holds w * h RGBA texels of it.
+int DecompressAstcFloat(uint8_t *src, long w, long h, long block_width, long block_height, int jobs,
+                        int float_format, uint8_t **dst, size_t *filesize);
+
+int DecompressAstcFloatInto(uint8_t *src, long w, long h, long block_width, long block_height, int jobs,
+                            int float_format, uint8_t *dst);
+
+// ToFile writes an image_format (TEXTURE2D_IMAGE_*) file, decoding and encoding a few block rows at a time.
+// 0 if either failed or the format is unknown.
+int DecompressEtc1ToFile(uint8_t *src, long w, long h, int jobs, int image_format, const char *out);
+
+int DecompressEtc2ToFile(uint8_t *src, long w, long h, int jobs, int image_format, const char *out);
+
+int DecompressEtc2a1ToFile(uint8_t *src, long w, long h, int jobs, int image_format, const char *out);
+
+int DecompressEtc2a8ToFile(uint8_t *src, long w, long h, int jobs, int image_format, const char *out);
+
+int DecompressAstcToFile(uint8_t *src, long w, long h, long block_width, long block_height, int jobs,
+                         int image_format, const char *out);
+
+int DecompressBc1ToFile(uint8_t *src, long w, long h, int jobs, int image_format, const char *out);
+
+int DecompressBc3ToFile(uint8_t *src, long w, long h, int jobs, int image_format, const char *out);
+
+int DecompressBc4ToFile(uint8_t *src, long w, long h, int jobs, int image_format, const char *out);
+
+int DecompressBc5ToFile(uint8_t *src, long w, long h, int jobs, int image_format, const char *out);
+
+int DecompressBc6ToFile(uint8_t *src, long w, long h, int jobs, int image_format, const char *out);
+
+int DecompressBc7ToFile(uint8_t *src, long w, long h, int jobs, int image_format, const char *out);
+
+// Same as ToFile, but returns the encoded image in dst
+int DecompressEtc1ToImageBytes(uint8_t *src, long w, long h, int jobs, int image_format, uint8_t **dst,
+                               size_t *filesize);
+
+int DecompressEtc2ToImageBytes(uint8_t *src, long w, long h, int jobs, int image_format, uint8_t **dst,
+                               size_t *filesize);
+
+int DecompressEtc2a1ToImageBytes(uint8_t *src, long w, long h, int jobs, int image_format, uint8_t **dst,
+                                 size_t *filesize);
+
+int DecompressEtc2a8ToImageBytes(uint8_t *src, long w, long h, int jobs, int image_format, uint8_t **dst,
+                                 size_t *filesize);
+
+int DecompressAstcToImageBytes(uint8_t *src, long w, long h, long block_width, long block_height, int jobs,
+                               int image_format, uint8_t **dst, size_t *filesize);
+
+int DecompressBc1ToImageBytes(uint8_t *src, long w, long h, int jobs, int image_format, uint8_t **dst,
+                              size_t *filesize);
+
+int DecompressBc3ToImageBytes(uint8_t *src, long w, long h, int jobs, int image_format, uint8_t **dst,
+                              size_t *filesize);
+
+int DecompressBc4ToImageBytes(uint8_t *src, long w, long h, int jobs, int image_format, uint8_t **dst,
+                              size_t *filesize);
+
+int DecompressBc5ToImageBytes(uint8_t *src, long w, long h, int jobs, int image_format, uint8_t **dst,
+                              size_t *filesize);
+
+int DecompressBc6ToImageBytes(uint8_t *src, long w, long h, int jobs, int image_format, uint8_t **dst,
+                              size_t *filesize);
+
+int DecompressBc7ToImageBytes(uint8_t *src, long w, long h, int jobs, int image_format, uint8_t **dst,
+                              size_t *filesize);
+
+// Decodes the rw * rh rectangle at (x, y) of a w * h image, touching only the blocks that cover it.
+// format is one of TEXTURE2D_FORMAT_*, block_width/block_height are only read for astc. dst holds
+// rw * rh pixels.
+int DecompressRegion(int format, uint8_t *src, long w, long h, long x, long y, long rw, long rh, long block_width,
+                     long block_height, int jobs, int output_format, uint8_t **dst, size_t *filesize);
+
+int DecompressRegionInto(int format, uint8_t *src, long w, long h, long x, long y, long rw, long rh,
+                         long block_width, long block_height, int jobs, int output_format, uint8_t *dst);
+
+// Rewrites ETC blocks as BCn blocks, one block at a time without a full image decode and compression
+// pass: each decoded block gets its endpoints fitted directly. etc_format is TEXTURE2D_FORMAT_ETC1,
+// ETC2_RGB, ETC2_RGBA1 or ETC2_RGBA; bc_format TEXTURE2D_FORMAT_BC1 (punch-through alpha from ETC2_RGBA1
+// and ETC2_RGBA below 128), BC3 or BC7. dst holds the blocks of the w * h image, row by row.
+int TranscodeEtcToBc(uint8_t *src, long w, long h, int etc_format, int bc_format, int jobs, uint8_t **dst,
+                     size_t *filesize);
+
+// Bytes per pixel of a TEXTURE2D_OUTPUT_* layout, 0 for an unknown one
+int OutputFormatBytes(int output_format);
+
+// Bytes per texel of a TEXTURE2D_FLOAT_* type, 0 for an unknown one
+int FloatFormatBytes(int float_format);
+
+// Bytes of blocks a w * h image of a TEXTURE2D_FORMAT_* holds, 0 for an unknown format or astc footprint.
+// block_width/block_height are only read for astc.
+size_t BlockImageBytes(int format, long w, long h, long block_width, long block_height);
+
+// Same for pvrtc: 8 byte blocks of 4x4 texels, 8x4 for 2bpp
+size_t PvrtcImageBytes(long w, long h, int is2bpp);
+
+// Mip `level` of a KTX 1, .astc or PKM file. format is a TEXTURE2D_FORMAT_* picked from the header's
+// glInternalFormat (or its .astc/PKM equivalent), block_width/block_height are the block footprint.
+typedef struct {
+    int format;
+    long width;
+    long height;
+    long block_width;
+    long block_height;
+    int levels;
+    size_t offset;              // of the level's blocks in the file
+} Texture2dContainerLevel;
+
+// Returns 0 for an unknown, unsupported or truncated file, or a level it does not hold
+int ParseContainer(const uint8_t *src, size_t size, int level, Texture2dContainerLevel *info);
+
+// Decodes a level in place from the file into width * height pixels of output_format
+int DecodeContainer(uint8_t *src, size_t size, int level, int jobs, int output_format, uint8_t **dst,
+                    size_t *filesize, long *width, long *height);
+
+int DecodeContainerInto(uint8_t *src, size_t size, int level, int jobs, int output_format, uint8_t *dst);
+
+// A Unity crunch (.crn) file opened once for decoding any of its levels and faces. The crunch tables
+// are set up on create and a level is unpacked once for all its faces. format is the
+// TEXTURE2D_FORMAT_* the blocks unpack to.
+typedef struct {
+    int format;
+    long width;
+    long height;
+    int levels;
+    int faces;
+} Texture2dCrunchInfo;
+
+// Copies src, null if it is not a crunch file or unpacks to a format we cannot decode
+CrunchDecoder *CrunchDecoderCreate(const uint8_t *src, size_t size);
+
+void CrunchDecoderGetInfo(CrunchDecoder *decoder, Texture2dCrunchInfo *info);
+
+// Size of mip `level`, 0 if there is no such level
+int CrunchDecoderLevelSize(CrunchDecoder *decoder, int level, long *width, long *height);
+
+// dst holds the level's width * height pixels of output_format
+int CrunchDecoderDecode(CrunchDecoder *decoder, int level, int face, int jobs, int output_format, uint8_t **dst,
+                        size_t *filesize, long *width, long *height);
+
+int CrunchDecoderDecodeInto(CrunchDecoder *decoder, int level, int face, int jobs, int output_format, uint8_t *dst);
 
+void CrunchDecoderFree(CrunchDecoder *decoder);
 
 #ifdef __cplusplus
 }
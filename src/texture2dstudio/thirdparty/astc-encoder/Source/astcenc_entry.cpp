@@ -21,6 +21,7 @@
 
 #include <array>
 #include <cstring>
+#include <mutex>
 #include <new>
 
 #include "astcenc.h"
@@ -816,10 +817,15 @@ astcenc_error astcenc_context_alloc(
 
 	*context = ctx;
 
+	// The angular and quant mode tables are process-wide and identical for every context, so build
+	// them exactly once; rebuilding them here would race with other threads' in-flight codecs
+	static std::once_flag tables_once;
+	std::call_once(tables_once, []() {
 #if !defined(ASTCENC_DECOMPRESS_ONLY)
-	prepare_angular_tables();
+		prepare_angular_tables();
 #endif
-	init_quant_mode_table();
+		init_quant_mode_table();
+	});
 
 	return ASTCENC_SUCCESS;
 }
@@ -25,11 +25,11 @@
 // built-in config, if not being set explicitly by the build system
 #include "astcenc_internal.h"
 
+#include <mutex>
+
 #if (ASTCENC_SSE > 0)    || (ASTCENC_AVX > 0) || \
     (ASTCENC_POPCNT > 0) || (ASTCENC_F16C > 0)
 
-static bool g_init { false };
-
 /** Does this CPU support SSE 4.1? Set to -1 if not yet initialized. */
 static bool g_cpu_has_sse41 { false };
 
@@ -77,10 +77,6 @@ static void detect_cpu_isa()
 		// AVX2 = Bank 7, EBX, bit 5
 		g_cpu_has_avx2 = data[1] & (1 << 5) ? true : false;
 	}
-
-	// Ensure state bits are updated before init flag is updated
-	MemoryBarrier();
-	g_init = true;
 }
 
 /* ============================================================================
@@ -112,20 +108,22 @@ static void detect_cpu_isa()
 		// AVX2 = Bank 7, EBX, bit 5
 		g_cpu_has_avx2 = data[1] & (1 << 5) ? true : false;
 	}
-
-	// Ensure state bits are updated before init flag is updated
-	__sync_synchronize();
-	g_init = true;
 }
 #endif
 
+/**
+ * @brief Run the ISA detection exactly once, even if several threads race to query it.
+ */
+static void init_cpu_isa()
+{
+	static std::once_flag isa_once;
+	std::call_once(isa_once, detect_cpu_isa);
+}
+
 /* See header for documentation. */
 bool cpu_supports_popcnt()
 {
-	if (!g_init)
-	{
-		detect_cpu_isa();
-	}
+	init_cpu_isa();
 
 	return g_cpu_has_popcnt;
 }
@@ -133,10 +131,7 @@ bool cpu_supports_popcnt()
 /* See header for documentation. */
 bool cpu_supports_f16c()
 {
-	if (!g_init)
-	{
-		detect_cpu_isa();
-	}
+	init_cpu_isa();
 
 	return g_cpu_has_f16c;
 }
@@ -144,10 +139,7 @@ bool cpu_supports_f16c()
 /* See header for documentation. */
 bool cpu_supports_sse41()
 {
-	if (!g_init)
-	{
-		detect_cpu_isa();
-	}
+	init_cpu_isa();
 
 	return g_cpu_has_sse41;
 }
@@ -155,10 +147,7 @@ bool cpu_supports_sse41()
 /* See header for documentation. */
 bool cpu_supports_avx2()
 {
-	if (!g_init)
-	{
-		detect_cpu_isa();
-	}
+	init_cpu_isa();
 
 	return g_cpu_has_avx2;
 }
@@ -39,9 +39,55 @@ namespace Etc
 				unsigned int *a_puiExtendedHeight, 
 				int *a_piEncodingTime_ms, bool a_bVerboseOutput)
 	{
+		Encode(a_pafSourceRGBA, Image::SourceFormat::RGBA32F, a_uiSourceWidth * sizeof(ColorFloatRGBA),
+				a_uiSourceWidth, a_uiSourceHeight,
+				a_format, a_eErrMetric, a_fEffort, a_uiJobs, a_uiMaxJobs,
+				a_ppaucEncodingBits, a_puiEncodingBitsBytes, a_puiExtendedWidth, a_puiExtendedHeight,
+				a_piEncodingTime_ms, a_bVerboseOutput);
+	}
+
+	void EncodeMipmaps(float *a_pafSourceRGBA,
+		unsigned int a_uiSourceWidth,
+		unsigned int a_uiSourceHeight,
+		Image::Format a_format,
+		ErrorMetric a_eErrMetric,
+		float a_fEffort,
+		unsigned int a_uiJobs,
+		unsigned int a_uiMaxJobs,
+		unsigned int a_uiMaxMipmaps,
+		unsigned int a_uiMipFilterFlags,
+		RawImage* a_pMipmapImages,
+		int *a_piEncodingTime_ms, 
+		bool a_bVerboseOutput)
+	{
+		EncodeMipmaps(a_pafSourceRGBA, Image::SourceFormat::RGBA32F, a_uiSourceWidth * sizeof(ColorFloatRGBA),
+						a_uiSourceWidth, a_uiSourceHeight,
+						a_format, a_eErrMetric, a_fEffort, a_uiJobs, a_uiMaxJobs,
+						a_uiMaxMipmaps, a_uiMipFilterFlags, a_pMipmapImages,
+						a_piEncodingTime_ms, a_bVerboseOutput);
+	}
 
-		Image image(a_pafSourceRGBA, a_uiSourceWidth,
-					a_uiSourceHeight,
+	// ----------------------------------------------------------------------------------------------------
+	//
+	void Encode(const void *a_pvSource,
+				Image::SourceFormat a_sourceformat,
+				unsigned int a_uiSourceStride,
+				unsigned int a_uiSourceWidth,
+				unsigned int a_uiSourceHeight,
+				Image::Format a_format,
+				ErrorMetric a_eErrMetric,
+				float a_fEffort,
+				unsigned int a_uiJobs,
+				unsigned int a_uiMaxJobs,
+				unsigned char **a_ppaucEncodingBits,
+				unsigned int *a_puiEncodingBitsBytes,
+				unsigned int *a_puiExtendedWidth,
+				unsigned int *a_puiExtendedHeight,
+				int *a_piEncodingTime_ms, bool a_bVerboseOutput)
+	{
+
+		Image image(a_pvSource, a_sourceformat, a_uiSourceStride,
+					a_uiSourceWidth, a_uiSourceHeight,
 					a_eErrMetric);
 		image.m_bVerboseOutput = a_bVerboseOutput;
 		image.Encode(a_format, a_eErrMetric, a_fEffort, a_uiJobs, a_uiMaxJobs);
@@ -53,7 +99,9 @@ namespace Etc
 		*a_piEncodingTime_ms = image.GetEncodingTimeMs();
 	}
 
-	void EncodeMipmaps(float *a_pafSourceRGBA,
+	void EncodeMipmaps(const void *a_pvSource,
+		Image::SourceFormat a_sourceformat,
+		unsigned int a_uiSourceStride,
 		unsigned int a_uiSourceWidth,
 		unsigned int a_uiSourceHeight,
 		Image::Format a_format,
@@ -64,35 +112,30 @@ namespace Etc
 		unsigned int a_uiMaxMipmaps,
 		unsigned int a_uiMipFilterFlags,
 		RawImage* a_pMipmapImages,
-		int *a_piEncodingTime_ms, 
+		int *a_piEncodingTime_ms,
 		bool a_bVerboseOutput)
 	{
-		auto mipWidth = a_uiSourceWidth;
-		auto mipHeight = a_uiSourceHeight;
-		int totalEncodingTime = 0;
-		for(unsigned int mip = 0; mip < a_uiMaxMipmaps && mipWidth >= 1 && mipHeight >= 1; mip++)
+		const unsigned char *paucSource = (const unsigned char *)a_pvSource;
+		// one source row as floats for the mipmap filter
+		ColorFloatRGBA *pafrgbaSourceRow = nullptr;
+		if (a_sourceformat != Image::SourceFormat::RGBA32F && a_uiMaxMipmaps > 1)
 		{
-			float* pImageData = nullptr;
-			float* pMipImage = nullptr;
-
-			if(mip == 0)
-			{
-				pImageData = a_pafSourceRGBA;
-			}
-			else
+			pafrgbaSourceRow = new ColorFloatRGBA[a_uiSourceWidth];
+		}
+		auto getSourceRow = [&](int iRow) -> const float *
+		{
+			const unsigned char *paucRow = paucSource + (size_t)iRow * a_uiSourceStride;
+			if (pafrgbaSourceRow == nullptr)
 			{
-				pMipImage = new float[mipWidth*mipHeight*4];
-				if(FilterTwoPass(a_pafSourceRGBA, a_uiSourceWidth, a_uiSourceHeight, pMipImage, mipWidth, mipHeight, a_uiMipFilterFlags, Etc::FilterLanczos3) )
-				{
-					pImageData = pMipImage;
-				}
+				return (const float *)paucRow;
 			}
+			Image::ConvertSourceRow(paucRow, a_sourceformat, a_uiSourceWidth, pafrgbaSourceRow);
+			return (const float *)pafrgbaSourceRow;
+		};
 
-			if ( pImageData )
-			{
-			
-				Image image(pImageData, mipWidth, mipHeight,	a_eErrMetric);
-
+		int totalEncodingTime = 0;
+		auto encodeMip = [&](Image &image, unsigned int mip)
+		{
 			image.m_bVerboseOutput = a_bVerboseOutput;
 			image.Encode(a_format, a_eErrMetric, a_fEffort, a_uiJobs, a_uiMaxJobs);
 
@@ -102,22 +145,41 @@ namespace Etc
 			a_pMipmapImages[mip].uiExtendedHeight = image.GetExtendedHeight();
 
 			totalEncodingTime += image.GetEncodingTimeMs();
-			}
+		};
 
-			if(pMipImage)
+		auto mipWidth = a_uiSourceWidth;
+		auto mipHeight = a_uiSourceHeight;
+		for(unsigned int mip = 0; mip < a_uiMaxMipmaps && mipWidth >= 1 && mipHeight >= 1; mip++)
+		{
+			if(mip == 0)
 			{
-				delete[] pMipImage;
+				Image image(a_pvSource, a_sourceformat, a_uiSourceStride, mipWidth, mipHeight, a_eErrMetric);
+				encodeMip(image, mip);
 			}
-
-			if (!pImageData)
+			else
 			{
-				break;
+				float* pMipImage = new float[mipWidth*mipHeight*4];
+				bool boolFiltered = FilterTwoPassRows(getSourceRow, a_uiSourceWidth, a_uiSourceHeight, pMipImage, mipWidth, mipHeight, a_uiMipFilterFlags, Etc::FilterLanczos3) != 0;
+				if (boolFiltered)
+				{
+					Image image(pMipImage, mipWidth, mipHeight, a_eErrMetric);
+					encodeMip(image, mip);
+				}
+
+				delete[] pMipImage;
+
+				if (!boolFiltered)
+				{
+					break;
+				}
 			}
 
 			mipWidth >>= 1;
 			mipHeight >>= 1;
 		}
 
+		delete[] pafrgbaSourceRow;
+
 		*a_piEncodingTime_ms = totalEncodingTime;
 	}
 
@@ -68,4 +68,37 @@ namespace Etc
 		RawImage* a_pMipmaps,
 		int *a_piEncodingTime_ms, bool a_bVerboseOutput = false);
 
+	// same as above, from a source image in a_sourceformat with a_uiSourceStride bytes between rows
+	// the source is converted to floats a block (or a filtered row) at a time, never as a whole
+	void Encode(const void *a_pvSource,
+				Image::SourceFormat a_sourceformat,
+				unsigned int a_uiSourceStride,
+				unsigned int a_uiSourceWidth,
+				unsigned int a_uiSourceHeight,
+				Image::Format a_format,
+				ErrorMetric a_eErrMetric,
+				float a_fEffort,
+				unsigned int a_uiJobs,
+				unsigned int a_uimaxJobs,
+				unsigned char **a_ppaucEncodingBits,
+				unsigned int *a_puiEncodingBitsBytes,
+				unsigned int *a_puiExtendedWidth,
+				unsigned int *a_puiExtendedHeight,
+				int *a_piEncodingTime_ms, bool a_bVerboseOutput = false);
+
+	void EncodeMipmaps(const void *a_pvSource,
+		Image::SourceFormat a_sourceformat,
+		unsigned int a_uiSourceStride,
+		unsigned int a_uiSourceWidth,
+		unsigned int a_uiSourceHeight,
+		Image::Format a_format,
+		ErrorMetric a_eErrMetric,
+		float a_fEffort,
+		unsigned int a_uiJobs,
+		unsigned int a_uiMaxJobs,
+		unsigned int a_uiMaxMipmaps,
+		unsigned int a_uiMipFilterFlags,
+		RawImage* a_pMipmaps,
+		int *a_piEncodingTime_ms, bool a_bVerboseOutput = false);
+
 }
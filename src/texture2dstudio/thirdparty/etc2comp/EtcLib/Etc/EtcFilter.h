@@ -135,9 +135,13 @@ void FilterResample(T *pSrcImage, int srcWidth, int srcHeight, T *pDstImage, int
 //** Description: Filters a 2d image with a two pass filter by averaging the
 //**    weighted contributions of the pixels within the filter region.  The
 //**    contributions are determined by a weighting function parameter.
+//**    FilterTwoPassRows takes the source image a row at a time: getSrcRow(iRow)
+//**    returns the srcWidth pixels of row iRow, which only need to stay valid
+//**    until the next call, so a source in another pixel format can be
+//**    converted a row at a time instead of as a whole.
 //**-------------------------------------------------------------------------
-template <typename T>
-int FilterTwoPass(T *pSrcImage, int srcWidth, int srcHeight,
+template <typename T, typename GetSrcRow>
+int FilterTwoPassRows(GetSrcRow getSrcRow, int srcWidth, int srcHeight,
 	T *pDestImage, int destWidth, int destHeight, unsigned int wrapFlags, double(*FilterProc)(double))
 {
 	const int numComponents = 4;
@@ -169,6 +173,8 @@ int FilterTwoPass(T *pSrcImage, int srcWidth, int srcHeight,
 	CalcContributions(srcWidth, destWidth, filterSize, bWrapHorizontal, FilterProc, contrib);
 	for (int iRow = 0; iRow < srcHeight; iRow++)
 	{
+		const T *pSrcRow = getSrcRow(iRow);
+
 		for (int iCol = 0; iCol < destWidth; iCol++)
 		{
 			dRed = 0;
@@ -183,7 +189,7 @@ int FilterTwoPass(T *pSrcImage, int srcWidth, int srcHeight,
 				{
 					iSrcCol = (iSrcCol < 0)?(srcWidth+iSrcCol):(iSrcCol >= srcWidth)?(iSrcCol-srcWidth):iSrcCol;
 				}
-				T* pSrcPixel = pSrcImage + ((iRow * srcWidth) + iSrcCol)*numComponents;
+				const T* pSrcPixel = pSrcRow + iSrcCol*numComponents;
 				dRed += contrib[iCol].weight[iWeight] * pSrcPixel[0];
 				dGreen += contrib[iCol].weight[iWeight] * pSrcPixel[1];
 				dBlue += contrib[iCol].weight[iWeight] * pSrcPixel[2];
@@ -240,5 +246,13 @@ int FilterTwoPass(T *pSrcImage, int srcWidth, int srcHeight,
 	return 1;
 }
 
+template <typename T>
+int FilterTwoPass(T *pSrcImage, int srcWidth, int srcHeight,
+	T *pDestImage, int destWidth, int destHeight, unsigned int wrapFlags, double(*FilterProc)(double))
+{
+	return FilterTwoPassRows([=](int iRow) { return pSrcImage + iRow * srcWidth * 4; },
+							srcWidth, srcHeight, pDestImage, destWidth, destHeight, wrapFlags, FilterProc);
+}
+
 
 }
\ No newline at end of file
@@ -29,13 +29,14 @@ Image is an array of 4x4 blocks that represent the encoding of the source image
 #include "EtcBlock4x4.h"
 #include "EtcBlock4x4EncodingBits.h"
 #include "EtcSortedBlockList.h"
+#include "ThreadPool.h"
 
 #if ETC_WINDOWS
 #include <windows.h>
 #endif
 #include <ctime>
+#include <atomic>
 #include <chrono>
-#include <future>
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
@@ -50,6 +51,10 @@ Image is an array of 4x4 blocks that represent the encoding of the source image
 
 namespace Etc
 {
+	// blocks handed to a pool thread at a time in the per-block passes
+	static const size_t BLOCK_RANGE_GRAIN = 32;
+	// worst blocks taken at a time in the effort passes, they are the slowest ones to iterate
+	static const unsigned int WORST_BLOCKS_GRAIN = 8;
 
 	// ----------------------------------------------------------------------------------------------------
 	//
@@ -57,7 +62,9 @@ namespace Etc
 	{
 		m_encodingStatus = EncodingStatus::SUCCESS;
 		m_warningsToCapture = EncodingStatus::SUCCESS;
-		m_pafrgbaSource = nullptr;
+		m_paucSource = nullptr;
+		m_sourceformat = SourceFormat::RGBA32F;
+		m_uiSourceStride = 0;
 
 		m_pablock = nullptr;
 
@@ -78,10 +85,34 @@ namespace Etc
 	Image::Image(float *a_pafSourceRGBA, unsigned int a_uiSourceWidth,
 					unsigned int a_uiSourceHeight, 
 					ErrorMetric a_errormetric)
+	{
+		InitSource(a_pafSourceRGBA, SourceFormat::RGBA32F, a_uiSourceWidth * sizeof(ColorFloatRGBA),
+					a_uiSourceWidth, a_uiSourceHeight, a_errormetric);
+	}
+
+	// ----------------------------------------------------------------------------------------------------
+	// constructor using an 8 or 16 bit source image
+	// used to set state before Encode() is called
+	//
+	Image::Image(const void *a_pvSource, SourceFormat a_sourceformat, unsigned int a_uiSourceStride,
+					unsigned int a_uiSourceWidth, unsigned int a_uiSourceHeight,
+					ErrorMetric a_errormetric)
+	{
+		InitSource(a_pvSource, a_sourceformat, a_uiSourceStride, a_uiSourceWidth, a_uiSourceHeight,
+					a_errormetric);
+	}
+
+	// ----------------------------------------------------------------------------------------------------
+	//
+	void Image::InitSource(const void *a_pvSource, SourceFormat a_sourceformat, unsigned int a_uiSourceStride,
+							unsigned int a_uiSourceWidth, unsigned int a_uiSourceHeight,
+							ErrorMetric a_errormetric)
 	{
 		m_encodingStatus = EncodingStatus::SUCCESS;
 		m_warningsToCapture = EncodingStatus::SUCCESS;
-		m_pafrgbaSource = (ColorFloatRGBA *) a_pafSourceRGBA;
+		m_paucSource = (const unsigned char *) a_pvSource;
+		m_sourceformat = a_sourceformat;
+		m_uiSourceStride = a_uiSourceStride;
 		m_uiSourceWidth = a_uiSourceWidth;
 		m_uiSourceHeight = a_uiSourceHeight;
 
@@ -122,7 +153,9 @@ namespace Etc
 					Image *a_pimageSource, ErrorMetric a_errormetric)
 	{
 		m_encodingStatus = EncodingStatus::SUCCESS;
-		m_pafrgbaSource = nullptr;
+		m_paucSource = nullptr;
+		m_sourceformat = SourceFormat::RGBA32F;
+		m_uiSourceStride = 0;
 		m_uiSourceWidth = a_uiSourceWidth;
 		m_uiSourceHeight = a_uiSourceHeight;
 
@@ -177,6 +210,30 @@ namespace Etc
 
 	}
 
+	// ----------------------------------------------------------------------------------------------------
+	//
+	void Image::ConvertSourceRow(const void *a_pvRow, SourceFormat a_sourceformat, unsigned int a_uiPixels,
+									ColorFloatRGBA *a_pafrgbaRow)
+	{
+		for (unsigned int uiPixel = 0; uiPixel < a_uiPixels; uiPixel++)
+		{
+			switch (a_sourceformat)
+			{
+			case SourceFormat::RGBA8:
+				a_pafrgbaRow[uiPixel] = ConvertSourcePixel((const unsigned char *)a_pvRow + 4 * uiPixel);
+				break;
+
+			case SourceFormat::RGBA16:
+				a_pafrgbaRow[uiPixel] = ConvertSourcePixel((const unsigned short *)a_pvRow + 4 * uiPixel);
+				break;
+
+			default:
+				a_pafrgbaRow[uiPixel] = ((const ColorFloatRGBA *)a_pvRow)[uiPixel];
+				break;
+			}
+		}
+	}
+
 	// ----------------------------------------------------------------------------------------------------
 	//
 	Image::~Image(void)
@@ -199,7 +256,7 @@ namespace Etc
 	// create a set of encoding bits that conforms to a_format
 	// find best fit using a_errormetric
 	// explore a range of possible encodings based on a_fEffort (range = [0:100])
-	// speed up process using a_uiJobs as the number of process threads (a_uiJobs must not excede a_uiMaxJobs)
+	// speed up process using up to a_uiJobs cores of the shared thread pool (a_uiJobs must not excede a_uiMaxJobs)
 	//
 	Image::EncodingStatus Image::Encode(Format a_format, ErrorMetric a_errormetric, float a_fEffort, unsigned int a_uiJobs, unsigned int a_uiMaxJobs)
 	{
@@ -254,24 +311,16 @@ namespace Etc
 		InitBlocksAndBlockSorter();
 
 
-		std::future<void> *handle = new std::future<void>[a_uiMaxJobs];
-
-		unsigned int uiNumThreadsNeeded = 0;
+		// a_uiJobs is the number of cores to use, the passes run on the shared pool and hand out
+		// ranges of neighbouring blocks
+		ThreadPool &pool = ThreadPool::Shared();
 		unsigned int uiUnfinishedBlocks = GetNumberOfBlocks();
 
-		uiNumThreadsNeeded = (uiUnfinishedBlocks < a_uiJobs) ? uiUnfinishedBlocks : a_uiJobs;
-			
-		for (int i = 0; i < (int)uiNumThreadsNeeded - 1; i++)
-		{
-			handle[i] = async(std::launch::async, &Image::RunFirstPass, this, i, uiNumThreadsNeeded);
-		}
-
-		RunFirstPass(uiNumThreadsNeeded - 1, uiNumThreadsNeeded);
-
-		for (int i = 0; i < (int)uiNumThreadsNeeded - 1; i++)
-		{
-			handle[i].get();
-		}
+		pool.ParallelForRanges(GetNumberOfBlocks(), BLOCK_RANGE_GRAIN, a_uiJobs,
+			[this](size_t a_uiBegin, size_t a_uiEnd)
+			{
+				RunFirstPass((unsigned int)a_uiBegin, (unsigned int)a_uiEnd);
+			});
 
 		// perform effort-based encoding
 		if (m_fEffort > ETCCOMP_MIN_EFFORT_LEVEL)
@@ -312,34 +361,17 @@ namespace Etc
 					break;
 				}
 
-				unsigned int uiIteratedBlocks = 0;
 				unsigned int blocksToIterateThisPass = (uiTotalEffortBlocks - uiFinishedBlocks);
-				uiNumThreadsNeeded = (uiUnfinishedBlocks < a_uiJobs) ? uiUnfinishedBlocks : a_uiJobs;
-
-				if (uiNumThreadsNeeded <= 1)
-				{
-					//since we already how many blocks each thread will process
-					//cap the thread limit to do the proper amount of work, and not more
-					uiIteratedBlocks = IterateThroughWorstBlocks(blocksToIterateThisPass, 0, 1);
-				}
-				else
-				{
-					//we have a lot of work to do, so lets multi thread it
-					std::future<unsigned int> *handleToBlockEncoders = new std::future<unsigned int>[uiNumThreadsNeeded-1];
-
-					for (int i = 0; i < (int)uiNumThreadsNeeded - 1; i++)
-					{
-						handleToBlockEncoders[i] = async(std::launch::async, &Image::IterateThroughWorstBlocks, this, blocksToIterateThisPass, i, uiNumThreadsNeeded);
-					}
-					uiIteratedBlocks = IterateThroughWorstBlocks(blocksToIterateThisPass, uiNumThreadsNeeded - 1, uiNumThreadsNeeded);
+				m_psortedblocklist->StartTaking(blocksToIterateThisPass);
 
-					for (int i = 0; i < (int)uiNumThreadsNeeded - 1; i++)
+				// every thread takes chunks of the worst blocks until the pass is used up
+				std::atomic<unsigned int> uiIterated(0);
+				pool.ParallelFor(a_uiJobs, a_uiJobs,
+					[&](size_t)
 					{
-						uiIteratedBlocks += handleToBlockEncoders[i].get();
-					}
-
-					delete[] handleToBlockEncoders;
-				}
+						uiIterated += IterateThroughWorstBlocks();
+					});
+				unsigned int uiIteratedBlocks = uiIterated;
 
 				if (m_bVerboseOutput)
 				{
@@ -349,51 +381,39 @@ namespace Etc
 		}
 
 		// generate Etc2-compatible bit-format 4x4 blocks
-		for (int i = 0; i < (int)a_uiJobs - 1; i++)
-		{
-			handle[i] = async(std::launch::async, &Image::SetEncodingBits, this, i, a_uiJobs);
-		}
-		SetEncodingBits(a_uiJobs - 1, a_uiJobs);
-
-		for (int i = 0; i < (int)a_uiJobs - 1; i++)
-		{
-			handle[i].get();
-		}
+		pool.ParallelForRanges(GetNumberOfBlocks(), BLOCK_RANGE_GRAIN, a_uiJobs,
+			[this](size_t a_uiBegin, size_t a_uiEnd)
+			{
+				SetEncodingBits((unsigned int)a_uiBegin, (unsigned int)a_uiEnd);
+			});
 
 		auto end = std::chrono::steady_clock::now();
 		std::chrono::milliseconds elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
 		m_iEncodeTime_ms = (int)elapsed.count();
 
-		delete[] handle;
 		delete m_psortedblocklist;
 		return m_encodingStatus;
 	}
 
 	// ----------------------------------------------------------------------------------------------------
 	// iterate the encoding thru the blocks with the worst error
-	// stop when a_uiMaxBlocks blocks have been iterated
-	// split the blocks between the process threads using a_uiMultithreadingOffset and a_uiMultithreadingStride
+	// take chunks of the sorted blocks until the ones set up with StartTaking are all taken
+	// return the number of blocks this call iterated
 	//
-	unsigned int Image::IterateThroughWorstBlocks(unsigned int a_uiMaxBlocks, 
-													unsigned int a_uiMultithreadingOffset, 
-													unsigned int a_uiMultithreadingStride)
+	unsigned int Image::IterateThroughWorstBlocks(void)
 	{
-		assert(a_uiMultithreadingStride > 0);
-		unsigned int uiIteratedBlocks = a_uiMultithreadingOffset;
+		unsigned int uiIteratedBlocks = 0;
 
-		SortedBlockList::Link *plink = m_psortedblocklist->GetLinkToFirstBlock();
-		for (plink = plink->Advance(a_uiMultithreadingOffset);
-				plink != nullptr;
-				plink = plink->Advance(a_uiMultithreadingStride) )
+		unsigned int uiBlocks;
+		Block4x4 * const *papblock;
+		while ((papblock = m_psortedblocklist->TakeBlocks(WORST_BLOCKS_GRAIN, &uiBlocks)) != nullptr)
 		{
-			if (uiIteratedBlocks >= a_uiMaxBlocks)
+			for (unsigned int uiBlock = 0; uiBlock < uiBlocks; uiBlock++)
 			{
-				break;
+				papblock[uiBlock]->PerformEncodingIteration(m_fEffort);
 			}
 
-			plink->GetBlock()->PerformEncodingIteration(m_fEffort);
-
-			uiIteratedBlocks += a_uiMultithreadingStride;	
+			uiIteratedBlocks += uiBlocks;
 		}
 
 		return uiIteratedBlocks;
@@ -583,14 +603,13 @@ namespace Etc
 	// run the first pass of the encoder
 	// the encoder generally finds a reasonable, fast encoding
 	// this is run on all blocks regardless of effort to ensure that all blocks have a valid encoding
+	// each call encodes blocks [a_uiBlockBegin, a_uiBlockEnd)
 	//
-	void Image::RunFirstPass(unsigned int a_uiMultithreadingOffset, unsigned int a_uiMultithreadingStride)
+	void Image::RunFirstPass(unsigned int a_uiBlockBegin, unsigned int a_uiBlockEnd)
 	{
-		assert(a_uiMultithreadingStride > 0);
+		assert(a_uiBlockEnd <= GetNumberOfBlocks());
 
-		for (unsigned int uiBlock = a_uiMultithreadingOffset;
-				uiBlock < GetNumberOfBlocks(); 
-				uiBlock += a_uiMultithreadingStride)
+		for (unsigned int uiBlock = a_uiBlockBegin; uiBlock < a_uiBlockEnd; uiBlock++)
 		{
 			Block4x4 *pblock = &m_pablock[uiBlock];
 			pblock->PerformEncodingIteration(m_fEffort);
@@ -600,14 +619,11 @@ namespace Etc
     // ----------------------------------------------------------------------------------------------------
 	// set the encoding bits (for the output file) based on the best encoding for each block
 	//
-	void Image::SetEncodingBits(unsigned int a_uiMultithreadingOffset,
-								unsigned int a_uiMultithreadingStride)
+	void Image::SetEncodingBits(unsigned int a_uiBlockBegin, unsigned int a_uiBlockEnd)
 	{
-		assert(a_uiMultithreadingStride > 0);
+		assert(a_uiBlockEnd <= GetNumberOfBlocks());
 
-		for (unsigned int uiBlock = a_uiMultithreadingOffset; 
-				uiBlock < GetNumberOfBlocks(); 
-				uiBlock += a_uiMultithreadingStride)
+		for (unsigned int uiBlock = a_uiBlockBegin; uiBlock < a_uiBlockEnd; uiBlock++)
 		{
 			Block4x4 *pblock = &m_pablock[uiBlock];
 			pblock->SetEncodingBitsFromEncoding();
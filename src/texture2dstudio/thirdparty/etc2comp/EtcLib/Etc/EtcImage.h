@@ -80,11 +80,25 @@ namespace Etc
 			DEFAULT = SRGB8
 		};
 
+		// layout of the source pixels
+		enum class SourceFormat
+		{
+			RGBA32F,		// ColorFloatRGBA
+			RGBA8,			// 4 unsigned chars
+			RGBA16,			// 4 unsigned shorts, native byte order
+		};
+
 		// constructor using source image
 		Image(float *a_pafSourceRGBA, unsigned int a_uiSourceWidth,
 				unsigned int a_uiSourceHeight,
 				ErrorMetric a_errormetric);
 
+		// constructor using a source image in a_sourceformat, a_uiSourceStride bytes between rows
+		// the pixels are converted to ColorFloatRGBA a block at a time, so the image is never expanded
+		Image(const void *a_pvSource, SourceFormat a_sourceformat, unsigned int a_uiSourceStride,
+				unsigned int a_uiSourceWidth, unsigned int a_uiSourceHeight,
+				ErrorMetric a_errormetric);
+
 		// constructor using encoding bits
 		Image(Format a_format, 
 				unsigned int a_uiSourceWidth, unsigned int a_uiSourceHeight,
@@ -149,14 +163,50 @@ namespace Etc
 
 		float GetError(void);
 
-		inline ColorFloatRGBA * GetSourcePixel(unsigned int a_uiH, unsigned int a_uiV)
+		// the source pixel at [a_uiH,a_uiV]
+		// returns false if the pixel is beyond the source image because of block padding
+		inline bool GetSourcePixel(unsigned int a_uiH, unsigned int a_uiV, ColorFloatRGBA *a_pfrgbaPixel)
 		{
 			if (a_uiH >= m_uiSourceWidth || a_uiV >= m_uiSourceHeight)
 			{
-				return nullptr;
+				return false;
+			}
+
+			const unsigned char *paucRow = m_paucSource + (size_t)a_uiV * m_uiSourceStride;
+
+			switch (m_sourceformat)
+			{
+			case SourceFormat::RGBA8:
+				*a_pfrgbaPixel = ConvertSourcePixel((const unsigned char *)paucRow + 4 * a_uiH);
+				break;
+
+			case SourceFormat::RGBA16:
+				*a_pfrgbaPixel = ConvertSourcePixel((const unsigned short *)paucRow + 4 * a_uiH);
+				break;
+
+			default:
+				*a_pfrgbaPixel = ((const ColorFloatRGBA *)paucRow)[a_uiH];
+				break;
 			}
 
-			return &m_pafrgbaSource[a_uiV*m_uiSourceWidth + a_uiH];
+			return true;
+		}
+
+		// a_uiPixels pixels of a source row in a_sourceformat as floats
+		static void ConvertSourceRow(const void *a_pvRow, SourceFormat a_sourceformat, unsigned int a_uiPixels,
+										ColorFloatRGBA *a_pafrgbaRow);
+
+		inline static ColorFloatRGBA ConvertSourcePixel(const unsigned char *a_paucPixel)
+		{
+			return ColorFloatRGBA::ConvertFromRGBA8(a_paucPixel[0], a_paucPixel[1], a_paucPixel[2], a_paucPixel[3]);
+		}
+
+		inline static ColorFloatRGBA ConvertSourcePixel(const unsigned short *a_paushPixel)
+		{
+			return ColorFloatRGBA((float)a_paushPixel[0] / 65535.0f,
+									(float)a_paushPixel[1] / 65535.0f,
+									(float)a_paushPixel[2] / 65535.0f,
+									(float)a_paushPixel[3] / 65535.0f);
 		}
 
 		inline Format GetFormat(void)
@@ -209,18 +259,20 @@ namespace Etc
 
 		void InitBlocksAndBlockSorter(void);
 
-		void RunFirstPass(unsigned int a_uiMultithreadingOffset, 
-							unsigned int a_uiMultithreadingStride);
+		void RunFirstPass(unsigned int a_uiBlockBegin, unsigned int a_uiBlockEnd);
+
+		void SetEncodingBits(unsigned int a_uiBlockBegin, unsigned int a_uiBlockEnd);
 
-		void SetEncodingBits(unsigned int a_uiMultithreadingOffset,
-								unsigned int a_uiMultithreadingStride);
+		unsigned int IterateThroughWorstBlocks(void);
 
-		unsigned int IterateThroughWorstBlocks(unsigned int a_uiMaxBlocks,
-												unsigned int a_uiMultithreadingOffset,
-												unsigned int a_uiMultithreadingStride);
+		void InitSource(const void *a_pvSource, SourceFormat a_sourceformat, unsigned int a_uiSourceStride,
+						unsigned int a_uiSourceWidth, unsigned int a_uiSourceHeight,
+						ErrorMetric a_errormetric);
 
 		// inputs
-		ColorFloatRGBA *m_pafrgbaSource;
+		const unsigned char *m_paucSource;
+		SourceFormat m_sourceformat;
+		unsigned int m_uiSourceStride;			// bytes between source rows
 		unsigned int m_uiSourceWidth;
 		unsigned int m_uiSourceHeight;
 		unsigned int m_uiExtendedWidth;
@@ -269,10 +269,10 @@ namespace Etc
 			{
 				unsigned int uiSourcePixelV = m_uiSourceV + uiBlockPixelV;
 
-				ColorFloatRGBA *pfrgbaSource = m_pimageSource->GetSourcePixel(uiSourcePixelH, uiSourcePixelV);
+				ColorFloatRGBA frgbaSource;
 
 				// if pixel extends beyond source image because of block padding
-				if (pfrgbaSource == nullptr)
+				if (!m_pimageSource->GetSourcePixel(uiSourcePixelH, uiSourcePixelV, &frgbaSource))
 				{
 					m_afrgbaSource[uiPixel] = ColorFloatRGBA(0.0f, 0.0f, 0.0f, NAN);	// denotes border pixel
 					m_boolBorderPixels = true;
@@ -283,7 +283,7 @@ namespace Etc
 					//get teh current pixel data, and store some of the attributes
 					//before capping values to fit the encoder type
 					
-					m_afrgbaSource[uiPixel] = (*pfrgbaSource).ClampRGBA();
+					m_afrgbaSource[uiPixel] = frgbaSource.ClampRGBA();
 
 					if (m_afrgbaSource[uiPixel].fA == 1.0f || m_errormetric == RGBX)
 					{
@@ -28,9 +28,12 @@ particular file format (e.g. ETC1, RGB8, RGBA8, R11)
 #include "EtcBlock4x4EncodingBits.h"
 #include "EtcBlock4x4.h"
 
+#include "simd.h"
+
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
+#include <float.h>
 
 namespace Etc
 {
@@ -39,6 +42,10 @@ namespace Etc
 	const float Block4x4Encoding::LUMA_WEIGHT = 3.0f;
 	const float Block4x4Encoding::CHROMA_BLUE_WEIGHT = 0.5f;
 
+	static void CalcSourceTerms(ErrorMetric a_errormetric, const ColorFloatRGBA &a_frgbaSourcePixel,
+								Block4x4Encoding::SourceTerms *a_pterms, unsigned int a_uiPixel);
+	static const Block4x4Encoding::ErrorKernels *GetErrorKernels(ErrorMetric a_errormetric);
+
 	// ----------------------------------------------------------------------------------------------------
 	//
 	Block4x4Encoding::Block4x4Encoding(void)
@@ -48,6 +55,8 @@ namespace Etc
 
 		m_pafrgbaSource = nullptr;
 
+		m_perrorkernels = nullptr;
+
 		m_boolBorderPixels = false;
 
 		m_fError = -1.0f;
@@ -89,25 +98,51 @@ namespace Etc
 
 		m_errormetric = a_errormetric;
 
+		m_perrorkernels = GetErrorKernels(a_errormetric);
+
 		for (unsigned int uiPixel = 0; uiPixel < PIXELS; uiPixel++)
 		{
 			m_afrgbaDecodedColors[uiPixel] = ColorFloatRGBA(-1.0f, -1.0f, -1.0f, -1.0f);
 			m_afDecodedAlphas[uiPixel] = -1.0f;
+
+			CalcSourceTerms(a_errormetric, m_pafrgbaSource[uiPixel], &m_sourceterms, uiPixel);
 		}
 
 	}
 
+	// ----------------------------------------------------------------------------------------------------
+	// copy the source terms of the 8 pixels of a half block, and their decoded alphas, to be contiguous
+	//
+	void Block4x4Encoding::GatherHalf(const unsigned int *a_pauiPixelMapping, SourceTerms *a_pterms,
+										float *a_pafDecodedAlphas)
+	{
+		for (unsigned int uiPixel = 0; uiPixel < PIXELS / 2; uiPixel++)
+		{
+			unsigned int uiSourcePixel = a_pauiPixelMapping[uiPixel];
+
+			a_pterms->afTerm0[uiPixel] = m_sourceterms.afTerm0[uiSourcePixel];
+			a_pterms->afTerm1[uiPixel] = m_sourceterms.afTerm1[uiSourcePixel];
+			a_pterms->afTerm2[uiPixel] = m_sourceterms.afTerm2[uiSourcePixel];
+			a_pterms->afAlpha[uiPixel] = m_sourceterms.afAlpha[uiSourcePixel];
+			a_pafDecodedAlphas[uiPixel] = m_afDecodedAlphas[uiSourcePixel];
+		}
+	}
+
 	// ----------------------------------------------------------------------------------------------------
 	// calculate the error for the block by summing the pixel errors
+	// the pixel errors are summed in pixel order, as before they were vectorised
 	//
 	void Block4x4Encoding::CalcBlockError(void)
 	{
+		float afPixelErrors[PIXELS];
+
+		m_perrorkernels->PixelErrors(m_sourceterms, m_afDecodedAlphas, m_afrgbaDecodedColors, afPixelErrors);
+
 		m_fError = 0.0f;
 
 		for (unsigned int uiPixel = 0; uiPixel < PIXELS; uiPixel++)
 		{
-			m_fError += CalcPixelError(m_afrgbaDecodedColors[uiPixel], m_afDecodedAlphas[uiPixel],
-										m_pafrgbaSource[uiPixel]);
+			m_fError += afPixelErrors[uiPixel];
 		}
 		
 	}
@@ -116,8 +151,9 @@ namespace Etc
 	// calculate the error between the source pixel and the decoded pixel
 	// the error amount is base on the error metric
 	//
-	float Block4x4Encoding::CalcPixelError(ColorFloatRGBA a_frgbaDecodedColor, float a_fDecodedAlpha,
-											ColorFloatRGBA a_frgbaSourcePixel)
+	template<ErrorMetric Metric>
+	float Block4x4Encoding::PixelError(const ColorFloatRGBA &a_frgbaDecodedColor, float a_fDecodedAlpha,
+										const ColorFloatRGBA &a_frgbaSourcePixel)
 	{
 
 		// if a border pixel
@@ -126,7 +162,7 @@ namespace Etc
 			return 0.0f;
 		}
 
-		if (m_errormetric == ErrorMetric::RGBA)
+		if (Metric == ErrorMetric::RGBA)
 		{
 			assert(a_fDecodedAlpha >= 0.0f);
 
@@ -141,7 +177,7 @@ namespace Etc
 
 			return fDRed*fDRed + fDGreen*fDGreen + fDBlue*fDBlue + fDAlpha*fDAlpha;
 		}
-		else if (m_errormetric == ErrorMetric::RGBX)
+		else if (Metric == ErrorMetric::RGBX)
 		{
 			assert(a_fDecodedAlpha >= 0.0f);
 
@@ -152,7 +188,7 @@ namespace Etc
 
 			return fDRed*fDRed + fDGreen*fDGreen + fDBlue*fDBlue + fDAlpha*fDAlpha;
 		}
-		else if (m_errormetric == ErrorMetric::REC709)
+		else if (Metric == ErrorMetric::REC709)
 		{
 			assert(a_fDecodedAlpha >= 0.0f);
 
@@ -184,7 +220,7 @@ namespace Etc
 			return 2.0f * 3.0f * fDeltaL * fDeltaL + fDRed*fDRed + fDGreen*fDGreen + fDBlue*fDBlue;
 #endif
 		}
-		else if (m_errormetric == ErrorMetric::NORMALXYZ)
+		else if (Metric == ErrorMetric::NORMALXYZ)
 		{
 			float fDecodedX = 2.0f * a_frgbaDecodedColor.fR - 1.0f;
 			float fDecodedY = 2.0f * a_frgbaDecodedColor.fG - 1.0f;
@@ -256,6 +292,480 @@ namespace Etc
 
 	// ----------------------------------------------------------------------------------------------------
 	//
+	float Block4x4Encoding::CalcPixelError(ColorFloatRGBA a_frgbaDecodedColor, float a_fDecodedAlpha,
+											ColorFloatRGBA a_frgbaSourcePixel)
+	{
+		switch (m_errormetric)
+		{
+		case ErrorMetric::RGBA:
+			return PixelError<ErrorMetric::RGBA>(a_frgbaDecodedColor, a_fDecodedAlpha, a_frgbaSourcePixel);
+		case ErrorMetric::RGBX:
+			return PixelError<ErrorMetric::RGBX>(a_frgbaDecodedColor, a_fDecodedAlpha, a_frgbaSourcePixel);
+		case ErrorMetric::REC709:
+			return PixelError<ErrorMetric::REC709>(a_frgbaDecodedColor, a_fDecodedAlpha, a_frgbaSourcePixel);
+		case ErrorMetric::NORMALXYZ:
+			return PixelError<ErrorMetric::NORMALXYZ>(a_frgbaDecodedColor, a_fDecodedAlpha, a_frgbaSourcePixel);
+		default:
+			return PixelError<ErrorMetric::NUMERIC>(a_frgbaDecodedColor, a_fDecodedAlpha, a_frgbaSourcePixel);
+		}
+	}
+
+	// ----------------------------------------------------------------------------------------------------
+	// the terms of a source pixel that the error metric computes on its own, for SourceTerms
+	// same float operations as PixelError so the kernels stay bit-identical to it
+	//
+	static void CalcSourceTerms(ErrorMetric a_errormetric, const ColorFloatRGBA &a_frgbaSourcePixel,
+								Block4x4Encoding::SourceTerms *a_pterms, unsigned int a_uiPixel)
+	{
+		float fTerm0 = a_frgbaSourcePixel.fR;
+		float fTerm1 = a_frgbaSourcePixel.fG;
+		float fTerm2 = a_frgbaSourcePixel.fB;
+
+		if (a_errormetric == ErrorMetric::RGBA)
+		{
+			fTerm0 = a_frgbaSourcePixel.fA * a_frgbaSourcePixel.fR;
+			fTerm1 = a_frgbaSourcePixel.fA * a_frgbaSourcePixel.fG;
+			fTerm2 = a_frgbaSourcePixel.fA * a_frgbaSourcePixel.fB;
+		}
+		else if (a_errormetric == ErrorMetric::REC709)
+		{
+			float fLuma1 = a_frgbaSourcePixel.fR*0.2126f + a_frgbaSourcePixel.fG*0.7152f + a_frgbaSourcePixel.fB*0.0722f;
+			float fChromaR1 = 0.5f * ((a_frgbaSourcePixel.fR - fLuma1) * (1.0f / (1.0f - 0.2126f)));
+			float fChromaB1 = 0.5f * ((a_frgbaSourcePixel.fB - fLuma1) * (1.0f / (1.0f - 0.0722f)));
+
+			fTerm0 = a_frgbaSourcePixel.fA * fLuma1;
+			fTerm1 = a_frgbaSourcePixel.fA * fChromaR1;
+			fTerm2 = a_frgbaSourcePixel.fA * fChromaB1;
+		}
+
+		a_pterms->afTerm0[a_uiPixel] = fTerm0;
+		a_pterms->afTerm1[a_uiPixel] = fTerm1;
+		a_pterms->afTerm2[a_uiPixel] = fTerm2;
+		a_pterms->afAlpha[a_uiPixel] = a_frgbaSourcePixel.fA;
+	}
+
+	// ----------------------------------------------------------------------------------------------------
+	// PixelError of one pixel from its source terms
+	//
+	template<ErrorMetric Metric>
+	static inline float TermsError(float a_fR, float a_fG, float a_fB, float a_fA, float a_fDecodedAlpha,
+									const Block4x4Encoding::SourceTerms &a_terms, unsigned int a_uiPixel)
+	{
+		float fSourceAlpha = a_terms.afAlpha[a_uiPixel];
+
+		// if a border pixel
+		if (isnan(fSourceAlpha))
+		{
+			return 0.0f;
+		}
+
+		if (Metric == ErrorMetric::RGBA)
+		{
+			float fDRed = a_fDecodedAlpha * a_fR - a_terms.afTerm0[a_uiPixel];
+			float fDGreen = a_fDecodedAlpha * a_fG - a_terms.afTerm1[a_uiPixel];
+			float fDBlue = a_fDecodedAlpha * a_fB - a_terms.afTerm2[a_uiPixel];
+			float fDAlpha = a_fDecodedAlpha - fSourceAlpha;
+
+			return fDRed*fDRed + fDGreen*fDGreen + fDBlue*fDBlue + fDAlpha*fDAlpha;
+		}
+		else if (Metric == ErrorMetric::RGBX)
+		{
+			float fDRed = a_fR - a_terms.afTerm0[a_uiPixel];
+			float fDGreen = a_fG - a_terms.afTerm1[a_uiPixel];
+			float fDBlue = a_fB - a_terms.afTerm2[a_uiPixel];
+			float fDAlpha = a_fDecodedAlpha - fSourceAlpha;
+
+			return fDRed*fDRed + fDGreen*fDGreen + fDBlue*fDBlue + fDAlpha*fDAlpha;
+		}
+		else if (Metric == ErrorMetric::REC709)
+		{
+			float fLuma2 = a_fR*0.2126f + a_fG*0.7152f + a_fB*0.0722f;
+			float fChromaR2 = 0.5f * ((a_fR - fLuma2) * (1.0f / (1.0f - 0.2126f)));
+			float fChromaB2 = 0.5f * ((a_fB - fLuma2) * (1.0f / (1.0f - 0.0722f)));
+
+			float fDeltaL = a_terms.afTerm0[a_uiPixel] - a_fDecodedAlpha * fLuma2;
+			float fDeltaCr = a_terms.afTerm1[a_uiPixel] - a_fDecodedAlpha * fChromaR2;
+			float fDeltaCb = a_terms.afTerm2[a_uiPixel] - a_fDecodedAlpha * fChromaB2;
+			float fDAlpha = a_fDecodedAlpha - fSourceAlpha;
+
+			return Block4x4Encoding::LUMA_WEIGHT*fDeltaL*fDeltaL +
+					fDeltaCr*fDeltaCr +
+					Block4x4Encoding::CHROMA_BLUE_WEIGHT*fDeltaCb*fDeltaCb +
+					fDAlpha*fDAlpha;
+		}
+		else if (Metric == ErrorMetric::NORMALXYZ)
+		{
+			return Block4x4Encoding::PixelError<ErrorMetric::NORMALXYZ>(ColorFloatRGBA(a_fR, a_fG, a_fB, a_fA),
+									a_fDecodedAlpha,
+									ColorFloatRGBA(a_terms.afTerm0[a_uiPixel], a_terms.afTerm1[a_uiPixel],
+													a_terms.afTerm2[a_uiPixel], fSourceAlpha));
+		}
+		else // ErrorMetric::NUMERIC
+		{
+			float fDX = a_fR - a_terms.afTerm0[a_uiPixel];
+			float fDY = a_fG - a_terms.afTerm1[a_uiPixel];
+			float fDZ = a_fB - a_terms.afTerm2[a_uiPixel];
+			float fDW = a_fA - fSourceAlpha;
+
+			return fDX*fDX + fDY*fDY + fDZ*fDZ + fDW*fDW;
+		}
+	}
+
+	// ----------------------------------------------------------------------------------------------------
+	//
+	template<ErrorMetric Metric>
+	static void BestSelectorsScalar(const Block4x4Encoding::SourceTerms &a_terms, const float *a_pafDecodedAlphas,
+									const ColorFloatRGBA *a_pafrgbaCandidates,
+									unsigned int *a_pauiSelectors, float *a_pafErrors)
+	{
+		for (unsigned int uiPixel = 0; uiPixel < Block4x4Encoding::PIXELS / 2; uiPixel++)
+		{
+			a_pafErrors[uiPixel] = FLT_MAX;
+			a_pauiSelectors[uiPixel] = 0;
+
+			for (unsigned int uiSelector = 0; uiSelector < 4; uiSelector++)
+			{
+				const ColorFloatRGBA &frgba = a_pafrgbaCandidates[uiSelector];
+				float fPixelError = TermsError<Metric>(frgba.fR, frgba.fG, frgba.fB, frgba.fA,
+														a_pafDecodedAlphas[uiPixel], a_terms, uiPixel);
+
+				if (fPixelError < a_pafErrors[uiPixel])
+				{
+					a_pafErrors[uiPixel] = fPixelError;
+					a_pauiSelectors[uiPixel] = uiSelector;
+				}
+			}
+		}
+	}
+
+	// ----------------------------------------------------------------------------------------------------
+	//
+	template<ErrorMetric Metric>
+	static void PixelErrorsScalar(const Block4x4Encoding::SourceTerms &a_terms, const float *a_pafDecodedAlphas,
+									const ColorFloatRGBA *a_pafrgbaDecodedColors, float *a_pafErrors)
+	{
+		for (unsigned int uiPixel = 0; uiPixel < Block4x4Encoding::PIXELS; uiPixel++)
+		{
+			const ColorFloatRGBA &frgba = a_pafrgbaDecodedColors[uiPixel];
+			a_pafErrors[uiPixel] = TermsError<Metric>(frgba.fR, frgba.fG, frgba.fB, frgba.fA,
+														a_pafDecodedAlphas[uiPixel], a_terms, uiPixel);
+		}
+	}
+
+#if defined(TEXTURE2D_SIMD_X86)
+	// ----------------------------------------------------------------------------------------------------
+	// TermsError of 4 pixels, in the same order of operations
+	// border pixels have a NaN source alpha and get an error of 0
+	//
+	template<ErrorMetric Metric>
+	SIMD_TARGET_SSE41 static inline __m128 TermsErrorSse41(__m128 a_fR, __m128 a_fG, __m128 a_fB, __m128 a_fA,
+															__m128 a_fDecodedAlpha, __m128 a_fTerm0,
+															__m128 a_fTerm1, __m128 a_fTerm2, __m128 a_fSourceAlpha)
+	{
+		__m128 fD0, fD1, fD2, fDAlpha;
+
+		if (Metric == ErrorMetric::RGBA)
+		{
+			fD0 = _mm_sub_ps(_mm_mul_ps(a_fDecodedAlpha, a_fR), a_fTerm0);
+			fD1 = _mm_sub_ps(_mm_mul_ps(a_fDecodedAlpha, a_fG), a_fTerm1);
+			fD2 = _mm_sub_ps(_mm_mul_ps(a_fDecodedAlpha, a_fB), a_fTerm2);
+			fDAlpha = _mm_sub_ps(a_fDecodedAlpha, a_fSourceAlpha);
+		}
+		else if (Metric == ErrorMetric::REC709)
+		{
+			__m128 fLuma2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a_fR, _mm_set1_ps(0.2126f)),
+													_mm_mul_ps(a_fG, _mm_set1_ps(0.7152f))),
+										_mm_mul_ps(a_fB, _mm_set1_ps(0.0722f)));
+			__m128 fChromaR2 = _mm_mul_ps(_mm_set1_ps(0.5f), _mm_mul_ps(_mm_sub_ps(a_fR, fLuma2),
+																		_mm_set1_ps(1.0f / (1.0f - 0.2126f))));
+			__m128 fChromaB2 = _mm_mul_ps(_mm_set1_ps(0.5f), _mm_mul_ps(_mm_sub_ps(a_fB, fLuma2),
+																		_mm_set1_ps(1.0f / (1.0f - 0.0722f))));
+
+			__m128 fDeltaL = _mm_sub_ps(a_fTerm0, _mm_mul_ps(a_fDecodedAlpha, fLuma2));
+			__m128 fDeltaCr = _mm_sub_ps(a_fTerm1, _mm_mul_ps(a_fDecodedAlpha, fChromaR2));
+			__m128 fDeltaCb = _mm_sub_ps(a_fTerm2, _mm_mul_ps(a_fDecodedAlpha, fChromaB2));
+
+			// LUMA_WEIGHT*dL and CHROMA_BLUE_WEIGHT*dCb are squared as (w*d)*d, like PixelError
+			fD0 = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(Block4x4Encoding::LUMA_WEIGHT), fDeltaL), fDeltaL);
+			fD1 = _mm_mul_ps(fDeltaCr, fDeltaCr);
+			fD2 = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(Block4x4Encoding::CHROMA_BLUE_WEIGHT), fDeltaCb), fDeltaCb);
+			fDAlpha = _mm_sub_ps(a_fDecodedAlpha, a_fSourceAlpha);
+
+			__m128 fError = _mm_add_ps(_mm_add_ps(_mm_add_ps(fD0, fD1), fD2), _mm_mul_ps(fDAlpha, fDAlpha));
+
+			return _mm_andnot_ps(_mm_cmpunord_ps(a_fSourceAlpha, a_fSourceAlpha), fError);
+		}
+		else
+		{
+			fD0 = _mm_sub_ps(a_fR, a_fTerm0);
+			fD1 = _mm_sub_ps(a_fG, a_fTerm1);
+			fD2 = _mm_sub_ps(a_fB, a_fTerm2);
+			// RGBX compares the decoded alpha, NUMERIC the alpha of the decoded color
+			fDAlpha = _mm_sub_ps(Metric == ErrorMetric::RGBX ? a_fDecodedAlpha : a_fA, a_fSourceAlpha);
+		}
+
+		__m128 fError = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(fD0, fD0), _mm_mul_ps(fD1, fD1)),
+												_mm_mul_ps(fD2, fD2)),
+									_mm_mul_ps(fDAlpha, fDAlpha));
+
+		return _mm_andnot_ps(_mm_cmpunord_ps(a_fSourceAlpha, a_fSourceAlpha), fError);
+	}
+
+	// ----------------------------------------------------------------------------------------------------
+	//
+	template<ErrorMetric Metric>
+	SIMD_TARGET_SSE41 static void BestSelectorsSse41(const Block4x4Encoding::SourceTerms &a_terms,
+														const float *a_pafDecodedAlphas,
+														const ColorFloatRGBA *a_pafrgbaCandidates,
+														unsigned int *a_pauiSelectors, float *a_pafErrors)
+	{
+		for (unsigned int uiPixel = 0; uiPixel < Block4x4Encoding::PIXELS / 2; uiPixel += 4)
+		{
+			__m128 fTerm0 = _mm_loadu_ps(&a_terms.afTerm0[uiPixel]);
+			__m128 fTerm1 = _mm_loadu_ps(&a_terms.afTerm1[uiPixel]);
+			__m128 fTerm2 = _mm_loadu_ps(&a_terms.afTerm2[uiPixel]);
+			__m128 fSourceAlpha = _mm_loadu_ps(&a_terms.afAlpha[uiPixel]);
+			__m128 fDecodedAlpha = _mm_loadu_ps(&a_pafDecodedAlphas[uiPixel]);
+
+			__m128 fBestError = _mm_set1_ps(FLT_MAX);
+			__m128 fBestSelector = _mm_setzero_ps();
+
+			for (unsigned int uiSelector = 0; uiSelector < 4; uiSelector++)
+			{
+				const ColorFloatRGBA &frgba = a_pafrgbaCandidates[uiSelector];
+				__m128 fError = TermsErrorSse41<Metric>(_mm_set1_ps(frgba.fR), _mm_set1_ps(frgba.fG),
+														_mm_set1_ps(frgba.fB), _mm_set1_ps(frgba.fA),
+														fDecodedAlpha, fTerm0, fTerm1, fTerm2, fSourceAlpha);
+
+				// strictly lower, so ties keep the first selector
+				__m128 fLower = _mm_cmplt_ps(fError, fBestError);
+				fBestError = _mm_blendv_ps(fBestError, fError, fLower);
+				fBestSelector = _mm_blendv_ps(fBestSelector, _mm_castsi128_ps(_mm_set1_epi32((int)uiSelector)), fLower);
+			}
+
+			_mm_storeu_ps(&a_pafErrors[uiPixel], fBestError);
+			_mm_storeu_si128((__m128i *)&a_pauiSelectors[uiPixel], _mm_castps_si128(fBestSelector));
+		}
+	}
+
+	// ----------------------------------------------------------------------------------------------------
+	// the decoded colors are RGBA structures, transposed 4 pixels at a time
+	//
+	template<ErrorMetric Metric>
+	SIMD_TARGET_SSE41 static void PixelErrorsSse41(const Block4x4Encoding::SourceTerms &a_terms,
+													const float *a_pafDecodedAlphas,
+													const ColorFloatRGBA *a_pafrgbaDecodedColors, float *a_pafErrors)
+	{
+		for (unsigned int uiPixel = 0; uiPixel < Block4x4Encoding::PIXELS; uiPixel += 4)
+		{
+			__m128 fR = _mm_loadu_ps(&a_pafrgbaDecodedColors[uiPixel].fR);
+			__m128 fG = _mm_loadu_ps(&a_pafrgbaDecodedColors[uiPixel + 1].fR);
+			__m128 fB = _mm_loadu_ps(&a_pafrgbaDecodedColors[uiPixel + 2].fR);
+			__m128 fA = _mm_loadu_ps(&a_pafrgbaDecodedColors[uiPixel + 3].fR);
+			_MM_TRANSPOSE4_PS(fR, fG, fB, fA);
+
+			__m128 fError = TermsErrorSse41<Metric>(fR, fG, fB, fA, _mm_loadu_ps(&a_pafDecodedAlphas[uiPixel]),
+													_mm_loadu_ps(&a_terms.afTerm0[uiPixel]),
+													_mm_loadu_ps(&a_terms.afTerm1[uiPixel]),
+													_mm_loadu_ps(&a_terms.afTerm2[uiPixel]),
+													_mm_loadu_ps(&a_terms.afAlpha[uiPixel]));
+
+			_mm_storeu_ps(&a_pafErrors[uiPixel], fError);
+		}
+	}
+
+	// ----------------------------------------------------------------------------------------------------
+	// TermsErrorSse41 for 8 pixels
+	//
+	template<ErrorMetric Metric>
+	SIMD_TARGET_AVX2 static inline __m256 TermsErrorAvx2(__m256 a_fR, __m256 a_fG, __m256 a_fB, __m256 a_fA,
+															__m256 a_fDecodedAlpha, __m256 a_fTerm0,
+															__m256 a_fTerm1, __m256 a_fTerm2, __m256 a_fSourceAlpha)
+	{
+		__m256 fD0, fD1, fD2, fDAlpha;
+
+		if (Metric == ErrorMetric::RGBA)
+		{
+			fD0 = _mm256_sub_ps(_mm256_mul_ps(a_fDecodedAlpha, a_fR), a_fTerm0);
+			fD1 = _mm256_sub_ps(_mm256_mul_ps(a_fDecodedAlpha, a_fG), a_fTerm1);
+			fD2 = _mm256_sub_ps(_mm256_mul_ps(a_fDecodedAlpha, a_fB), a_fTerm2);
+			fDAlpha = _mm256_sub_ps(a_fDecodedAlpha, a_fSourceAlpha);
+		}
+		else if (Metric == ErrorMetric::REC709)
+		{
+			__m256 fLuma2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a_fR, _mm256_set1_ps(0.2126f)),
+													_mm256_mul_ps(a_fG, _mm256_set1_ps(0.7152f))),
+										_mm256_mul_ps(a_fB, _mm256_set1_ps(0.0722f)));
+			__m256 fChromaR2 = _mm256_mul_ps(_mm256_set1_ps(0.5f), _mm256_mul_ps(_mm256_sub_ps(a_fR, fLuma2),
+																		_mm256_set1_ps(1.0f / (1.0f - 0.2126f))));
+			__m256 fChromaB2 = _mm256_mul_ps(_mm256_set1_ps(0.5f), _mm256_mul_ps(_mm256_sub_ps(a_fB, fLuma2),
+																		_mm256_set1_ps(1.0f / (1.0f - 0.0722f))));
+
+			__m256 fDeltaL = _mm256_sub_ps(a_fTerm0, _mm256_mul_ps(a_fDecodedAlpha, fLuma2));
+			__m256 fDeltaCr = _mm256_sub_ps(a_fTerm1, _mm256_mul_ps(a_fDecodedAlpha, fChromaR2));
+			__m256 fDeltaCb = _mm256_sub_ps(a_fTerm2, _mm256_mul_ps(a_fDecodedAlpha, fChromaB2));
+
+			// LUMA_WEIGHT*dL and CHROMA_BLUE_WEIGHT*dCb are squared as (w*d)*d, like PixelError
+			fD0 = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(Block4x4Encoding::LUMA_WEIGHT), fDeltaL), fDeltaL);
+			fD1 = _mm256_mul_ps(fDeltaCr, fDeltaCr);
+			fD2 = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(Block4x4Encoding::CHROMA_BLUE_WEIGHT), fDeltaCb), fDeltaCb);
+			fDAlpha = _mm256_sub_ps(a_fDecodedAlpha, a_fSourceAlpha);
+
+			__m256 fError = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(fD0, fD1), fD2), _mm256_mul_ps(fDAlpha, fDAlpha));
+
+			return _mm256_andnot_ps(_mm256_cmp_ps(a_fSourceAlpha, a_fSourceAlpha, _CMP_UNORD_Q), fError);
+		}
+		else
+		{
+			fD0 = _mm256_sub_ps(a_fR, a_fTerm0);
+			fD1 = _mm256_sub_ps(a_fG, a_fTerm1);
+			fD2 = _mm256_sub_ps(a_fB, a_fTerm2);
+			// RGBX compares the decoded alpha, NUMERIC the alpha of the decoded color
+			fDAlpha = _mm256_sub_ps(Metric == ErrorMetric::RGBX ? a_fDecodedAlpha : a_fA, a_fSourceAlpha);
+		}
+
+		__m256 fError = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(fD0, fD0), _mm256_mul_ps(fD1, fD1)),
+												_mm256_mul_ps(fD2, fD2)),
+									_mm256_mul_ps(fDAlpha, fDAlpha));
+
+		return _mm256_andnot_ps(_mm256_cmp_ps(a_fSourceAlpha, a_fSourceAlpha, _CMP_UNORD_Q), fError);
+	}
+
+	// ----------------------------------------------------------------------------------------------------
+	//
+	template<ErrorMetric Metric>
+	SIMD_TARGET_AVX2 static void BestSelectorsAvx2(const Block4x4Encoding::SourceTerms &a_terms,
+													const float *a_pafDecodedAlphas,
+													const ColorFloatRGBA *a_pafrgbaCandidates,
+													unsigned int *a_pauiSelectors, float *a_pafErrors)
+	{
+		__m256 fTerm0 = _mm256_loadu_ps(a_terms.afTerm0);
+		__m256 fTerm1 = _mm256_loadu_ps(a_terms.afTerm1);
+		__m256 fTerm2 = _mm256_loadu_ps(a_terms.afTerm2);
+		__m256 fSourceAlpha = _mm256_loadu_ps(a_terms.afAlpha);
+		__m256 fDecodedAlpha = _mm256_loadu_ps(a_pafDecodedAlphas);
+
+		__m256 fBestError = _mm256_set1_ps(FLT_MAX);
+		__m256 fBestSelector = _mm256_setzero_ps();
+
+		for (unsigned int uiSelector = 0; uiSelector < 4; uiSelector++)
+		{
+			const ColorFloatRGBA &frgba = a_pafrgbaCandidates[uiSelector];
+			__m256 fError = TermsErrorAvx2<Metric>(_mm256_set1_ps(frgba.fR), _mm256_set1_ps(frgba.fG),
+													_mm256_set1_ps(frgba.fB), _mm256_set1_ps(frgba.fA),
+													fDecodedAlpha, fTerm0, fTerm1, fTerm2, fSourceAlpha);
+
+			__m256 fLower = _mm256_cmp_ps(fError, fBestError, _CMP_LT_OQ);
+			fBestError = _mm256_blendv_ps(fBestError, fError, fLower);
+			fBestSelector = _mm256_blendv_ps(fBestSelector, _mm256_castsi256_ps(_mm256_set1_epi32((int)uiSelector)),
+												fLower);
+		}
+
+		_mm256_storeu_ps(a_pafErrors, fBestError);
+		_mm256_storeu_si256((__m256i *)a_pauiSelectors, _mm256_castps_si256(fBestSelector));
+	}
+
+	// ----------------------------------------------------------------------------------------------------
+	//
+	template<ErrorMetric Metric>
+	SIMD_TARGET_AVX2 static void PixelErrorsAvx2(const Block4x4Encoding::SourceTerms &a_terms,
+													const float *a_pafDecodedAlphas,
+													const ColorFloatRGBA *a_pafrgbaDecodedColors, float *a_pafErrors)
+	{
+		for (unsigned int uiPixel = 0; uiPixel < Block4x4Encoding::PIXELS; uiPixel += 8)
+		{
+			// pixels 0..3 in the low lanes, 4..7 in the high lanes
+			const float *pfDecoded = &a_pafrgbaDecodedColors[uiPixel].fR;
+			__m256 fR = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pfDecoded)),
+													_mm_loadu_ps(pfDecoded + 16), 1);
+			__m256 fG = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pfDecoded + 4)),
+													_mm_loadu_ps(pfDecoded + 20), 1);
+			__m256 fB = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pfDecoded + 8)),
+													_mm_loadu_ps(pfDecoded + 24), 1);
+			__m256 fA = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pfDecoded + 12)),
+													_mm_loadu_ps(pfDecoded + 28), 1);
+
+			__m256 fRG0 = _mm256_unpacklo_ps(fR, fG);
+			__m256 fBA0 = _mm256_unpacklo_ps(fB, fA);
+			__m256 fRG1 = _mm256_unpackhi_ps(fR, fG);
+			__m256 fBA1 = _mm256_unpackhi_ps(fB, fA);
+			fR = _mm256_shuffle_ps(fRG0, fBA0, _MM_SHUFFLE(1, 0, 1, 0));
+			fG = _mm256_shuffle_ps(fRG0, fBA0, _MM_SHUFFLE(3, 2, 3, 2));
+			fB = _mm256_shuffle_ps(fRG1, fBA1, _MM_SHUFFLE(1, 0, 1, 0));
+			fA = _mm256_shuffle_ps(fRG1, fBA1, _MM_SHUFFLE(3, 2, 3, 2));
+
+			__m256 fError = TermsErrorAvx2<Metric>(fR, fG, fB, fA, _mm256_loadu_ps(&a_pafDecodedAlphas[uiPixel]),
+													_mm256_loadu_ps(&a_terms.afTerm0[uiPixel]),
+													_mm256_loadu_ps(&a_terms.afTerm1[uiPixel]),
+													_mm256_loadu_ps(&a_terms.afTerm2[uiPixel]),
+													_mm256_loadu_ps(&a_terms.afAlpha[uiPixel]));
+
+			_mm256_storeu_ps(&a_pafErrors[uiPixel], fError);
+		}
+	}
+#endif
+
+	// ----------------------------------------------------------------------------------------------------
+	// kernels by error metric, in ErrorMetric order
+	// NORMALXYZ is not vectorised
+	//
+	static const Block4x4Encoding::ErrorKernels s_aerrorkernelsScalar[] =
+	{
+		{ BestSelectorsScalar<ErrorMetric::RGBA>, PixelErrorsScalar<ErrorMetric::RGBA> },
+		{ BestSelectorsScalar<ErrorMetric::RGBX>, PixelErrorsScalar<ErrorMetric::RGBX> },
+		{ BestSelectorsScalar<ErrorMetric::REC709>, PixelErrorsScalar<ErrorMetric::REC709> },
+		{ BestSelectorsScalar<ErrorMetric::NUMERIC>, PixelErrorsScalar<ErrorMetric::NUMERIC> },
+		{ BestSelectorsScalar<ErrorMetric::NORMALXYZ>, PixelErrorsScalar<ErrorMetric::NORMALXYZ> },
+	};
+
+#if defined(TEXTURE2D_SIMD_X86)
+	static const Block4x4Encoding::ErrorKernels s_aerrorkernelsSse41[] =
+	{
+		{ BestSelectorsSse41<ErrorMetric::RGBA>, PixelErrorsSse41<ErrorMetric::RGBA> },
+		{ BestSelectorsSse41<ErrorMetric::RGBX>, PixelErrorsSse41<ErrorMetric::RGBX> },
+		{ BestSelectorsSse41<ErrorMetric::REC709>, PixelErrorsSse41<ErrorMetric::REC709> },
+		{ BestSelectorsSse41<ErrorMetric::NUMERIC>, PixelErrorsSse41<ErrorMetric::NUMERIC> },
+		{ BestSelectorsScalar<ErrorMetric::NORMALXYZ>, PixelErrorsScalar<ErrorMetric::NORMALXYZ> },
+	};
+
+	static const Block4x4Encoding::ErrorKernels s_aerrorkernelsAvx2[] =
+	{
+		{ BestSelectorsAvx2<ErrorMetric::RGBA>, PixelErrorsAvx2<ErrorMetric::RGBA> },
+		{ BestSelectorsAvx2<ErrorMetric::RGBX>, PixelErrorsAvx2<ErrorMetric::RGBX> },
+		{ BestSelectorsAvx2<ErrorMetric::REC709>, PixelErrorsAvx2<ErrorMetric::REC709> },
+		{ BestSelectorsAvx2<ErrorMetric::NUMERIC>, PixelErrorsAvx2<ErrorMetric::NUMERIC> },
+		{ BestSelectorsScalar<ErrorMetric::NORMALXYZ>, PixelErrorsScalar<ErrorMetric::NORMALXYZ> },
+	};
+#endif
+
+	// ----------------------------------------------------------------------------------------------------
+	// the kernels for a_errormetric at the detected instruction set (see simd.h)
+	// an unknown metric is treated as NUMERIC, like CalcPixelError
+	//
+	static const Block4x4Encoding::ErrorKernels *GetErrorKernels(ErrorMetric a_errormetric)
+	{
+		unsigned int uiMetric = (unsigned int)a_errormetric;
+		if (uiMetric >= (unsigned int)ErrorMetric::ERROR_METRICS)
+		{
+			uiMetric = (unsigned int)ErrorMetric::NUMERIC;
+		}
+
+#if defined(TEXTURE2D_SIMD_X86)
+		if (simd_level() >= SIMD_AVX2)
+		{
+			return &s_aerrorkernelsAvx2[uiMetric];
+		}
+		else if (simd_level() >= SIMD_SSE41)
+		{
+			return &s_aerrorkernelsSse41[uiMetric];
+		}
+#endif
+
+		return &s_aerrorkernelsScalar[uiMetric];
+	}
+
+	// ----------------------------------------------------------------------------------------------------
+	//
 
 } // namespace Etc
 
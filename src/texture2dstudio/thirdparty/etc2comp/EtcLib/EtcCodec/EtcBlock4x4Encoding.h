@@ -118,6 +118,38 @@ namespace Etc
 		float CalcPixelError(ColorFloatRGBA a_frgbaDecodedColor, float a_fDecodedAlpha,
 								ColorFloatRGBA a_frgbaSourcePixel);
 
+		template<ErrorMetric Metric>
+		static float PixelError(const ColorFloatRGBA &a_frgbaDecodedColor, float a_fDecodedAlpha,
+								const ColorFloatRGBA &a_frgbaSourcePixel);
+
+		// source pixels as structure-of-arrays for the vectorised error kernels
+		// the terms of the error metric that only depend on the source pixel are precomputed
+		// RGBA: alpha * rgb, REC709: alpha * (luma, chroma red, chroma blue), others: rgb
+		struct SourceTerms
+		{
+			float afTerm0[PIXELS];
+			float afTerm1[PIXELS];
+			float afTerm2[PIXELS];
+			float afAlpha[PIXELS];
+		};
+
+		// per error metric and instruction set, picked once in Init
+		// errors are bit-identical to CalcPixelError, so every kernel makes the same encoding decisions
+		struct ErrorKernels
+		{
+			// for each of the 8 pixels of a_terms, the first of the 4 candidate colors with the lowest error
+			void (*BestSelectors)(const SourceTerms &a_terms, const float *a_pafDecodedAlphas,
+									const ColorFloatRGBA *a_pafrgbaCandidates,
+									unsigned int *a_pauiSelectors, float *a_pafErrors);
+
+			// the error of each of the 16 pixels against its own decoded color
+			void (*PixelErrors)(const SourceTerms &a_terms, const float *a_pafDecodedAlphas,
+								const ColorFloatRGBA *a_pafrgbaDecodedColors, float *a_pafErrors);
+		};
+
+		// the block's source terms of the pixels in a_pauiPixelMapping, with their decoded alphas
+		void GatherHalf(const unsigned int *a_pauiPixelMapping, SourceTerms *a_pterms, float *a_pafDecodedAlphas);
+
 	protected:
 
 		void Init(Block4x4 *a_pblockParent,
@@ -140,6 +172,8 @@ namespace Etc
 		unsigned int	m_uiEncodingIterations;
 		bool			m_boolDone;						// all iterations have been done
 		ErrorMetric		m_errormetric;
+		const ErrorKernels *m_perrorkernels;
+		SourceTerms		m_sourceterms;					// m_pafrgbaSource for m_perrorkernels
 
 	private:
 
@@ -692,6 +692,11 @@ namespace Etc
 	void Block4x4Encoding_ETC1::TryDifferentialHalf(DifferentialTrys::Half *a_phalf)
 	{
 
+		// the half's source pixels, contiguous for the error kernels
+		SourceTerms termsHalf;
+		float afDecodedAlphasHalf[PIXELS / 2];
+		GatherHalf(a_phalf->m_pauiPixelMapping, &termsHalf, afDecodedAlphasHalf);
+
 		a_phalf->m_ptryBest = nullptr;
 		float fBestTryError = FLT_MAX;
 
@@ -727,9 +732,7 @@ namespace Etc
 					for (unsigned int uiCW = 0; uiCW < CW_RANGES; uiCW++)
 					{
 						unsigned int auiPixelSelectors[PIXELS / 2];
-						ColorFloatRGBA	afrgbaDecodedPixels[PIXELS / 2];
-						float afPixelErrors[PIXELS / 2] = { FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX, 
-															FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX };
+						float afPixelErrors[PIXELS / 2];
 
 						// pre-compute decoded pixels for each selector
 						ColorFloatRGBA afrgbaSelectors[SELECTORS];
@@ -739,29 +742,8 @@ namespace Etc
 						afrgbaSelectors[2] = (frgbaColor + s_aafCwTable[uiCW][2]).ClampRGB();
 						afrgbaSelectors[3] = (frgbaColor + s_aafCwTable[uiCW][3]).ClampRGB();
 
-						for (unsigned int uiPixel = 0; uiPixel < 8; uiPixel++)
-						{
-							ColorFloatRGBA *pfrgbaSourcePixel = &m_pafrgbaSource[a_phalf->m_pauiPixelMapping[uiPixel]];
-							ColorFloatRGBA frgbaDecodedPixel;
-
-							for (unsigned int uiSelector = 0; uiSelector < SELECTORS; uiSelector++)
-							{
-								frgbaDecodedPixel = afrgbaSelectors[uiSelector];
-
-								float fPixelError;
-
-								fPixelError = CalcPixelError(frgbaDecodedPixel, m_afDecodedAlphas[a_phalf->m_pauiPixelMapping[uiPixel]],
-																	*pfrgbaSourcePixel);
-
-								if (fPixelError < afPixelErrors[uiPixel])
-								{
-									auiPixelSelectors[uiPixel] = uiSelector;
-									afrgbaDecodedPixels[uiPixel] = frgbaDecodedPixel;
-									afPixelErrors[uiPixel] = fPixelError;
-								}
-
-							}
-						}
+						m_perrorkernels->BestSelectors(termsHalf, afDecodedAlphasHalf, afrgbaSelectors,
+														auiPixelSelectors, afPixelErrors);
 
 						// add up all pixel errors
 						float fCWError = 0.0f;
@@ -885,6 +867,11 @@ namespace Etc
 	void Block4x4Encoding_ETC1::TryIndividualHalf(IndividualTrys::Half *a_phalf)
 	{
 
+		// the half's source pixels, contiguous for the error kernels
+		SourceTerms termsHalf;
+		float afDecodedAlphasHalf[PIXELS / 2];
+		GatherHalf(a_phalf->m_pauiPixelMapping, &termsHalf, afDecodedAlphasHalf);
+
 		a_phalf->m_ptryBest = nullptr;
 		float fBestTryError = FLT_MAX;
 
@@ -920,9 +907,7 @@ namespace Etc
 					for (unsigned int uiCW = 0; uiCW < CW_RANGES; uiCW++)
 					{
 						unsigned int auiPixelSelectors[PIXELS / 2];
-						ColorFloatRGBA	afrgbaDecodedPixels[PIXELS / 2];
-						float afPixelErrors[PIXELS / 2] = { FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX,
-															FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX };
+						float afPixelErrors[PIXELS / 2];
 
 						// pre-compute decoded pixels for each selector
 						ColorFloatRGBA afrgbaSelectors[SELECTORS];
@@ -932,29 +917,8 @@ namespace Etc
 						afrgbaSelectors[2] = (frgbaColor + s_aafCwTable[uiCW][2]).ClampRGB();
 						afrgbaSelectors[3] = (frgbaColor + s_aafCwTable[uiCW][3]).ClampRGB();
 
-						for (unsigned int uiPixel = 0; uiPixel < 8; uiPixel++)
-						{
-							ColorFloatRGBA *pfrgbaSourcePixel = &m_pafrgbaSource[a_phalf->m_pauiPixelMapping[uiPixel]];
-							ColorFloatRGBA frgbaDecodedPixel;
-
-							for (unsigned int uiSelector = 0; uiSelector < SELECTORS; uiSelector++)
-							{
-								frgbaDecodedPixel = afrgbaSelectors[uiSelector];
-
-								float fPixelError;
-
-								fPixelError = CalcPixelError(frgbaDecodedPixel, m_afDecodedAlphas[a_phalf->m_pauiPixelMapping[uiPixel]],
-										*pfrgbaSourcePixel);
-
-								if (fPixelError < afPixelErrors[uiPixel])
-								{
-									auiPixelSelectors[uiPixel] = uiSelector;
-									afrgbaDecodedPixels[uiPixel] = frgbaDecodedPixel;
-									afPixelErrors[uiPixel] = fPixelError;
-								}
-
-							}
-						}
+						m_perrorkernels->BestSelectors(termsHalf, afDecodedAlphasHalf, afrgbaSelectors,
+														auiPixelSelectors, afPixelErrors);
 
 						// add up all pixel errors
 						float fCWError = 0.0f;
@@ -20,7 +20,9 @@ EtcSortedBlockList.cpp
 SortedBlockList is a list of 4x4 blocks that can be used by the "effort" system to prioritize
 the encoding of the 4x4 blocks.
 
-The sorting is done with buckets, where each bucket is an indication of how much error each 4x4 block has
+The sorting is done with buckets, where each bucket is an indication of how much error each 4x4 block has.
+The buckets are laid out back to back in one array with a counting sort, worst bucket first, keeping the
+image order of the blocks within each bucket.
 
 */
 
@@ -49,180 +51,162 @@ namespace Etc
 
 		m_uiAddedBlocks = 0;
 		m_uiSortedBlocks = 0;
-		m_palinkPool = new Link[m_uiImageBlocks];
-		m_pabucket = new Bucket[m_iBuckets];
+		m_papblockAdded = new Block4x4 *[m_uiImageBlocks];
+		m_papblockSorted = new Block4x4 *[m_uiImageBlocks];
+		m_paiBucket = new int[m_uiImageBlocks];
+		m_pauiBucketBlocks = new unsigned int[m_iBuckets];
+		m_pauiBucketStart = new unsigned int[m_iBuckets];
 		m_fMaxError = 0.0f;
 
-		InitBuckets();
+		memset(m_pauiBucketBlocks, 0, m_iBuckets * sizeof(unsigned int));
 
+		m_uiTakeLimit = 0;
+		m_uiTakeNext = 0;
 	}
 
 	// ----------------------------------------------------------------------------------------------------
 	//
 	SortedBlockList::~SortedBlockList(void)
 	{
-		delete[] m_palinkPool;
-		delete[] m_pabucket;
+		delete[] m_papblockAdded;
+		delete[] m_papblockSorted;
+		delete[] m_paiBucket;
+		delete[] m_pauiBucketBlocks;
+		delete[] m_pauiBucketStart;
 	}
 
 	// ----------------------------------------------------------------------------------------------------
-    // add a 4x4 block to the list
+	// add a 4x4 block to the list
 	// the 4x4 block will be sorted later
 	//
-    void SortedBlockList::AddBlock(Block4x4 *a_pblock)
-    {
-        assert(m_uiAddedBlocks < m_uiImageBlocks);
-        Link *plink = &m_palinkPool[m_uiAddedBlocks++];
-		plink->Init(a_pblock);
-    }
+	void SortedBlockList::AddBlock(Block4x4 *a_pblock)
+	{
+		assert(m_uiAddedBlocks < m_uiImageBlocks);
+		m_papblockAdded[m_uiAddedBlocks++] = a_pblock;
+	}
 
 	// ----------------------------------------------------------------------------------------------------
 	// sort all of the 4x4 blocks that have been added to the list
 	//
 	// first, determine the maximum error, then assign an error range to each bucket
-	// next, determine which bucket each 4x4 block belongs to based on the 4x4 block's error
-	// add the 4x4 block to the appropriate bucket
-	// lastly, walk thru the buckets and add each bucket to a sorted linked list
+	// next, determine which bucket each 4x4 block belongs to based on the 4x4 block's error and count
+	// the blocks of each bucket
+	// lastly, give every bucket its range of the sorted array, worst first, and place the blocks
 	//
 	// the resultant sorting is an approximate sorting from most to least error
 	//
-    void SortedBlockList::Sort(void)
-    {
+	void SortedBlockList::Sort(void)
+	{
 		assert(m_uiAddedBlocks == m_uiImageBlocks);
-        InitBuckets();
-
-        // find max block error
-        m_fMaxError = -1.0f;
-
-        for (unsigned int uiLink = 0; uiLink < m_uiAddedBlocks; uiLink++)
-        {
-            Link *plinkBlock = &m_palinkPool[uiLink];
-
-            float fBlockError = plinkBlock->GetBlock()->GetError();
-            if (fBlockError > m_fMaxError)
-            {
-                m_fMaxError = fBlockError;
-            }
-        }
-        // prevent divide by zero or divide by negative
-        if (m_fMaxError <= 0.0f)
-        {
-            m_fMaxError = 1.0f;
-        }
-		//used for debugging
-		//int numDone = 0;
-        // put all of the blocks with unfinished encodings into the appropriate bucket
-		m_uiSortedBlocks = 0;
-        for (unsigned int uiLink = 0; uiLink < m_uiAddedBlocks; uiLink++)
-        {
-            Link *plinkBlock = &m_palinkPool[uiLink];
 
-			// if the encoding is done, don't add it to the list
-			if (plinkBlock->GetBlock()->GetEncoding()->IsDone())
+		// find max block error
+		m_fMaxError = -1.0f;
+
+		for (unsigned int uiBlock = 0; uiBlock < m_uiAddedBlocks; uiBlock++)
+		{
+			float fBlockError = m_papblockAdded[uiBlock]->GetError();
+			if (fBlockError > m_fMaxError)
 			{
-				//numDone++;
-				continue;
+				m_fMaxError = fBlockError;
 			}
+		}
+		// prevent divide by zero or divide by negative
+		if (m_fMaxError <= 0.0f)
+		{
+			m_fMaxError = 1.0f;
+		}
 
-            // calculate the appropriate sort bucket
-            float fBlockError = plinkBlock->GetBlock()->GetError();
-            int iBucket = (int) floorf(m_iBuckets * fBlockError / m_fMaxError);
-            // clamp to bucket index
-            iBucket = iBucket < 0 ? 0 : iBucket >= m_iBuckets ? m_iBuckets - 1 : iBucket;
+		memset(m_pauiBucketBlocks, 0, m_iBuckets * sizeof(unsigned int));
 
-            // add block to bucket
+		// bucket all of the blocks with unfinished encodings
+		m_uiSortedBlocks = 0;
+		for (unsigned int uiBlock = 0; uiBlock < m_uiAddedBlocks; uiBlock++)
+		{
+			Block4x4 *pblock = m_papblockAdded[uiBlock];
+
+			// if the encoding is done, don't add it to the list
+			if (pblock->GetEncoding()->IsDone())
 			{
-				Bucket *pbucket = &m_pabucket[iBucket];
-				if (pbucket->plinkLast)
-				{
-					pbucket->plinkLast->SetNext(plinkBlock);
-					pbucket->plinkLast = plinkBlock;
-				}
-				else
-				{
-					pbucket->plinkFirst = pbucket->plinkLast = plinkBlock;
-				}
-				plinkBlock->SetNext(nullptr);
+				m_paiBucket[uiBlock] = -1;
+				continue;
 			}
 
+			// calculate the appropriate sort bucket
+			float fBlockError = pblock->GetError();
+			int iBucket = (int) floorf(m_iBuckets * fBlockError / m_fMaxError);
+			// clamp to bucket index
+			iBucket = iBucket < 0 ? 0 : iBucket >= m_iBuckets ? m_iBuckets - 1 : iBucket;
+
+			m_paiBucket[uiBlock] = iBucket;
+			m_pauiBucketBlocks[iBucket]++;
 			m_uiSortedBlocks++;
+		}
 
-            if (0)
-            {
-                printf("%u: e=%.3f\n", uiLink, fBlockError);
-                Print();
-                printf("\n\n\n");
-            }
-        }
-		//printf("num blocks already done: %d\n",numDone);
-		//link the blocks together across buckets
-		m_plinkFirst = nullptr;
-		m_plinkLast = nullptr;
+		// start of each bucket in the sorted array, the worst bucket first
+		unsigned int uiStart = 0;
 		for (int iBucket = m_iBuckets - 1; iBucket >= 0; iBucket--)
 		{
-			Bucket *pbucket = &m_pabucket[iBucket];
+			m_pauiBucketStart[iBucket] = uiStart;
+			uiStart += m_pauiBucketBlocks[iBucket];
+		}
 
-			if (pbucket->plinkFirst)
+		for (unsigned int uiBlock = 0; uiBlock < m_uiAddedBlocks; uiBlock++)
+		{
+			int iBucket = m_paiBucket[uiBlock];
+			if (iBucket >= 0)
 			{
-				if (m_plinkFirst == nullptr)
-				{
-					m_plinkFirst = pbucket->plinkFirst;
-				}
-				else
-				{
-					assert(pbucket->plinkLast->GetNext() == nullptr);
-					m_plinkLast->SetNext(pbucket->plinkFirst);
-				}
-
-				m_plinkLast = pbucket->plinkLast;
+				m_papblockSorted[m_pauiBucketStart[iBucket]++] = m_papblockAdded[uiBlock];
 			}
 		}
 
+		m_uiTakeLimit = 0;
+		m_uiTakeNext = 0;
+	}
 
+	// ----------------------------------------------------------------------------------------------------
+	// prepare to hand out the worst a_uiMaxBlocks blocks of the last sort
+	// must not overlap with TakeBlocks calls
+	//
+	void SortedBlockList::StartTaking(unsigned int a_uiMaxBlocks)
+	{
+		m_uiTakeLimit = a_uiMaxBlocks < m_uiSortedBlocks ? a_uiMaxBlocks : m_uiSortedBlocks;
+		m_uiTakeNext = 0;
 	}
 
 	// ----------------------------------------------------------------------------------------------------
-	// clear all of the buckets.  normally done in preparation for a sort
+	// claim the next chunk of blocks
+	// a relaxed counter is enough, each index is handed out exactly once and the blocks are only
+	// written by the thread that claimed them
 	//
-	void SortedBlockList::InitBuckets(void)
-    {
-        for (int iBucket = 0; iBucket < m_iBuckets; iBucket++)
-        {
-            Bucket *pbucket = &m_pabucket[iBucket];
-
-            pbucket->plinkFirst = 0;
-            pbucket->plinkLast = 0;
-        }
-    }
-
-    // ----------------------------------------------------------------------------------------------------
-    // print out the list of sorted 4x4 blocks
+	Block4x4 * const * SortedBlockList::TakeBlocks(unsigned int a_uiMaxCount, unsigned int *a_puiCount)
+	{
+		unsigned int uiFirst = m_uiTakeNext.fetch_add(a_uiMaxCount, std::memory_order_relaxed);
+		if (uiFirst >= m_uiTakeLimit)
+		{
+			*a_puiCount = 0;
+			return nullptr;
+		}
+
+		unsigned int uiLeft = m_uiTakeLimit - uiFirst;
+		*a_puiCount = uiLeft < a_uiMaxCount ? uiLeft : a_uiMaxCount;
+		return &m_papblockSorted[uiFirst];
+	}
+
+	// ----------------------------------------------------------------------------------------------------
+	// print out the number of sorted 4x4 blocks per bucket
 	// normally used for debugging
 	//
-    void SortedBlockList::Print(void)
-    {
-        for (int iBucket = m_iBuckets-1; iBucket >= 0; iBucket--)
-        {
-            Bucket *pbucket = &m_pabucket[iBucket];
-
-            unsigned int uiBlocks = 0;
-            for (Link *plink = pbucket->plinkFirst; plink != nullptr; plink = plink->GetNext() )
-            {
-                uiBlocks++;
-
-				if (plink == pbucket->plinkLast)
-				{
-					break;
-				}
-            }
-
-            float fBucketError = m_fMaxError * iBucket / m_iBuckets;
-            float fBucketRMS = sqrtf(fBucketError / (4.0f*16.0f) );
-            printf("%3d: e=%.3f rms=%.6f %u\n", iBucket, fBucketError, fBucketRMS, uiBlocks);
-        }
-    }
-
-    // ----------------------------------------------------------------------------------------------------
-    //
+	void SortedBlockList::Print(void)
+	{
+		for (int iBucket = m_iBuckets-1; iBucket >= 0; iBucket--)
+		{
+			float fBucketError = m_fMaxError * iBucket / m_iBuckets;
+			float fBucketRMS = sqrtf(fBucketError / (4.0f*16.0f) );
+			printf("%3d: e=%.3f rms=%.6f %u\n", iBucket, fBucketError, fBucketRMS, m_pauiBucketBlocks[iBucket]);
+		}
+	}
+
+	// ----------------------------------------------------------------------------------------------------
+	//
 
 }   // namespace Etc
@@ -16,73 +16,31 @@
 
 #pragma once
 
+#include <atomic>
+
 namespace Etc
 {
 	class Block4x4;
 
-    class SortedBlockList
-    {
-    public:
-
-		class Link
-		{
-		public:
-
-			inline void Init(Block4x4 *a_pblock)
-			{
-				m_pblock = a_pblock;
-				m_plinkNext = nullptr;
-			}
-
-			inline Block4x4 * GetBlock(void)
-			{
-				return m_pblock;
-			}
-
-			inline void SetNext(Link *a_plinkNext)
-			{
-				m_plinkNext = a_plinkNext;
-			}
-
-			inline Link * GetNext(void)
-			{
-				return m_plinkNext;
-			}
-
-			inline Link * Advance(unsigned int a_uiSteps = 1)
-			{
-				Link *plink = this;
-
-				for (unsigned int uiStep = 0; uiStep < a_uiSteps; uiStep++)
-				{
-					if (plink == nullptr)
-					{
-						break;
-					}
-
-					plink = plink->m_plinkNext;
-				}
-
-				return plink;
-			}
-
-		private:
-
-			Block4x4 *m_pblock;
-			Link *m_plinkNext;
-		};
+	// the image's 4x4 blocks ordered from most to least error in one contiguous array
+	// workers of an effort pass take chunks of the worst blocks from a shared cursor
+	class SortedBlockList
+	{
+	public:
 
 		SortedBlockList(unsigned int a_uiImageBlocks, unsigned int a_uiBuckets);
 		~SortedBlockList(void);
 
-        void AddBlock(Block4x4 *a_pblock);
+		void AddBlock(Block4x4 *a_pblock);
 
-        void Sort(void);
+		void Sort(void);
 
-		inline Link * GetLinkToFirstBlock(void)
-		{
-			return m_plinkFirst;
-		}
+		// hand out the first a_uiMaxBlocks sorted blocks through TakeBlocks
+		void StartTaking(unsigned int a_uiMaxBlocks);
+
+		// the next up to a_uiMaxCount blocks, nullptr once all blocks of the pass were taken
+		// safe to call from several threads
+		Block4x4 * const * TakeBlocks(unsigned int a_uiMaxCount, unsigned int *a_puiCount);
 
 		inline unsigned int GetNumberOfAddedBlocks(void)
 		{
@@ -98,27 +56,24 @@ namespace Etc
 
 	private:
 
-        void InitBuckets(void);
-
-        class Bucket
-        {
-        public:
-            Link *plinkFirst;
-            Link *plinkLast;
-        };
-
-        unsigned int m_uiImageBlocks;
-        int m_iBuckets;
+		unsigned int m_uiImageBlocks;
+		int m_iBuckets;
 
 		unsigned int m_uiAddedBlocks;
 		unsigned int m_uiSortedBlocks;
-		Link *m_palinkPool;
-        Bucket *m_pabucket;
-        float m_fMaxError;
-
-		Link *m_plinkFirst;
-		Link *m_plinkLast;
-
-    };
+		Block4x4 **m_papblockAdded;
+		Block4x4 **m_papblockSorted;
+		// per added block, its bucket or -1 when its encoding is done
+		int *m_paiBucket;
+		// blocks per bucket in the last sort
+		unsigned int *m_pauiBucketBlocks;
+		// where the next block of each bucket goes while sorting
+		unsigned int *m_pauiBucketStart;
+		float m_fMaxError;
+
+		unsigned int m_uiTakeLimit;
+		std::atomic<unsigned int> m_uiTakeNext;
+
+	};
 
 } // namespace Etc
@@ -787,6 +787,15 @@ unsigned lodepng_deflate(unsigned char** out, size_t* outsize,
                          const unsigned char* in, size_t insize,
                          const LodePNGCompressSettings* settings);
 
+/*
+Compress one part of a larger deflate stream. If last is 0, no block is marked final and the
+output ends byte aligned (with an empty stored block), so the next part can be appended directly.
+Back-references do not cross parts.
+*/
+unsigned lodepng_deflate_part(unsigned char** out, size_t* outsize,
+                              const unsigned char* in, size_t insize,
+                              const LodePNGCompressSettings* settings, unsigned last);
+
 #endif /*LODEPNG_COMPILE_ENCODER*/
 #endif /*LODEPNG_COMPILE_ZLIB*/
 
@@ -1,6 +1,8 @@
 #include "astcDecoder.h"
 #include <math.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 #include "color.h"
 #include "fp16.h"
 
@@ -192,9 +194,28 @@ typedef struct {
     int endpoint_value_num;
     int endpoints[4][8];
     int weights[144][2];
-    int partition[144];
+    const uint8_t *partition;
 } BlockData;
 
+// Bilinear infill of one weight grid texel: index of the top-left grid weight and the w00, w01, w10,
+// w11 factors
+typedef struct {
+    uint8_t index;
+    uint8_t factors[4];
+} InfillTexel;
+
+// Per-footprint tables shared by every block of an image. Infill depends only on the weight grid size
+// and partition maps only on the partition count and seed, so each is built the first time a block
+// uses it.
+typedef struct {
+    int bw;
+    int bh;
+    uint8_t infill_ready[11][11];
+    InfillTexel infill[11][11][144];
+    uint8_t partition_ready[3][1024];
+    uint8_t partitions[3][1024][144];
+} DecodeContext;
+
 typedef struct {
     int bits;
     int nonbits;
@@ -317,7 +338,9 @@ void decode_intseq(const uint8_t *buf, int offset, const int a, const int b, con
     }
 }
 
-void decode_block_params(const uint8_t *buf, BlockData *block_data) {
+// 0 for a block the spec calls illegal (grid larger than the footprint, over 64 weights, weight bits
+// outside 24..96, no endpoint range that fits), which decodes to the error colour
+int decode_block_params(const uint8_t *buf, BlockData *block_data) {
     block_data->dual_plane = !!(buf[1] & 4);
     block_data->weight_range = (buf[0] >> 4 & 1) | (buf[1] << 2 & 8);
 
@@ -390,6 +413,9 @@ void decode_block_params(const uint8_t *buf, BlockData *block_data) {
     default:
         weight_bits = block_data->weight_num * WeightPrecTableB[block_data->weight_range];
     }
+    if (block_data->width > block_data->bw || block_data->height > block_data->bh || block_data->weight_num > 64 ||
+        weight_bits < 24 || weight_bits > 96)
+        return 0;
 
     if (block_data->part_num == 1) {
         block_data->cem[0] = u8ptr_to_u16(buf + 1) >> 5 & 0xf;
@@ -452,9 +478,10 @@ void decode_block_params(const uint8_t *buf, BlockData *block_data) {
 
         if (endpoint_bits <= remain_bits) {
             block_data->cem_range = i;
-            break;
+            return 1;
         }
     }
+    return 0;
 }
 
 void decode_endpoints_hdr7(int *endpoints, int *v) {
@@ -878,7 +905,33 @@ void decode_endpoints(const uint8_t *buf, BlockData *data) {
     }
 }
 
-void decode_weights(const uint8_t *buf, BlockData *data) {
+const InfillTexel *infill_table(DecodeContext *ctx, const int width, const int height) {
+    InfillTexel *table = ctx->infill[width - 2][height - 2];
+    if (ctx->infill_ready[width - 2][height - 2])
+        return table;
+
+    int ds = (1024 + ctx->bw / 2) / (ctx->bw - 1);
+    int dt = (1024 + ctx->bh / 2) / (ctx->bh - 1);
+
+    for (int t = 0, i = 0; t < ctx->bh; t++) {
+        for (int s = 0; s < ctx->bw; s++, i++) {
+            int gs = (ds * s * (width - 1) + 32) >> 6;
+            int gt = (dt * t * (height - 1) + 32) >> 6;
+            int fs = gs & 0xf;
+            int ft = gt & 0xf;
+            int w11 = (fs * ft + 8) >> 4;
+            table[i].index = (gs >> 4) + (gt >> 4) * width;
+            table[i].factors[0] = 16 - fs - ft + w11;
+            table[i].factors[1] = fs - w11;
+            table[i].factors[2] = ft - w11;
+            table[i].factors[3] = w11;
+        }
+    }
+    ctx->infill_ready[width - 2][height - 2] = 1;
+    return table;
+}
+
+void decode_weights(const uint8_t *buf, BlockData *data, DecodeContext *ctx) {
     IntSeqData seq[128];
     int wv[128] = {};
     decode_intseq(buf, 128, WeightPrecTableA[data->weight_range], WeightPrecTableB[data->weight_range],
@@ -956,36 +1009,39 @@ void decode_weights(const uint8_t *buf, BlockData *data) {
         }
     }
 
-    int ds = (1024 + data->bw / 2) / (data->bw - 1);
-    int dt = (1024 + data->bh / 2) / (data->bh - 1);
-    int pn = data->dual_plane ? 2 : 1;
-
-    for (int t = 0, i = 0; t < data->bh; t++) {
-        for (int s = 0; s < data->bw; s++, i++) {
-            int gs = (ds * s * (data->width - 1) + 32) >> 6;
-            int gt = (dt * t * (data->height - 1) + 32) >> 6;
-            int fs = gs & 0xf;
-            int ft = gt & 0xf;
-            int v = (gs >> 4) + (gt >> 4) * data->width;
-            int w11 = (fs * ft + 8) >> 4;
-            int w10 = ft - w11;
-            int w01 = fs - w11;
-            int w00 = 16 - fs - ft + w11;
-
-            for (int p = 0; p < pn; p++) {
-                int p00 = wv[v * pn + p];
-                int p01 = wv[(v + 1) * pn + p];
-                int p10 = wv[(v + data->width) * pn + p];
-                int p11 = wv[(v + data->width + 1) * pn + p];
-                data->weights[i][p] = (p00 * w00 + p01 * w01 + p10 * w10 + p11 * w11 + 8) >> 4;
+    const InfillTexel *infill = infill_table(ctx, data->width, data->height);
+    if (data->dual_plane) {
+        for (int i = 0; i < data->bw * data->bh; i++) {
+            const InfillTexel *t = &infill[i];
+            for (int p = 0; p < 2; p++) {
+                int p00 = wv[t->index * 2 + p];
+                int p01 = wv[(t->index + 1) * 2 + p];
+                int p10 = wv[(t->index + data->width) * 2 + p];
+                int p11 = wv[(t->index + data->width + 1) * 2 + p];
+                data->weights[i][p] =
+                  (p00 * t->factors[0] + p01 * t->factors[1] + p10 * t->factors[2] + p11 * t->factors[3] + 8) >> 4;
             }
         }
+    } else {
+        for (int i = 0; i < data->bw * data->bh; i++) {
+            const InfillTexel *t = &infill[i];
+            const int *v = wv + t->index;
+            data->weights[i][0] = (v[0] * t->factors[0] + v[1] * t->factors[1] + v[data->width] * t->factors[2] +
+                                   v[data->width + 1] * t->factors[3] + 8) >>
+                                  4;
+        }
     }
 }
 
-void select_partition(const uint8_t *buf, BlockData *data) {
+void select_partition(const uint8_t *buf, BlockData *data, DecodeContext *ctx) {
+    int index = *(int *)buf >> 13 & 0x3ff;
+    uint8_t *partition = ctx->partitions[data->part_num - 2][index];
+    data->partition = partition;
+    if (ctx->partition_ready[data->part_num - 2][index])
+        return;
+
     int small_block = data->bw * data->bh < 31;
-    int seed = (*(int *)buf >> 13 & 0x3ff) | (data->part_num - 1) << 10;
+    int seed = index | (data->part_num - 1) << 10;
 
     uint32_t rnum = seed;
     rnum ^= rnum >> 15;
@@ -1023,7 +1079,7 @@ void select_partition(const uint8_t *buf, BlockData *data) {
                 int b = (seeds[2] * x + seeds[3] * y + (rnum >> 10)) & 0x3f;
                 int c = data->part_num < 3 ? 0 : (seeds[4] * x + seeds[5] * y + (rnum >> 6)) & 0x3f;
                 int d = data->part_num < 4 ? 0 : (seeds[6] * x + seeds[7] * y + (rnum >> 2)) & 0x3f;
-                data->partition[i] = (a >= b && a >= c && a >= d) ? 0 : (b >= c && b >= d) ? 1 : (c >= d) ? 2 : 3;
+                partition[i] = (a >= b && a >= c && a >= d) ? 0 : (b >= c && b >= d) ? 1 : (c >= d) ? 2 : 3;
             }
         }
     } else {
@@ -1033,10 +1089,11 @@ void select_partition(const uint8_t *buf, BlockData *data) {
                 int b = (seeds[2] * x + seeds[3] * y + (rnum >> 10)) & 0x3f;
                 int c = data->part_num < 3 ? 0 : (seeds[4] * x + seeds[5] * y + (rnum >> 6)) & 0x3f;
                 int d = data->part_num < 4 ? 0 : (seeds[6] * x + seeds[7] * y + (rnum >> 2)) & 0x3f;
-                data->partition[i] = (a >= b && a >= c && a >= d) ? 0 : (b >= c && b >= d) ? 1 : (c >= d) ? 2 : 3;
+                partition[i] = (a >= b && a >= c && a >= d) ? 0 : (b >= c && b >= d) ? 1 : (c >= d) ? 2 : 3;
             }
         }
     }
+    ctx->partition_ready[data->part_num - 2][index] = 1;
 }
 
 void applicate_color(const BlockData *data, uint32_t *outbuf) {
@@ -1105,7 +1162,9 @@ void applicate_color(const BlockData *data, uint32_t *outbuf) {
     }
 }
 
-void decode_block(const uint8_t *buf, const int bw, const int bh, uint32_t *outbuf) {
+void decode_block(const uint8_t *buf, DecodeContext *ctx, uint32_t *outbuf) {
+    const int bw = ctx->bw;
+    const int bh = ctx->bh;
     if (buf[0] == 0xfc && (buf[1] & 1) == 1) {
         uint_fast32_t c;
         if (buf[1] & 2)
@@ -1114,33 +1173,56 @@ void decode_block(const uint8_t *buf, const int bw, const int bh, uint32_t *outb
             c = color(buf[9], buf[11], buf[13], buf[15]);
         for (int i = 0; i < bw * bh; i++)
             outbuf[i] = c;
-    } else if (((buf[0] & 0xc3) == 0xc0 && (buf[1] & 1) == 1) || (buf[0] & 0xf) == 0) {
-        uint_fast32_t c = color(255, 0, 255, 255);
-        for (int i = 0; i < bw * bh; i++)
-            outbuf[i] = c;
     } else {
         BlockData block_data;
         block_data.bw = bw;
         block_data.bh = bh;
-        decode_block_params(buf, &block_data);
+        if (((buf[0] & 0xc3) == 0xc0 && (buf[1] & 1) == 1) || (buf[0] & 0xf) == 0 ||
+            !decode_block_params(buf, &block_data)) {
+            uint_fast32_t c = color(255, 0, 255, 255);
+            for (int i = 0; i < bw * bh; i++)
+                outbuf[i] = c;
+            return;
+        }
         decode_endpoints(buf, &block_data);
-        decode_weights(buf, &block_data);
+        decode_weights(buf, &block_data, ctx);
         if (block_data.part_num > 1)
-            select_partition(buf, &block_data);
+            select_partition(buf, &block_data, ctx);
         applicate_color(&block_data, outbuf);
     }
 }
 
-int decode_astc(const uint8_t *data, const long w, const long h, const int bw, const int bh, uint32_t *image) {
+template<int Layout>
+static int decode_astc_image(const uint8_t *data, const long w, const long h, const int bw, const int bh,
+                             uint8_t *image) {
     const long num_blocks_x = (w + bw - 1) / bw;
     const long num_blocks_y = (h + bh - 1) / bh;
+    // only the ready flags need clearing, the tables are filled before first use
+    DecodeContext *ctx = (DecodeContext *)malloc(sizeof(DecodeContext));
+    if (!ctx)
+        return 0;
+    ctx->bw = bw;
+    ctx->bh = bh;
+    memset(ctx->infill_ready, 0, sizeof(ctx->infill_ready));
+    memset(ctx->partition_ready, 0, sizeof(ctx->partition_ready));
+
     uint32_t buffer[144];
     const uint8_t *d = data;
     for (long by = 0; by < num_blocks_y; by++) {
         for (long bx = 0; bx < num_blocks_x; bx++, d += 16) {
-            decode_block(d, bw, bh, buffer);
-            copy_block_buffer(bx, by, w, h, bw, bh, buffer, image);
+            decode_block(d, ctx, buffer);
+            copy_block_buffer_as<Layout>(bx, by, w, h, bw, bh, buffer, image);
         }
     }
+    free(ctx);
     return 1;
 }
+
+int decode_astc(const uint8_t *data, const long w, const long h, const int bw, const int bh, uint32_t *image) {
+    return decode_astc_image<LAYOUT_BGRA>(data, w, h, bw, bh, (uint8_t *)image);
+}
+
+int decode_astc_as(const uint8_t *data, const long w, const long h, const int bw, const int bh, int layout,
+                   uint8_t *image) {
+    DECODE_WITH_LAYOUT(decode_astc_image, layout, data, w, h, bw, bh, image)
+}
@@ -4,5 +4,7 @@
 #include <stdint.h>
 
 int decode_astc(const uint8_t *, const long, const long, const int, const int, uint32_t *);
+// layout is one of the LAYOUT_* values in color.h
+int decode_astc_as(const uint8_t *, const long, const long, const int, const int, int, uint8_t *);
 
 #endif /* end of include guard: ASTC_H */
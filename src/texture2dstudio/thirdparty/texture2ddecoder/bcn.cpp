@@ -4,42 +4,151 @@
 #include <algorithm>
 #include "color.h"
 #include "fp16.h"
+#include "simd.h"
+
+// Blocks are decoded through a kernel class picked once from simd_level():
+//   colors(c0, c1, c2, c3, d, outbuf)
+//                                    - BC1: 16 2-bit indices of d into the 4-colour palette
+//   channel(a, d, channel, outbuf)   - BC3/4/5 alpha: 16 3-bit indices of d into the 8 bytes of a,
+//                                      written to byte `channel` of each texel
+//   bc7(ep0, ep1, subset, wc, wa, rotation, outbuf)
+//                                    - BC7: per texel endpoints ep0/ep1[subset] interpolated with the
+//                                      colour and alpha weights wc/wa (0..64), then the rotation swap
+
+// the other decoders have kernels of the same names, so these stay local to the file
+namespace {
+
+struct ScalarKernel {
+	static void colors(uint32_t c0, uint32_t c1, uint32_t c2, uint32_t c3, uint_fast32_t d, uint32_t* outbuf) {
+		const uint32_t c[4] = { c0, c1, c2, c3 };
+		for (int i = 0; i < 16; i++, d >>= 2)
+			outbuf[i] = c[d & 3];
+	}
+
+	static void channel(uint64_t a, uint_fast64_t d, int channel, uint32_t* outbuf) {
+		uint8_t* dst = (uint8_t*)outbuf;
+		for (int i = 0; i < 16; i++, d >>= 3)
+			dst[i * 4 + channel] = uint8_t(a >> (d & 7) * 8);
+	}
+
+	static void bc7(const uint32_t* ep0, const uint32_t* ep1, const uint8_t* subset, const uint8_t* wc,
+		const uint8_t* wa, int rotation, uint32_t* outbuf) {
+		for (int i = 0; i < 16; i++) {
+			const uint8_t* e0 = (const uint8_t*)(ep0 + subset[i]);
+			const uint8_t* e1 = (const uint8_t*)(ep1 + subset[i]);
+			uint8_t* dst = (uint8_t*)(outbuf + i);
+			for (int c = 0; c < 4; c++) {
+				const uint8_t w = c == 3 ? wa[i] : wc[i];
+				dst[c] = uint8_t(uint16_t(e0[c] * (64 - w) + e1[c] * w + 32) >> 6);
+			}
+			if (rotation)
+				std::swap(dst[3], dst[3 - rotation]);
+		}
+	}
+};
+
+#if defined(TEXTURE2D_SIMD_X86)
+
+struct Sse41Kernel {
+	SIMD_TARGET_SSE41 static void colors(uint32_t c0, uint32_t c1, uint32_t c2, uint32_t c3, uint_fast32_t d,
+		uint32_t* outbuf) {
+		const __m128i palette = _mm_setr_epi32((int)c0, (int)c1, (int)c2, (int)c3);
+		const __m128i vd = _mm_set1_epi32((int)d);
+		const __m128i bytes = _mm_set1_epi32(0x03020100);
+		__m128i lsb = _mm_setr_epi32(1, 1 << 2, 1 << 4, 1 << 6);
+		for (int y = 0; y < 4; y++, lsb = _mm_slli_epi32(lsb, 8)) {
+			const __m128i msb = _mm_add_epi32(lsb, lsb);
+			// pshufb control of entry (msb << 1 | lsb): byte offset 8 * msb + 4 * lsb
+			__m128i ctrl = _mm_and_si128(_mm_cmpeq_epi32(_mm_and_si128(vd, lsb), lsb), _mm_set1_epi32(0x04040404));
+			ctrl = _mm_or_si128(ctrl, _mm_and_si128(_mm_cmpeq_epi32(_mm_and_si128(vd, msb), msb),
+				_mm_set1_epi32(0x08080808)));
+			_mm_storeu_si128((__m128i*)(outbuf + y * 4), _mm_shuffle_epi8(palette, _mm_or_si128(ctrl, bytes)));
+		}
+	}
+
+	SIMD_TARGET_SSE41 static void channel(uint64_t a, uint_fast64_t d, int channel, uint32_t* outbuf) {
+		simd_store_channel(_mm_shuffle_epi8(_mm_set_epi64x(0, (long long)a), simd_spread_indices3(d)), channel, outbuf);
+	}
+
+	SIMD_TARGET_SSE41 static void bc7(const uint32_t* ep0, const uint32_t* ep1, const uint8_t* subset,
+		const uint8_t* wc, const uint8_t* wa, int rotation, uint32_t* outbuf) {
+		const __m128i e0 = _mm_loadu_si128((const __m128i*)ep0);
+		const __m128i e1 = _mm_loadu_si128((const __m128i*)ep1);
+		const __m128i subsets = _mm_loadu_si128((const __m128i*)subset);
+		const __m128i colorWeights = _mm_loadu_si128((const __m128i*)wc);
+		const __m128i alphaWeights = _mm_loadu_si128((const __m128i*)wa);
+		const __m128i alphaBytes = _mm_set1_epi32((int)0xff000000);
+		const __m128i bytes = _mm_set1_epi32(0x03020100);
+		const __m128i sixtyFour = _mm_set1_epi8(64);
+		const __m128i round = _mm_set1_epi16(32);
+		// byte swap of the rotation (alpha with red, green or blue)
+		static const int8_t rotations[4][16] = {
+			{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+			{ 0, 1, 3, 2, 4, 5, 7, 6, 8, 9, 11, 10, 12, 13, 15, 14 },
+			{ 0, 3, 2, 1, 4, 7, 6, 5, 8, 11, 10, 9, 12, 15, 14, 13 },
+			{ 3, 1, 2, 0, 7, 5, 6, 4, 11, 9, 10, 8, 15, 13, 14, 12 },
+		};
+		const __m128i rotate = _mm_loadu_si128((const __m128i*)rotations[rotation]);
+		__m128i texel = _mm_setr_epi8(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3);
+		for (int i = 0; i < 16; i += 4, texel = _mm_add_epi8(texel, _mm_set1_epi8(4))) {
+			// per byte: the texel's subset endpoint bytes and its weight (alpha byte takes wa)
+			__m128i ctrl = _mm_shuffle_epi8(subsets, texel);
+			ctrl = _mm_or_si128(_mm_add_epi8(_mm_add_epi8(ctrl, ctrl), _mm_add_epi8(ctrl, ctrl)), bytes);
+			const __m128i a = _mm_shuffle_epi8(e0, ctrl);
+			const __m128i b = _mm_shuffle_epi8(e1, ctrl);
+			const __m128i w = _mm_blendv_epi8(_mm_shuffle_epi8(colorWeights, texel),
+				_mm_shuffle_epi8(alphaWeights, texel), alphaBytes);
+			const __m128i iw = _mm_sub_epi8(sixtyFour, w);
+			// a * (64 - w) + b * w per channel, weights fit signed bytes
+			__m128i lo = _mm_maddubs_epi16(_mm_unpacklo_epi8(a, b), _mm_unpacklo_epi8(iw, w));
+			__m128i hi = _mm_maddubs_epi16(_mm_unpackhi_epi8(a, b), _mm_unpackhi_epi8(iw, w));
+			lo = _mm_srli_epi16(_mm_add_epi16(lo, round), 6);
+			hi = _mm_srli_epi16(_mm_add_epi16(hi, round), 6);
+			_mm_storeu_si128((__m128i*)(outbuf + i), _mm_shuffle_epi8(_mm_packus_epi16(lo, hi), rotate));
+		}
+	}
+};
+
+struct Avx2Kernel : Sse41Kernel {
+	SIMD_TARGET_AVX2 static void colors(uint32_t c0, uint32_t c1, uint32_t c2, uint32_t c3, uint_fast32_t d,
+		uint32_t* outbuf) {
+		const __m256i palette = _mm256_broadcastsi128_si256(_mm_setr_epi32((int)c0, (int)c1, (int)c2, (int)c3));
+		const __m256i vd = _mm256_set1_epi32((int)d);
+		const __m256i three = _mm256_set1_epi32(3);
+		const __m256i lo = _mm256_and_si256(_mm256_srlv_epi32(vd, _mm256_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14)), three);
+		const __m256i hi = _mm256_and_si256(_mm256_srlv_epi32(vd, _mm256_setr_epi32(16, 18, 20, 22, 24, 26, 28, 30)), three);
+		_mm256_storeu_si256((__m256i*)outbuf, _mm256_permutevar8x32_epi32(palette, lo));
+		_mm256_storeu_si256((__m256i*)(outbuf + 8), _mm256_permutevar8x32_epi32(palette, hi));
+	}
+};
+
+#endif
 
+}  // namespace
+
+template<class Kernel>
 static inline void decode_bc1_block(const uint8_t* data, uint32_t* outbuf) {
 	uint8_t r0, g0, b0, r1, g1, b1;
 	int q0 = *(uint16_t*)(data);
 	int q1 = *(uint16_t*)(data + 2);
 	rgb565_le(q0, &r0, &g0, &b0);
 	rgb565_le(q1, &r1, &g1, &b1);
-	uint_fast32_t c[4] = { color(r0, g0, b0, 255), color(r1, g1, b1, 255) };
+	const uint32_t c0 = color(r0, g0, b0, 255);
+	const uint32_t c1 = color(r1, g1, b1, 255);
+	uint32_t c2, c3;
 	if (q0 > q1) {
-		c[2] = color((r0 * 2 + r1) / 3, (g0 * 2 + g1) / 3, (b0 * 2 + b1) / 3, 255);
-		c[3] = color((r0 + r1 * 2) / 3, (g0 + g1 * 2) / 3, (b0 + b1 * 2) / 3, 255);
+		c2 = color((r0 * 2 + r1) / 3, (g0 * 2 + g1) / 3, (b0 * 2 + b1) / 3, 255);
+		c3 = color((r0 + r1 * 2) / 3, (g0 + g1 * 2) / 3, (b0 + b1 * 2) / 3, 255);
 	}
 	else {
-		c[2] = color((r0 + r1) / 2, (g0 + g1) / 2, (b0 + b1) / 2, 255);
-		c[3] = color(0, 0, 0, 255);
+		c2 = color((r0 + r1) / 2, (g0 + g1) / 2, (b0 + b1) / 2, 255);
+		c3 = color(0, 0, 0, 255);
 	}
-	uint_fast32_t d = lton32(*(uint32_t*)(data + 4));
-	for (int i = 0; i < 16; i++, d >>= 2)
-		outbuf[i] = c[d & 3];
+	Kernel::colors(c0, c1, c2, c3, lton32(*(uint32_t*)(data + 4)), outbuf);
 }
 
-int decode_bc1(const uint8_t* data, const long w, const long h, uint32_t* image) {
-	long num_blocks_x = (w + 3) / 4;
-	long num_blocks_y = (h + 3) / 4;
-	uint32_t buffer[16];
-	const uint8_t* d = data;
-	for (long by = 0; by < num_blocks_y; by++) {
-		for (long bx = 0; bx < num_blocks_x; bx++, d += 8) {
-			decode_bc1_block(d, buffer);
-			copy_block_buffer(bx, by, w, h, 4, 4, buffer, image);
-		}
-	}
-	return 1;
-}
-
-void decode_bc3_alpha(const uint8_t* data, uint32_t* outbuf, int channel) {
+template<class Kernel>
+static void decode_bc3_alpha_block(const uint8_t* data, uint32_t* outbuf, int channel) {
 	uint_fast8_t a[8] = { data[0], data[1] };
 	if (a[0] > a[1]) {
 		a[2] = (a[0] * 6 + a[1]) / 7;
@@ -58,36 +167,101 @@ void decode_bc3_alpha(const uint8_t* data, uint32_t* outbuf, int channel) {
 		a[7] = 255;
 	}
 
-	uint8_t* dst = (uint8_t*)outbuf;
-	uint_fast64_t d = lton64(*(uint64_t*)data) >> 16;
-	for (int i = 0; i < 16; i++, d >>= 3)
-		dst[i * 4 + channel] = a[d & 7];
+	uint64_t palette = 0;
+	for (int i = 0; i < 8; i++)
+		palette |= (uint64_t)a[i] << 8 * i;
+	Kernel::channel(palette, lton64(*(uint64_t*)data) >> 16, channel, outbuf);
+}
+
+template<class Kernel>
+static void decode_bc7_block(const uint8_t* _src, uint32_t* _dst);
+
+struct BcBlockDecoders {
+	void (*bc1)(const uint8_t*, uint32_t*);
+	void (*alpha)(const uint8_t*, uint32_t*, int);
+	void (*bc7)(const uint8_t*, uint32_t*);
+};
+
+template<class Kernel>
+static BcBlockDecoders block_decoders() {
+	BcBlockDecoders decoders = { decode_bc1_block<Kernel>, decode_bc3_alpha_block<Kernel>, decode_bc7_block<Kernel> };
+	return decoders;
 }
 
-static inline void decode_bc3_block(const uint8_t* data, uint32_t* outbuf) {
-	decode_bc1_block(data + 8, outbuf);
-	decode_bc3_alpha(data, outbuf, 3);
+static BcBlockDecoders select_block_decoders() {
+#if defined(TEXTURE2D_SIMD_X86)
+	switch (simd_level()) {
+	case SIMD_AVX2:
+		return block_decoders<Avx2Kernel>();
+	case SIMD_SSE41:
+		return block_decoders<Sse41Kernel>();
+	default:
+		break;
+	}
+#endif
+	return block_decoders<ScalarKernel>();
 }
 
-int decode_bc3(const uint8_t* data, const long w, const long h, uint32_t* image) {
+static const BcBlockDecoders& bc_decoders() {
+	static const BcBlockDecoders decoders = select_block_decoders();
+	return decoders;
+}
+
+template<int Layout>
+static int decode_bc1_image(const uint8_t* data, const long w, const long h, uint8_t* image) {
+	long num_blocks_x = (w + 3) / 4;
+	long num_blocks_y = (h + 3) / 4;
+	uint32_t buffer[16];
+	const uint8_t* d = data;
+	void (*decode_block)(const uint8_t*, uint32_t*) = bc_decoders().bc1;
+	for (long by = 0; by < num_blocks_y; by++) {
+		for (long bx = 0; bx < num_blocks_x; bx++, d += 8) {
+			decode_block(d, buffer);
+			copy_block_buffer_as<Layout>(bx, by, w, h, 4, 4, buffer, image);
+		}
+	}
+	return 1;
+}
+
+int decode_bc1(const uint8_t* data, const long w, const long h, uint32_t* image) {
+	return decode_bc1_image<LAYOUT_BGRA>(data, w, h, (uint8_t*)image);
+}
+
+int decode_bc1_as(const uint8_t* data, const long w, const long h, int layout, uint8_t* image) {
+	DECODE_WITH_LAYOUT(decode_bc1_image, layout, data, w, h, image)
+}
+
+void decode_bc3_alpha(const uint8_t* data, uint32_t* outbuf, int channel) {
+	bc_decoders().alpha(data, outbuf, channel);
+}
+
+template<int Layout>
+static int decode_bc3_image(const uint8_t* data, const long w, const long h, uint8_t* image) {
 	long num_blocks_x = (w + 3) / 4;
 	long num_blocks_y = (h + 3) / 4;
 	uint32_t buffer[16];
 	const uint8_t* d = data;
+	const BcBlockDecoders& decoders = bc_decoders();
 	for (long by = 0; by < num_blocks_y; by++) {
 		for (long bx = 0; bx < num_blocks_x; bx++, d += 16) {
-			decode_bc3_block(d, buffer);
-			copy_block_buffer(bx, by, w, h, 4, 4, buffer, image);
+			decoders.bc1(d + 8, buffer);
+			decoders.alpha(d, buffer, 3);
+			copy_block_buffer_as<Layout>(bx, by, w, h, 4, 4, buffer, image);
 		}
 	}
 	return 1;
 }
 
-static inline void decode_bc4_block(const uint8_t* data, uint32_t* outbuf) {
-	decode_bc3_alpha(data, outbuf, 2);
+int decode_bc3(const uint8_t* data, const long w, const long h, uint32_t* image) {
+	return decode_bc3_image<LAYOUT_BGRA>(data, w, h, (uint8_t*)image);
 }
 
-int decode_bc4(const uint8_t* data, uint32_t m_width, uint32_t m_height, uint32_t* image) {
+int decode_bc3_as(const uint8_t* data, const long w, const long h, int layout, uint8_t* image) {
+	DECODE_WITH_LAYOUT(decode_bc3_image, layout, data, w, h, image)
+}
+
+template<int Layout>
+static int decode_bc4_image(const uint8_t* data, uint32_t m_width, uint32_t m_height, uint8_t* image) {
 	uint32_t m_block_width = 4;
 	uint32_t m_block_height = 4;
 	uint32_t m_blocks_x = (m_width + m_block_width - 1) / m_block_width;
@@ -95,21 +269,26 @@ int decode_bc4(const uint8_t* data, uint32_t m_width, uint32_t m_height, uint32_
 	uint32_t buffer[16];
 	for (uint32_t i = 0; i < 16; i++)
 		buffer[i] = 0xff000000;
+	void (*decode_alpha)(const uint8_t*, uint32_t*, int) = bc_decoders().alpha;
 	for (uint32_t by = 0; by < m_blocks_y; by++) {
 		for (uint32_t bx = 0; bx < m_blocks_x; bx++, data += 8) {
-			decode_bc4_block(data, buffer);
-			copy_block_buffer(bx, by, m_width, m_height, m_block_width, m_block_height, buffer, image);
+			decode_alpha(data, buffer, 2);
+			copy_block_buffer_as<Layout>(bx, by, m_width, m_height, m_block_width, m_block_height, buffer, image);
 		}
 	}
 	return 1;
 }
 
-static inline void decode_bc5_block(const uint8_t* data, uint32_t* outbuf) {
-	decode_bc3_alpha(data, outbuf, 2);
-	decode_bc3_alpha(data + 8, outbuf, 1);
+int decode_bc4(const uint8_t* data, uint32_t m_width, uint32_t m_height, uint32_t* image) {
+	return decode_bc4_image<LAYOUT_BGRA>(data, m_width, m_height, (uint8_t*)image);
 }
 
-int decode_bc5(const uint8_t* data, uint32_t m_width, uint32_t m_height, uint32_t* image) {
+int decode_bc4_as(const uint8_t* data, uint32_t m_width, uint32_t m_height, int layout, uint8_t* image) {
+	DECODE_WITH_LAYOUT(decode_bc4_image, layout, data, m_width, m_height, image)
+}
+
+template<int Layout>
+static int decode_bc5_image(const uint8_t* data, uint32_t m_width, uint32_t m_height, uint8_t* image) {
 	uint32_t m_block_width = 4;
 	uint32_t m_block_height = 4;
 	uint32_t m_blocks_x = (m_width + m_block_width - 1) / m_block_width;
@@ -117,15 +296,25 @@ int decode_bc5(const uint8_t* data, uint32_t m_width, uint32_t m_height, uint32_
 	uint32_t buffer[16];
 	for (uint32_t i = 0; i < 16; i++)
 		buffer[i] = 0xff000000;
+	void (*decode_alpha)(const uint8_t*, uint32_t*, int) = bc_decoders().alpha;
 	for (uint32_t by = 0; by < m_blocks_y; by++) {
 		for (uint32_t bx = 0; bx < m_blocks_x; bx++, data += 16) {
-			decode_bc5_block(data, buffer);
-			copy_block_buffer(bx, by, m_width, m_height, m_block_width, m_block_height, buffer, image);
+			decode_alpha(data, buffer, 2);
+			decode_alpha(data + 8, buffer, 1);
+			copy_block_buffer_as<Layout>(bx, by, m_width, m_height, m_block_width, m_block_height, buffer, image);
 		}
 	}
 	return 1;
 }
 
+int decode_bc5(const uint8_t* data, uint32_t m_width, uint32_t m_height, uint32_t* image) {
+	return decode_bc5_image<LAYOUT_BGRA>(data, m_width, m_height, (uint8_t*)image);
+}
+
+int decode_bc5_as(const uint8_t* data, uint32_t m_width, uint32_t m_height, int layout, uint8_t* image) {
+	DECODE_WITH_LAYOUT(decode_bc5_image, layout, data, m_width, m_height, image)
+}
+
 struct BitReader
 {
 	BitReader(const uint8_t* _data, uint16_t _bitPos = 0)
@@ -791,7 +980,8 @@ static void decode_bc6_block(const uint8_t* _src, uint32_t* _dst, bool _signed)
 	}
 }
 
-int decode_bc6(const uint8_t* data, uint32_t m_width, uint32_t m_height, uint32_t* image) {
+template<int Layout>
+static int decode_bc6_image(const uint8_t* data, uint32_t m_width, uint32_t m_height, uint8_t* image) {
 	uint32_t m_block_width = 4;
 	uint32_t m_block_height = 4;
 	uint32_t m_blocks_x = (m_width + m_block_width - 1) / m_block_width;
@@ -800,12 +990,20 @@ int decode_bc6(const uint8_t* data, uint32_t m_width, uint32_t m_height, uint32_
 	for (uint32_t by = 0; by < m_blocks_y; by++) {
 		for (uint32_t bx = 0; bx < m_blocks_x; bx++, data += 16) {
 			decode_bc6_block(data, buffer, false);
-			copy_block_buffer(bx, by, m_width, m_height, m_block_width, m_block_height, buffer, image);
+			copy_block_buffer_as<Layout>(bx, by, m_width, m_height, m_block_width, m_block_height, buffer, image);
 		}
 	}
 	return 1;
 }
 
+int decode_bc6(const uint8_t* data, uint32_t m_width, uint32_t m_height, uint32_t* image) {
+	return decode_bc6_image<LAYOUT_BGRA>(data, m_width, m_height, (uint8_t*)image);
+}
+
+int decode_bc6_as(const uint8_t* data, uint32_t m_width, uint32_t m_height, int layout, uint8_t* image) {
+	DECODE_WITH_LAYOUT(decode_bc6_image, layout, data, m_width, m_height, image)
+}
+
 static const uint32_t s_bptcP3[] =
 { //  76543210     0000   1111   2222   3333   4444   5555   6666   7777
 	0xaa685050, // 0, 0,  1, 1,  0, 0,  1, 1,  0, 2,  2, 1,  2, 2,  2, 2
@@ -936,22 +1134,33 @@ static uint8_t expand_quantized(uint8_t v, int bits) {
 	return v | (v >> bits);
 }
 
-static void decode_bc7_block(const uint8_t* _src, uint32_t* _dst)
+// The 128-bit block as two little-endian words, read LSB first like BitReader
+struct Bc7Bits
 {
-	BitReader bit(_src);
+	uint64_t lo;
+	uint64_t hi;
+	uint16_t pos;
 
-	uint8_t mode = 0;
-	for (; mode < 8 && 0 == bit.read(1); ++mode)
+	// 64 bits starting at bit _pos (0 < _pos < 128)
+	uint64_t at(uint16_t _pos) const
 	{
+		return _pos >= 64 ? hi >> (_pos - 64) : lo >> _pos | hi << (64 - _pos);
 	}
 
-	if (mode == 8)
+	uint16_t read(uint8_t _numBits)
 	{
-		memset(_dst, 0, 16 * 4);
-		return;
+		const uint16_t value = uint16_t(at(pos) & ((1u << _numBits) - 1));
+		pos += _numBits;
+		return value;
 	}
+};
 
-	const Bc7ModeInfo& mi = s_bp7ModeInfo[mode];
+// One instantiation per mode, so the mode layout folds into constants and the endpoint and index loops
+// unroll; indices come from one 64-bit stream per index set instead of a peek per texel.
+template<int Mode, class Kernel>
+static void decode_bc7_mode(Bc7Bits& bit, uint32_t* _dst)
+{
+	const Bc7ModeInfo& mi = s_bp7ModeInfo[Mode];
 	const uint8_t modePBits = 0 != mi.endpointPBits
 		? mi.endpointPBits
 		: mi.sharedPBits
@@ -961,40 +1170,21 @@ static void decode_bc7_block(const uint8_t* _src, uint32_t* _dst)
 	const uint8_t rotationMode = uint8_t(bit.read(mi.rotationBits));
 	const uint8_t indexSelectionMode = uint8_t(bit.read(mi.indexSelectionBits));
 
-	uint8_t epR[6];
-	uint8_t epG[6];
-	uint8_t epB[6];
-	uint8_t epA[6];
-
-	for (uint8_t ii = 0; ii < mi.numSubsets; ++ii)
+	// ep[channel][subset * 2 + endpoint], channels r, g, b, a
+	uint8_t ep[4][6];
+	const int channels = mi.alphaBits ? 4 : 3;
+	for (int cc = 0; cc < channels; ++cc)
 	{
-		epR[ii * 2 + 0] = uint8_t(bit.read(mi.colorBits) << modePBits);
-		epR[ii * 2 + 1] = uint8_t(bit.read(mi.colorBits) << modePBits);
-	}
-
-	for (uint8_t ii = 0; ii < mi.numSubsets; ++ii)
-	{
-		epG[ii * 2 + 0] = uint8_t(bit.read(mi.colorBits) << modePBits);
-		epG[ii * 2 + 1] = uint8_t(bit.read(mi.colorBits) << modePBits);
-	}
-
-	for (uint8_t ii = 0; ii < mi.numSubsets; ++ii)
-	{
-		epB[ii * 2 + 0] = uint8_t(bit.read(mi.colorBits) << modePBits);
-		epB[ii * 2 + 1] = uint8_t(bit.read(mi.colorBits) << modePBits);
-	}
-
-	if (mi.alphaBits)
-	{
-		for (uint8_t ii = 0; ii < mi.numSubsets; ++ii)
+		const uint8_t bits = cc == 3 ? mi.alphaBits : mi.colorBits;
+		for (uint8_t ii = 0; ii < mi.numSubsets * 2; ++ii)
 		{
-			epA[ii * 2 + 0] = uint8_t(bit.read(mi.alphaBits) << modePBits);
-			epA[ii * 2 + 1] = uint8_t(bit.read(mi.alphaBits) << modePBits);
+			ep[cc][ii] = uint8_t(bit.read(bits) << modePBits);
 		}
 	}
-	else
+
+	if (!mi.alphaBits)
 	{
-		memset(epA, 0xff, 6);
+		memset(ep[3], 0xff, 6);
 	}
 
 	if (0 != modePBits)
@@ -1004,132 +1194,150 @@ static void decode_bc7_block(const uint8_t* _src, uint32_t* _dst)
 			const uint8_t pda = uint8_t(bit.read(modePBits));
 			const uint8_t pdb = uint8_t(0 == mi.sharedPBits ? bit.read(modePBits) : pda);
 
-			epR[ii * 2 + 0] |= pda;
-			epR[ii * 2 + 1] |= pdb;
-			epG[ii * 2 + 0] |= pda;
-			epG[ii * 2 + 1] |= pdb;
-			epB[ii * 2 + 0] |= pda;
-			epB[ii * 2 + 1] |= pdb;
-			epA[ii * 2 + 0] |= pda;
-			epA[ii * 2 + 1] |= pdb;
+			for (int cc = 0; cc < 4; ++cc)
+			{
+				ep[cc][ii * 2 + 0] |= pda;
+				ep[cc][ii * 2 + 1] |= pdb;
+			}
 		}
 	}
 
-	const uint8_t colorBits = mi.colorBits + modePBits;
-
-	for (uint8_t ii = 0; ii < mi.numSubsets; ++ii)
+	for (int cc = 0; cc < channels; ++cc)
 	{
-		epR[ii * 2 + 0] = expand_quantized(epR[ii * 2 + 0], colorBits);
-		epR[ii * 2 + 1] = expand_quantized(epR[ii * 2 + 1], colorBits);
-		epG[ii * 2 + 0] = expand_quantized(epG[ii * 2 + 0], colorBits);
-		epG[ii * 2 + 1] = expand_quantized(epG[ii * 2 + 1], colorBits);
-		epB[ii * 2 + 0] = expand_quantized(epB[ii * 2 + 0], colorBits);
-		epB[ii * 2 + 1] = expand_quantized(epB[ii * 2 + 1], colorBits);
+		const uint8_t bits = (cc == 3 ? mi.alphaBits : mi.colorBits) + modePBits;
+		for (uint8_t ii = 0; ii < mi.numSubsets * 2; ++ii)
+		{
+			ep[cc][ii] = expand_quantized(ep[cc][ii], bits);
+		}
 	}
 
-	if (mi.alphaBits)
+	uint32_t ep0[4] = {};
+	uint32_t ep1[4] = {};
+	for (uint8_t ii = 0; ii < mi.numSubsets; ++ii)
 	{
-		const uint8_t alphaBits = mi.alphaBits + modePBits;
-
-		for (uint8_t ii = 0; ii < mi.numSubsets; ++ii)
-		{
-			epA[ii * 2 + 0] = expand_quantized(epA[ii * 2 + 0], alphaBits);
-			epA[ii * 2 + 1] = expand_quantized(epA[ii * 2 + 1], alphaBits);
-		}
+		ep0[ii] = color(ep[0][ii * 2], ep[1][ii * 2], ep[2][ii * 2], ep[3][ii * 2]);
+		ep1[ii] = color(ep[0][ii * 2 + 1], ep[1][ii * 2 + 1], ep[2][ii * 2 + 1], ep[3][ii * 2 + 1]);
 	}
 
 	const bool hasIndexBits1 = 0 != mi.indexBits[1];
-
 	const uint8_t* factors[] =
 	{
-						s_bptcFactors[mi.indexBits[0] - 2],
-		hasIndexBits1 ? s_bptcFactors[mi.indexBits[1] - 2] : factors[0],
+		s_bptcFactors[mi.indexBits[0] - 2],
+		s_bptcFactors[(hasIndexBits1 ? mi.indexBits[1] : mi.indexBits[0]) - 2],
 	};
 
-	uint16_t offset[2] =
+	// the second index set (modes 4 and 5, one subset) follows the 16 * bits - 1 of the first
+	uint64_t stream[2] =
 	{
-		0,
-		uint16_t(mi.numSubsets * (16 * mi.indexBits[0] - 1)),
+		bit.at(bit.pos),
+		hasIndexBits1 ? bit.at(uint16_t(bit.pos + 16 * mi.indexBits[0] - 1)) : 0,
 	};
 
-	for (uint8_t yy = 0; yy < 4; ++yy)
+	uint8_t subset[16];
+	uint8_t wc[16];
+	uint8_t wa[16];
+	for (uint8_t idx = 0; idx < 16; ++idx)
 	{
-		for (uint8_t xx = 0; xx < 4; ++xx)
+		uint8_t subsetIndex = 0;
+		uint8_t indexAnchor = 0;
+		switch (mi.numSubsets)
 		{
-			const uint8_t idx = yy * 4 + xx;
-
-			uint8_t subsetIndex = 0;
-			uint8_t indexAnchor = 0;
-			switch (mi.numSubsets)
-			{
-			case 2:
-				subsetIndex = (s_bptcP2[partitionSetIdx] >> idx) & 1;
-				indexAnchor = 0 != subsetIndex ? s_bptcA2[partitionSetIdx] : 0;
-				break;
-
-			case 3:
-				subsetIndex = (s_bptcP3[partitionSetIdx] >> (2 * idx)) & 3;
-				indexAnchor = 0 != subsetIndex ? s_bptcA3[subsetIndex - 1][partitionSetIdx] : 0;
-				break;
-
-			default:
-				break;
-			}
+		case 2:
+			subsetIndex = (s_bptcP2[partitionSetIdx] >> idx) & 1;
+			indexAnchor = 0 != subsetIndex ? s_bptcA2[partitionSetIdx] : 0;
+			break;
 
-			const uint8_t anchor = idx == indexAnchor;
-			const uint8_t num[2] =
-			{
-				uint8_t(mi.indexBits[0] - anchor),
-				uint8_t(hasIndexBits1 ? mi.indexBits[1] - anchor : 0),
-			};
+		case 3:
+			subsetIndex = (s_bptcP3[partitionSetIdx] >> (2 * idx)) & 3;
+			indexAnchor = 0 != subsetIndex ? s_bptcA3[subsetIndex - 1][partitionSetIdx] : 0;
+			break;
 
-			const uint8_t index[2] =
-			{
-								(uint8_t)bit.peek(offset[0], num[0]),
-				hasIndexBits1 ? (uint8_t)bit.peek(offset[1], num[1]) : index[0],
-			};
+		default:
+			break;
+		}
 
-			offset[0] += num[0];
-			offset[1] += num[1];
+		const uint8_t anchor = idx == indexAnchor;
+		uint8_t index[2];
+		const uint8_t num0 = uint8_t(mi.indexBits[0] - anchor);
+		index[0] = uint8_t(stream[0] & ((1u << num0) - 1));
+		stream[0] >>= num0;
+		if (hasIndexBits1)
+		{
+			const uint8_t num1 = uint8_t(mi.indexBits[1] - anchor);
+			index[1] = uint8_t(stream[1] & ((1u << num1) - 1));
+			stream[1] >>= num1;
+		}
+		else
+		{
+			index[1] = index[0];
+		}
 
-			const uint8_t fc = factors[indexSelectionMode][index[indexSelectionMode]];
-			const uint8_t fa = factors[!indexSelectionMode][index[!indexSelectionMode]];
+		subset[idx] = subsetIndex;
+		wc[idx] = factors[indexSelectionMode][index[indexSelectionMode]];
+		wa[idx] = factors[!indexSelectionMode][index[!indexSelectionMode]];
+	}
 
-			const uint8_t fca = 64 - fc;
-			const uint8_t fcb = fc;
-			const uint8_t faa = 64 - fa;
-			const uint8_t fab = fa;
+	Kernel::bc7(ep0, ep1, subset, wc, wa, rotationMode, _dst);
+}
 
-			subsetIndex *= 2;
-			uint8_t rr = uint8_t(uint16_t(epR[subsetIndex] * fca + epR[subsetIndex + 1] * fcb + 32) >> 6);
-			uint8_t gg = uint8_t(uint16_t(epG[subsetIndex] * fca + epG[subsetIndex + 1] * fcb + 32) >> 6);
-			uint8_t bb = uint8_t(uint16_t(epB[subsetIndex] * fca + epB[subsetIndex + 1] * fcb + 32) >> 6);
-			uint8_t aa = uint8_t(uint16_t(epA[subsetIndex] * faa + epA[subsetIndex + 1] * fab + 32) >> 6);
+template<class Kernel>
+static void decode_bc7_block(const uint8_t* _src, uint32_t* _dst)
+{
+	Bc7Bits bit;
+	memcpy(&bit.lo, _src, 8);
+	memcpy(&bit.hi, _src + 8, 8);
+	bit.lo = lton64(bit.lo);
+	bit.hi = lton64(bit.hi);
+
+	// mode is the number of zero bits before the first set bit
+	const uint8_t modeByte = uint8_t(bit.lo);
+	if (0 == modeByte)
+	{
+		memset(_dst, 0, 16 * 4);
+		return;
+	}
 
-			switch (rotationMode)
-			{
-			case 1: std::swap(aa, rr); break;
-			case 2: std::swap(aa, gg); break;
-			case 3: std::swap(aa, bb); break;
-			default:                  break;
-			};
+	uint8_t mode = 0;
+	while (0 == (modeByte >> mode & 1))
+	{
+		++mode;
+	}
+	bit.pos = mode + 1;
 
-			_dst[idx] = color(rr, gg, bb, aa);
-		}
+	switch (mode)
+	{
+	case 0: decode_bc7_mode<0, Kernel>(bit, _dst); break;
+	case 1: decode_bc7_mode<1, Kernel>(bit, _dst); break;
+	case 2: decode_bc7_mode<2, Kernel>(bit, _dst); break;
+	case 3: decode_bc7_mode<3, Kernel>(bit, _dst); break;
+	case 4: decode_bc7_mode<4, Kernel>(bit, _dst); break;
+	case 5: decode_bc7_mode<5, Kernel>(bit, _dst); break;
+	case 6: decode_bc7_mode<6, Kernel>(bit, _dst); break;
+	default: decode_bc7_mode<7, Kernel>(bit, _dst); break;
 	}
 }
 
-int decode_bc7(const uint8_t* data, uint32_t m_width, uint32_t m_height, uint32_t* image) {
+template<int Layout>
+static int decode_bc7_image(const uint8_t* data, uint32_t m_width, uint32_t m_height, uint8_t* image) {
 	uint32_t m_block_width = 4;
 	uint32_t m_block_height = 4;
 	uint32_t m_blocks_x = (m_width + m_block_width - 1) / m_block_width;
 	uint32_t m_blocks_y = (m_height + m_block_height - 1) / m_block_height;
 	uint32_t buffer[16];
+	void (*decode_block)(const uint8_t*, uint32_t*) = bc_decoders().bc7;
 	for (uint32_t by = 0; by < m_blocks_y; by++) {
 		for (uint32_t bx = 0; bx < m_blocks_x; bx++, data += 16) {
-			decode_bc7_block(data, buffer);
-			copy_block_buffer(bx, by, m_width, m_height, m_block_width, m_block_height, buffer, image);
+			decode_block(data, buffer);
+			copy_block_buffer_as<Layout>(bx, by, m_width, m_height, m_block_width, m_block_height, buffer, image);
 		}
 	}
 	return 1;
-}
\ No newline at end of file
+}
+
+int decode_bc7(const uint8_t* data, uint32_t m_width, uint32_t m_height, uint32_t* image) {
+	return decode_bc7_image<LAYOUT_BGRA>(data, m_width, m_height, (uint8_t*)image);
+}
+
+int decode_bc7_as(const uint8_t* data, uint32_t m_width, uint32_t m_height, int layout, uint8_t* image) {
+	DECODE_WITH_LAYOUT(decode_bc7_image, layout, data, m_width, m_height, image)
+}
@@ -17,4 +17,12 @@ int decode_bc3(const uint8_t* data, const long w, const long h, uint32_t* image)
 int decode_bc4(const uint8_t* data, uint32_t m_width, uint32_t m_height, uint32_t* image);
 int decode_bc5(const uint8_t* data, uint32_t m_width, uint32_t m_height, uint32_t* image);
 int decode_bc6(const uint8_t* data, uint32_t m_width, uint32_t m_height, uint32_t* image);
-int decode_bc7(const uint8_t* data, uint32_t m_width, uint32_t m_height, uint32_t* image);
\ No newline at end of file
+int decode_bc7(const uint8_t* data, uint32_t m_width, uint32_t m_height, uint32_t* image);
+
+// Same as above writing one of the LAYOUT_* pixel layouts from color.h
+int decode_bc1_as(const uint8_t* data, const long w, const long h, int layout, uint8_t* image);
+int decode_bc3_as(const uint8_t* data, const long w, const long h, int layout, uint8_t* image);
+int decode_bc4_as(const uint8_t* data, uint32_t m_width, uint32_t m_height, int layout, uint8_t* image);
+int decode_bc5_as(const uint8_t* data, uint32_t m_width, uint32_t m_height, int layout, uint8_t* image);
+int decode_bc6_as(const uint8_t* data, uint32_t m_width, uint32_t m_height, int layout, uint8_t* image);
+int decode_bc7_as(const uint8_t* data, uint32_t m_width, uint32_t m_height, int layout, uint8_t* image);
\ No newline at end of file
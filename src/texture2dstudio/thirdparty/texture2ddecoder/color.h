@@ -84,4 +84,90 @@ static inline void copy_block_buffer(const long bx, const long by, const long w,
         memcpy(image + y * w + x, buffer, xl);
 }
 
+// Output pixel layouts, named by their byte order in memory. Block decoders always produce color()
+// texels (BGRA bytes); the layout is applied while a block is copied into the image.
+enum {
+    LAYOUT_BGRA = 0,
+    LAYOUT_RGBA = 1,
+    LAYOUT_RGB = 2,
+    LAYOUT_R8 = 3,
+    LAYOUT_RG8 = 4,
+};
+
+static inline int layout_bytes(const int layout) {
+    static const int Bytes[] = {4, 4, 3, 1, 2};
+    return layout >= LAYOUT_BGRA && layout <= LAYOUT_RG8 ? Bytes[layout] : 0;
+}
+
+// bytes per output pixel, and in order the byte offset inside a color() texel of output byte c at bits 4c
+template<int Layout>
+struct PixelLayout;
+
+template<>
+struct PixelLayout<LAYOUT_BGRA> {
+    static const int bytes = 4;
+    static const int order = 0x3210;
+};
+
+template<>
+struct PixelLayout<LAYOUT_RGBA> {
+    static const int bytes = 4;
+    static const int order = 0x3012;
+};
+
+template<>
+struct PixelLayout<LAYOUT_RGB> {
+    static const int bytes = 3;
+    static const int order = 0x012;
+};
+
+template<>
+struct PixelLayout<LAYOUT_R8> {
+    static const int bytes = 1;
+    static const int order = 0x2;
+};
+
+template<>
+struct PixelLayout<LAYOUT_RG8> {
+    static const int bytes = 2;
+    static const int order = 0x12;
+};
+
+template<int Layout>
+static inline void copy_block_buffer_as(const long bx, const long by, const long w, const long h, const long bw,
+                                        const long bh, const uint32_t *buffer, uint8_t *image) {
+    typedef PixelLayout<Layout> L;
+    long x = bw * bx;
+    long xl = bw * (bx + 1) > w ? w - bw * bx : bw;
+    const uint32_t *buffer_end = buffer + bw * bh;
+    for (long y = by * bh; buffer < buffer_end && y < h; buffer += bw, y++) {
+        uint8_t *out = image + (y * w + x) * L::bytes;
+        if (Layout == LAYOUT_BGRA) {
+            memcpy(out, buffer, xl * 4);
+            continue;
+        }
+        const uint8_t *in = (const uint8_t *)buffer;
+        for (long i = 0; i < xl; i++, in += 4, out += L::bytes)
+            for (int c = 0; c < L::bytes; c++)
+                out[c] = in[L::order >> c * 4 & 0xf];
+    }
+}
+
+// Expands to a switch returning func<LAYOUT_*>(args...) for a runtime layout, 0 for an unknown one
+#define DECODE_WITH_LAYOUT(func, layout, ...)                                                                      \
+    switch (layout) {                                                                                              \
+    case LAYOUT_BGRA:                                                                                              \
+        return func<LAYOUT_BGRA>(__VA_ARGS__);                                                                     \
+    case LAYOUT_RGBA:                                                                                              \
+        return func<LAYOUT_RGBA>(__VA_ARGS__);                                                                     \
+    case LAYOUT_RGB:                                                                                               \
+        return func<LAYOUT_RGB>(__VA_ARGS__);                                                                      \
+    case LAYOUT_R8:                                                                                                \
+        return func<LAYOUT_R8>(__VA_ARGS__);                                                                       \
+    case LAYOUT_RG8:                                                                                               \
+        return func<LAYOUT_RG8>(__VA_ARGS__);                                                                      \
+    default:                                                                                                       \
+        return 0;                                                                                                  \
+    }
+
 #endif /* end of include guard: COLOR_H */
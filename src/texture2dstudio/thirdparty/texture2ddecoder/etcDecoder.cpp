@@ -2,6 +2,7 @@
 #include <stdint.h>
 #include <string.h>
 #include "color.h"
+#include "simd.h"
 
 const uint_fast8_t WriteOrderTable[16] = {0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15};
 const uint_fast8_t WriteOrderTableRev[16] = {15, 11, 7, 3, 14, 10, 6, 2, 13, 9, 5, 1, 12, 8, 4, 0};
@@ -16,8 +17,8 @@ const uint_fast8_t Etc1ModifierTable[8][2] = {{2,  8},
 const uint_fast8_t Etc2aModifierTable[2][8][2] = {
         {{0, 8}, {0, 17}, {0, 29}, {0,  42}, {0,  60}, {0,  80}, {0,  106}, {0,  183}},
         {{2, 8}, {5, 17}, {9, 29}, {13, 42}, {18, 60}, {24, 80}, {33, 106}, {47, 183}}};
-const uint_fast8_t Etc1SubblockTable[2][16] = {{0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1},
-                                               {0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1}};
+// subblock of texel i (bit i set = second subblock), for flip bit 0 and 1
+const uint_fast16_t Etc1SubblockMask[2] = {0xff00, 0xcccc};
 const uint_fast8_t Etc2DistanceTable[8] = {3, 6, 11, 16, 23, 32, 41, 64};
 const int_fast8_t Etc2AlphaModTable[16][8] = {
         {-3, -6, -9,  -15, 2, 5, 8, 14},
@@ -41,22 +42,211 @@ static inline uint_fast8_t clamp(const int n) {
     return n < 0 ? 0 : n > 255 ? 255 : n;
 }
 
-static inline uint32_t applicate_color(uint_fast8_t c[3], int_fast16_t m) {
+static inline uint32_t applicate_color(const uint_fast8_t c[3], int_fast16_t m) {
     return color(clamp(c[0] + m), clamp(c[1] + m), clamp(c[2] + m), 255);
 }
 
-static inline uint32_t applicate_color_alpha(uint_fast8_t c[3], int_fast16_t m, int transparent) {
-    return color(clamp(c[0] + m), clamp(c[1] + m), clamp(c[2] + m), transparent ? 0 : 255);
+static inline uint32_t applicate_color_raw(const uint_fast8_t c[3]) {
+    return color(c[0], c[1], c[2], 255);
 }
 
-static inline uint32_t applicate_color_raw(uint_fast8_t c[3]) {
-    return color(c[0], c[1], c[2], 255);
+// Every colour block picks its texels from a small palette: 2 subblocks x 4 modifiers (individual,
+// differential) or 4 paint colours (T, H). The palette is built once per block and the 16 indices are
+// expanded from the j (lsb), k (msb) and s (subblock) bit fields, where bit i = x * 4 + y covers texel
+// (x, y). A palette index is s << 2 | msb << 1 | lsb. Alpha/EAC blocks use an 8-entry byte palette.
+//
+// Kernel classes provide:
+//   subblocks(c, m0, m1, j, k, s, transparent, outbuf) - individual/differential modes; `transparent`
+//                                                         clears alpha of index 2 (punch-through)
+//   expand(palette, j, k, outbuf)                       - T/H modes (4-entry palette)
+//   planar(c, outbuf)                                   - planar mode
+//   channel(palette, l, channel, outbuf)                - 16 3-bit indices of l into byte `channel`
+
+// the other decoders have kernels of the same names, so these stay local to the file
+namespace {
+
+struct ScalarKernel {
+    static void subblocks(const uint_fast8_t c[][3], const uint_fast8_t *m0, const uint_fast8_t *m1,
+                          uint_fast32_t j, uint_fast32_t k, uint_fast32_t s, int transparent, uint32_t *outbuf) {
+        uint32_t palette[8];
+        for (int n = 0; n < 2; n++) {
+            const uint_fast8_t *m = n ? m1 : m0;
+            palette[n * 4 + 0] = applicate_color(c[n], m[0]);
+            palette[n * 4 + 1] = applicate_color(c[n], m[1]);
+            palette[n * 4 + 2] = applicate_color(c[n], -m[0]);
+            palette[n * 4 + 3] = applicate_color(c[n], -m[1]);
+            if (transparent)
+                palette[n * 4 + 2] &= TRANSPARENT_MASK;
+        }
+        for (int i = 0; i < 16; i++, j >>= 1, k >>= 1, s >>= 1)
+            outbuf[WriteOrderTable[i]] = palette[(s & 1) << 2 | (k & 1) << 1 | (j & 1)];
+    }
+
+    static void expand(const uint32_t *palette, uint_fast32_t j, uint_fast32_t k, uint32_t *outbuf) {
+        for (int i = 0; i < 16; i++, j >>= 1, k >>= 1)
+            outbuf[WriteOrderTable[i]] = palette[(k & 1) << 1 | (j & 1)];
+    }
+
+    static void planar(const uint_fast8_t c[][3], uint32_t *outbuf) {
+        for (int y = 0, i = 0; y < 4; y++) {
+            for (int x = 0; x < 4; x++, i++) {
+                uint8_t r = clamp((x * (c[1][0] - c[0][0]) + y * (c[2][0] - c[0][0]) + 4 * c[0][0] + 2) >> 2);
+                uint8_t g = clamp((x * (c[1][1] - c[0][1]) + y * (c[2][1] - c[0][1]) + 4 * c[0][1] + 2) >> 2);
+                uint8_t b = clamp((x * (c[1][2] - c[0][2]) + y * (c[2][2] - c[0][2]) + 4 * c[0][2] + 2) >> 2);
+                outbuf[i] = color(r, g, b, 255);
+            }
+        }
+    }
+
+    static void channel(uint64_t palette, uint_fast64_t l, int channel, uint32_t *outbuf) {
+        for (int i = 0; i < 16; i++, l >>= 3)
+            ((uint8_t *) (outbuf + WriteOrderTableRev[i]))[channel] = palette >> (l & 7) * 8;
+    }
+};
+
+#if defined(TEXTURE2D_SIMD_X86)
+
+// Row y of the 4x4 block: lanes x = 0..3 test bit x * 4 + y of a broadcast index field.
+SIMD_TARGET_SSE41 static inline __m128i select_bits(__m128i field, __m128i bit) {
+    return _mm_cmpeq_epi32(_mm_and_si128(field, bit), bit);
+}
+
+SIMD_TARGET_SSE41 static inline void
+expand_sse41(__m128i lo, __m128i hi, uint_fast32_t j, uint_fast32_t k, uint_fast32_t s, uint32_t *outbuf) {
+    const __m128i vj = _mm_set1_epi32((int) j);
+    const __m128i vk = _mm_set1_epi32((int) k);
+    const __m128i vs = _mm_set1_epi32((int) s);
+    const __m128i lsb_offset = _mm_set1_epi32(0x04040404);
+    const __m128i msb_offset = _mm_set1_epi32(0x08080808);
+    const __m128i bytes = _mm_set1_epi32(0x03020100);
+    __m128i bit = _mm_setr_epi32(1, 1 << 4, 1 << 8, 1 << 12);
+    for (int y = 0; y < 4; y++, bit = _mm_add_epi32(bit, bit)) {
+        // pshufb control selecting palette entry (msb << 1 | lsb) of the subblock's half
+        __m128i ctrl = _mm_or_si128(_mm_and_si128(select_bits(vk, bit), msb_offset),
+                                    _mm_and_si128(select_bits(vj, bit), lsb_offset));
+        ctrl = _mm_or_si128(ctrl, bytes);
+        __m128i texels = _mm_blendv_epi8(_mm_shuffle_epi8(lo, ctrl), _mm_shuffle_epi8(hi, ctrl),
+                                         select_bits(vs, bit));
+        _mm_storeu_si128((__m128i *) (outbuf + y * 4), texels);
+    }
+}
+
+// 4 entries of base colour c +/- the small and large modifier; saturating byte arithmetic is the clamp.
+SIMD_TARGET_SSE41 static inline __m128i subblock_palette_sse41(const uint_fast8_t c[3], const uint_fast8_t *m) {
+    const __m128i base = _mm_set1_epi32((int) color(c[0], c[1], c[2], 255));
+    const int small = m[0] * 0x010101, large = m[1] * 0x010101;
+    __m128i palette = _mm_adds_epu8(base, _mm_setr_epi32(small, large, 0, 0));
+    return _mm_subs_epu8(palette, _mm_setr_epi32(0, 0, small, large));
+}
+
+struct Sse41Kernel {
+    SIMD_TARGET_SSE41 static void subblocks(const uint_fast8_t c[][3], const uint_fast8_t *m0,
+                                            const uint_fast8_t *m1, uint_fast32_t j, uint_fast32_t k,
+                                            uint_fast32_t s, int transparent, uint32_t *outbuf) {
+        __m128i lo = subblock_palette_sse41(c[0], m0);
+        __m128i hi = subblock_palette_sse41(c[1], m1);
+        if (transparent) {
+            const __m128i mask = _mm_setr_epi32(-1, -1, (int) TRANSPARENT_MASK, -1);
+            lo = _mm_and_si128(lo, mask);
+            hi = _mm_and_si128(hi, mask);
+        }
+        expand_sse41(lo, hi, j, k, s, outbuf);
+    }
+
+    SIMD_TARGET_SSE41 static void expand(const uint32_t *palette, uint_fast32_t j, uint_fast32_t k,
+                                         uint32_t *outbuf) {
+        const __m128i entries = _mm_loadu_si128((const __m128i *) palette);
+        expand_sse41(entries, entries, j, k, 0, outbuf);
+    }
+
+    SIMD_TARGET_SSE41 static void planar(const uint_fast8_t c[][3], uint32_t *outbuf) {
+        // 16-bit lanes hold rows 0-1 and rows 2-3; packus is the clamp
+        const __m128i x = _mm_setr_epi16(0, 1, 2, 3, 0, 1, 2, 3);
+        const __m128i y01 = _mm_setr_epi16(0, 0, 0, 0, 1, 1, 1, 1);
+        const __m128i y23 = _mm_setr_epi16(2, 2, 2, 2, 3, 3, 3, 3);
+        __m128i channels[3];
+        for (int n = 0; n < 3; n++) {
+            const __m128i dx = _mm_set1_epi16((short) (c[1][n] - c[0][n]));
+            const __m128i dy = _mm_set1_epi16((short) (c[2][n] - c[0][n]));
+            const __m128i origin = _mm_add_epi16(_mm_mullo_epi16(x, dx), _mm_set1_epi16((short) (4 * c[0][n] + 2)));
+            __m128i top = _mm_srai_epi16(_mm_add_epi16(origin, _mm_mullo_epi16(y01, dy)), 2);
+            __m128i bottom = _mm_srai_epi16(_mm_add_epi16(origin, _mm_mullo_epi16(y23, dy)), 2);
+            channels[n] = _mm_packus_epi16(top, bottom);
+        }
+        // interleave to b, g, r, a bytes
+        const __m128i alpha = _mm_set1_epi8((char) 0xff);
+        const __m128i bg_lo = _mm_unpacklo_epi8(channels[2], channels[1]);
+        const __m128i bg_hi = _mm_unpackhi_epi8(channels[2], channels[1]);
+        const __m128i ra_lo = _mm_unpacklo_epi8(channels[0], alpha);
+        const __m128i ra_hi = _mm_unpackhi_epi8(channels[0], alpha);
+        _mm_storeu_si128((__m128i *) outbuf, _mm_unpacklo_epi16(bg_lo, ra_lo));
+        _mm_storeu_si128((__m128i *) (outbuf + 4), _mm_unpackhi_epi16(bg_lo, ra_lo));
+        _mm_storeu_si128((__m128i *) (outbuf + 8), _mm_unpacklo_epi16(bg_hi, ra_hi));
+        _mm_storeu_si128((__m128i *) (outbuf + 12), _mm_unpackhi_epi16(bg_hi, ra_hi));
+    }
+
+    SIMD_TARGET_SSE41 static void channel(uint64_t palette, uint_fast64_t l, int channel, uint32_t *outbuf) {
+        // one index per byte in bitstream order, then reordered to row-major (WriteOrderTableRev)
+        const __m128i order = _mm_setr_epi8(15, 11, 7, 3, 14, 10, 6, 2, 13, 9, 5, 1, 12, 8, 4, 0);
+        const __m128i index = _mm_shuffle_epi8(simd_spread_indices3(l), order);
+        simd_store_channel(_mm_shuffle_epi8(_mm_set_epi64x(0, (long long) palette), index), channel, outbuf);
+    }
+};
+
+// Lanes hold row-major texels; shifts move bit x * 4 + y of an index field to bit 0.
+SIMD_TARGET_AVX2 static inline void expand_avx2(__m256i palette, uint_fast32_t j, uint_fast32_t k, uint_fast32_t s,
+                                                uint32_t *outbuf) {
+    const __m256i vj = _mm256_set1_epi32((int) j);
+    const __m256i vk = _mm256_set1_epi32((int) k);
+    const __m256i vs = _mm256_set1_epi32((int) s);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i shifts[2] = {_mm256_setr_epi32(0, 4, 8, 12, 1, 5, 9, 13),
+                               _mm256_setr_epi32(2, 6, 10, 14, 3, 7, 11, 15)};
+    for (int half = 0; half < 2; half++) {
+        const __m256i shift = shifts[half];
+        __m256i index = _mm256_and_si256(_mm256_srlv_epi32(vj, shift), one);
+        index = _mm256_or_si256(index, _mm256_slli_epi32(_mm256_and_si256(_mm256_srlv_epi32(vk, shift), one), 1));
+        index = _mm256_or_si256(index, _mm256_slli_epi32(_mm256_and_si256(_mm256_srlv_epi32(vs, shift), one), 2));
+        _mm256_storeu_si256((__m256i *) (outbuf + half * 8), _mm256_permutevar8x32_epi32(palette, index));
+    }
 }
 
+struct Avx2Kernel : Sse41Kernel {
+    SIMD_TARGET_AVX2 static void subblocks(const uint_fast8_t c[][3], const uint_fast8_t *m0,
+                                           const uint_fast8_t *m1, uint_fast32_t j, uint_fast32_t k,
+                                           uint_fast32_t s, int transparent, uint32_t *outbuf) {
+        const __m256i base = _mm256_setr_epi32((int) color(c[0][0], c[0][1], c[0][2], 255),
+                                               (int) color(c[0][0], c[0][1], c[0][2], 255),
+                                               (int) color(c[0][0], c[0][1], c[0][2], 255),
+                                               (int) color(c[0][0], c[0][1], c[0][2], 255),
+                                               (int) color(c[1][0], c[1][1], c[1][2], 255),
+                                               (int) color(c[1][0], c[1][1], c[1][2], 255),
+                                               (int) color(c[1][0], c[1][1], c[1][2], 255),
+                                               (int) color(c[1][0], c[1][1], c[1][2], 255));
+        const int small0 = m0[0] * 0x010101, large0 = m0[1] * 0x010101;
+        const int small1 = m1[0] * 0x010101, large1 = m1[1] * 0x010101;
+        __m256i palette = _mm256_adds_epu8(base, _mm256_setr_epi32(small0, large0, 0, 0, small1, large1, 0, 0));
+        palette = _mm256_subs_epu8(palette, _mm256_setr_epi32(0, 0, small0, large0, 0, 0, small1, large1));
+        if (transparent)
+            palette = _mm256_and_si256(palette, _mm256_setr_epi32(-1, -1, (int) TRANSPARENT_MASK, -1,
+                                                                  -1, -1, (int) TRANSPARENT_MASK, -1));
+        expand_avx2(palette, j, k, s, outbuf);
+    }
+
+    SIMD_TARGET_AVX2 static void expand(const uint32_t *palette, uint_fast32_t j, uint_fast32_t k,
+                                        uint32_t *outbuf) {
+        expand_avx2(_mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) palette)), j, k, 0, outbuf);
+    }
+};
+
+#endif
+
+}  // namespace
+
+template<class Kernel>
 static void decode_etc1_block(const uint8_t *data, uint32_t *outbuf) {
     const uint_fast8_t code[2] = {static_cast<uint_fast8_t>(data[3] >> 5),
                                   static_cast<uint_fast8_t>(data[3] >> 2 & 7)};  // Table codewords
-    const uint_fast8_t *table = Etc1SubblockTable[data[3] & 1];
     uint_fast8_t c[2][3];
     if (data[3] & 2) {
         // diff bit == 1
@@ -84,13 +274,11 @@ static void decode_etc1_block(const uint8_t *data, uint32_t *outbuf) {
 
     uint_fast16_t j = data[6] << 8 | data[7];  // less significant pixel index bits
     uint_fast16_t k = data[4] << 8 | data[5];  // more significant pixel index bits
-    for (int i = 0; i < 16; i++, j >>= 1, k >>= 1) {
-        uint_fast8_t s = table[i];
-        uint_fast8_t m = Etc1ModifierTable[code[s]][j & 1];
-        outbuf[WriteOrderTable[i]] = applicate_color(c[s], k & 1 ? -m : m);
-    }
+    Kernel::subblocks(c, Etc1ModifierTable[code[0]], Etc1ModifierTable[code[1]], j, k,
+                      Etc1SubblockMask[data[3] & 1], 0, outbuf);
 }
 
+template<class Kernel>
 static void decode_etc2_block(const uint8_t *data, uint32_t *outbuf) {
     uint_fast16_t j = data[6] << 8 | data[7];  // 15 -> 0
     uint_fast32_t k = data[4] << 8 | data[5];  // 31 -> 16
@@ -113,11 +301,9 @@ static void decode_etc2_block(const uint8_t *data, uint32_t *outbuf) {
             c[1][1] = (data[2] & 0x0f) | data[2] << 4;
             c[1][2] = (data[3] & 0xf0) | data[3] >> 4;
             const uint_fast8_t d = Etc2DistanceTable[(data[3] >> 1 & 6) | (data[3] & 1)];
-            uint_fast32_t color_set[4] = {applicate_color_raw(c[0]), applicate_color(c[1], d),
-                                          applicate_color_raw(c[1]), applicate_color(c[1], -d)};
-            k <<= 1;
-            for (int i = 0; i < 16; i++, j >>= 1, k >>= 1)
-                outbuf[WriteOrderTable[i]] = color_set[(k & 2) | (j & 1)];
+            uint32_t color_set[4] = {applicate_color_raw(c[0]), applicate_color(c[1], d),
+                                     applicate_color_raw(c[1]), applicate_color(c[1], -d)};
+            Kernel::expand(color_set, j, k, outbuf);
         } else if (g + dg < 0 || g + dg > 255) {
             // H
             c[0][0] = (data[0] << 1 & 0xf0) | (data[0] >> 3 & 0xf);
@@ -134,11 +320,9 @@ static void decode_etc2_block(const uint8_t *data, uint32_t *outbuf) {
                 (c[0][0] == c[1][0] && (c[0][1] > c[1][1] || (c[0][1] == c[1][1] && c[0][2] >= c[1][2]))))
                 ++d;
             d = Etc2DistanceTable[d];
-            uint_fast32_t color_set[4] = {applicate_color(c[0], d), applicate_color(c[0], -d), applicate_color(c[1], d),
-                                          applicate_color(c[1], -d)};
-            k <<= 1;
-            for (int i = 0; i < 16; i++, j >>= 1, k >>= 1)
-                outbuf[WriteOrderTable[i]] = color_set[(k & 2) | (j & 1)];
+            uint32_t color_set[4] = {applicate_color(c[0], d), applicate_color(c[0], -d), applicate_color(c[1], d),
+                                     applicate_color(c[1], -d)};
+            Kernel::expand(color_set, j, k, outbuf);
         } else if (b + db < 0 || b + db > 255) {
             // planar
             c[0][0] = (data[0] << 1 & 0xfc) | (data[0] >> 5 & 3);
@@ -152,19 +336,11 @@ static void decode_etc2_block(const uint8_t *data, uint32_t *outbuf) {
             c[2][0] = (data[5] << 5 & 0xe0) | (data[6] >> 3 & 0x1c) | (data[5] >> 1 & 3);
             c[2][1] = (data[6] << 3 & 0xf8) | (data[7] >> 5 & 0x6) | (data[6] >> 4 & 1);
             c[2][2] = data[7] << 2 | (data[7] >> 4 & 3);
-            for (int y = 0, i = 0; y < 4; y++) {
-                for (int x = 0; x < 4; x++, i++) {
-                    uint8_t r = clamp((x * (c[1][0] - c[0][0]) + y * (c[2][0] - c[0][0]) + 4 * c[0][0] + 2) >> 2);
-                    uint8_t g = clamp((x * (c[1][1] - c[0][1]) + y * (c[2][1] - c[0][1]) + 4 * c[0][1] + 2) >> 2);
-                    uint8_t b = clamp((x * (c[1][2] - c[0][2]) + y * (c[2][2] - c[0][2]) + 4 * c[0][2] + 2) >> 2);
-                    outbuf[i] = color(r, g, b, 255);
-                }
-            }
+            Kernel::planar(c, outbuf);
         } else {
             // differential
             const uint_fast8_t code[2] = {static_cast<uint_fast8_t>(data[3] >> 5),
                                           static_cast<uint_fast8_t>(data[3] >> 2 & 7)};
-            const uint_fast8_t *table = Etc1SubblockTable[data[3] & 1];
             c[0][0] = r | r >> 5;
             c[0][1] = g | g >> 5;
             c[0][2] = b | b >> 5;
@@ -174,31 +350,25 @@ static void decode_etc2_block(const uint8_t *data, uint32_t *outbuf) {
             c[1][0] |= c[1][0] >> 5;
             c[1][1] |= c[1][1] >> 5;
             c[1][2] |= c[1][2] >> 5;
-            for (int i = 0; i < 16; i++, j >>= 1, k >>= 1) {
-                uint_fast8_t s = table[i];
-                uint_fast8_t m = Etc1ModifierTable[code[s]][j & 1];
-                outbuf[WriteOrderTable[i]] = applicate_color(c[s], k & 1 ? -m : m);
-            }
+            Kernel::subblocks(c, Etc1ModifierTable[code[0]], Etc1ModifierTable[code[1]], j, k,
+                              Etc1SubblockMask[data[3] & 1], 0, outbuf);
         }
     } else {
         // individual (diff bit == 0)
         const uint_fast8_t code[2] = {static_cast<uint_fast8_t>(data[3] >> 5),
                                       static_cast<uint_fast8_t>(data[3] >> 2 & 7)};
-        const uint_fast8_t *table = Etc1SubblockTable[data[3] & 1];
         c[0][0] = (data[0] & 0xf0) | data[0] >> 4;
         c[1][0] = (data[0] & 0x0f) | data[0] << 4;
         c[0][1] = (data[1] & 0xf0) | data[1] >> 4;
         c[1][1] = (data[1] & 0x0f) | data[1] << 4;
         c[0][2] = (data[2] & 0xf0) | data[2] >> 4;
         c[1][2] = (data[2] & 0x0f) | data[2] << 4;
-        for (int i = 0; i < 16; i++, j >>= 1, k >>= 1) {
-            uint_fast8_t s = table[i];
-            uint_fast8_t m = Etc1ModifierTable[code[s]][j & 1];
-            outbuf[WriteOrderTable[i]] = applicate_color(c[s], k & 1 ? -m : m);
-        }
+        Kernel::subblocks(c, Etc1ModifierTable[code[0]], Etc1ModifierTable[code[1]], j, k,
+                          Etc1SubblockMask[data[3] & 1], 0, outbuf);
     }
 }
 
+template<class Kernel>
 static void decode_etc2a1_block(const uint8_t *data, uint32_t *outbuf) {
     uint_fast16_t j = data[6] << 8 | data[7];  // 15 -> 0
     uint_fast32_t k = data[4] << 8 | data[5];  // 31 -> 16
@@ -222,15 +392,11 @@ static void decode_etc2a1_block(const uint8_t *data, uint32_t *outbuf) {
         c[1][1] = (data[2] & 0x0f) | data[2] << 4;
         c[1][2] = (data[3] & 0xf0) | data[3] >> 4;
         const uint_fast8_t d = Etc2DistanceTable[(data[3] >> 1 & 6) | (data[3] & 1)];
-        uint_fast32_t color_set[4] = {applicate_color_raw(c[0]), applicate_color(c[1], d), applicate_color_raw(c[1]),
-                                      applicate_color(c[1], -d)};
-        k <<= 1;
-        for (int i = 0; i < 16; i++, j >>= 1, k >>= 1) {
-            int index = (k & 2) | (j & 1);
-            outbuf[WriteOrderTable[i]] = color_set[index];
-            if (!obaq && index == 2)
-                outbuf[WriteOrderTable[i]] &= TRANSPARENT_MASK;
-        }
+        uint32_t color_set[4] = {applicate_color_raw(c[0]), applicate_color(c[1], d), applicate_color_raw(c[1]),
+                                 applicate_color(c[1], -d)};
+        if (!obaq)
+            color_set[2] &= TRANSPARENT_MASK;
+        Kernel::expand(color_set, j, k, outbuf);
     } else if (g + dg < 0 || g + dg > 255) {
         // H
         c[0][0] = (data[0] << 1 & 0xf0) | (data[0] >> 3 & 0xf);
@@ -247,15 +413,11 @@ static void decode_etc2a1_block(const uint8_t *data, uint32_t *outbuf) {
             (c[0][0] == c[1][0] && (c[0][1] > c[1][1] || (c[0][1] == c[1][1] && c[0][2] >= c[1][2]))))
             ++d;
         d = Etc2DistanceTable[d];
-        uint_fast32_t color_set[4] = {applicate_color(c[0], d), applicate_color(c[0], -d), applicate_color(c[1], d),
-                                      applicate_color(c[1], -d)};
-        k <<= 1;
-        for (int i = 0; i < 16; i++, j >>= 1, k >>= 1) {
-            int index = (k & 2) | (j & 1);
-            outbuf[WriteOrderTable[i]] = color_set[index];
-            if (!obaq && index == 2)
-                outbuf[WriteOrderTable[i]] &= TRANSPARENT_MASK;
-        }
+        uint32_t color_set[4] = {applicate_color(c[0], d), applicate_color(c[0], -d), applicate_color(c[1], d),
+                                 applicate_color(c[1], -d)};
+        if (!obaq)
+            color_set[2] &= TRANSPARENT_MASK;
+        Kernel::expand(color_set, j, k, outbuf);
     } else if (b + db < 0 || b + db > 255) {
         // planar
         c[0][0] = (data[0] << 1 & 0xfc) | (data[0] >> 5 & 3);
@@ -269,19 +431,11 @@ static void decode_etc2a1_block(const uint8_t *data, uint32_t *outbuf) {
         c[2][0] = (data[5] << 5 & 0xe0) | (data[6] >> 3 & 0x1c) | (data[5] >> 1 & 3);
         c[2][1] = (data[6] << 3 & 0xf8) | (data[7] >> 5 & 0x6) | (data[6] >> 4 & 1);
         c[2][2] = data[7] << 2 | (data[7] >> 4 & 3);
-        for (int y = 0, i = 0; y < 4; y++) {
-            for (int x = 0; x < 4; x++, i++) {
-                uint8_t r = clamp((x * (c[1][0] - c[0][0]) + y * (c[2][0] - c[0][0]) + 4 * c[0][0] + 2) >> 2);
-                uint8_t g = clamp((x * (c[1][1] - c[0][1]) + y * (c[2][1] - c[0][1]) + 4 * c[0][1] + 2) >> 2);
-                uint8_t b = clamp((x * (c[1][2] - c[0][2]) + y * (c[2][2] - c[0][2]) + 4 * c[0][2] + 2) >> 2);
-                outbuf[i] = color(r, g, b, 255);
-            }
-        }
+        Kernel::planar(c, outbuf);
     } else {
-        // differential
+        // differential; without opaque bit, index 2 (msb set, lsb clear) is transparent
         const uint_fast8_t code[2] = {static_cast<uint_fast8_t>(data[3] >> 5),
                                       static_cast<uint_fast8_t>(data[3] >> 2 & 7)};
-        const uint_fast8_t *table = Etc1SubblockTable[data[3] & 1];
         c[0][0] = r | r >> 5;
         c[0][1] = g | g >> 5;
         c[0][2] = b | b >> 5;
@@ -291,22 +445,21 @@ static void decode_etc2a1_block(const uint8_t *data, uint32_t *outbuf) {
         c[1][0] |= c[1][0] >> 5;
         c[1][1] |= c[1][1] >> 5;
         c[1][2] |= c[1][2] >> 5;
-        for (int i = 0; i < 16; i++, j >>= 1, k >>= 1) {
-            uint_fast8_t s = table[i];
-            uint_fast8_t m = Etc2aModifierTable[obaq][code[s]][j & 1];
-            outbuf[WriteOrderTable[i]] = applicate_color_alpha(c[s], k & 1 ? -m : m, !obaq && (k & 1) && !(j & 1));
-        }
+        Kernel::subblocks(c, Etc2aModifierTable[obaq][code[0]], Etc2aModifierTable[obaq][code[1]], j, k,
+                          Etc1SubblockMask[data[3] & 1], !obaq, outbuf);
     }
 }
 
+template<class Kernel>
 static void decode_etc2a8_block(const uint8_t *data, uint32_t *outbuf) {
     if (data[1] & 0xf0) {
         // multiplier != 0
         const uint_fast8_t multiplier = data[1] >> 4;
         const int_fast8_t *table = Etc2AlphaModTable[data[1] & 0xf];
-        uint_fast64_t l = bton64(*(uint64_t *) data);
-        for (int i = 0; i < 16; i++, l >>= 3)
-            ((uint8_t *) (outbuf + WriteOrderTableRev[i]))[3] = clamp(data[0] + multiplier * table[l & 7]);
+        uint64_t palette = 0;
+        for (int i = 0; i < 8; i++)
+            palette |= (uint64_t) clamp(data[0] + multiplier * table[i]) << 8 * i;
+        Kernel::channel(palette, bton64(*(uint64_t *) data), 3, outbuf);
     } else {
         // multiplier == 0 (always same as base codeword)
         for (int i = 0; i < 16; i++, outbuf++)
@@ -314,150 +467,288 @@ static void decode_etc2a8_block(const uint8_t *data, uint32_t *outbuf) {
     }
 }
 
+template<class Kernel>
 static void decode_eac_block(const uint8_t *data, int color, uint32_t *outbuf) {
     uint_fast8_t multiplier = data[1] >> 1 & 0x78;
     if (multiplier == 0)
         multiplier = 1;
     const int_fast8_t *table = Etc2AlphaModTable[data[1] & 0xf];
-    uint_fast64_t l = bton64(*(uint64_t *) data);
-    for (int i = 0; i < 16; i++, l >>= 3) {
-        int_fast16_t val = data[0] * 8 + multiplier * table[l & 7] + 4;
-        ((uint8_t *) (outbuf + WriteOrderTableRev[i]))[color] = val < 0 ? 0 : val >= 2048 ? 0xff : val >> 3;
+    uint64_t palette = 0;
+    for (int i = 0; i < 8; i++) {
+        int_fast16_t val = data[0] * 8 + multiplier * table[i] + 4;
+        palette |= (uint64_t) (val < 0 ? 0 : val >= 2048 ? 0xff : val >> 3) << 8 * i;
     }
+    Kernel::channel(palette, bton64(*(uint64_t *) data), color, outbuf);
 }
 
+template<class Kernel>
 static void decode_eac_signed_block(const uint8_t *data, int color, uint32_t *outbuf) {
     int8_t base = (int8_t) data[0];
     uint_fast8_t multiplier = data[1] >> 1 & 0x78;
     if (multiplier == 0)
         multiplier = 1;
     const int_fast8_t *table = Etc2AlphaModTable[data[1] & 0xf];
-    uint_fast64_t l = bton64(*(uint64_t *) data);
-    for (int i = 0; i < 16; i++, l >>= 3) {
-        int_fast16_t val = base * 8 + multiplier * table[l & 7] + 1023;
-        ((uint8_t *) (outbuf + WriteOrderTableRev[i]))[color] = val < 0 ? 0 : val >= 2048 ? 0xff : val >> 3;
+    uint64_t palette = 0;
+    for (int i = 0; i < 8; i++) {
+        int_fast16_t val = base * 8 + multiplier * table[i] + 1023;
+        palette |= (uint64_t) (val < 0 ? 0 : val >= 2048 ? 0xff : val >> 3) << 8 * i;
     }
+    Kernel::channel(palette, bton64(*(uint64_t *) data), color, outbuf);
 }
 
-int decode_etc1(const uint8_t *data, const long w, const long h, uint32_t *image) {
+struct EtcBlockDecoders {
+    void (*etc1)(const uint8_t *, uint32_t *);
+    void (*etc2)(const uint8_t *, uint32_t *);
+    void (*etc2a1)(const uint8_t *, uint32_t *);
+    void (*etc2a8)(const uint8_t *, uint32_t *);
+    void (*eac)(const uint8_t *, int, uint32_t *);
+    void (*eac_signed)(const uint8_t *, int, uint32_t *);
+};
+
+template<class Kernel>
+static EtcBlockDecoders block_decoders() {
+    EtcBlockDecoders decoders = {decode_etc1_block<Kernel>, decode_etc2_block<Kernel>, decode_etc2a1_block<Kernel>,
+                                 decode_etc2a8_block<Kernel>, decode_eac_block<Kernel>,
+                                 decode_eac_signed_block<Kernel>};
+    return decoders;
+}
+
+static EtcBlockDecoders select_block_decoders() {
+#if defined(TEXTURE2D_SIMD_X86)
+    switch (simd_level()) {
+        case SIMD_AVX2:
+            return block_decoders<Avx2Kernel>();
+        case SIMD_SSE41:
+            return block_decoders<Sse41Kernel>();
+        default:
+            break;
+    }
+#endif
+    return block_decoders<ScalarKernel>();
+}
+
+static const EtcBlockDecoders &etc_decoders() {
+    static const EtcBlockDecoders decoders = select_block_decoders();
+    return decoders;
+}
+
+void decode_etc1_texels(const uint8_t *data, uint32_t *outbuf) {
+    etc_decoders().etc1(data, outbuf);
+}
+
+void decode_etc2_texels(const uint8_t *data, uint32_t *outbuf) {
+    etc_decoders().etc2(data, outbuf);
+}
+
+void decode_etc2a1_texels(const uint8_t *data, uint32_t *outbuf) {
+    etc_decoders().etc2a1(data, outbuf);
+}
+
+void decode_etc2a8_texels(const uint8_t *data, uint32_t *outbuf) {
+    const EtcBlockDecoders &decoders = etc_decoders();
+    decoders.etc2(data + 8, outbuf);
+    decoders.etc2a8(data, outbuf);
+}
+
+template<int Layout>
+static int decode_etc1_image(const uint8_t *data, const long w, const long h, uint8_t *image) {
     long num_blocks_x = (w + 3) / 4;
     long num_blocks_y = (h + 3) / 4;
     uint32_t buffer[16];
+    void (*decode_block)(const uint8_t *, uint32_t *) = etc_decoders().etc1;
     for (long by = 0; by < num_blocks_y; by++) {
         for (long bx = 0; bx < num_blocks_x; bx++, data += 8) {
-            decode_etc1_block(data, buffer);
-            copy_block_buffer(bx, by, w, h, 4, 4, buffer, image);
+            decode_block(data, buffer);
+            copy_block_buffer_as<Layout>(bx, by, w, h, 4, 4, buffer, image);
         }
     }
     return 1;
 }
 
-int decode_etc2(const uint8_t *data, const long w, const long h, uint32_t *image) {
+int decode_etc1(const uint8_t *data, const long w, const long h, uint32_t *image) {
+    return decode_etc1_image<LAYOUT_BGRA>(data, w, h, (uint8_t *)image);
+}
+
+int decode_etc1_as(const uint8_t *data, const long w, const long h, int layout, uint8_t *image) {
+    DECODE_WITH_LAYOUT(decode_etc1_image, layout, data, w, h, image)
+}
+
+template<int Layout>
+static int decode_etc2_image(const uint8_t *data, const long w, const long h, uint8_t *image) {
     long num_blocks_x = (w + 3) / 4;
     long num_blocks_y = (h + 3) / 4;
     uint32_t buffer[16];
+    void (*decode_block)(const uint8_t *, uint32_t *) = etc_decoders().etc2;
     for (long by = 0; by < num_blocks_y; by++) {
         for (long bx = 0; bx < num_blocks_x; bx++, data += 8) {
-            decode_etc2_block(data, buffer);
-            copy_block_buffer(bx, by, w, h, 4, 4, buffer, image);
+            decode_block(data, buffer);
+            copy_block_buffer_as<Layout>(bx, by, w, h, 4, 4, buffer, image);
         }
     }
     return 1;
 }
 
-int decode_etc2a1(const uint8_t *data, const long w, const long h, uint32_t *image) {
+int decode_etc2(const uint8_t *data, const long w, const long h, uint32_t *image) {
+    return decode_etc2_image<LAYOUT_BGRA>(data, w, h, (uint8_t *)image);
+}
+
+int decode_etc2_as(const uint8_t *data, const long w, const long h, int layout, uint8_t *image) {
+    DECODE_WITH_LAYOUT(decode_etc2_image, layout, data, w, h, image)
+}
+
+template<int Layout>
+static int decode_etc2a1_image(const uint8_t *data, const long w, const long h, uint8_t *image) {
     long num_blocks_x = (w + 3) / 4;
     long num_blocks_y = (h + 3) / 4;
     uint32_t buffer[16];
+    void (*decode_block)(const uint8_t *, uint32_t *) = etc_decoders().etc2a1;
     for (long by = 0; by < num_blocks_y; by++) {
         for (long bx = 0; bx < num_blocks_x; bx++, data += 8) {
-            decode_etc2a1_block(data, buffer);
-            copy_block_buffer(bx, by, w, h, 4, 4, buffer, image);
+            decode_block(data, buffer);
+            copy_block_buffer_as<Layout>(bx, by, w, h, 4, 4, buffer, image);
         }
     }
     return 1;
 }
 
-int decode_etc2a8(const uint8_t *data, const long w, const long h, uint32_t *image) {
+int decode_etc2a1(const uint8_t *data, const long w, const long h, uint32_t *image) {
+    return decode_etc2a1_image<LAYOUT_BGRA>(data, w, h, (uint8_t *)image);
+}
+
+int decode_etc2a1_as(const uint8_t *data, const long w, const long h, int layout, uint8_t *image) {
+    DECODE_WITH_LAYOUT(decode_etc2a1_image, layout, data, w, h, image)
+}
+
+template<int Layout>
+static int decode_etc2a8_image(const uint8_t *data, const long w, const long h, uint8_t *image) {
     long num_blocks_x = (w + 3) / 4;
     long num_blocks_y = (h + 3) / 4;
     uint32_t buffer[16];
+    const EtcBlockDecoders &decoders = etc_decoders();
     for (long by = 0; by < num_blocks_y; by++) {
         for (long bx = 0; bx < num_blocks_x; bx++, data += 16) {
-            decode_etc2_block(data + 8, buffer);
-            decode_etc2a8_block(data, buffer);
-            copy_block_buffer(bx, by, w, h, 4, 4, buffer, image);
+            decoders.etc2(data + 8, buffer);
+            decoders.etc2a8(data, buffer);
+            copy_block_buffer_as<Layout>(bx, by, w, h, 4, 4, buffer, image);
         }
     }
     return 1;
 }
 
-int decode_eacr(const uint8_t *data, const long w, const long h, uint32_t *image) {
+int decode_etc2a8(const uint8_t *data, const long w, const long h, uint32_t *image) {
+    return decode_etc2a8_image<LAYOUT_BGRA>(data, w, h, (uint8_t *)image);
+}
+
+int decode_etc2a8_as(const uint8_t *data, const long w, const long h, int layout, uint8_t *image) {
+    DECODE_WITH_LAYOUT(decode_etc2a8_image, layout, data, w, h, image)
+}
+
+template<int Layout>
+static int decode_eacr_image(const uint8_t *data, const long w, const long h, uint8_t *image) {
     long num_blocks_x = (w + 3) / 4;
     long num_blocks_y = (h + 3) / 4;
     uint32_t buffer[16];
     uint32_t base_buffer[16];
     for (int i = 0; i < 16; i++)
         base_buffer[i] = color(0, 0, 0, 255);
+    void (*decode_block)(const uint8_t *, int, uint32_t *) = etc_decoders().eac;
     for (long by = 0; by < num_blocks_y; by++) {
         for (long bx = 0; bx < num_blocks_x; bx++, data += 8) {
             memcpy(buffer, base_buffer, sizeof(buffer));
-            decode_eac_block(data, 2, buffer);
-            copy_block_buffer(bx, by, w, h, 4, 4, buffer, image);
+            decode_block(data, 2, buffer);
+            copy_block_buffer_as<Layout>(bx, by, w, h, 4, 4, buffer, image);
         }
     }
     return 1;
 }
 
-int decode_eacr_signed(const uint8_t *data, const long w, const long h, uint32_t *image) {
+int decode_eacr(const uint8_t *data, const long w, const long h, uint32_t *image) {
+    return decode_eacr_image<LAYOUT_BGRA>(data, w, h, (uint8_t *)image);
+}
+
+int decode_eacr_as(const uint8_t *data, const long w, const long h, int layout, uint8_t *image) {
+    DECODE_WITH_LAYOUT(decode_eacr_image, layout, data, w, h, image)
+}
+
+template<int Layout>
+static int decode_eacr_signed_image(const uint8_t *data, const long w, const long h, uint8_t *image) {
     long num_blocks_x = (w + 3) / 4;
     long num_blocks_y = (h + 3) / 4;
     uint32_t buffer[16];
     uint32_t base_buffer[16];
     for (int i = 0; i < 16; i++)
         base_buffer[i] = color(0, 0, 0, 255);
+    void (*decode_block)(const uint8_t *, int, uint32_t *) = etc_decoders().eac_signed;
     for (long by = 0; by < num_blocks_y; by++) {
         for (long bx = 0; bx < num_blocks_x; bx++, data += 8) {
             memcpy(buffer, base_buffer, sizeof(buffer));
-            decode_eac_signed_block(data, 2, buffer);
-            copy_block_buffer(bx, by, w, h, 4, 4, buffer, image);
+            decode_block(data, 2, buffer);
+            copy_block_buffer_as<Layout>(bx, by, w, h, 4, 4, buffer, image);
         }
     }
     return 1;
 }
 
-int decode_eacrg(const uint8_t *data, const long w, const long h, uint32_t *image) {
+int decode_eacr_signed(const uint8_t *data, const long w, const long h, uint32_t *image) {
+    return decode_eacr_signed_image<LAYOUT_BGRA>(data, w, h, (uint8_t *)image);
+}
+
+int decode_eacr_signed_as(const uint8_t *data, const long w, const long h, int layout, uint8_t *image) {
+    DECODE_WITH_LAYOUT(decode_eacr_signed_image, layout, data, w, h, image)
+}
+
+template<int Layout>
+static int decode_eacrg_image(const uint8_t *data, const long w, const long h, uint8_t *image) {
     long num_blocks_x = (w + 3) / 4;
     long num_blocks_y = (h + 3) / 4;
     uint32_t buffer[16];
     uint32_t base_buffer[16];
     for (int i = 0; i < 16; i++)
         base_buffer[i] = color(0, 0, 0, 255);
+    void (*decode_block)(const uint8_t *, int, uint32_t *) = etc_decoders().eac;
     for (long by = 0; by < num_blocks_y; by++) {
         for (long bx = 0; bx < num_blocks_x; bx++, data += 16) {
             memcpy(buffer, base_buffer, sizeof(buffer));
-            decode_eac_block(data, 2, buffer);
-            decode_eac_block(data + 8, 1, buffer);
-            copy_block_buffer(bx, by, w, h, 4, 4, buffer, image);
+            decode_block(data, 2, buffer);
+            decode_block(data + 8, 1, buffer);
+            copy_block_buffer_as<Layout>(bx, by, w, h, 4, 4, buffer, image);
         }
     }
     return 1;
 }
 
-int decode_eacrg_signed(const uint8_t *data, const long w, const long h, uint32_t *image) {
+int decode_eacrg(const uint8_t *data, const long w, const long h, uint32_t *image) {
+    return decode_eacrg_image<LAYOUT_BGRA>(data, w, h, (uint8_t *)image);
+}
+
+int decode_eacrg_as(const uint8_t *data, const long w, const long h, int layout, uint8_t *image) {
+    DECODE_WITH_LAYOUT(decode_eacrg_image, layout, data, w, h, image)
+}
+
+template<int Layout>
+static int decode_eacrg_signed_image(const uint8_t *data, const long w, const long h, uint8_t *image) {
     long num_blocks_x = (w + 3) / 4;
     long num_blocks_y = (h + 3) / 4;
     uint32_t buffer[16];
     uint32_t base_buffer[16];
     for (int i = 0; i < 16; i++)
         base_buffer[i] = color(0, 0, 0, 255);
+    void (*decode_block)(const uint8_t *, int, uint32_t *) = etc_decoders().eac_signed;
     for (long by = 0; by < num_blocks_y; by++) {
         for (long bx = 0; bx < num_blocks_x; bx++, data += 16) {
             memcpy(buffer, base_buffer, sizeof(buffer));
-            decode_eac_signed_block(data, 2, buffer);
-            decode_eac_signed_block(data + 8, 1, buffer);
-            copy_block_buffer(bx, by, w, h, 4, 4, buffer, image);
+            decode_block(data, 2, buffer);
+            decode_block(data + 8, 1, buffer);
+            copy_block_buffer_as<Layout>(bx, by, w, h, 4, 4, buffer, image);
         }
     }
     return 1;
 }
+
+int decode_eacrg_signed(const uint8_t *data, const long w, const long h, uint32_t *image) {
+    return decode_eacrg_signed_image<LAYOUT_BGRA>(data, w, h, (uint8_t *)image);
+}
+
+int decode_eacrg_signed_as(const uint8_t *data, const long w, const long h, int layout, uint8_t *image) {
+    DECODE_WITH_LAYOUT(decode_eacrg_signed_image, layout, data, w, h, image)
+}
@@ -12,4 +12,20 @@ int decode_eacr_signed(const uint8_t *, const long, const long, uint32_t *);
 int decode_eacrg(const uint8_t *, const long, const long, uint32_t *);
 int decode_eacrg_signed(const uint8_t *, const long, const long, uint32_t *);
 
+// Same as above writing one of the LAYOUT_* pixel layouts from color.h
+int decode_etc1_as(const uint8_t *, const long, const long, int, uint8_t *);
+int decode_etc2_as(const uint8_t *, const long, const long, int, uint8_t *);
+int decode_etc2a1_as(const uint8_t *, const long, const long, int, uint8_t *);
+int decode_etc2a8_as(const uint8_t *, const long, const long, int, uint8_t *);
+int decode_eacr_as(const uint8_t *, const long, const long, int, uint8_t *);
+int decode_eacr_signed_as(const uint8_t *, const long, const long, int, uint8_t *);
+int decode_eacrg_as(const uint8_t *, const long, const long, int, uint8_t *);
+int decode_eacrg_signed_as(const uint8_t *, const long, const long, int, uint8_t *);
+
+// One block as 16 color() texels, row by row. etc2a8 reads the 16 byte alpha + colour block.
+void decode_etc1_texels(const uint8_t *data, uint32_t *outbuf);
+void decode_etc2_texels(const uint8_t *data, uint32_t *outbuf);
+void decode_etc2a1_texels(const uint8_t *data, uint32_t *outbuf);
+void decode_etc2a8_texels(const uint8_t *data, uint32_t *outbuf);
+
 #endif /* end of include guard: ETC_H */
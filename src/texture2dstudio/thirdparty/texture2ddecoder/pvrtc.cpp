@@ -1,12 +1,16 @@
 #include "pvrtc.h"
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include "color.h"
 #include "endianness.h"
+#include "simd.h"
 
 static const int PVRTC1_STANDARD_WEIGHT[] = {0, 3, 5, 8};
 static const int PVRTC1_PUNCHTHROUGH_WEIGHT[] = {0, 4, 4, 8};
 
+// Blocks are stored in morton order. With the low bits interleaved (y even, x odd) and the bits of
+// the longer side above min_dim appended, the index is the sum of a per-column and a per-row part.
 static inline long morton_index(const long x, const long y, const long min_dim) {
     long offset = 0, shift = 0;
     for (long mask = 1; mask < min_dim; mask <<= 1, shift++)
@@ -15,54 +19,50 @@ static inline long morton_index(const long x, const long y, const long min_dim)
     return offset;
 }
 
-static void get_texel_colors(const uint8_t *data, PVRTCTexelInfo *info) {
+static void get_texel_colors(const uint8_t *data, int16_t *colors) {
     uint16_t ca = lton16(*(uint16_t *)(data + 4));
     uint16_t cb = lton16(*(uint16_t *)(data + 6));
     if (ca & 0x8000) {
-        info->a.r = ca >> 10 & 0x1f;
-        info->a.g = ca >> 5 & 0x1f;
-        info->a.b = (ca & 0x1e) | (ca >> 4 & 1);
-        info->a.a = 0xf;
+        colors[0] = ca >> 10 & 0x1f;
+        colors[1] = ca >> 5 & 0x1f;
+        colors[2] = (ca & 0x1e) | (ca >> 4 & 1);
+        colors[3] = 0xf;
     } else {
-        info->a.r = (ca >> 7 & 0x1e) | (ca >> 11 & 1);
-        info->a.g = (ca >> 3 & 0x1e) | (ca >> 7 & 1);
-        info->a.b = (ca << 1 & 0x1c) | (ca >> 2 & 3);
-        info->a.a = ca >> 11 & 0xe;
+        colors[0] = (ca >> 7 & 0x1e) | (ca >> 11 & 1);
+        colors[1] = (ca >> 3 & 0x1e) | (ca >> 7 & 1);
+        colors[2] = (ca << 1 & 0x1c) | (ca >> 2 & 3);
+        colors[3] = ca >> 11 & 0xe;
     }
     if (cb & 0x8000) {
-        info->b.r = cb >> 10 & 0x1f;
-        info->b.g = cb >> 5 & 0x1f;
-        info->b.b = cb & 0x1f;
-        info->b.a = 0xf;
+        colors[4] = cb >> 10 & 0x1f;
+        colors[5] = cb >> 5 & 0x1f;
+        colors[6] = cb & 0x1f;
+        colors[7] = 0xf;
     } else {
-        info->b.r = (cb >> 7 & 0x1e) | (cb >> 11 & 1);
-        info->b.g = (cb >> 3 & 0x1e) | (cb >> 7 & 1);
-        info->b.b = (cb << 1 & 0x1e) | (cb >> 3 & 1);
-        info->b.a = cb >> 11 & 0xe;
+        colors[4] = (cb >> 7 & 0x1e) | (cb >> 11 & 1);
+        colors[5] = (cb >> 3 & 0x1e) | (cb >> 7 & 1);
+        colors[6] = (cb << 1 & 0x1e) | (cb >> 3 & 1);
+        colors[7] = cb >> 11 & 0xe;
     }
 }
 
-static void get_texel_weights_4bpp(const uint8_t *data, PVRTCTexelInfo *info) {
-    info->punch_through_flag = 0;
-
+static void get_texel_weights_4bpp(const uint8_t *data, int8_t weight[32]) {
     int mod_mode = data[4] & 1;
     uint32_t mod_bits = lton32(*(uint32_t *)data);
 
     if (mod_mode) {
         for (int i = 0; i < 16; i++, mod_bits >>= 2) {
-            info->weight[i] = PVRTC1_PUNCHTHROUGH_WEIGHT[mod_bits & 3];
+            weight[i] = PVRTC1_PUNCHTHROUGH_WEIGHT[mod_bits & 3];
             if ((mod_bits & 3) == 2)
-                info->punch_through_flag |= 1 << i;
+                weight[i] |= PVRTC_PUNCH_THROUGH;
         }
     } else {
         for (int i = 0; i < 16; i++, mod_bits >>= 2)
-            info->weight[i] = PVRTC1_STANDARD_WEIGHT[mod_bits & 3];
+            weight[i] = PVRTC1_STANDARD_WEIGHT[mod_bits & 3];
     }
 }
 
-static void get_texel_weights_2bpp(const uint8_t *data, PVRTCTexelInfo *info) {
-    info->punch_through_flag = 0;
-
+static void get_texel_weights_2bpp(const uint8_t *data, int8_t weight[32]) {
     int mod_mode = data[4] & 1;
     uint32_t mod_bits = lton32(*(uint32_t *)data);
 
@@ -70,179 +70,267 @@ static void get_texel_weights_2bpp(const uint8_t *data, PVRTCTexelInfo *info) {
         int fillflag = data[0] & 1 ? (data[2] & 0x10 ? -1 : -2) : -3;
         for (int y = 0, i = 1; y < 4; ++y & 1 ? --i : ++i)
             for (int x = 0; x < 4; x++, i += 2)
-                info->weight[i] = fillflag;
+                weight[i] = fillflag;
         for (int y = 0, i = 0; y < 4; ++y & 1 ? ++i : --i)
             for (int x = 0; x < 4; x++, i += 2, mod_bits >>= 2)
-                info->weight[i] = PVRTC1_STANDARD_WEIGHT[mod_bits & 3];
-        info->weight[0] = (info->weight[0] + 3) & 8;
+                weight[i] = PVRTC1_STANDARD_WEIGHT[mod_bits & 3];
+        weight[0] = (weight[0] + 3) & 8;
         if (data[0] & 1)
-            info->weight[20] = (info->weight[20] + 3) & 8;
+            weight[20] = (weight[20] + 3) & 8;
     } else {
         for (int i = 0; i < 32; i++, mod_bits >>= 1)
-            info->weight[i] = mod_bits & 1 ? 8 : 0;
+            weight[i] = mod_bits & 1 ? 8 : 0;
     }
 }
 
-static void applicate_color_4bpp(const uint8_t *data, PVRTCTexelInfo *const info[9], uint32_t buf[32]) {
-    static const int INTERP_WEIGHT[4][3] = {{2, 2, 0}, {1, 3, 0}, {0, 4, 0}, {0, 3, 1}};
-    PVRTCTexelColorInt clr_a[16] = {}, clr_b[16] = {};
-
-    for (int y = 0, i = 0; y < 4; y++) {
-        for (int x = 0; x < 4; x++, i++) {
-            for (int acy = 0, ac = 0; acy < 3; acy++) {
-                for (int acx = 0; acx < 3; acx++, ac++) {
-                    int interp_weight = INTERP_WEIGHT[x][acx] * INTERP_WEIGHT[y][acy];
-                    clr_a[i].r += info[ac]->a.r * interp_weight;
-                    clr_a[i].g += info[ac]->a.g * interp_weight;
-                    clr_a[i].b += info[ac]->a.b * interp_weight;
-                    clr_a[i].a += info[ac]->a.a * interp_weight;
-                    clr_b[i].r += info[ac]->b.r * interp_weight;
-                    clr_b[i].g += info[ac]->b.g * interp_weight;
-                    clr_b[i].b += info[ac]->b.b * interp_weight;
-                    clr_b[i].a += info[ac]->b.a * interp_weight;
-                }
-            }
-            clr_a[i].r = (clr_a[i].r >> 1) + (clr_a[i].r >> 6);
-            clr_a[i].g = (clr_a[i].g >> 1) + (clr_a[i].g >> 6);
-            clr_a[i].b = (clr_a[i].b >> 1) + (clr_a[i].b >> 6);
-            clr_a[i].a = (clr_a[i].a) + (clr_a[i].a >> 4);
-            clr_b[i].r = (clr_b[i].r >> 1) + (clr_b[i].r >> 6);
-            clr_b[i].g = (clr_b[i].g >> 1) + (clr_b[i].g >> 6);
-            clr_b[i].b = (clr_b[i].b >> 1) + (clr_b[i].b >> 6);
-            clr_b[i].a = (clr_b[i].a) + (clr_b[i].a >> 4);
-        }
+int pvrtc_expand(const uint8_t *data, const long w, const long h, const int is2bpp, PVRTCImage *image) {
+    long bw = is2bpp ? 8 : 4;
+    long num_blocks_x = is2bpp ? (w + 7) / 8 : (w + 3) / 4;
+    long num_blocks_y = (h + 3) / 4;
+    long min_num_blocks = num_blocks_x <= num_blocks_y ? num_blocks_x : num_blocks_y;
+
+    memset(image, 0, sizeof(*image));
+    if ((num_blocks_x & (num_blocks_x - 1)) || (num_blocks_y & (num_blocks_y - 1))) {
+        //extern const char* error_msg;
+        //error_msg = "the number of blocks of each side must be a power of 2";
+        return 0;
     }
 
-    const PVRTCTexelInfo *self_info = info[4];
-    uint32_t punch_through_flag = self_info->punch_through_flag;
-    for (int i = 0; i < 16; i++, punch_through_flag >>= 1) {
-        buf[i] = color((clr_a[i].r * (8 - self_info->weight[i]) + clr_b[i].r * self_info->weight[i]) / 8,
-                       (clr_a[i].g * (8 - self_info->weight[i]) + clr_b[i].g * self_info->weight[i]) / 8,
-                       (clr_a[i].b * (8 - self_info->weight[i]) + clr_b[i].b * self_info->weight[i]) / 8,
-                       punch_through_flag & 1
-                         ? 0
-                         : (clr_a[i].a * (8 - self_info->weight[i]) + clr_b[i].a * self_info->weight[i]) / 8);
+    long plane_w = num_blocks_x * bw;
+    long *morton_x = (long *)malloc(sizeof(long) * (num_blocks_x + num_blocks_y));
+    image->colors = (int16_t *)malloc(sizeof(int16_t) * 8 * num_blocks_x * num_blocks_y);
+    image->weights = (int8_t *)malloc(plane_w * num_blocks_y * 4);
+    if (morton_x == NULL || image->colors == NULL || image->weights == NULL) {
+        free(morton_x);
+        pvrtc_free(image);
+        return 0;
     }
-}
+    image->w = w;
+    image->h = h;
+    image->blocks_x = num_blocks_x;
+    image->blocks_y = num_blocks_y;
+    image->is2bpp = is2bpp;
 
-static void applicate_color_2bpp(const uint8_t *data, PVRTCTexelInfo *const info[9], uint32_t buf[32]) {
-    static const int INTERP_WEIGHT_X[8][3] = {{4, 4, 0}, {3, 5, 0}, {2, 6, 0}, {1, 7, 0},
-                                              {0, 8, 0}, {0, 7, 1}, {0, 6, 2}, {0, 5, 3}};
-    static const int INTERP_WEIGHT_Y[4][3] = {{2, 2, 0}, {1, 3, 0}, {0, 4, 0}, {0, 3, 1}};
-    PVRTCTexelColorInt clr_a[32] = {}, clr_b[32] = {};
-
-    for (int y = 0, i = 0; y < 4; y++) {
-        for (int x = 0; x < 8; x++, i++) {
-            for (int acy = 0, ac = 0; acy < 3; acy++) {
-                for (int acx = 0; acx < 3; acx++, ac++) {
-                    int interp_weight = INTERP_WEIGHT_X[x][acx] * INTERP_WEIGHT_Y[y][acy];
-                    clr_a[i].r += info[ac]->a.r * interp_weight;
-                    clr_a[i].g += info[ac]->a.g * interp_weight;
-                    clr_a[i].b += info[ac]->a.b * interp_weight;
-                    clr_a[i].a += info[ac]->a.a * interp_weight;
-                    clr_b[i].r += info[ac]->b.r * interp_weight;
-                    clr_b[i].g += info[ac]->b.g * interp_weight;
-                    clr_b[i].b += info[ac]->b.b * interp_weight;
-                    clr_b[i].a += info[ac]->b.a * interp_weight;
-                }
-            }
-            clr_a[i].r = (clr_a[i].r >> 2) + (clr_a[i].r >> 7);
-            clr_a[i].g = (clr_a[i].g >> 2) + (clr_a[i].g >> 7);
-            clr_a[i].b = (clr_a[i].b >> 2) + (clr_a[i].b >> 7);
-            clr_a[i].a = (clr_a[i].a >> 1) + (clr_a[i].a >> 5);
-            clr_b[i].r = (clr_b[i].r >> 2) + (clr_b[i].r >> 7);
-            clr_b[i].g = (clr_b[i].g >> 2) + (clr_b[i].g >> 7);
-            clr_b[i].b = (clr_b[i].b >> 2) + (clr_b[i].b >> 7);
-            clr_b[i].a = (clr_b[i].a >> 1) + (clr_b[i].a >> 5);
+    long *morton_y = morton_x + num_blocks_x;
+    for (long bx = 0; bx < num_blocks_x; bx++)
+        morton_x[bx] = morton_index(bx, 0, min_num_blocks);
+    for (long by = 0; by < num_blocks_y; by++)
+        morton_y[by] = morton_index(0, by, min_num_blocks);
+
+    void (*get_texel_weights_func)(const uint8_t *, int8_t[32]) =
+      is2bpp ? get_texel_weights_2bpp : get_texel_weights_4bpp;
+    int8_t weight[32];
+    int16_t *colors = image->colors;
+    for (long by = 0; by < num_blocks_y; by++) {
+        int8_t *weights = image->weights + by * 4 * plane_w;
+        for (long bx = 0; bx < num_blocks_x; bx++, colors += 8, weights += bw) {
+            const uint8_t *d = data + (morton_x[bx] | morton_y[by]) * 8;
+            get_texel_colors(d, colors);
+            get_texel_weights_func(d, weight);
+            for (long y = 0; y < 4; y++)
+                memcpy(weights + y * plane_w, weight + y * bw, bw);
         }
     }
+    free(morton_x);
+    return 1;
+}
+
+void pvrtc_free(PVRTCImage *image) {
+    free(image->colors);
+    free(image->weights);
+    image->colors = NULL;
+    image->weights = NULL;
+}
+
+// Each pixel row is decoded in three passes:
+//   the block colours of the two block rows around it blended vertically (weights 0..4),
+//   its modulation weights with 2bpp fill texels averaged from their neighbours, which are always
+//   explicitly stored texels since fill texels form a checkerboard,
+//   then per pixel the horizontal blend, the expansion to 8 bit and the modulation, by a kernel
+//   class picked once from simd_level():
+//     rows(r0, r1, wy0, wy1, n, v)   - v = r0 * wy0 + r1 * wy1 for the n block colours of a row
+//     modulate(v, weights, w, blocks_x, is2bpp, out)
+//                                    - a row of color() texels
+
+// the other decoders have kernels of the same names, so these stay local to the file
+namespace {
+
+struct ScalarKernel {
+    static void rows(const int16_t *r0, const int16_t *r1, int wy0, int wy1, long n, int16_t *v) {
+        for (long i = 0; i < n * 8; i++)
+            v[i] = r0[i] * wy0 + r1[i] * wy1;
+    }
 
-    static const int POSYA[4][2] = {{1, 24}, {4, -8}, {4, -8}, {4, -8}};
-    static const int POSYB[4][2] = {{4, 8}, {4, 8}, {4, 8}, {7, -24}};
-    static const int POSXL[8][2] = {{3, 7}, {4, -1}, {4, -1}, {4, -1}, {4, -1}, {4, -1}, {4, -1}, {4, -1}};
-    static const int POSXR[8][2] = {{4, 1}, {4, 1}, {4, 1}, {4, 1}, {4, 1}, {4, 1}, {4, 1}, {5, -7}};
-
-    PVRTCTexelInfo *self_info = info[4];
-    uint32_t punch_through_flag = self_info->punch_through_flag;
-    for (int y = 0, i = 0; y < 4; y++) {
-        for (int x = 0; x < 8; x++, i++, punch_through_flag >>= 1) {
-            switch (self_info->weight[i]) {
-            case -1:
-                self_info->weight[i] =
-                  (info[POSYA[y][0]]->weight[i + POSYA[y][1]] + info[POSYB[y][0]]->weight[i + POSYB[y][1]] + 1) / 2;
-                break;
-            case -2:
-                self_info->weight[i] =
-                  (info[POSXL[x][0]]->weight[i + POSXL[x][1]] + info[POSXR[x][0]]->weight[i + POSXR[x][1]] + 1) / 2;
-                break;
-            case -3:
-                self_info->weight[i] =
-                  (info[POSYA[y][0]]->weight[i + POSYA[y][1]] + info[POSYB[y][0]]->weight[i + POSYB[y][1]] +
-                   info[POSXL[x][0]]->weight[i + POSXL[x][1]] + info[POSXR[x][0]]->weight[i + POSXR[x][1]] + 2) /
-                  4;
-                break;
+    template<int Is2bpp>
+    static void modulate(const int16_t *v, const int8_t *weights, long w, long blocks_x, uint32_t *out) {
+        const long half = Is2bpp ? 4 : 2;
+        for (long x = 0; x < w; x++) {
+            long bx = x / (half * 2), px = x % (half * 2);
+            long c0, c1, w0, w1;
+            if (px < half) {
+                c0 = bx == 0 ? blocks_x - 1 : bx - 1, c1 = bx;
+                w0 = half - px, w1 = half + px;
+            } else {
+                c0 = bx, c1 = bx == blocks_x - 1 ? 0 : bx + 1;
+                w0 = 3 * half - px, w1 = px - half;
+            }
+            int e[8];
+            for (int k = 0; k < 8; k++) {
+                int s = v[c0 * 8 + k] * w0 + v[c1 * 8 + k] * w1;
+                if ((k & 3) == 3)
+                    e[k] = Is2bpp ? (s >> 1) + (s >> 5) : s + (s >> 4);
+                else
+                    e[k] = Is2bpp ? (s >> 2) + (s >> 7) : (s >> 1) + (s >> 6);
             }
-            buf[i] = color((clr_a[i].r * (8 - self_info->weight[i]) + clr_b[i].r * self_info->weight[i]) / 8,
-                           (clr_a[i].g * (8 - self_info->weight[i]) + clr_b[i].g * self_info->weight[i]) / 8,
-                           (clr_a[i].b * (8 - self_info->weight[i]) + clr_b[i].b * self_info->weight[i]) / 8,
-                           punch_through_flag & 1
-                             ? 0
-                             : (clr_a[i].a * (8 - self_info->weight[i]) + clr_b[i].a * self_info->weight[i]) / 8);
+            int weight = weights[x] & 0xf;
+            out[x] = color((e[0] * (8 - weight) + e[4] * weight) / 8, (e[1] * (8 - weight) + e[5] * weight) / 8,
+                           (e[2] * (8 - weight) + e[6] * weight) / 8,
+                           weights[x] & PVRTC_PUNCH_THROUGH ? 0 : (e[3] * (8 - weight) + e[7] * weight) / 8);
         }
     }
-}
+};
 
-int decode_pvrtc(const uint8_t *data, const long w, const long h, uint32_t *image, const int is2bpp) {
-    long bw = is2bpp ? 8 : 4;
-    long num_blocks_x = is2bpp ? (w + 7) / 8 : (w + 3) / 4;
-    long num_blocks_y = (h + 3) / 4;
-    long num_blocks = num_blocks_x * num_blocks_y;
-    long min_num_blocks = num_blocks_x <= num_blocks_y ? num_blocks_x : num_blocks_y;
+#if defined(TEXTURE2D_SIMD_X86)
 
-    if ((num_blocks_x & (num_blocks_x - 1)) || (num_blocks_y & (num_blocks_y - 1))) {
-        //extern const char* error_msg;
-        //error_msg = "the number of blocks of each side must be a power of 2";
-        return 0;
+// The A and B colour of a pixel share one register as 16 bit lanes (A.rgba, B.rgba)
+struct Sse41Kernel {
+    SIMD_TARGET_SSE41 static void rows(const int16_t *r0, const int16_t *r1, int wy0, int wy1, long n, int16_t *v) {
+        const __m128i m0 = _mm_set1_epi16((short)wy0);
+        const __m128i m1 = _mm_set1_epi16((short)wy1);
+        for (long i = 0; i < n; i++) {
+            __m128i a = _mm_mullo_epi16(_mm_loadu_si128((const __m128i *)(r0 + i * 8)), m0);
+            __m128i b = _mm_mullo_epi16(_mm_loadu_si128((const __m128i *)(r1 + i * 8)), m1);
+            _mm_storeu_si128((__m128i *)(v + i * 8), _mm_add_epi16(a, b));
+        }
     }
 
-    PVRTCTexelInfo *texel_info = (PVRTCTexelInfo *)malloc(sizeof(PVRTCTexelInfo) * num_blocks);
-    if (texel_info == NULL) {
-        //extern const char* error_msg;
-        //error_msg = "memory allocation failed";
-        return 0;
+    template<int Is2bpp>
+    SIMD_TARGET_SSE41 static void modulate(const int16_t *v, const int8_t *weights, long w, long blocks_x,
+                                           uint32_t *out) {
+        const long bw = Is2bpp ? 8 : 4, half = bw / 2;
+        // the two horizontal weights of each column of a block, and the modulation factors (8 - w, w)
+        // of each weight, with alpha zeroed for punch-through
+        __m128i wx0[8], wx1[8], mod[PVRTC_PUNCH_THROUGH + 9];
+        for (long px = 0; px < bw; px++) {
+            wx0[px] = _mm_set1_epi16((short)(px < half ? half - px : 3 * half - px));
+            wx1[px] = _mm_set1_epi16((short)(px < half ? half + px : px - half));
+        }
+        for (int i = 0; i <= 8; i++) {
+            mod[i] = _mm_setr_epi16(8 - i, 8 - i, 8 - i, 8 - i, i, i, i, i);
+            mod[i | PVRTC_PUNCH_THROUGH] = _mm_setr_epi16(8 - i, 8 - i, 8 - i, 0, i, i, i, 0);
+        }
+        const __m128i to_bgra = _mm_setr_epi8(4, 2, 0, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        for (long x = 0; x < w; x++) {
+            long bx = x / bw, px = x % bw;
+            const int16_t *c0, *c1;
+            if (px < half) {
+                c0 = v + (bx == 0 ? blocks_x - 1 : bx - 1) * 8, c1 = v + bx * 8;
+            } else {
+                c0 = v + bx * 8, c1 = v + (bx == blocks_x - 1 ? 0 : bx + 1) * 8;
+            }
+            __m128i s = _mm_add_epi16(_mm_mullo_epi16(_mm_loadu_si128((const __m128i *)c0), wx0[px]),
+                                      _mm_mullo_epi16(_mm_loadu_si128((const __m128i *)c1), wx1[px]));
+            __m128i rgb = Is2bpp ? _mm_add_epi16(_mm_srli_epi16(s, 2), _mm_srli_epi16(s, 7))
+                                 : _mm_add_epi16(_mm_srli_epi16(s, 1), _mm_srli_epi16(s, 6));
+            __m128i alpha = Is2bpp ? _mm_add_epi16(_mm_srli_epi16(s, 1), _mm_srli_epi16(s, 5))
+                                   : _mm_add_epi16(s, _mm_srli_epi16(s, 4));
+            __m128i m = _mm_mullo_epi16(_mm_blend_epi16(rgb, alpha, 0x88), mod[weights[x]]);
+            m = _mm_srli_epi16(_mm_add_epi16(m, _mm_srli_si128(m, 8)), 3);
+            out[x] = (uint32_t)_mm_cvtsi128_si32(_mm_shuffle_epi8(m, to_bgra));
+        }
     }
+};
 
-    void (*get_texel_weights_func)(const uint8_t *, PVRTCTexelInfo *) =
-      is2bpp ? get_texel_weights_2bpp : get_texel_weights_4bpp;
-    void (*applicate_color_func)(const uint8_t *, PVRTCTexelInfo *const[9], uint32_t[32]) =
-      is2bpp ? applicate_color_2bpp : applicate_color_4bpp;
+#endif
 
-    const uint8_t *d = data;
-    for (long i = 0; i < num_blocks; i++, d += 8) {
-        get_texel_colors(d, &texel_info[i]);
-        get_texel_weights_func(d, &texel_info[i]);
+}  // namespace
+
+template<class Kernel, int Layout>
+static int decode_rows(const PVRTCImage *image, long y0, long y1, uint8_t *out) {
+    const long w = image->w, blocks_x = image->blocks_x, blocks_y = image->blocks_y;
+    const long plane_w = blocks_x * (image->is2bpp ? 8 : 4), plane_h = blocks_y * 4;
+    y0 = y0 < 0 ? 0 : y0;
+    y1 = y1 > image->h ? image->h : y1;
+    int16_t *v = (int16_t *)malloc(sizeof(int16_t) * 8 * blocks_x);
+    int8_t *weights = (int8_t *)malloc(w);
+    uint32_t *row = (uint32_t *)malloc(sizeof(uint32_t) * w);
+    if (v == NULL || weights == NULL || row == NULL) {
+        free(v);
+        free(weights);
+        free(row);
+        return 0;
     }
 
-    uint32_t buffer[32];
-    PVRTCTexelInfo *local_info[9];
-    long pos_x[3], pos_y[3];
+    for (long py = y0; py < y1; py++) {
+        long by = py >> 2, y = py & 3;
+        long r0, r1;
+        int wy0, wy1;
+        if (y < 2) {
+            r0 = by == 0 ? blocks_y - 1 : by - 1, r1 = by;
+            wy0 = 2 - (int)y, wy1 = 2 + (int)y;
+        } else {
+            r0 = by, r1 = by == blocks_y - 1 ? 0 : by + 1;
+            wy0 = 6 - (int)y, wy1 = (int)y - 2;
+        }
+        Kernel::rows(image->colors + r0 * blocks_x * 8, image->colors + r1 * blocks_x * 8, wy0, wy1, blocks_x, v);
 
-    for (long by = 0; by < num_blocks_y; by++) {
-        pos_y[0] = by == 0 ? num_blocks_y - 1 : by - 1;
-        pos_y[1] = by;
-        pos_y[2] = by == num_blocks_y - 1 ? 0 : by + 1;
-        for (long bx = 0, x = 0; bx < num_blocks_x; bx++, x += 4) {
-            pos_x[0] = bx == 0 ? num_blocks_x - 1 : bx - 1;
-            pos_x[1] = bx;
-            pos_x[2] = bx == num_blocks_x - 1 ? 0 : bx + 1;
-            for (long cy = 0, c = 0; cy < 3; cy++)
-                for (long cx = 0; cx < 3; cx++, c++)
-                    local_info[c] = &texel_info[morton_index(pos_x[cx], pos_y[cy], min_num_blocks)];
-            applicate_color_func(data + morton_index(bx, by, min_num_blocks) * 8, local_info, buffer);
-            copy_block_buffer(bx, by, w, h, bw, 4, buffer, image);
+        const int8_t *plane = image->weights + py * plane_w;
+        memcpy(weights, plane, w);
+        if (image->is2bpp) {
+            const int8_t *above = image->weights + (py == 0 ? plane_h - 1 : py - 1) * plane_w;
+            const int8_t *below = image->weights + (py == plane_h - 1 ? 0 : py + 1) * plane_w;
+            for (long x = 0; x < w; x++) {
+                if (weights[x] >= 0)
+                    continue;
+                int vertical = above[x] + below[x];
+                int horizontal = plane[x == 0 ? plane_w - 1 : x - 1] + plane[x == plane_w - 1 ? 0 : x + 1];
+                switch (weights[x]) {
+                case -1:
+                    weights[x] = (vertical + 1) / 2;
+                    break;
+                case -2:
+                    weights[x] = (horizontal + 1) / 2;
+                    break;
+                case -3:
+                    weights[x] = (vertical + horizontal + 2) / 4;
+                    break;
+                }
+            }
+            Kernel::template modulate<1>(v, weights, w, blocks_x, row);
+        } else {
+            Kernel::template modulate<0>(v, weights, w, blocks_x, row);
         }
+        copy_block_buffer_as<Layout>(0, 0, w, 1, w, 1, row, out + py * w * PixelLayout<Layout>::bytes);
     }
 
-    free(texel_info);
+    free(v);
+    free(weights);
+    free(row);
     return 1;
 }
+
+template<int Layout>
+static int decode_rows_as(const PVRTCImage *image, long y0, long y1, uint8_t *out) {
+#if defined(TEXTURE2D_SIMD_X86)
+    if (simd_level() >= SIMD_SSE41)
+        return decode_rows<Sse41Kernel, Layout>(image, y0, y1, out);
+#endif
+    return decode_rows<ScalarKernel, Layout>(image, y0, y1, out);
+}
+
+int pvrtc_decode_rows_as(const PVRTCImage *image, const long y0, const long y1, int layout, uint8_t *out) {
+    DECODE_WITH_LAYOUT(decode_rows_as, layout, image, y0, y1, out)
+}
+
+int decode_pvrtc_as(const uint8_t *data, const long w, const long h, const int is2bpp, int layout, uint8_t *image) {
+    PVRTCImage expanded;
+    if (!pvrtc_expand(data, w, h, is2bpp, &expanded))
+        return 0;
+    int result = pvrtc_decode_rows_as(&expanded, 0, h, layout, image);
+    pvrtc_free(&expanded);
+    return result;
+}
+
+int decode_pvrtc(const uint8_t *data, const long w, const long h, uint32_t *image, const int is2bpp) {
+    return decode_pvrtc_as(data, w, h, is2bpp, LAYOUT_BGRA, (uint8_t *)image);
+}
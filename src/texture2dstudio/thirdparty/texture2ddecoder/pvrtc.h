@@ -3,27 +3,34 @@
 
 #include <stdint.h>
 
+// A PVRTC1 image with its blocks expanded once, in row-major block order: the A and B colours of
+// every block and the modulation weight of every texel. Rows of it are then decoded independently,
+// so an image can be split across threads.
 typedef struct {
-    uint8_t r;
-    uint8_t g;
-    uint8_t b;
-    uint8_t a;
-} PVRTCTexelColor;
+    long w;
+    long h;
+    long blocks_x;
+    long blocks_y;
+    int is2bpp;
+    // 8 values per block: A then B as r, g, b, a at the block's stored precision (5 bit rgb, 4 bit alpha)
+    int16_t *colors;
+    // blocks_x * bw by blocks_y * 4 texels. 0..8, PVRTC_PUNCH_THROUGH set on a 4bpp punch-through
+    // texel, -1/-2/-3 for a 2bpp texel interpolated from its vertical/horizontal/all 4 neighbours.
+    int8_t *weights;
+} PVRTCImage;
 
-typedef struct {
-    int r;
-    int g;
-    int b;
-    int a;
-} PVRTCTexelColorInt;
+#define PVRTC_PUNCH_THROUGH 0x10
 
-typedef struct {
-    PVRTCTexelColor a;
-    PVRTCTexelColor b;
-    int8_t weight[32];
-    uint32_t punch_through_flag;
-} PVRTCTexelInfo;
+// 0 when the number of blocks of a side is not a power of 2 or allocation failed
+int pvrtc_expand(const uint8_t *data, const long w, const long h, const int is2bpp, PVRTCImage *image);
+
+void pvrtc_free(PVRTCImage *image);
+
+// Decodes pixel rows y0..y1 of an expanded image into the whole w * h image in a LAYOUT_* layout
+int pvrtc_decode_rows_as(const PVRTCImage *image, const long y0, const long y1, int layout, uint8_t *out);
 
 int decode_pvrtc(const uint8_t *, const long, const long, uint32_t *, const int);
 
+int decode_pvrtc_as(const uint8_t *data, const long w, const long h, const int is2bpp, int layout, uint8_t *image);
+
 #endif /* end of include guard: PVRTC_H */
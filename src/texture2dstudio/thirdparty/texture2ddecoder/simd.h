@@ -0,0 +1,97 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Runtime SIMD dispatch for the block decoders. Kernels carry per-function target attributes so the
+// library still builds with default compiler flags; decoders pick a kernel once from simd_level().
+// TEXTURE2D_SIMD=none|sse41|avx2 caps the detected level (benchmarks, cross-checking kernels).
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define TEXTURE2D_SIMD_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define SIMD_TARGET_SSE41
+#define SIMD_TARGET_AVX2
+#else
+#define SIMD_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+enum {
+    SIMD_NONE = 0,
+    SIMD_SSE41 = 1,
+    SIMD_AVX2 = 2,
+};
+
+static inline int simd_detect() {
+    int level = SIMD_NONE;
+#if defined(TEXTURE2D_SIMD_X86)
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    const int ids = info[0];
+    __cpuid(info, 1);
+    if (info[2] & (1 << 19))
+        level = SIMD_SSE41;
+    // AVX2 also needs the OS to save the ymm state (OSXSAVE + XCR0 bits 1 and 2)
+    if (ids >= 7 && (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6) {
+        __cpuidex(info, 7, 0);
+        if (info[1] & (1 << 5))
+            level = SIMD_AVX2;
+    }
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.1"))
+        level = SIMD_SSE41;
+    if (__builtin_cpu_supports("avx2"))
+        level = SIMD_AVX2;
+#endif
+#endif
+    const char *cap = getenv("TEXTURE2D_SIMD");
+    if (cap) {
+        if (strcmp(cap, "none") == 0)
+            level = SIMD_NONE;
+        else if (strcmp(cap, "sse41") == 0 && level > SIMD_SSE41)
+            level = SIMD_SSE41;
+    }
+    return level;
+}
+
+static inline int simd_level() {
+    static const int level = simd_detect();
+    return level;
+}
+
+#if defined(TEXTURE2D_SIMD_X86)
+// Spreads the 16 3-bit indices in the low 48 bits of d (first index lowest) into one byte each.
+// Word i takes the two bytes holding bits 3i..3i+2, multiplying by 2^(8 - 3i % 8) moves them to the
+// high byte.
+SIMD_TARGET_SSE41 static inline __m128i simd_spread_indices3(uint64_t d) {
+    const __m128i v = _mm_set_epi64x(0, (long long) d);
+    const __m128i lo = _mm_shuffle_epi8(v, _mm_setr_epi8(0, 1, 0, 1, 0, 1, 1, 2, 1, 2, 1, 2, 2, 3, 2, 3));
+    const __m128i hi = _mm_shuffle_epi8(v, _mm_setr_epi8(3, 4, 3, 4, 3, 4, 4, 5, 4, 5, 4, 5, 5, 6, 5, 6));
+    const __m128i scale = _mm_setr_epi16(256, 32, 4, 128, 16, 2, 64, 8);
+    const __m128i mask = _mm_set1_epi16(7);
+    const __m128i first = _mm_and_si128(_mm_srli_epi16(_mm_mullo_epi16(lo, scale), 8), mask);
+    const __m128i second = _mm_and_si128(_mm_srli_epi16(_mm_mullo_epi16(hi, scale), 8), mask);
+    return _mm_packus_epi16(first, second);
+}
+
+// Stores 16 bytes (one per texel, row-major) into byte `channel` of a 4x4 block of 32-bit texels
+SIMD_TARGET_SSE41 static inline void simd_store_channel(__m128i values, int channel, uint32_t *outbuf) {
+    const __m128i shift = _mm_cvtsi32_si128(channel * 8);
+    const __m128i keep = _mm_set1_epi32((int) ~(0xffu << channel * 8));
+    for (int y = 0; y < 4; y++, values = _mm_srli_si128(values, 4)) {
+        __m128i *row = (__m128i *) (outbuf + y * 4);
+        const __m128i texels = _mm_and_si128(_mm_loadu_si128(row), keep);
+        _mm_storeu_si128(row, _mm_or_si128(texels, _mm_sll_epi32(_mm_cvtepu8_epi32(values), shift)));
+    }
+}
+#endif
+
+#endif /* end of include guard: SIMD_H */
@@ -1,34 +1,102 @@
 #include "unitycrunch.h"
 #include <stdint.h>
 #include <algorithm>
+#include <vector>
 #include "unitycrunch/crn_decomp.h"
 
-bool unity_crunch_unpack_level(const uint8_t* data, uint32_t data_size, uint32_t level_index, void** ret, uint32_t* ret_size) {
+static int block_format(crn_format format) {
+	switch (format)
+	{
+	case cCRNFmtDXT1:
+		return UNITY_CRUNCH_BC1;
+	case cCRNFmtDXT5:
+	case cCRNFmtDXT5_CCxY:
+	case cCRNFmtDXT5_xGxR:
+	case cCRNFmtDXT5_xGBR:
+	case cCRNFmtDXT5_AGBR:
+		return UNITY_CRUNCH_BC3;
+	case cCRNFmtDXT5A:
+		return UNITY_CRUNCH_BC4;
+	case cCRNFmtDXN_XY:
+	case cCRNFmtDXN_YX:
+		return UNITY_CRUNCH_BC5;
+	case cCRNFmtETC1:
+	case cCRNFmtETC1S:
+		return UNITY_CRUNCH_ETC1;
+	case cCRNFmtETC2:
+		return UNITY_CRUNCH_ETC2;
+	case cCRNFmtETC2A:
+	case cCRNFmtETC2AS:
+		return UNITY_CRUNCH_ETC2A;
+	default:
+		return UNITY_CRUNCH_UNSUPPORTED;
+	}
+}
+
+void* unity_crunch_begin(const uint8_t* data, uint32_t data_size, unity_crunch_info* info) {
 	unitycrnd::crn_texture_info tex_info;
 	if (!unitycrnd::crnd_get_texture_info(data, data_size, &tex_info))
 	{
-		return false;
+		return nullptr;
 	}
+	if (tex_info.m_faces == 0 || tex_info.m_faces > cCRNMaxFaces)
+	{
+		return nullptr;
+	}
+	info->width = tex_info.m_width;
+	info->height = tex_info.m_height;
+	info->levels = tex_info.m_levels;
+	info->faces = tex_info.m_faces;
+	info->bytes_per_block = unitycrnd::crnd_get_bytes_per_dxt_block(tex_info.m_format);
+	info->format = tex_info.m_format;
+	info->block_format = block_format(tex_info.m_format);
+	return unitycrnd::crnd_unpack_begin(data, data_size);
+}
+
+bool unity_crunch_unpack(void* context, uint32_t level_index, uint8_t** faces, uint32_t face_size) {
+	// a zero row pitch packs the block rows tightly
+	return unitycrnd::crnd_unpack_level(context, (void**) faces, face_size, 0, level_index);
+}
+
+void unity_crunch_end(void* context) {
+	unitycrnd::crnd_unpack_end(context);
+}
 
-	unitycrnd::crnd_unpack_context pContext = unitycrnd::crnd_unpack_begin(data, data_size);
-	if (!pContext)
+bool unity_crunch_unpack_level(const uint8_t* data, uint32_t data_size, uint32_t level_index, void** ret, uint32_t* ret_size) {
+	unity_crunch_info info;
+	void* context = unity_crunch_begin(data, data_size, &info);
+	if (!context)
+	{
+		return false;
+	}
+	if (level_index >= info.levels)
 	{
+		unity_crunch_end(context);
 		return false;
 	}
 
-	const crn_uint32 width = std::max(1U, tex_info.m_width >> level_index);
-	const crn_uint32 height = std::max(1U, tex_info.m_height >> level_index);
-	const crn_uint32 blocks_x = std::max(1U, (width + 3) >> 2);
-	const crn_uint32 blocks_y = std::max(1U, (height + 3) >> 2);
-	const crn_uint32 row_pitch = blocks_x * unitycrnd::crnd_get_bytes_per_dxt_block(tex_info.m_format);
-	const crn_uint32 total_face_size = row_pitch * blocks_y;
-	*ret = new uint8_t[total_face_size];
-	*ret_size = total_face_size;
-	if (!unitycrnd::crnd_unpack_level(pContext, ret, total_face_size, row_pitch, level_index))
+	const uint32_t width = std::max(1U, info.width >> level_index);
+	const uint32_t height = std::max(1U, info.height >> level_index);
+	const uint32_t blocks_x = std::max(1U, (width + 3) >> 2);
+	const uint32_t blocks_y = std::max(1U, (height + 3) >> 2);
+	const uint32_t total_face_size = blocks_x * info.bytes_per_block * blocks_y;
+	// crunch writes every face of the level, only the first one is returned
+	uint8_t* first = new uint8_t[total_face_size];
+	std::vector<uint8_t> others((size_t) total_face_size * (info.faces - 1));
+	std::vector<uint8_t*> faces(info.faces);
+	faces[0] = first;
+	for (uint32_t i = 1; i < info.faces; i++)
+	{
+		faces[i] = others.data() + (size_t) total_face_size * (i - 1);
+	}
+	bool ok = unity_crunch_unpack(context, level_index, faces.data(), total_face_size);
+	unity_crunch_end(context);
+	if (!ok)
 	{
-		unitycrnd::crnd_unpack_end(pContext);
+		delete[] first;
 		return false;
 	}
-	unitycrnd::crnd_unpack_end(pContext);
+	*ret = first;
+	*ret_size = total_face_size;
 	return true;
-}
\ No newline at end of file
+}
@@ -2,4 +2,35 @@
 
 #include <stdint.h>
 
-bool unity_crunch_unpack_level(const uint8_t* data, uint32_t data_size, uint32_t level_index, void** ret, uint32_t* ret_size);
\ No newline at end of file
+// What a crunch level unpacks to, the swizzled DXT5 variants are plain DXT5 blocks
+enum {
+	UNITY_CRUNCH_UNSUPPORTED = -1,
+	UNITY_CRUNCH_BC1,
+	UNITY_CRUNCH_BC3,
+	UNITY_CRUNCH_BC4,
+	UNITY_CRUNCH_BC5,
+	UNITY_CRUNCH_ETC1,
+	UNITY_CRUNCH_ETC2,
+	UNITY_CRUNCH_ETC2A,
+};
+
+typedef struct {
+	uint32_t width;
+	uint32_t height;
+	uint32_t levels;
+	uint32_t faces;
+	uint32_t bytes_per_block;
+	int format;	// crn_format
+	int block_format;	// UNITY_CRUNCH_*
+} unity_crunch_info;
+
+// An unpack context keeps the decoded palettes and huffman tables of one .crn file, so every level
+// and face is unpacked without setting them up again. data must outlive the context.
+void* unity_crunch_begin(const uint8_t* data, uint32_t data_size, unity_crunch_info* info);
+
+// Unpacks all faces of a level, faces[i] receiving face_size bytes of tightly packed blocks
+bool unity_crunch_unpack(void* context, uint32_t level_index, uint8_t** faces, uint32_t face_size);
+
+void unity_crunch_end(void* context);
+
+bool unity_crunch_unpack_level(const uint8_t* data, uint32_t data_size, uint32_t level_index, void** ret, uint32_t* ret_size);
@@ -0,0 +1,126 @@
+"""Writes checker_dxt1.crn, a minimal crunch file assembled by hand.
+
+Usage: python3 make_checker.py checker_dxt1.crn
+"""
+import struct
+import sys
+
+# codelength code sizes are sent in the order of g_most_probable_codelength_codes in crn_decomp.h
+ORDER = [17, 18, 19, 20, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15, 16]
+
+
+class Bits:
+    def __init__(self):
+        self.bits = []
+
+    def put(self, value, n):
+        self.bits += [(value >> (n - 1 - i)) & 1 for i in range(n)]
+
+    def code(self, codes, sym):
+        value, n = codes[sym]
+        self.put(value, n)
+
+    def bytes(self):
+        b = self.bits + [0] * (-len(self.bits) % 8)
+        return bytes(int(''.join(map(str, b[i:i + 8])), 2) for i in range(0, len(b), 8))
+
+
+def canonical(sizes):
+    codes, code = {}, 0
+    for n in range(1, 17):
+        for sym, size in enumerate(sizes):
+            if size == n:
+                codes[sym] = (code, n)
+                code += 1
+        code <<= 1
+    return codes
+
+
+def model(bits, sizes):
+    # code lengths sent as literals, the codelength code covers the lengths used
+    used = sorted(set(sizes))
+    cl_sizes = [0] * 21
+    n = 1
+    while (1 << n) < len(used):
+        n += 1
+    for s in used:
+        cl_sizes[s] = n
+    send = max(ORDER.index(s) for s in used) + 1
+    bits.put(len(sizes), 14)
+    bits.put(send, 5)
+    for i in range(send):
+        bits.put(cl_sizes[ORDER[i]], 3)
+    cl = canonical(cl_sizes)
+    for s in sizes:
+        bits.code(cl, s)
+    return canonical(sizes)
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for b in data:
+        q = b ^ (crc >> 8)
+        crc = (crc << 8) & 0xFFFF
+        r = (q >> 4) ^ q
+        crc ^= r
+        r = (r << 5) & 0xFFFF
+        crc ^= r
+        r = (r << 7) & 0xFFFF
+        crc ^= r
+    return ~crc & 0xFFFF
+
+
+# 8x8 DXT1, two levels: palette of a red and a blue endpoint pair and one all-zero selector.
+# Level 0 steps the endpoint index by 0, 1, 0, 1 (a 2x2 checkerboard), level 1 is a single blue block.
+tables = Bits()
+ref = model(tables, [1, 1])            # reference_encoding_dm: 0 = fresh endpoints for both blocks
+ep_delta = model(tables, [1, 1])       # endpoint index deltas 0 and 1
+sel_delta = model(tables, [1, 1])      # selector index, always 0
+
+endpoints = Bits()
+dm5 = model(endpoints, [1, 2] + [0] * 29 + [2])   # 5 bit deltas 0, 1, 31
+dm6 = model(endpoints, [1, 1])                    # 6 bit deltas, always 0
+for a, b, c, d, e, f in ((31, 0, 0, 31, 0, 0), (1, 0, 31, 1, 0, 31)):
+    for sym, dm in ((a, dm5), (b, dm6), (c, dm5), (d, dm5), (e, dm6), (f, dm5)):
+        endpoints.code(dm, sym)
+
+selectors = Bits()
+dm4 = model(selectors, [1, 1])
+for _ in range(8):
+    selectors.code(dm4, 0)
+
+
+def level(deltas):
+    bits = Bits()
+    for i, delta in enumerate(deltas):
+        if i % 4 == 0:
+            bits.code(ref, 0)  # one reference group per 2x2 blocks
+        bits.code(ep_delta, delta)
+        bits.code(sel_delta, 0)
+    return bits.bytes()
+
+
+# blocks go x0y0, x1y0 (group 0 row 0) then x0y1, x1y1; level 1 pads its single block to a 2x2 group
+chunks = [tables.bytes(), endpoints.bytes(), selectors.bytes(), level([0, 1, 0, 1]), level([1, 0, 0, 0])]
+header_size = 78
+ofs = [header_size]
+for c in chunks:
+    ofs.append(ofs[-1] + len(c))
+body = b''.join(chunks)
+data_size = header_size + len(body)
+
+
+def u24(v):
+    return v.to_bytes(3, 'big')
+
+
+def palette(i, num):
+    return u24(ofs[i]) + u24(len(chunks[i])) + struct.pack('>H', num)
+
+
+header = struct.pack('>HHHIHHHBBBHIII', 0x4878, header_size, 0, data_size, crc16(body), 8, 8, 2, 1, 0, 0, 0, 0, 0)
+header += palette(1, 2) + palette(2, 1) + b'\0' * 16
+header += struct.pack('>H', len(chunks[0])) + u24(ofs[0]) + struct.pack('>II', ofs[3], ofs[4])
+assert len(header) == header_size
+header = header[:4] + struct.pack('>H', crc16(header[6:])) + header[6:]
+open(sys.argv[1], 'wb').write(header + body)
@@ -0,0 +1,58 @@
+import threading
+
+import pytexture2dstudio
+
+RED = bytes((0, 0, 255, 255))   # TEXTURE2D_OUTPUT_BGRA
+BLUE = bytes((255, 0, 0, 255))
+
+
+def pixel(data, w, x, y):
+    return data[(y * w + x) * 4:(y * w + x) * 4 + 4]
+
+
+def CrunchDecode():
+    # crn/checker_dxt1.crn, written by crn/make_checker.py: 8x8 DXT1 with two levels
+    with open("crn/checker_dxt1.crn", mode="rb") as r:
+        data = r.read()
+    decoder = pytexture2dstudio.CrunchDecoder(data)
+    assert decoder.Info() == (5, 8, 8, 2, 1)
+    data, w, h = decoder.Decode(0)
+    assert (w, h) == (8, 8)
+    for y in range(h):
+        for x in range(w):
+            assert pixel(data, w, x, y) == (RED if (x // 4 + y // 4) % 2 == 0 else BLUE)
+    data, w, h = decoder.Decode(1)
+    assert (w, h) == (4, 4) and data == BLUE * 16
+
+
+def CrunchReinit():
+    with open("crn/checker_dxt1.crn", mode="rb") as r:
+        data = r.read()
+    decoder = pytexture2dstudio.CrunchDecoder(data)
+    stop = False
+
+    def decode():
+        while not stop:
+            decoder.Decode(0)
+            decoder.Decode(1)
+
+    threads = [threading.Thread(target=decode) for _ in range(3)]
+    for t in threads:
+        t.start()
+    try:
+        for _ in range(50):
+            try:
+                decoder.__init__(data)
+            except TypeError:
+                pass
+            else:
+                raise AssertionError("CrunchDecoder accepted a second __init__")
+    finally:
+        stop = True
+        for t in threads:
+            t.join()
+
+
+if __name__ == '__main__':
+    CrunchDecode()
+    CrunchReinit()
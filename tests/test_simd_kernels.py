@@ -0,0 +1,68 @@
+import hashlib
+import json
+import os
+import random
+import subprocess
+import sys
+
+import pytexture2dstudio
+
+# TEXTURE2D_SIMD caps the kernel level once per process, so every level decodes in its own interpreter
+LEVELS = ["none", "sse41", "avx2"]
+W, H = 37, 21  # partial blocks on both edges; pvrtc needs power of two block counts and uses 32x16
+ASTC_FOOTPRINTS = [(4, 4), (5, 4), (6, 6), (8, 5), (8, 8), (10, 10), (12, 12)]
+
+
+def blocks(block_bytes, bw=4, bh=4, w=W, h=H, seed=0):
+    n = -(-w // bw) * -(-h // bh)
+    return random.Random(seed).randbytes(n * block_bytes)
+
+
+def astc_blocks(bw, bh, seed=0):
+    # astc has no kernels of its own and random bytes are mostly illegal blocks, so compress an image instead
+    rng = random.Random(seed)
+    pixels = bytearray()
+    for y in range(H):
+        for x in range(W):
+            pixels += bytes((x * 7 & 255, y * 12 & 255, rng.randrange(256), 255 if x < 20 else rng.randrange(256)))
+    return pytexture2dstudio.CompressAstcRaw(bytes(pixels), W, H, W * 4, 10, bw, bh, 1, 0)
+
+
+def cases():
+    for name, block_bytes in (("Etc1", 8), ("Etc2", 8), ("Etc2a1", 8), ("Etc2a8", 16),
+                              ("EacR11", 8), ("EacR11Signed", 8), ("EacRG11", 16), ("EacRG11Signed", 16),
+                              ("Bc1", 8), ("Bc3", 16), ("Bc4", 8), ("Bc5", 16), ("Bc6", 16), ("Bc7", 16)):
+        yield name, "Decompress" + name, (blocks(block_bytes), W, H)
+    for bw, bh in ASTC_FOOTPRINTS:
+        yield "Astc%dx%d" % (bw, bh), "DecompressAstc", (astc_blocks(bw, bh), W, H, bw, bh)
+    yield "Pvrtc4bpp", "DecompressPvrtc", (blocks(8, 4, 4, 32, 16), 32, 16, 0)
+    yield "Pvrtc2bpp", "DecompressPvrtc", (blocks(8, 8, 4, 32, 16), 32, 16, 1)
+
+
+def decode_all():
+    digests = {}
+    for name, func, args in cases():
+        for output_format in range(5):
+            for jobs in (1, 4):
+                data = getattr(pytexture2dstudio, func)(*args, jobs, output_format)
+                digests["%s/%d/%d" % (name, output_format, jobs)] = hashlib.sha256(data).hexdigest()
+    return digests
+
+
+def SimdKernels():
+    results = {}
+    for level in LEVELS:
+        env = dict(os.environ, TEXTURE2D_SIMD=level)
+        out = subprocess.run([sys.executable, __file__, "--decode"], env=env, check=True,
+                             stdout=subprocess.PIPE).stdout
+        results[level] = json.loads(out)
+    mismatches = [key for key in results["none"]
+                  if len({results[level][key] for level in LEVELS}) != 1]
+    assert not mismatches, "kernels disagree with the scalar decoders: " + ", ".join(mismatches)
+
+
+if __name__ == '__main__':
+    if sys.argv[1:] == ["--decode"]:
+        print(json.dumps(decode_all()))
+    else:
+        SimdKernels()